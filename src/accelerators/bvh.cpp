@@ -35,6 +35,14 @@
 #include "accelerators/bvh.h"
 #include "probes.h"
 #include "paramset.h"
+#include "intersection.h"
+#include "parallel.h"
+#include "shapes/trianglemesh.h"
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define PBRT_BVH_HAS_SSE
+#include <xmmintrin.h>
+#endif
 
 // BVHAccel Local Declarations
 struct BVHPrimitiveInfo {
@@ -110,6 +118,125 @@ bool CompareToBucket::operator()(const BVHPrimitiveInfo &p) const {
 }
 
 
+struct BVHBucketInfo {
+    BVHBucketInfo() { count = 0; }
+    int count;
+    BBox bounds;
+};
+
+
+// Nodes with at least _bvhTaskPrimitives_ primitives build their first child
+// in another task; the bounds and SAH buckets of the nodes with more than
+// _bvhChunkPrimitives_ primitives are gathered in parallel chunks
+static const uint32_t bvhTaskPrimitives = 4096;
+static const uint32_t bvhChunkPrimitives = 32768;
+
+
+static void BoundPrimitives(const vector<BVHPrimitiveInfo> &buildData,
+        uint32_t start, uint32_t end, BBox *bbox, BBox *centroidBounds) {
+    for (uint32_t i = start; i < end; ++i) {
+        *bbox = Union(*bbox, buildData[i].bounds);
+        *centroidBounds = Union(*centroidBounds, buildData[i].centroid);
+    }
+}
+
+
+static void ComputeBounds(const vector<BVHPrimitiveInfo> &buildData,
+        uint32_t start, uint32_t end, BBox *bbox, BBox *centroidBounds) {
+    const uint32_t nChunks = (end - start + bvhChunkPrimitives - 1) /
+                             bvhChunkPrimitives;
+    if (nChunks == 1) {
+        BoundPrimitives(buildData, start, end, bbox, centroidBounds);
+        return;
+    }
+    vector<BBox> chunkBounds(nChunks), chunkCentroidBounds(nChunks);
+    ParallelFor(0, nChunks, 1, [&](int64_t c) {
+        const uint32_t first = start + c * bvhChunkPrimitives;
+        BoundPrimitives(buildData, first, min(end, first + bvhChunkPrimitives),
+                        &chunkBounds[c], &chunkCentroidBounds[c]);
+    });
+    for (uint32_t c = 0; c < nChunks; ++c) {
+        *bbox = Union(*bbox, chunkBounds[c]);
+        *centroidBounds = Union(*centroidBounds, chunkCentroidBounds[c]);
+    }
+}
+
+
+static void FillBuckets(const vector<BVHPrimitiveInfo> &buildData,
+        uint32_t start, uint32_t end, int dim, const BBox &centroidBounds,
+        int nBuckets, BVHBucketInfo *buckets) {
+    for (uint32_t i = start; i < end; ++i) {
+        int b = nBuckets *
+            ((buildData[i].centroid[dim] - centroidBounds.pMin[dim]) /
+             (centroidBounds.pMax[dim] - centroidBounds.pMin[dim]));
+        if (b == nBuckets) b = nBuckets-1;
+        Assert(b >= 0 && b < nBuckets);
+        buckets[b].count++;
+        buckets[b].bounds = Union(buckets[b].bounds, buildData[i].bounds);
+    }
+}
+
+
+static void ComputeBuckets(const vector<BVHPrimitiveInfo> &buildData,
+        uint32_t start, uint32_t end, int dim, const BBox &centroidBounds,
+        int nBuckets, BVHBucketInfo *buckets) {
+    const uint32_t nChunks = (end - start + bvhChunkPrimitives - 1) /
+                             bvhChunkPrimitives;
+    if (nChunks == 1) {
+        FillBuckets(buildData, start, end, dim, centroidBounds, nBuckets,
+                    buckets);
+        return;
+    }
+    vector<BVHBucketInfo> chunkBuckets(nChunks * nBuckets);
+    ParallelFor(0, nChunks, 1, [&](int64_t c) {
+        const uint32_t first = start + c * bvhChunkPrimitives;
+        FillBuckets(buildData, first, min(end, first + bvhChunkPrimitives),
+                    dim, centroidBounds, nBuckets, &chunkBuckets[c * nBuckets]);
+    });
+    for (uint32_t c = 0; c < nChunks; ++c) {
+        for (int b = 0; b < nBuckets; ++b) {
+            buckets[b].count += chunkBuckets[c * nBuckets + b].count;
+            buckets[b].bounds = Union(buckets[b].bounds,
+                                      chunkBuckets[c * nBuckets + b].bounds);
+        }
+    }
+}
+
+
+struct BVHBuildState {
+    BVHBuildState() : totalNodes(0) { mutex = Mutex::Create(); }
+    ~BVHBuildState();
+    AtomicInt32 totalNodes;
+    Mutex *mutex;
+    // The subtree tasks own the arenas of their nodes, they are kept until
+    // the tree is flattened
+    vector<BVHBuildTask *> tasks;
+};
+
+
+struct BVHBuildTask : public Task {
+    BVHBuildTask(BVHAccel *b, BVHBuildState &s, vector<BVHPrimitiveInfo> &d,
+                 uint32_t st, uint32_t e)
+        : bvh(b), state(s), buildData(d), start(st), end(e), node(NULL) { }
+    void Run() {
+        node = bvh->recursiveBuild(arena, state, buildData, start, end);
+    }
+    BVHAccel *bvh;
+    BVHBuildState &state;
+    vector<BVHPrimitiveInfo> &buildData;
+    uint32_t start, end;
+    MemoryArena arena;
+    BVHBuildNode *node;
+};
+
+
+BVHBuildState::~BVHBuildState() {
+    for (uint32_t i = 0; i < tasks.size(); ++i)
+        delete tasks[i];
+    Mutex::Destroy(mutex);
+}
+
+
 struct LinearBVHNode {
     BBox bounds;
     union {
@@ -149,12 +276,134 @@ static inline bool IntersectP(const BBox &bounds, const Ray &ray,
 
 
 
+// A 4-wide node collapsing two levels of the binary tree; the bounds of the
+// children are stored by axis so that a ray is tested against all of them
+// at once
+struct LinearQBVHNode {
+    LinearQBVHNode() {
+        for (int c = 0; c < 4; ++c) {
+            // Empty children have inverted bounds that no ray overlaps
+            for (int a = 0; a < 3; ++a) {
+                bounds[0][a][c] = INFINITY;
+                bounds[1][a][c] = -INFINITY;
+            }
+            children[c] = 0;
+            nPrimitives[c] = 0;
+        }
+        axis[0] = axis[1] = axis[2] = 0;
+    }
+    void SetChild(int c, const LinearBVHNode &node) {
+        for (int a = 0; a < 3; ++a) {
+            bounds[0][a][c] = node.bounds.pMin[a];
+            bounds[1][a][c] = node.bounds.pMax[a];
+        }
+        children[c] = node.primitivesOffset;
+        nPrimitives[c] = node.nPrimitives;
+    }
+    float bounds[2][3][4];  // [pMin/pMax][axis][child]
+    uint32_t children[4];   // leaf: primitives, interior: node
+    uint8_t nPrimitives[4]; // 0 -> interior child
+    uint8_t axis[3];        // split axes of the node and of its two halves
+    uint8_t pad[9];         // ensure 128 byte total size
+};
+
+
+struct QBVHRay {
+    QBVHRay(const Ray &ray, const Vector &invDir) {
+#ifdef PBRT_BVH_HAS_SSE
+        for (int a = 0; a < 3; ++a) {
+            o[a] = _mm_set1_ps(ray.o[a]);
+            inv[a] = _mm_set1_ps(invDir[a]);
+        }
+#else
+        for (int a = 0; a < 3; ++a) {
+            o[a] = ray.o[a];
+            inv[a] = invDir[a];
+        }
+#endif
+    }
+#ifdef PBRT_BVH_HAS_SSE
+    __m128 o[3], inv[3];
+#else
+    float o[3], inv[3];
+#endif
+};
+
+
+// Returns the mask of the children of _node_ overlapped by _ray_; the NaNs
+// of axis-aligned rays starting on a slab keep the child
+static inline int IntersectP(const LinearQBVHNode &node, const QBVHRay &r,
+        const uint32_t dirIsNeg[3], float mint, float maxt) {
+#ifdef PBRT_BVH_HAS_SSE
+    __m128 tmin = _mm_set1_ps(mint), tmax = _mm_set1_ps(maxt);
+    for (int a = 0; a < 3; ++a) {
+        const __m128 t0 = _mm_mul_ps(_mm_sub_ps(
+            _mm_load_ps(node.bounds[dirIsNeg[a]][a]), r.o[a]), r.inv[a]);
+        const __m128 t1 = _mm_mul_ps(_mm_sub_ps(
+            _mm_load_ps(node.bounds[1-dirIsNeg[a]][a]), r.o[a]), r.inv[a]);
+        tmin = _mm_max_ps(t0, tmin);
+        tmax = _mm_min_ps(t1, tmax);
+    }
+    return _mm_movemask_ps(_mm_cmple_ps(tmin, tmax));
+#else
+    int mask = 0;
+    for (int c = 0; c < 4; ++c) {
+        float tmin = mint, tmax = maxt;
+        for (int a = 0; a < 3; ++a) {
+            const float t0 = (node.bounds[dirIsNeg[a]][a][c] - r.o[a]) * r.inv[a];
+            const float t1 = (node.bounds[1-dirIsNeg[a]][a][c] - r.o[a]) * r.inv[a];
+            if (t0 > tmin) tmin = t0;
+            if (t1 < tmax) tmax = t1;
+        }
+        if (tmin <= tmax) mask |= 1 << c;
+    }
+    return mask;
+#endif
+}
+
+
+// Orders the children of _node_ from the nearest to the farthest along the
+// ray, following the split axes of the collapsed binary nodes
+static inline void OrderChildren(const LinearQBVHNode &node,
+        const uint32_t dirIsNeg[3], int order[4]) {
+    const int first = dirIsNeg[node.axis[0]] ? 2 : 0;
+    order[0] = first + dirIsNeg[node.axis[1 + first / 2]];
+    order[1] = first + 1 - dirIsNeg[node.axis[1 + first / 2]];
+    order[2] = 2 - first + dirIsNeg[node.axis[2 - first / 2]];
+    order[3] = 3 - first - dirIsNeg[node.axis[2 - first / 2]];
+}
+
+
 // BVHAccel Method Definitions
 BVHAccel::BVHAccel(const vector<Reference<Primitive> > &p,
-                   uint32_t mp, const string &sm) {
+                   uint32_t mp, const string &sm, const string &layout) {
     maxPrimsInNode = min(255u, mp);
-    for (uint32_t i = 0; i < p.size(); ++i)
-        p[i]->FullyRefine(primitives);
+    // Refine the primitives, the faces of the triangle meshes are kept in
+    // their mesh instead of being refined to a _Triangle_ each
+    vector<Reference<Primitive> > todo;
+    for (uint32_t i = 0; i < p.size(); ++i) {
+        todo.push_back(p[i]);
+        while (todo.size()) {
+            Reference<Primitive> prim = todo.back();
+            todo.pop_back();
+            const GeometricPrimitive *gprim =
+                dynamic_cast<const GeometricPrimitive *>(prim.GetPtr());
+            const TriangleMesh *mesh = gprim ?
+                dynamic_cast<const TriangleMesh *>(gprim->GetShape().GetPtr()) :
+                NULL;
+            if (mesh) {
+                for (int f = 0; f < mesh->FaceCount(); ++f)
+                    items.push_back(BVHItem(meshes.size(), f));
+                meshes.push_back(BVHMesh(prim, mesh));
+            }
+            else if (prim->CanIntersect()) {
+                items.push_back(BVHItem(BVHItem::noMesh, primitives.size()));
+                primitives.push_back(prim);
+            }
+            else
+                prim->Refine(todo);
+        }
+    }
     if (sm == "sah")         splitMethod = SPLIT_SAH;
     else if (sm == "middle") splitMethod = SPLIT_MIDDLE;
     else if (sm == "equal")  splitMethod = SPLIT_EQUAL_COUNTS;
@@ -163,33 +412,44 @@ BVHAccel::BVHAccel(const vector<Reference<Primitive> > &p,
                 sm.c_str());
         splitMethod = SPLIT_SAH;
     }
+    if (layout != "binary" && layout != "qbvh")
+        Warning("BVH layout \"%s\" unknown.  Using \"binary\".",
+                layout.c_str());
 
-    if (primitives.size() == 0) {
-        nodes = NULL;
+    nodes = NULL;
+    qnodes = NULL;
+    if (items.size() == 0)
         return;
-    }
-    // Build BVH from _primitives_
-    PBRT_BVH_STARTED_CONSTRUCTION(this, primitives.size());
+    // Build BVH from _items_
+    PBRT_BVH_STARTED_CONSTRUCTION(this, items.size());
 
     // Initialize _buildData_ array for primitives
-    vector<BVHPrimitiveInfo> buildData;
-    buildData.reserve(primitives.size());
-    for (uint32_t i = 0; i < primitives.size(); ++i) {
-        BBox bbox = primitives[i]->WorldBound();
-        buildData.push_back(BVHPrimitiveInfo(i, bbox));
-    }
-
-    // Recursively build BVH tree for primitives
+    vector<BVHPrimitiveInfo> buildData(items.size());
+    ParallelFor(0, items.size(), 0, [&](int64_t i) {
+        const BVHItem &item = items[i];
+        buildData[i] = BVHPrimitiveInfo(i, item.mesh == BVHItem::noMesh ?
+            primitives[item.index]->WorldBound() :
+            meshes[item.mesh].mesh->FaceWorldBound(item.index));
+    });
+
+    // Recursively build BVH tree for primitives, the large subtrees are
+    // built in parallel tasks
     MemoryArena buildArena;
-    uint32_t totalNodes = 0;
-    vector<Reference<Primitive> > orderedPrims;
-    orderedPrims.reserve(primitives.size());
-    BVHBuildNode *root = recursiveBuild(buildArena, buildData, 0,
-                                        primitives.size(), &totalNodes,
-                                        orderedPrims);
-    primitives.swap(orderedPrims);
-        Info("BVH created with %d nodes for %d primitives (%.2f MB)", totalNodes,
-             (int)primitives.size(), float(totalNodes * sizeof(LinearBVHNode))/(1024.f*1024.f));
+    BVHBuildState state;
+    BVHBuildNode *root = recursiveBuild(buildArena, state, buildData, 0,
+                                        items.size());
+    uint32_t totalNodes = state.totalNodes;
+
+    // The leaves own consecutive ranges of _buildData_ in depth-first order
+    vector<BVHItem> orderedItems(items.size());
+    for (uint32_t i = 0; i < buildData.size(); ++i)
+        orderedItems[i] = items[buildData[i].primitiveNumber];
+    items.swap(orderedItems);
+        Info("BVH created with %d nodes for %d primitives and %d mesh faces "
+             "(%.2f MB)", totalNodes, (int)primitives.size(),
+             int(items.size() - primitives.size()),
+             float(totalNodes * sizeof(LinearBVHNode) +
+                   items.size() * sizeof(BVHItem))/(1024.f*1024.f));
 
     // Compute representation of depth-first traversal of BVH tree
     nodes = AllocAligned<LinearBVHNode>(totalNodes);
@@ -198,67 +458,66 @@ BVHAccel::BVHAccel(const vector<Reference<Primitive> > &p,
     uint32_t offset = 0;
     flattenBVHTree(root, &offset);
     Assert(offset == totalNodes);
+    bounds = nodes[0].bounds;
+
+    // Collapse the binary tree into 4-wide nodes if requested
+    if (layout == "qbvh") {
+        vector<LinearQBVHNode> qbvhNodes;
+        qbvhNodes.reserve(totalNodes / 3 + 1);
+        collapseQBVH(0, qbvhNodes);
+        qnodes = AllocAligned<LinearQBVHNode>(qbvhNodes.size());
+        for (uint32_t i = 0; i < qbvhNodes.size(); ++i)
+            new (&qnodes[i]) LinearQBVHNode(qbvhNodes[i]);
+        FreeAligned(nodes);
+        nodes = NULL;
+        Info("QBVH created with %d nodes (%.2f MB)", (int)qbvhNodes.size(),
+             float(qbvhNodes.size() * sizeof(LinearQBVHNode))/(1024.f*1024.f));
+    }
     PBRT_BVH_FINISHED_CONSTRUCTION(this);
 }
 
 
 BBox BVHAccel::WorldBound() const {
-    return nodes ? nodes[0].bounds : BBox();
+    return bounds;
 }
 
 
 BVHBuildNode *BVHAccel::recursiveBuild(MemoryArena &buildArena,
-        vector<BVHPrimitiveInfo> &buildData, uint32_t start,
-        uint32_t end, uint32_t *totalNodes,
-        vector<Reference<Primitive> > &orderedPrims) {
+        BVHBuildState &state, vector<BVHPrimitiveInfo> &buildData,
+        uint32_t start, uint32_t end) {
     Assert(start != end);
-    (*totalNodes)++;
+    AtomicAdd(&state.totalNodes, 1);
     BVHBuildNode *node = buildArena.Alloc<BVHBuildNode>();
-    // Compute bounds of all primitives in BVH node
-    BBox bbox;
-    for (uint32_t i = start; i < end; ++i)
-        bbox = Union(bbox, buildData[i].bounds);
+    // Compute bounds of all primitives and of their centroids in BVH node
+    BBox bbox, centroidBounds;
+    ComputeBounds(buildData, start, end, &bbox, &centroidBounds);
     uint32_t nPrimitives = end - start;
     if (nPrimitives == 1) {
         // Create leaf _BVHBuildNode_
-        uint32_t firstPrimOffset = orderedPrims.size();
-        for (uint32_t i = start; i < end; ++i) {
-            uint32_t primNum = buildData[i].primitiveNumber;
-            orderedPrims.push_back(primitives[primNum]);
-        }
-        node->InitLeaf(firstPrimOffset, nPrimitives, bbox);
+        node->InitLeaf(start, nPrimitives, bbox);
     }
     else {
-        // Compute bound of primitive centroids, choose split dimension _dim_
-        BBox centroidBounds;
-        for (uint32_t i = start; i < end; ++i)
-            centroidBounds = Union(centroidBounds, buildData[i].centroid);
+        // Choose split dimension _dim_
         int dim = centroidBounds.MaximumExtent();
 
         // Partition primitives into two sets and build children
         uint32_t mid = (start + end) / 2;
+        BVHBuildNode *children[2];
         if (centroidBounds.pMax[dim] == centroidBounds.pMin[dim]) {
             // If nPrimitives is no greater than maxPrimsInNode,
             // then all the nodes can be stored in a compact bvh node.
             if (nPrimitives <= maxPrimsInNode) {
                 // Create leaf _BVHBuildNode_
-                uint32_t firstPrimOffset = orderedPrims.size();
-                for (uint32_t i = start; i < end; ++i) {
-                    uint32_t primNum = buildData[i].primitiveNumber;
-                    orderedPrims.push_back(primitives[primNum]);
-                }
-                node->InitLeaf(firstPrimOffset, nPrimitives, bbox);
+                node->InitLeaf(start, nPrimitives, bbox);
                 return node;
             }
             else {
                 // else if nPrimitives is greater than maxPrimsInNode, we
                 // need to split it further to guarantee each node contains
                 // no more than maxPrimsInNode primitives.
-                node->InitInterior(dim,
-                                   recursiveBuild(buildArena, buildData, start, mid,
-                                                  totalNodes, orderedPrims),
-                                   recursiveBuild(buildArena, buildData, mid, end,
-                                                  totalNodes, orderedPrims));
+                buildChildren(buildArena, state, buildData, start, mid, end,
+                              children);
+                node->InitInterior(dim, children[0], children[1]);
                 return node;
             }
         }
@@ -294,25 +553,11 @@ BVHBuildNode *BVHAccel::recursiveBuild(MemoryArena &buildArena,
                                  &buildData[end-1]+1, ComparePoints(dim));
             }
             else {
-                // Allocate _BucketInfo_ for SAH partition buckets
+                // Initialize _BVHBucketInfo_ for SAH partition buckets
                 const int nBuckets = 12;
-                struct BucketInfo {
-                    BucketInfo() { count = 0; }
-                    int count;
-                    BBox bounds;
-                };
-                BucketInfo buckets[nBuckets];
-
-                // Initialize _BucketInfo_ for SAH partition buckets
-                for (uint32_t i = start; i < end; ++i) {
-                    int b = nBuckets *
-                        ((buildData[i].centroid[dim] - centroidBounds.pMin[dim]) /
-                         (centroidBounds.pMax[dim] - centroidBounds.pMin[dim]));
-                    if (b == nBuckets) b = nBuckets-1;
-                    Assert(b >= 0 && b < nBuckets);
-                    buckets[b].count++;
-                    buckets[b].bounds = Union(buckets[b].bounds, buildData[i].bounds);
-                }
+                BVHBucketInfo buckets[nBuckets];
+                ComputeBuckets(buildData, start, end, dim, centroidBounds,
+                               nBuckets, buckets);
 
                 // Compute costs for splitting after each bucket
                 float cost[nBuckets-1];
@@ -352,28 +597,44 @@ BVHBuildNode *BVHAccel::recursiveBuild(MemoryArena &buildArena,
                 
                 else {
                     // Create leaf _BVHBuildNode_
-                    uint32_t firstPrimOffset = orderedPrims.size();
-                    for (uint32_t i = start; i < end; ++i) {
-                        uint32_t primNum = buildData[i].primitiveNumber;
-                        orderedPrims.push_back(primitives[primNum]);
-                    }
-                    node->InitLeaf(firstPrimOffset, nPrimitives, bbox);
+                    node->InitLeaf(start, nPrimitives, bbox);
                     return node;
                 }
             }
             break;
         }
         }
-        node->InitInterior(dim,
-                           recursiveBuild(buildArena, buildData, start, mid,
-                                          totalNodes, orderedPrims),
-                           recursiveBuild(buildArena, buildData, mid, end,
-                                          totalNodes, orderedPrims));
+        buildChildren(buildArena, state, buildData, start, mid, end,
+                      children);
+        node->InitInterior(dim, children[0], children[1]);
     }
     return node;
 }
 
 
+void BVHAccel::buildChildren(MemoryArena &buildArena, BVHBuildState &state,
+        vector<BVHPrimitiveInfo> &buildData, uint32_t start, uint32_t mid,
+        uint32_t end, BVHBuildNode *children[2]) {
+    if (end - start < bvhTaskPrimitives) {
+        children[0] = recursiveBuild(buildArena, state, buildData, start, mid);
+        children[1] = recursiveBuild(buildArena, state, buildData, mid, end);
+        return;
+    }
+
+    // Build the first child in another task while this one builds the
+    // second, the children own disjoint ranges of _buildData_
+    BVHBuildTask *task = new BVHBuildTask(this, state, buildData, start, mid);
+    { MutexLock lock(*state.mutex);
+    state.tasks.push_back(task);
+    }
+    TaskGroup group;
+    group.Enqueue(task);
+    children[1] = recursiveBuild(buildArena, state, buildData, mid, end);
+    group.Wait();
+    children[0] = task->node;
+}
+
+
 uint32_t BVHAccel::flattenBVHTree(BVHBuildNode *node, uint32_t *offset) {
     LinearBVHNode *linearNode = &nodes[*offset];
     linearNode->bounds = node->bounds;
@@ -395,12 +656,88 @@ uint32_t BVHAccel::flattenBVHTree(BVHBuildNode *node, uint32_t *offset) {
 }
 
 
+uint32_t BVHAccel::collapseQBVH(uint32_t nodeNum,
+        vector<LinearQBVHNode> &qbvhNodes) const {
+    // Take the children of the binary node _nodeNum_ and of its interior
+    // children, a leaf child keeps a single slot
+    const uint32_t qnodeNum = qbvhNodes.size();
+    qbvhNodes.push_back(LinearQBVHNode());
+    LinearQBVHNode qnode;
+    const LinearBVHNode *node = &nodes[nodeNum];
+    if (node->nPrimitives > 0) {
+        // The whole tree is a single leaf
+        qnode.SetChild(0, *node);
+        qbvhNodes[qnodeNum] = qnode;
+        return qnodeNum;
+    }
+    qnode.axis[0] = node->axis;
+    const uint32_t halves[2] = { nodeNum + 1, node->secondChildOffset };
+    for (int h = 0; h < 2; ++h) {
+        const LinearBVHNode *half = &nodes[halves[h]];
+        if (half->nPrimitives > 0) {
+            qnode.SetChild(2 * h, *half);
+            continue;
+        }
+        qnode.axis[1 + h] = half->axis;
+        const uint32_t children[2] = { halves[h] + 1, half->secondChildOffset };
+        for (int c = 0; c < 2; ++c) {
+            const LinearBVHNode *child = &nodes[children[c]];
+            qnode.SetChild(2 * h + c, *child);
+            if (child->nPrimitives == 0)
+                qnode.children[2 * h + c] = collapseQBVH(children[c],
+                                                         qbvhNodes);
+        }
+    }
+    qbvhNodes[qnodeNum] = qnode;
+    return qnodeNum;
+}
+
+
 BVHAccel::~BVHAccel() {
     FreeAligned(nodes);
+    FreeAligned(qnodes);
+}
+
+
+inline const Primitive *BVHAccel::itemPrimitive(const BVHItem &item) const {
+    if (item.mesh == BVHItem::noMesh)
+        return primitives[item.index].GetPtr();
+    return meshes[item.mesh].primitive.GetPtr();
+}
+
+
+inline bool BVHAccel::intersectItem(const BVHItem &item, const Ray &ray,
+                                    Intersection *isect) const {
+    if (item.mesh == BVHItem::noMesh)
+        return primitives[item.index]->Intersect(ray, isect);
+    // Fill _isect_ as _GeometricPrimitive::Intersect()_ does for the mesh
+    const BVHMesh &m = meshes[item.mesh];
+    float thit, rayEpsilon;
+    if (!m.mesh->IntersectFace(item.index, ray, &thit, &rayEpsilon,
+                               &isect->dg, m.mesh))
+        return false;
+    isect->primitive = m.primitive.GetPtr();
+    isect->WorldToObject = *m.mesh->WorldToObject;
+    isect->ObjectToWorld = *m.mesh->ObjectToWorld;
+    isect->shapeId = m.mesh->shapeId;
+    isect->primitiveId = m.primitive->primitiveId;
+    isect->rayEpsilon = rayEpsilon;
+    ray.maxt = thit;
+    return true;
+}
+
+
+inline bool BVHAccel::intersectPItem(const BVHItem &item,
+                                     const Ray &ray) const {
+    if (item.mesh == BVHItem::noMesh)
+        return primitives[item.index]->IntersectP(ray);
+    const BVHMesh &m = meshes[item.mesh];
+    return m.mesh->IntersectPFace(item.index, ray, m.mesh);
 }
 
 
 bool BVHAccel::Intersect(const Ray &ray, Intersection *isect) const {
+    if (qnodes) return intersectQBVH(ray, isect);
     if (!nodes) return false;
     PBRT_BVH_INTERSECTION_STARTED(const_cast<BVHAccel *>(this), const_cast<Ray *>(&ray));
     bool hit = false;
@@ -418,14 +755,15 @@ bool BVHAccel::Intersect(const Ray &ray, Intersection *isect) const {
                 PBRT_BVH_INTERSECTION_TRAVERSED_LEAF_NODE(const_cast<LinearBVHNode *>(node));
                 for (uint32_t i = 0; i < node->nPrimitives; ++i)
                 {
-                    PBRT_BVH_INTERSECTION_PRIMITIVE_TEST(const_cast<Primitive *>(primitives[node->primitivesOffset+i].GetPtr()));
-                    if (primitives[node->primitivesOffset+i]->Intersect(ray, isect))
+                    const BVHItem &item = items[node->primitivesOffset+i];
+                    PBRT_BVH_INTERSECTION_PRIMITIVE_TEST(const_cast<Primitive *>(itemPrimitive(item)));
+                    if (intersectItem(item, ray, isect))
                     {
-                        PBRT_BVH_INTERSECTION_PRIMITIVE_HIT(const_cast<Primitive *>(primitives[node->primitivesOffset+i].GetPtr()));
+                        PBRT_BVH_INTERSECTION_PRIMITIVE_HIT(const_cast<Primitive *>(itemPrimitive(item)));
                         hit = true;
                     }
                     else {
-                        PBRT_BVH_INTERSECTION_PRIMITIVE_MISSED(const_cast<Primitive *>(primitives[node->primitivesOffset+i].GetPtr()));
+                        PBRT_BVH_INTERSECTION_PRIMITIVE_MISSED(const_cast<Primitive *>(itemPrimitive(item)));
                    }
                 }
                 if (todoOffset == 0) break;
@@ -455,6 +793,7 @@ bool BVHAccel::Intersect(const Ray &ray, Intersection *isect) const {
 
 
 bool BVHAccel::IntersectP(const Ray &ray) const {
+    if (qnodes) return intersectPQBVH(ray);
     if (!nodes) return false;
     PBRT_BVH_INTERSECTIONP_STARTED(const_cast<BVHAccel *>(this), const_cast<Ray *>(&ray));
     Vector invDir(1.f / ray.d.x, 1.f / ray.d.y, 1.f / ray.d.z);
@@ -468,13 +807,14 @@ bool BVHAccel::IntersectP(const Ray &ray) const {
             if (node->nPrimitives > 0) {
                 PBRT_BVH_INTERSECTIONP_TRAVERSED_LEAF_NODE(const_cast<LinearBVHNode *>(node));
                   for (uint32_t i = 0; i < node->nPrimitives; ++i) {
-                    PBRT_BVH_INTERSECTIONP_PRIMITIVE_TEST(const_cast<Primitive *>(primitives[node->primitivesOffset + i].GetPtr()));
-                    if (primitives[node->primitivesOffset+i]->IntersectP(ray)) {
-                        PBRT_BVH_INTERSECTIONP_PRIMITIVE_HIT(const_cast<Primitive *>(primitives[node->primitivesOffset+i].GetPtr()));
+                    const BVHItem &item = items[node->primitivesOffset+i];
+                    PBRT_BVH_INTERSECTIONP_PRIMITIVE_TEST(const_cast<Primitive *>(itemPrimitive(item)));
+                    if (intersectPItem(item, ray)) {
+                        PBRT_BVH_INTERSECTIONP_PRIMITIVE_HIT(const_cast<Primitive *>(itemPrimitive(item)));
                         return true;
                     }
                 else {
-                        PBRT_BVH_INTERSECTIONP_PRIMITIVE_MISSED(const_cast<Primitive *>(primitives[node->primitivesOffset + i].GetPtr()));
+                        PBRT_BVH_INTERSECTIONP_PRIMITIVE_MISSED(const_cast<Primitive *>(itemPrimitive(item)));
                     }
                 }
                 if (todoOffset == 0) break;
@@ -503,11 +843,107 @@ bool BVHAccel::IntersectP(const Ray &ray) const {
 }
 
 
+bool BVHAccel::intersectQBVH(const Ray &ray, Intersection *isect) const {
+    PBRT_BVH_INTERSECTION_STARTED(const_cast<BVHAccel *>(this), const_cast<Ray *>(&ray));
+    bool hit = false;
+    Vector invDir(1.f / ray.d.x, 1.f / ray.d.y, 1.f / ray.d.z);
+    uint32_t dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+    const QBVHRay qray(ray, invDir);
+    // Follow ray through the 4-wide nodes, the overlapped children are
+    // pushed from the farthest to the nearest
+    struct QBVHTodo { uint32_t offset, nPrimitives; };
+    QBVHTodo todo[128];
+    uint32_t todoOffset = 0;
+    todo[todoOffset].offset = 0;
+    todo[todoOffset++].nPrimitives = 0;
+    while (todoOffset > 0) {
+        const QBVHTodo entry = todo[--todoOffset];
+        if (entry.nPrimitives > 0) {
+            // Intersect ray with primitives in leaf
+            for (uint32_t i = 0; i < entry.nPrimitives; ++i) {
+                const BVHItem &item = items[entry.offset+i];
+                const Primitive *prim = itemPrimitive(item);
+                PBRT_BVH_INTERSECTION_PRIMITIVE_TEST(const_cast<Primitive *>(prim));
+                if (intersectItem(item, ray, isect)) {
+                    PBRT_BVH_INTERSECTION_PRIMITIVE_HIT(const_cast<Primitive *>(prim));
+                    hit = true;
+                }
+                else {
+                    PBRT_BVH_INTERSECTION_PRIMITIVE_MISSED(const_cast<Primitive *>(prim));
+                }
+            }
+            continue;
+        }
+        const LinearQBVHNode &node = qnodes[entry.offset];
+        const int mask = ::IntersectP(node, qray, dirIsNeg, ray.mint, ray.maxt);
+        if (!mask) continue;
+        int order[4];
+        OrderChildren(node, dirIsNeg, order);
+        for (int i = 3; i >= 0; --i) {
+            const int c = order[i];
+            if (mask & (1 << c)) {
+                todo[todoOffset].offset = node.children[c];
+                todo[todoOffset++].nPrimitives = node.nPrimitives[c];
+            }
+        }
+    }
+    PBRT_BVH_INTERSECTION_FINISHED();
+    return hit;
+}
+
+
+bool BVHAccel::intersectPQBVH(const Ray &ray) const {
+    PBRT_BVH_INTERSECTIONP_STARTED(const_cast<BVHAccel *>(this), const_cast<Ray *>(&ray));
+    Vector invDir(1.f / ray.d.x, 1.f / ray.d.y, 1.f / ray.d.z);
+    uint32_t dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+    const QBVHRay qray(ray, invDir);
+    struct QBVHTodo { uint32_t offset, nPrimitives; };
+    QBVHTodo todo[128];
+    uint32_t todoOffset = 0;
+    todo[todoOffset].offset = 0;
+    todo[todoOffset++].nPrimitives = 0;
+    while (todoOffset > 0) {
+        const QBVHTodo entry = todo[--todoOffset];
+        if (entry.nPrimitives > 0) {
+            for (uint32_t i = 0; i < entry.nPrimitives; ++i) {
+                const BVHItem &item = items[entry.offset+i];
+                const Primitive *prim = itemPrimitive(item);
+                PBRT_BVH_INTERSECTIONP_PRIMITIVE_TEST(const_cast<Primitive *>(prim));
+                if (intersectPItem(item, ray)) {
+                    PBRT_BVH_INTERSECTIONP_PRIMITIVE_HIT(const_cast<Primitive *>(prim));
+                    PBRT_BVH_INTERSECTIONP_FINISHED();
+                    return true;
+                }
+                else {
+                    PBRT_BVH_INTERSECTIONP_PRIMITIVE_MISSED(const_cast<Primitive *>(prim));
+                }
+            }
+            continue;
+        }
+        const LinearQBVHNode &node = qnodes[entry.offset];
+        const int mask = ::IntersectP(node, qray, dirIsNeg, ray.mint, ray.maxt);
+        if (!mask) continue;
+        int order[4];
+        OrderChildren(node, dirIsNeg, order);
+        for (int i = 3; i >= 0; --i) {
+            const int c = order[i];
+            if (mask & (1 << c)) {
+                todo[todoOffset].offset = node.children[c];
+                todo[todoOffset++].nPrimitives = node.nPrimitives[c];
+            }
+        }
+    }
+    PBRT_BVH_INTERSECTIONP_FINISHED();
+    return false;
+}
+
+
 BVHAccel *CreateBVHAccelerator(const vector<Reference<Primitive> > &prims,
         const ParamSet &ps) {
     string splitMethod = ps.FindOneString("splitmethod", "sah");
     uint32_t maxPrimsInNode = ps.FindOneInt("maxnodeprims", 4);
-    return new BVHAccel(prims, maxPrimsInNode, splitMethod);
+    string layout = ps.FindOneString("layout", "binary");
+    return new BVHAccel(prims, maxPrimsInNode, splitMethod, layout);
 }
 
 
@@ -43,14 +43,34 @@ struct BVHBuildNode;
 
 // BVHAccel Forward Declarations
 struct BVHPrimitiveInfo;
+struct BVHBuildState;
+struct BVHBuildTask;
 struct LinearBVHNode;
+struct LinearQBVHNode;
+class TriangleMesh;
+
+// A triangle mesh referenced in place by the BVH leaves
+struct BVHMesh {
+    BVHMesh(const Reference<Primitive> &p, const TriangleMesh *m)
+        : primitive(p), mesh(m) { }
+    Reference<Primitive> primitive;
+    const TriangleMesh *mesh;
+};
+
+// A BVH leaf entry, either a face of _meshes[mesh]_ or _primitives[index]_
+struct BVHItem {
+    static const uint32_t noMesh = 0xffffffff;
+    BVHItem() { }
+    BVHItem(uint32_t m, uint32_t i) : mesh(m), index(i) { }
+    uint32_t mesh, index;
+};
 
 // BVHAccel Declarations
 class BVHAccel : public Aggregate {
 public:
     // BVHAccel Public Methods
     BVHAccel(const vector<Reference<Primitive> > &p, uint32_t maxPrims = 1,
-             const string &sm = "sah");
+             const string &sm = "sah", const string &layout = "binary");
     BBox WorldBound() const;
     bool CanIntersect() const { return true; }
     ~BVHAccel();
@@ -58,17 +78,33 @@ public:
     bool IntersectP(const Ray &ray) const;
 private:
     // BVHAccel Private Methods
+    friend struct BVHBuildTask;
     BVHBuildNode *recursiveBuild(MemoryArena &buildArena,
-        vector<BVHPrimitiveInfo> &buildData, uint32_t start, uint32_t end,
-        uint32_t *totalNodes, vector<Reference<Primitive> > &orderedPrims);
+        BVHBuildState &state, vector<BVHPrimitiveInfo> &buildData,
+        uint32_t start, uint32_t end);
+    void buildChildren(MemoryArena &buildArena, BVHBuildState &state,
+        vector<BVHPrimitiveInfo> &buildData, uint32_t start, uint32_t mid,
+        uint32_t end, BVHBuildNode *children[2]);
     uint32_t flattenBVHTree(BVHBuildNode *node, uint32_t *offset);
+    uint32_t collapseQBVH(uint32_t nodeNum,
+                          vector<LinearQBVHNode> &qbvhNodes) const;
+    bool intersectQBVH(const Ray &ray, Intersection *isect) const;
+    bool intersectPQBVH(const Ray &ray) const;
+    inline const Primitive *itemPrimitive(const BVHItem &item) const;
+    inline bool intersectItem(const BVHItem &item, const Ray &ray,
+                              Intersection *isect) const;
+    inline bool intersectPItem(const BVHItem &item, const Ray &ray) const;
 
     // BVHAccel Private Data
     uint32_t maxPrimsInNode;
     enum SplitMethod { SPLIT_MIDDLE, SPLIT_EQUAL_COUNTS, SPLIT_SAH };
     SplitMethod splitMethod;
     vector<Reference<Primitive> > primitives;
+    vector<BVHMesh> meshes;
+    vector<BVHItem> items;
     LinearBVHNode *nodes;
+    LinearQBVHNode *qnodes; // The 4-wide layout, replaces _nodes_ if used
+    BBox bounds;
 };
 
 
@@ -131,6 +131,7 @@
 #include "shapes/loopsubdiv.h"
 #include "shapes/nurbs.h"
 #include "shapes/paraboloid.h"
+#include "shapes/plymesh.h"
 #include "shapes/rectangle.h"
 #include "shapes/sphere.h"
 #include "shapes/trianglemesh.h"
@@ -148,6 +149,7 @@
 #include "textures/wrinkled.h"
 #include "volumes/absorbing.h"
 #include "volumes/binarygrid.h"
+#include "volumes/brickedgrid.h"
 #include "volumes/annotatedgrid.h"
 #include "volumes/fluorescentbinarygrid.h"
 #include "volumes/exponential.h"
@@ -383,6 +385,9 @@ Reference<Shape> MakeShape(const string &name,
     else if (name == "trianglemesh")
         s = CreateTriangleMeshShape(object2world, world2object, reverseOrientation,
                                     paramSet, &graphicsState.floatTextures);
+    else if (name == "plymesh")
+        s = CreatePLYMeshShape(object2world, world2object, reverseOrientation,
+                               paramSet, &graphicsState.floatTextures);
     else if (name == "heightfield")
         s = CreateHeightfieldShape(object2world, world2object, reverseOrientation,
                                    paramSet);
@@ -607,6 +612,8 @@ VolumeRegion *MakeVolumeRegion(const string &name,
         vr = CreateVSDGridVolumeRegion(volume2world, paramSet);
     else if (name == "binaryvolumegrid")
         vr = CreateBinaryGridVolumeRegion(volume2world, paramSet);
+    else if (name == "brickedgrid")
+        vr = CreateBrickedGridVolumeRegion(volume2world, paramSet);
     else if (name == "annotatedgrid")
         vr = CreateAnnotatedVolumeGrid(volume2world, paramSet);
     else if (name == "exponential")
@@ -814,6 +821,13 @@ void pbrtInit(const Options &opt) {
     currentApiState = STATE_OPTIONS_BLOCK;
     renderOptions = new RenderOptions;
     graphicsState = GraphicsState();
+    if (opt.spectralSamples != 0 && !SetSpectralSamples(opt.spectralSamples))
+        Severe("Unable to sample the spectra with %d samples.",
+               opt.spectralSamples);
+    if ((opt.lambdaStart != 0 || opt.lambdaEnd != 0) &&
+        !SetSpectralRange(opt.lambdaStart, opt.lambdaEnd))
+        Severe("Unable to sample the spectra over [%d, %d] nm.",
+               opt.lambdaStart, opt.lambdaEnd);
     SampledSpectrum::Init();
 }
 
@@ -0,0 +1,211 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+// core/checkpoint.cpp*
+#include "stdafx.h"
+#include "checkpoint.h"
+#include "film.h"
+#include "parallel.h"
+#include "progressreporter.h"
+#include "sensor.h"
+#include "shard.h"
+#include "timer.h"
+
+// Checkpoint Local Declarations
+static const uint32_t checkpointVersion = 1;
+
+// Header of the snapshot files, followed by the stage name and the state
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t stageLength;
+    uint64_t key;
+    uint64_t nTasks;
+    uint64_t nFinished;
+};
+
+
+static bool WriteCheckpoint(const string &file, const string &stage,
+        uint64_t key, uint64_t nTasks, uint64_t nFinished,
+        CheckpointState *state) {
+    // Write the snapshot aside and move it over the previous one, so an
+    // interrupted write never loses the last good snapshot
+    const string tmpFile = file + ".tmp";
+    FILE *f = fopen(tmpFile.c_str(), "wb");
+    if (!f) return false;
+    CheckpointHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "PBRTCKPT", 8);
+    header.version = checkpointVersion;
+    header.stageLength = uint32_t(stage.size());
+    header.key = key;
+    header.nTasks = nTasks;
+    header.nFinished = nFinished;
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(stage.data(), 1, stage.size(), f) == stage.size() &&
+              state->Write(f);
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmpFile.c_str(), file.c_str()) != 0) {
+        remove(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+
+// Returns the number of tasks finished by the snapshot of _stage_, or -1 if
+// the snapshot belongs to another stage
+static int64_t ReadCheckpoint(const string &file, const string &stage,
+        uint64_t key, uint64_t nTasks, CheckpointState *state) {
+    FILE *f = fopen(file.c_str(), "rb");
+    if (!f) return 0;
+    CheckpointHeader header;
+    if (fread(&header, sizeof(header), 1, f) != 1 ||
+        memcmp(header.magic, "PBRTCKPT", 8) != 0 ||
+        header.version != checkpointVersion) {
+        fclose(f);
+        Severe("\"%s\" is not a checkpoint of this version of pbrt",
+               file.c_str());
+    }
+    string fileStage(header.stageLength, ' ');
+    if (header.stageLength > 0 &&
+        fread(&fileStage[0], 1, header.stageLength, f) != header.stageLength) {
+        fclose(f);
+        Severe("Checkpoint \"%s\" is truncated", file.c_str());
+    }
+    if (fileStage != stage) {
+        fclose(f);
+        return -1;
+    }
+    if (header.key != key || header.nTasks != nTasks) {
+        fclose(f);
+        Severe("Checkpoint \"%s\" of \"%s\" was written for a different scene",
+               file.c_str(), stage.c_str());
+    }
+    if (!state->Read(f)) {
+        fclose(f);
+        Severe("Checkpoint \"%s\" does not match the scene", file.c_str());
+    }
+    fclose(f);
+    return int64_t(header.nFinished);
+}
+
+
+// CheckpointState Method Definitions
+CheckpointState::~CheckpointState() {
+}
+
+
+bool SensorCheckpointState::Write(FILE *file) {
+    for (uint32_t i = 0; i < sensors.size(); ++i)
+        if (!sensors[i]->WriteCheckpoint(file)) return false;
+    return true;
+}
+
+
+bool SensorCheckpointState::Read(FILE *file) {
+    for (uint32_t i = 0; i < sensors.size(); ++i)
+        if (!sensors[i]->ReadCheckpoint(file)) return false;
+    return true;
+}
+
+
+bool FilmCheckpointState::Write(FILE *file) {
+    return film->WriteCheckpoint(file);
+}
+
+
+bool FilmCheckpointState::Read(FILE *file) {
+    return film->ReadCheckpoint(file);
+}
+
+
+// Checkpoint Function Definitions
+void RunTasksWithCheckpoints(const vector<Task *> &tasks, const string &stage,
+                             uint64_t key, CheckpointState *state,
+                             ProgressReporter &reporter,
+                             const std::function<void(uint64_t, uint64_t)>
+                                 &batchDone) {
+    bool checkpoint = state && !PbrtOptions.checkpointFile.empty();
+    if (!checkpoint && !batchDone) {
+        EnqueueTasks(tasks);
+        WaitForAllTasks();
+        return;
+    }
+    const string file = checkpoint ?
+        ShardFileName(PbrtOptions.checkpointFile) : string();
+
+    // Skip the tasks finished before the render was interrupted
+    uint64_t nFinished = 0;
+    if (checkpoint && PbrtOptions.resume) {
+        int64_t n = ReadCheckpoint(file, stage, key, tasks.size(), state);
+        if (n < 0) {
+            // The snapshot is for a later stage, leave it for that one
+            checkpoint = false;
+        }
+        else if (n > 0) {
+            nFinished = uint64_t(n);
+            reporter.Update(int(nFinished));
+            Info("Resuming \"%s\" after %llu of %llu tasks", stage.c_str(),
+                 (unsigned long long)nFinished,
+                 (unsigned long long)tasks.size());
+        }
+    }
+
+    // Run the tasks in batches, writing a snapshot between two batches
+    // whenever the interval has elapsed
+    const uint64_t batchSize = 8 * NumSystemCores();
+    Timer timer;
+    timer.Start();
+    while (nFinished < tasks.size()) {
+        const uint64_t end = min(nFinished + batchSize, uint64_t(tasks.size()));
+        EnqueueTasks(vector<Task *>(tasks.begin() + nFinished,
+                                    tasks.begin() + end));
+        WaitForAllTasks();
+        if (batchDone) batchDone(nFinished, end);
+        nFinished = end;
+        if (checkpoint && nFinished < tasks.size() &&
+            timer.Time() >= PbrtOptions.checkpointInterval) {
+            if (!WriteCheckpoint(file, stage, key, tasks.size(), nFinished,
+                                 state)) {
+                Warning("Unable to write checkpoint \"%s\", continuing "
+                        "without checkpoints", file.c_str());
+                checkpoint = false;
+            }
+            timer.Reset();
+            timer.Start();
+        }
+    }
+
+    // The results of the stage are written by the caller, the snapshot is
+    // no longer needed
+    if (checkpoint) remove(file.c_str());
+}
@@ -0,0 +1,130 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#ifndef PBRT_CORE_CHECKPOINT_H
+#define PBRT_CORE_CHECKPOINT_H
+
+// core/checkpoint.h*
+#include "pbrt.h"
+#include <stdio.h>
+#include <functional>
+class Sensor;
+class Task;
+
+// CheckpointState Declarations
+// The results a long render accumulates: saved in its snapshots and
+// restored when it is resumed.  Both methods return false on I/O errors or,
+// when reading, if the snapshot does not match the scene.
+class CheckpointState {
+public:
+    // CheckpointState Interface
+    virtual ~CheckpointState();
+    virtual bool Write(FILE *file) = 0;
+    virtual bool Read(FILE *file) = 0;
+};
+
+
+// SensorCheckpointState Declarations
+class SensorCheckpointState : public CheckpointState {
+public:
+    // SensorCheckpointState Public Methods
+    SensorCheckpointState(const vector<Sensor *> &sensors)
+        : sensors(sensors) { }
+    bool Write(FILE *file);
+    bool Read(FILE *file);
+private:
+    // SensorCheckpointState Private Data
+    vector<Sensor *> sensors;
+};
+
+
+// FilmCheckpointState Declarations
+class FilmCheckpointState : public CheckpointState {
+public:
+    // FilmCheckpointState Public Methods
+    FilmCheckpointState(Film *film) : film(film) { }
+    bool Write(FILE *file);
+    bool Read(FILE *file);
+private:
+    // FilmCheckpointState Private Data
+    Film *film;
+};
+
+
+// Checkpoint Utility Functions
+template <typename T>
+inline bool WriteCheckpointArray(FILE *file, const T *data, uint64_t n) {
+    return fwrite(&n, sizeof(n), 1, file) == 1 &&
+           (n == 0 || fwrite(data, sizeof(T), n, file) == n);
+}
+
+
+template <typename T>
+inline bool ReadCheckpointArray(FILE *file, T *data, uint64_t n) {
+    uint64_t count;
+    return fread(&count, sizeof(count), 1, file) == 1 && count == n &&
+           (n == 0 || fread(data, sizeof(T), n, file) == n);
+}
+
+
+template <typename T>
+inline bool WriteCheckpointVector(FILE *file, const vector<T> &v) {
+    return WriteCheckpointArray(file, v.empty() ? NULL : &v[0], v.size());
+}
+
+
+template <typename T>
+inline bool ReadCheckpointVector(FILE *file, vector<T> *v) {
+    uint64_t count;
+    if (fread(&count, sizeof(count), 1, file) != 1) return false;
+    v->resize(count);
+    return count == 0 || fread(&(*v)[0], sizeof(T), count, file) == count;
+}
+
+
+// Runs _tasks_ to completion.  With --checkpoint, the tasks are run in
+// batches and a snapshot of _state_ and of the number of finished tasks is
+// written whenever the checkpoint interval has elapsed; with --resume, the
+// tasks finished by a snapshot of the same _stage_ and _key_ are skipped.
+// The tasks must be independent of their scheduling for the resumed result
+// to match an uninterrupted run.  If _batchDone_ is given, the tasks are
+// always run in batches and it is called with the range of each batch once
+// all its tasks finished, before any snapshot is written.
+void RunTasksWithCheckpoints(const vector<Task *> &tasks, const string &stage,
+                             uint64_t key, CheckpointState *state,
+                             ProgressReporter &reporter,
+                             const std::function<void(uint64_t, uint64_t)>
+                                 &batchDone = nullptr);
+
+#endif // PBRT_CORE_CHECKPOINT_H
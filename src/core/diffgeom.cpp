@@ -47,6 +47,7 @@ DifferentialGeometry::DifferentialGeometry(const Point &P,
     u = uu;
     v = vv;
     shape = sh;
+    faceIndex = 0;
     dudx = dvdx = dudy = dvdy = 0;
 
     // Adjust normal based on orientation and handedness
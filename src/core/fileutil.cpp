@@ -33,9 +33,15 @@
 #include "fileutil.h"
 #include <cstdlib>
 #include <climits>
+#include <fstream>
+#include <algorithm>
 #ifndef PBRT_IS_WINDOWS
 #include <libgen.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #endif
 
 static string searchDirectory;
@@ -147,3 +153,91 @@ void RemoveString(string& s, const string& p) {
          i = s.find(p))
         s.erase(i, n);
 }
+
+
+MappedFile *MappedFile::Open(const string &filename) {
+    // The whole file, read once front to back
+    return Map(filename, ~uint64_t(0), true);
+}
+
+
+MappedFile *MappedFile::Open(const string &filename, uint64_t nBytes) {
+    // Exactly nBytes, paged in ahead and then accessed in any order
+    return Map(filename, nBytes, false);
+}
+
+
+MappedFile *MappedFile::Map(const string &filename, uint64_t nBytes,
+                            bool sequential) {
+#ifndef PBRT_IS_WINDOWS
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0)
+        return NULL;
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        close(fd);
+        return NULL;
+    }
+    const uint64_t size = uint64_t(fileStat.st_size);
+    if (nBytes != ~uint64_t(0) && size != nBytes) {
+        close(fd);
+        return NULL;
+    }
+    if (size == 0) {
+        close(fd);
+        return new MappedFile(NULL, 0, false);
+    }
+    void *ptr = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED)
+        return NULL;
+    madvise(ptr, size, sequential ? MADV_SEQUENTIAL : MADV_WILLNEED);
+    return new MappedFile((const uint8_t *)ptr, size, true);
+#else
+    std::ifstream stream(filename.c_str(), std::ios::in | std::ios::binary);
+    if (!stream.is_open())
+        return NULL;
+    stream.seekg(0, std::ios::end);
+    const uint64_t size = uint64_t(stream.tellg());
+    if (nBytes != ~uint64_t(0) && size != nBytes)
+        return NULL;
+    stream.seekg(0);
+    uint8_t *data = new uint8_t[size];
+    stream.read((char *)data, size);
+    return new MappedFile(data, size, false);
+#endif // PBRT_IS_WINDOWS
+}
+
+
+MappedFile::~MappedFile() {
+#ifndef PBRT_IS_WINDOWS
+    if (mapped)
+        munmap((void *)data, size);
+#else
+    delete[] data;
+#endif
+}
+
+
+void MappedFile::AdviseRandom() const {
+    // Once a volume has been scanned, voxels are fetched in ray order
+    // and read-ahead only evicts pages that are still in use
+#ifndef PBRT_IS_WINDOWS
+    if (mapped)
+        madvise((void *)data, size, MADV_RANDOM);
+#endif
+}
+
+
+void MappedFile::Prefetch(uint64_t offset, uint64_t nBytes) const {
+    // Ask for a range that is about to be streamed through; madvise() wants
+    // a page-aligned start
+#ifndef PBRT_IS_WINDOWS
+    if (!mapped || offset >= size)
+        return;
+    const uint64_t pageSize = uint64_t(sysconf(_SC_PAGESIZE));
+    const uint64_t start = offset - offset % pageSize;
+    const uint64_t end = std::min(offset + nBytes, size);
+    madvise((void *)(data + start), end - start, MADV_WILLNEED);
+#endif
+}
@@ -51,6 +51,33 @@ string DirectoryContaining(const string &filename);
 void SetSearchDirectory(const string &dirname);
 void RemoveString(string& s, const string& p);
 
+// A read-only file, memory-mapped where mmap() is available and read in
+// one go otherwise
+class MappedFile {
+public:
+    // MappedFile Public Methods
+    static MappedFile *Open(const string &filename);
+    static MappedFile *Open(const string &filename, uint64_t nBytes);
+    ~MappedFile();
+    const uint8_t *Data() const { return data; }
+    uint64_t Size() const { return size; }
+    void AdviseRandom() const;
+    void Prefetch(uint64_t offset, uint64_t nBytes) const;
+private:
+    // MappedFile Private Methods
+    static MappedFile *Map(const string &filename, uint64_t nBytes,
+                           bool sequential);
+    MappedFile(const uint8_t *d, uint64_t n, bool m)
+        : data(d), size(n), mapped(m) { }
+    MappedFile(const MappedFile &);
+    MappedFile &operator=(const MappedFile &);
+
+    // MappedFile Private Data
+    const uint8_t *data;
+    const uint64_t size;
+    const bool mapped;
+};
+
 
 #endif // PBRT_CORE_FILEUTIL_H
 
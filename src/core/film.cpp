@@ -36,12 +36,37 @@
 #include "paramset.h"
 
 // Film Method Definitions
+FilmTile::~FilmTile() {
+}
+
+
 Film::~Film() {
 }
 
 
+FilmTile *Film::GetFilmTile(int xstart, int xend, int ystart, int yend) {
+    return NULL;
+}
+
+
+void Film::MergeFilmTile(FilmTile *tile) {
+    delete tile;
+}
+
+
 void Film::UpdateDisplay(int x0, int y0, int x1, int y1,
                          float splatScale) {
 }
 
 
+bool Film::WriteCheckpoint(FILE *file) const {
+    // Films that cannot save their pixels are rendered without checkpoints
+    return false;
+}
+
+
+bool Film::ReadCheckpoint(FILE *file) {
+    return false;
+}
+
+
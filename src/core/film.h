@@ -39,6 +39,18 @@
 // core/film.h*
 #include "pbrt.h"
 
+// FilmTile Declarations
+// A _FilmTile_ accumulates the samples of a single rendering task into
+// private storage so that the task does not contend with other threads
+// for the film's pixels; _Film::MergeFilmTile()_ folds it back in once.
+class FilmTile {
+public:
+    virtual ~FilmTile();
+    virtual void AddSample(const CameraSample &sample,
+                           const Spectrum &L) = 0;
+};
+
+
 // Film Declarations
 class Film {
 public:
@@ -53,8 +65,13 @@ public:
                                  int *ystart, int *yend) const = 0;
     virtual void GetPixelExtent(int *xstart, int *xend,
                                 int *ystart, int *yend) const = 0;
+    virtual FilmTile *GetFilmTile(int xstart, int xend,
+                                  int ystart, int yend);
+    virtual void MergeFilmTile(FilmTile *tile);
     virtual void UpdateDisplay(int x0, int y0, int x1, int y1, float splatScale = 1.f);
     virtual void WriteImage(float splatScale = 1.f) = 0;
+    virtual bool WriteCheckpoint(FILE *file) const;
+    virtual bool ReadCheckpoint(FILE *file);
 
     // Film Public Data
     const int xResolution, yResolution;
@@ -0,0 +1,167 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+
+// core/herowavelength.cpp*
+#include "stdafx.h"
+#include "herowavelength.h"
+#include "volume.h"
+
+// HeroWavelengths Method Definitions
+HeroWavelengths::HeroWavelengths(float u, int n, bool e)
+    : emission(e) {
+    count = Clamp(n, 1, nHeroWavelengths);
+    // Rotate the hero sample over the range to place the companions
+    const float range = float(sampledLambdaEnd - sampledLambdaStart);
+    for (int i = 0; i < count; ++i) {
+        float ui = u + float(i) / float(count);
+        if (ui >= 1.f) ui -= 1.f;
+        lambda[i] = min(sampledLambdaStart + Floor2Int(ui * range),
+                        sampledLambdaEnd - 1);
+        weight[i] = 1.f;
+    }
+}
+
+
+float HeroWavelengths::Energy() const {
+    float energy = 0.f;
+    for (int i = 0; i < count; ++i)
+        energy += weight[i];
+    return energy / count;
+}
+
+
+void HeroWavelengths::Scale(const Spectrum &s) {
+    for (int i = 0; i < count; ++i)
+        weight[i] *= s.Power(lambda[i]);
+}
+
+
+void HeroWavelengths::Attenuate(const VolumeRegion *vr, const Ray &segment,
+                                float step, float offset) {
+    // Beer-Lambert attenuation of all the wavelengths along _segment_
+    for (int i = 0; i < count; ++i) {
+        if (weight[i] == 0.f) continue;
+        weight[i] *= expf(-Tau(vr, segment, step, offset, lambda[i]));
+    }
+}
+
+
+void HeroWavelengths::Transmit(const VolumeRegion *vr, const Ray &segment,
+                               float step, float offset) {
+    // The hero throughput is tracked analogically, only the companions are
+    // weighted by the ratio of their transmittance to the hero one
+    if (count == 1) return;
+    const float tauHero = Tau(vr, segment, step, offset, lambda[0]);
+    for (int i = 1; i < count; ++i) {
+        if (weight[i] == 0.f) continue;
+        const float tau = Tau(vr, segment, step, offset, lambda[i]);
+        weight[i] *= expf(tauHero - tau);
+    }
+}
+
+
+void HeroWavelengths::Survive(const VolumeRegion *vr, const Point &p,
+                              const Vector &w, float time) {
+    // The photon survived a roulette on the hero albedo at _p_, the
+    // companions are weighted by the ratio of their albedo to the hero one
+    if (count == 1) return;
+    const float sigmaTHero = Sigma_t(vr, p, w, time, lambda[0]);
+    const float albedoHero = sigmaTHero > 0.f ?
+        Sigma_s(vr, p, w, time, lambda[0]) / sigmaTHero : 0.f;
+    for (int i = 1; i < count; ++i) {
+        if (weight[i] == 0.f) continue;
+        const float sigmaT = Sigma_t(vr, p, w, time, lambda[i]);
+        if (albedoHero > 0.f && sigmaT > 0.f)
+            weight[i] *= Sigma_s(vr, p, w, time, lambda[i]) / sigmaT /
+                         albedoHero;
+        else
+            weight[i] = 0.f;
+    }
+}
+
+
+void HeroWavelengths::Collide(const VolumeRegion *vr, const Point &p,
+                              const Vector &w, float time) {
+    // A collision was sampled at _p_ with the hero extinction, the
+    // transmittance up to it is reweighted by Transmit()
+    if (count == 1) return;
+    const float sigmaHero = Sigma_t(vr, p, w, time, lambda[0]);
+    for (int i = 1; i < count; ++i) {
+        if (sigmaHero > 0.f)
+            weight[i] *= Sigma_t(vr, p, w, time, lambda[i]) / sigmaHero;
+        else
+            weight[i] = 0.f;
+    }
+}
+
+
+// A collision followed by a scattering at the same point, the extinction
+// of Collide() cancels against the albedo of Survive()
+void HeroWavelengths::Scatter(const VolumeRegion *vr, const Point &p,
+                              const Vector &w, float time) {
+    if (count == 1) return;
+    const float sigmaHero = Sigma_s(vr, p, w, time, lambda[0]);
+    for (int i = 1; i < count; ++i) {
+        if (sigmaHero > 0.f)
+            weight[i] *= Sigma_s(vr, p, w, time, lambda[i]) / sigmaHero;
+        else
+            weight[i] = 0.f;
+    }
+}
+
+
+bool HeroWavelengths::IsBlack() const {
+    for (int i = 0; i < count; ++i)
+        if (weight[i] != 0.f) return false;
+    return true;
+}
+
+
+float HeroWavelengths::Sigma_s(const VolumeRegion *vr, const Point &p,
+                               const Vector &w, float time, int wl) const {
+    return emission ? vr->Sigma_sf(p, w, time, wl) :
+                      vr->Sigma_s(p, w, time, wl);
+}
+
+
+float HeroWavelengths::Sigma_t(const VolumeRegion *vr, const Point &p,
+                               const Vector &w, float time, int wl) const {
+    return emission ? vr->Sigma_tf(p, w, time, wl) :
+                      vr->Sigma_t(p, w, time, wl);
+}
+
+
+float HeroWavelengths::Tau(const VolumeRegion *vr, const Ray &segment,
+                           float step, float offset, int wl) const {
+    return emission ? vr->tauLambda_f(segment, step, offset, wl) :
+                      vr->tauLambda(segment, step, offset, wl);
+}
@@ -0,0 +1,92 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#ifndef PBRT_CORE_HEROWAVELENGTH_H
+#define PBRT_CORE_HEROWAVELENGTH_H
+
+// core/herowavelength.h*
+#include "pbrt.h"
+#include "spectrum.h"
+
+// Maximum number of wavelengths carried by a single photon
+static const int nHeroWavelengths = 4;
+
+// HeroWavelengths Declarations
+// A photon carries a hero wavelength that drives all the sampling decisions
+// and a few companion wavelengths, stratified over the spectral range, whose
+// scalar throughputs are reweighted against the hero one.  Emitted photons
+// are transported with the emission band (the _f_ coefficients) of the
+// medium.
+class HeroWavelengths {
+public:
+    // HeroWavelengths Public Methods
+    explicit HeroWavelengths(float u, int n = nHeroWavelengths,
+                             bool emission = false);
+    int Count() const { return count; }
+    int Hero() const { return lambda[0]; }
+    int Wavelength(int i) const { return lambda[i]; }
+    float Weight(int i) const { return weight[i]; }
+    float Energy() const;
+    void Scale(const Spectrum &s);
+    void Attenuate(const VolumeRegion *vr, const Ray &segment, float step,
+        float offset);
+    void Transmit(const VolumeRegion *vr, const Ray &segment, float step,
+        float offset);
+    void Survive(const VolumeRegion *vr, const Point &p, const Vector &w,
+        float time);
+    void Collide(const VolumeRegion *vr, const Point &p, const Vector &w,
+        float time);
+    void Scatter(const VolumeRegion *vr, const Point &p, const Vector &w,
+        float time);
+    bool IsBlack() const;
+
+private:
+    // HeroWavelengths Private Methods
+    float Sigma_s(const VolumeRegion *vr, const Point &p, const Vector &w,
+        float time, int wl) const;
+    float Sigma_t(const VolumeRegion *vr, const Point &p, const Vector &w,
+        float time, int wl) const;
+    float Tau(const VolumeRegion *vr, const Ray &segment, float step,
+        float offset, int wl) const;
+
+    // HeroWavelengths Private Data
+    bool emission;
+    int count;
+    int lambda[nHeroWavelengths];
+    float weight[nHeroWavelengths];
+};
+
+
+#endif // PBRT_CORE_HEROWAVELENGTH_H
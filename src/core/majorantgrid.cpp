@@ -0,0 +1,100 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+
+// core/majorantgrid.cpp*
+#include "stdafx.h"
+#include "majorantgrid.h"
+
+// MajorantGrid Method Definitions
+MajorantGrid::MajorantGrid(const BBox &e, uint64 nx, uint64 ny, uint64 nz,
+                           int shift)
+    : extent(e), cellShift(shift) {
+    nVoxels[0] = nx; nVoxels[1] = ny; nVoxels[2] = nz;
+    for (int axis = 0; axis < 3; ++axis) {
+        nCells[axis] = (nVoxels[axis] + (uint64(1) << cellShift) - 1) >> cellShift;
+        cellWidth[axis] = (extent.pMax[axis] - extent.pMin[axis]) *
+                          (uint64(1) << cellShift) / nVoxels[axis];
+    }
+    cellMin = new float[CellCount()];
+    cellMax = new float[CellCount()];
+    minValue = maxValue = 0.f;
+}
+
+
+MajorantGrid::~MajorantGrid() {
+    delete[] cellMin;
+    delete[] cellMax;
+}
+
+
+uint64 MajorantGrid::CellOrigin(uint64 cell, int axis) const {
+    switch (axis) {
+    case 0: return (cell % nCells[0]) << cellShift;
+    case 1: return ((cell / nCells[0]) % nCells[1]) << cellShift;
+    default: return (cell / (nCells[0] * nCells[1])) << cellShift;
+    }
+}
+
+
+
+// MajorantWalker Method Definitions
+MajorantWalker::MajorantWalker(const MajorantGrid &g, const Ray &ray,
+                               float tMin, float tMax)
+    : grid(g), t(tMin), tEnd(tMax) {
+    const Point p = ray(tMin);
+    for (int axis = 0; axis < 3; ++axis) {
+        const float width = grid.cellWidth[axis];
+        const float offset = (p[axis] - grid.extent.pMin[axis]) / width;
+        pos[axis] = Clamp(Floor2Int(offset), 0, int(grid.nCells[axis]) - 1);
+        const float edge = grid.extent.pMin[axis] + pos[axis] * width;
+        if (ray.d[axis] > 0.f) {
+            nextT[axis] = tMin + (edge + width - p[axis]) / ray.d[axis];
+            deltaT[axis] = width / ray.d[axis];
+            step[axis] = 1;
+            out[axis] = int(grid.nCells[axis]);
+        }
+        else if (ray.d[axis] < 0.f) {
+            nextT[axis] = tMin + (edge - p[axis]) / ray.d[axis];
+            deltaT[axis] = -width / ray.d[axis];
+            step[axis] = -1;
+            out[axis] = -1;
+        }
+        else {
+            nextT[axis] = INFINITY;
+            deltaT[axis] = INFINITY;
+            step[axis] = 0;
+            out[axis] = -1;
+        }
+    }
+}
+
+
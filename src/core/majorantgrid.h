@@ -0,0 +1,173 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#ifndef PBRT_CORE_MAJORANTGRID_H
+#define PBRT_CORE_MAJORANTGRID_H
+
+// core/majorantgrid.h*
+#include "pbrt.h"
+#include "geometry.h"
+#include "parallel.h"
+#include "rng.h"
+
+// MajorantGrid Declarations
+
+// Coarse grid over a voxel volume holding the density range of every cell
+// of 2^shift voxels on a side. The range includes the one voxel apron that
+// trilinear lookups inside the cell reach into, so the maximum bounds the
+// interpolated density anywhere in the cell.
+class MajorantGrid {
+public:
+    // MajorantGrid Public Methods
+    MajorantGrid(const BBox &e, uint64 nx, uint64 ny, uint64 nz, int shift);
+    ~MajorantGrid();
+    template <typename VoxelFunc> void Build(VoxelFunc voxel);
+    uint64 CellCount() const { return nCells[0] * nCells[1] * nCells[2]; }
+    uint64 CellIndex(uint64 cx, uint64 cy, uint64 cz) const {
+        return (cz * nCells[1] + cy) * nCells[0] + cx;
+    }
+    uint64 CellOrigin(uint64 cell, int axis) const;
+    float Min(uint64 cell) const { return cellMin[cell]; }
+    float Max(uint64 cell) const { return cellMax[cell]; }
+    float Max() const { return maxValue; }
+    float Min() const { return minValue; }
+    template <typename DensityFunc>
+    bool Track(const Ray &rayObj, float tMin, float tMax, float sigmaScale,
+               DensityFunc density, RNG &rng, float *tHit,
+               float *densityHit) const;
+private:
+    // MajorantGrid Private Data
+    friend class MajorantWalker;
+    const BBox extent;
+    const int cellShift;
+    uint64 nVoxels[3], nCells[3];
+    Vector cellWidth;
+    float *cellMin, *cellMax;
+    float minValue, maxValue;
+};
+
+
+// MajorantWalker Declarations
+
+// Walks the cells of a MajorantGrid pierced by an object space ray in
+// front-to-back order
+class MajorantWalker {
+public:
+    // MajorantWalker Public Methods
+    MajorantWalker(const MajorantGrid &g, const Ray &ray, float tMin,
+                   float tMax);
+    bool Next(uint64 *cell, float *t0, float *t1) {
+        if (t >= tEnd) return false;
+        *cell = grid.CellIndex(pos[0], pos[1], pos[2]);
+        const int axis = (nextT[0] < nextT[1]) ?
+            ((nextT[0] < nextT[2]) ? 0 : 2) : ((nextT[1] < nextT[2]) ? 1 : 2);
+        *t0 = t;
+        *t1 = min(nextT[axis], tEnd);
+        t = nextT[axis];
+        pos[axis] += step[axis];
+        if (pos[axis] == out[axis])
+            t = tEnd;
+        nextT[axis] += deltaT[axis];
+        return true;
+    }
+private:
+    // MajorantWalker Private Data
+    const MajorantGrid &grid;
+    int pos[3], step[3], out[3];
+    float nextT[3], deltaT[3];
+    float t, tEnd;
+};
+
+
+
+// MajorantGrid Inline Functions
+template <typename VoxelFunc> void MajorantGrid::Build(VoxelFunc voxel) {
+    const uint64 cellSize = uint64(1) << cellShift;
+    const uint64 nx = nVoxels[0], ny = nVoxels[1], nz = nVoxels[2];
+    ParallelFor(0, CellCount(), 0, [&](int64_t cell) {
+        const uint64 x0 = CellOrigin(cell, 0);
+        const uint64 y0 = CellOrigin(cell, 1);
+        const uint64 z0 = CellOrigin(cell, 2);
+        float lo = INFINITY, hi = -INFINITY;
+        for (uint64 k = max(z0, uint64(1)) - 1; k <= min(z0 + cellSize, nz - 1); ++k)
+            for (uint64 j = max(y0, uint64(1)) - 1; j <= min(y0 + cellSize, ny - 1); ++j)
+                for (uint64 i = max(x0, uint64(1)) - 1; i <= min(x0 + cellSize, nx - 1); ++i) {
+                    const float value = voxel((k * ny + j) * nx + i);
+                    lo = min(lo, value);
+                    hi = max(hi, value);
+                }
+        cellMin[cell] = lo;
+        cellMax[cell] = hi;
+    });
+    minValue = INFINITY;
+    maxValue = -INFINITY;
+    for (uint64 cell = 0; cell < CellCount(); ++cell) {
+        minValue = min(minValue, cellMin[cell]);
+        maxValue = max(maxValue, cellMax[cell]);
+    }
+}
+
+
+template <typename DensityFunc>
+bool MajorantGrid::Track(const Ray &rayObj, float tMin, float tMax,
+        float sigmaScale, DensityFunc density, RNG &rng, float *tHit,
+        float *densityHit) const {
+    // Delta tracking against the maximum density of each cell; cells with
+    // no density have a zero majorant and are crossed without sampling
+    MajorantWalker walker(*this, rayObj, tMin, tMax);
+    uint64 cell;
+    float t0, t1;
+    while (walker.Next(&cell, &t0, &t1)) {
+        const float majorant = cellMax[cell] * sigmaScale;
+        if (majorant <= 0.f) continue;
+        float t = t0;
+        while (true) {
+            t -= logf(1 - rng.RandomFloat()) / majorant;
+            if (t >= t1)
+                break;
+            const float d = density(rayObj(t));
+            if (rng.RandomFloat() * cellMax[cell] < d) {
+                *tHit = t;
+                *densityHit = d;
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+
+#endif // PBRT_CORE_MAJORANTGRID_H
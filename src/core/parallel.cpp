@@ -47,6 +47,8 @@
 #include <errno.h>
 #endif 
 #include <list>
+#include <atomic>
+#include <thread>
 
 // Parallel Local Declarations
 #if defined(PBRT_IS_WINDOWS)
@@ -56,16 +58,82 @@ static pthread_t *threads;
 #endif 
 #ifdef PBRT_USE_GRAND_CENTRAL_DISPATCH
 static dispatch_queue_t gcdQueue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
-static dispatch_group_t gcdGroup = dispatch_group_create();
 #else
-static Mutex *taskQueueMutex = Mutex::Create();
-static std::vector<Task *> taskQueue;
+// TaskDeque Declarations
+
+// Chase-Lev work-stealing deque: the owning worker pushes and pops at the
+// bottom without locking while other workers steal from the top
+class TaskDeque {
+public:
+    // TaskDeque Public Methods
+    TaskDeque() : top(0), bottom(0) {
+        array.store(new Array(1024), std::memory_order_relaxed);
+    }
+    ~TaskDeque() {
+        delete array.load(std::memory_order_relaxed);
+        for (uint32_t i = 0; i < retired.size(); ++i)
+            delete retired[i];
+    }
+    void Push(Task *task);
+    Task *Pop();
+    Task *Steal();
+private:
+    // TaskDeque Private Types
+    struct Array {
+        Array(int64_t n) : size(n), tasks(new std::atomic<Task *>[n]) { }
+        ~Array() { delete[] tasks; }
+        Task *Get(int64_t i) const {
+            return tasks[i & (size - 1)].load(std::memory_order_relaxed);
+        }
+        void Put(int64_t i, Task *task) {
+            tasks[i & (size - 1)].store(task, std::memory_order_relaxed);
+        }
+        const int64_t size;
+        std::atomic<Task *> *tasks;
+    };
+
+    // TaskDeque Private Data
+    std::atomic<int64_t> top;
+    char pad[PBRT_L1_CACHE_LINE_SIZE];
+    std::atomic<int64_t> bottom;
+    std::atomic<Array *> array;
+    vector<Array *> retired;
+};
+
+
 #endif // PBRT_USE_GRAND_CENTRAL_DISPATCH
+
+// TaskWorker Declarations
+struct TaskWorker {
+    static void Execute(Task *task);
 #ifndef PBRT_USE_GRAND_CENTRAL_DISPATCH
+    TaskWorker() : inboxMutex(Mutex::Create()), inboxSize(0) { }
+    ~TaskWorker() { Mutex::Destroy(inboxMutex); }
+    Task *NextTask();
+    Task *StealTask();
+    static void Loop(int index);
+
+    // Tasks enqueued by threads outside the pool are mailed to a worker,
+    // which moves them onto its deque where the others can steal them
+    TaskDeque deque;
+    Mutex *inboxMutex;
+    vector<Task *> inbox;
+    AtomicInt32 inboxSize;
+    uint32_t victimSeed;
+    char pad[PBRT_L1_CACHE_LINE_SIZE];
+#endif // !PBRT_USE_GRAND_CENTRAL_DISPATCH
+};
+
+
+#ifndef PBRT_USE_GRAND_CENTRAL_DISPATCH
+static TaskWorker *workers;
+static int nWorkers;
+static thread_local int workerIndex = -1;
+static AtomicInt32 nextInbox;
 static Semaphore *workerSemaphore;
-static uint32_t numUnfinishedTasks;
-static ConditionVariable *tasksRunningCondition;
-#endif // PBRT_USE_GRAND_CENTRAL_DISPATCH
+static volatile bool shutdownWorkers;
+#endif // !PBRT_USE_GRAND_CENTRAL_DISPATCH
+static ConditionVariable *taskGroupCondition = new ConditionVariable;
 #ifndef PBRT_USE_GRAND_CENTRAL_DISPATCH
 static
 #if defined(PBRT_IS_WINDOWS)
@@ -629,6 +697,15 @@ void ConditionVariable::Signal() {
 }
 
 
+#endif // !PBRT_IS_WINDOWS
+#if !defined(PBRT_IS_WINDOWS)
+void ConditionVariable::Broadcast() {
+    int err;
+    if ((err = pthread_cond_broadcast(&cond)) != 0)
+        Severe("Error from pthread_cond_broadcast: %s", strerror(err));
+}
+
+
 #endif // !PBRT_IS_WINDOWS
 #if defined(PBRT_IS_WINDOWS)
 
@@ -718,6 +795,18 @@ void ConditionVariable::Signal() {
 }
 
 
+#endif // PBRT_IS_WINDOWS
+#if defined(PBRT_IS_WINDOWS)
+void ConditionVariable::Broadcast() {
+    EnterCriticalSection(&waitersCountMutex);
+    int haveWaiters = (waitersCount > 0);
+    LeaveCriticalSection(&waitersCountMutex);
+
+    if (haveWaiters)
+        SetEvent(events[BROADCAST]);
+}
+
+
 #endif // PBRT_IS_WINDOWS
 void TasksInit() {
     if (PbrtOptions.nCores == 1)
@@ -726,8 +815,12 @@ void TasksInit() {
     return;
 #else // PBRT_USE_GRAND_CENTRAL_DISPATCH
     static const int nThreads = NumSystemCores();
+    nWorkers = nThreads;
+    workers = new TaskWorker[nThreads];
+    for (int i = 0; i < nThreads; ++i)
+        workers[i].victimSeed = 2654435761u * uint32_t(i + 1);
     workerSemaphore = new Semaphore;
-    tasksRunningCondition = new ConditionVariable;
+    shutdownWorkers = false;
 #if !defined(PBRT_IS_WINDOWS)
     threads = new pthread_t[nThreads];
     for (int i = 0; i < nThreads; ++i) {
@@ -753,15 +846,12 @@ void TasksCleanup() {
 #ifdef PBRT_USE_GRAND_CENTRAL_DISPATCH
     return;
 #else // // PBRT_USE_GRAND_CENTRAL_DISPATCH
-    if (!taskQueueMutex || !workerSemaphore)
+    if (!workers || !workerSemaphore)
         return;
-    { MutexLock lock(*taskQueueMutex);
-    Assert(taskQueue.size() == 0);
-    }
 
     static const int nThreads = NumSystemCores();
-    if (workerSemaphore != NULL)
-        workerSemaphore->Post(nThreads);
+    shutdownWorkers = true;
+    workerSemaphore->Post(nThreads);
 
     if (threads != NULL) {
 #if !defined(PBRT_IS_WINDOWS)
@@ -779,6 +869,12 @@ void TasksCleanup() {
         delete[] threads;
         threads = NULL;
     }
+    for (int i = 0; i < nWorkers; ++i)
+        Assert(workers[i].inbox.size() == 0);
+    delete[] workers;
+    workers = NULL;
+    delete workerSemaphore;
+    workerSemaphore = NULL;
 #endif // PBRT_USE_GRAND_CENTRAL_DISPATCH
 }
 
@@ -787,69 +883,251 @@ Task::~Task() {
 }
 
 
-#ifdef PBRT_USE_GRAND_CENTRAL_DISPATCH
-static void lRunTask(void *t) {
-    Task *task = (Task *)t;
+#ifndef PBRT_USE_GRAND_CENTRAL_DISPATCH
+void TaskDeque::Push(Task *task) {
+    int64_t b = bottom.load(std::memory_order_relaxed);
+    int64_t t = top.load(std::memory_order_acquire);
+    Array *a = array.load(std::memory_order_relaxed);
+    if (b - t > a->size - 1) {
+        // Grow the array; thieves may still be reading the old one, so it
+        // is kept around until the deque goes away
+        Array *grown = new Array(2 * a->size);
+        for (int64_t i = t; i < b; ++i)
+            grown->Put(i, a->Get(i));
+        retired.push_back(a);
+        array.store(grown, std::memory_order_release);
+        a = grown;
+    }
+    a->Put(b, task);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom.store(b + 1, std::memory_order_relaxed);
+}
+
+
+Task *TaskDeque::Pop() {
+    int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+    Array *a = array.load(std::memory_order_relaxed);
+    bottom.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t t = top.load(std::memory_order_relaxed);
+    if (t > b) {
+        // Deque was empty
+        bottom.store(b + 1, std::memory_order_relaxed);
+        return NULL;
+    }
+    Task *task = a->Get(b);
+    if (t == b) {
+        // Last task; race any thieves for it
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed))
+            task = NULL;
+        bottom.store(b + 1, std::memory_order_relaxed);
+    }
+    return task;
+}
+
+
+Task *TaskDeque::Steal() {
+    int64_t t = top.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    int64_t b = bottom.load(std::memory_order_acquire);
+    if (t >= b)
+        return NULL;
+    Array *a = array.load(std::memory_order_acquire);
+    Task *task = a->Get(t);
+    if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                     std::memory_order_relaxed))
+        return NULL;
+    return task;
+}
+
+
+#endif // !PBRT_USE_GRAND_CENTRAL_DISPATCH
+void TaskWorker::Execute(Task *task) {
+    TaskGroup *group = task->group;
     PBRT_STARTED_TASK(task);
     task->Run();
     PBRT_FINISHED_TASK(task);
+    if (AtomicAdd(&group->nUnfinished, -1) == 0) {
+        taskGroupCondition->Lock();
+        taskGroupCondition->Broadcast();
+        taskGroupCondition->Unlock();
+    }
+}
+
+
+#ifndef PBRT_USE_GRAND_CENTRAL_DISPATCH
+Task *TaskWorker::NextTask() {
+    // Run the most recently pushed task of this worker first
+    Task *task = deque.Pop();
+    if (task) return task;
+
+    // Move any tasks mailed to this worker onto its deque
+    if (inboxSize > 0) {
+        vector<Task *> mail;
+        { MutexLock lock(*inboxMutex);
+        mail.swap(inbox);
+        inboxSize = 0;
+        }
+        if (mail.size() > 0) {
+            for (uint32_t i = mail.size() - 1; i > 0; --i)
+                deque.Push(mail[i]);
+            return mail[0];
+        }
+    }
+    return StealTask();
+}
+
+
+Task *TaskWorker::StealTask() {
+    // Visit the other workers starting from a random one
+    victimSeed ^= victimSeed << 13;
+    victimSeed ^= victimSeed >> 17;
+    victimSeed ^= victimSeed << 5;
+    const int start = victimSeed % nWorkers;
+    for (int i = 0; i < nWorkers; ++i) {
+        TaskWorker &victim = workers[(start + i) % nWorkers];
+        if (&victim == this) continue;
+        Task *task = victim.deque.Steal();
+        if (task) return task;
+        if (victim.inboxSize > 0) {
+            MutexLock lock(*victim.inboxMutex);
+            if (victim.inbox.size() > 0) {
+                task = victim.inbox.back();
+                victim.inbox.pop_back();
+                victim.inboxSize = victim.inbox.size();
+                return task;
+            }
+        }
+    }
+    return NULL;
+}
+
+
+void TaskWorker::Loop(int index) {
+    workerIndex = index;
+    TaskWorker &worker = workers[index];
+    while (true) {
+        Task *task = worker.NextTask();
+        if (task) {
+            Execute(task);
+            continue;
+        }
+        // Nothing left to run or steal; sleep until more tasks arrive
+        workerSemaphore->Wait();
+        if (shutdownWorkers)
+            break;
+    }
+}
+
+
+#endif // !PBRT_USE_GRAND_CENTRAL_DISPATCH
+#ifdef PBRT_USE_GRAND_CENTRAL_DISPATCH
+static void lRunTask(void *t) {
+    TaskWorker::Execute((Task *)t);
 }
 
 
 #endif
-void EnqueueTasks(const vector<Task *> &tasks) {
+TaskGroup::TaskGroup() {
+    nUnfinished = 0;
+}
+
+
+TaskGroup::~TaskGroup() {
+    Wait();
+}
+
+
+void TaskGroup::Enqueue(Task *task) {
+    Enqueue(vector<Task *>(1, task));
+}
+
+
+void TaskGroup::Enqueue(const vector<Task *> &tasks) {
+    if (tasks.size() == 0)
+        return;
+    for (uint32_t i = 0; i < tasks.size(); ++i)
+        tasks[i]->group = this;
+    AtomicAdd(&nUnfinished, int32_t(tasks.size()));
     if (PbrtOptions.nCores == 1) {
-        for (unsigned int i = 0; i < tasks.size(); ++i)
-            tasks[i]->Run();
+        for (uint32_t i = 0; i < tasks.size(); ++i)
+            TaskWorker::Execute(tasks[i]);
         return;
     }
 #ifdef PBRT_USE_GRAND_CENTRAL_DISPATCH
     for (uint32_t i = 0; i < tasks.size(); ++i)
-        dispatch_group_async_f(gcdGroup, gcdQueue, tasks[i], lRunTask);
+        dispatch_async_f(gcdQueue, tasks[i], lRunTask);
 #else
     if (!threads)
         TasksInit();
 
-    { MutexLock lock(*taskQueueMutex);
-    for (unsigned int i = 0; i < tasks.size(); ++i)
-        taskQueue.push_back(tasks[i]);
+    if (workerIndex >= 0) {
+        // Spawned from a running task: keep them local, idle workers steal
+        TaskDeque &deque = workers[workerIndex].deque;
+        for (uint32_t i = 0; i < tasks.size(); ++i)
+            deque.Push(tasks[i]);
     }
-    tasksRunningCondition->Lock();
-    numUnfinishedTasks += tasks.size();
-    tasksRunningCondition->Unlock();
-
-    workerSemaphore->Post(tasks.size());
+    else {
+        // Deal the tasks out to the workers' inboxes in contiguous runs
+        const int first = AtomicAdd(&nextInbox, 1) - 1;
+        const uint32_t nTasks = tasks.size();
+        for (int w = 0; w < nWorkers; ++w) {
+            const uint32_t begin = (uint64_t(nTasks) * w) / nWorkers;
+            const uint32_t end = (uint64_t(nTasks) * (w + 1)) / nWorkers;
+            if (begin == end) continue;
+            TaskWorker &worker = workers[(first + w) % nWorkers];
+            MutexLock lock(*worker.inboxMutex);
+            worker.inbox.insert(worker.inbox.end(), tasks.begin() + begin,
+                                tasks.begin() + end);
+            worker.inboxSize = worker.inbox.size();
+        }
+    }
+    workerSemaphore->Post(min(int(tasks.size()), nWorkers));
 #endif
 }
 
 
+void TaskGroup::Wait() {
+#ifndef PBRT_USE_GRAND_CENTRAL_DISPATCH
+    if (workerIndex >= 0) {
+        // Waiting inside a task: run other tasks instead of blocking a worker
+        TaskWorker &worker = workers[workerIndex];
+        while (nUnfinished > 0) {
+            Task *task = worker.NextTask();
+            if (task)
+                TaskWorker::Execute(task);
+            else
+                std::this_thread::yield();
+        }
+        return;
+    }
+#endif // !PBRT_USE_GRAND_CENTRAL_DISPATCH
+    taskGroupCondition->Lock();
+    while (nUnfinished > 0)
+        taskGroupCondition->Wait();
+    taskGroupCondition->Unlock();
+}
+
+
+static TaskGroup *DefaultTaskGroup() {
+    static TaskGroup *group = new TaskGroup;
+    return group;
+}
+
+
+void EnqueueTasks(const vector<Task *> &tasks) {
+    DefaultTaskGroup()->Enqueue(tasks);
+}
+
+
 #ifndef PBRT_USE_GRAND_CENTRAL_DISPATCH
 #if defined(PBRT_IS_WINDOWS)
 static DWORD WINAPI taskEntry(LPVOID arg) {
 #else
 static void *taskEntry(void *arg) {
 #endif
-    while (true) {
-        workerSemaphore->Wait();
-        // Try to get task from task queue
-        Task *myTask = NULL;
-        { MutexLock lock(*taskQueueMutex);
-        if (taskQueue.size() == 0)
-            break;
-        myTask = taskQueue.back();
-        taskQueue.pop_back();
-        }
-
-        // Do work for _myTask_
-        PBRT_STARTED_TASK(myTask);
-        myTask->Run();
-        PBRT_FINISHED_TASK(myTask);
-        tasksRunningCondition->Lock();
-        int unfinished = --numUnfinishedTasks;
-        if (unfinished == 0)
-            tasksRunningCondition->Signal();
-        tasksRunningCondition->Unlock();
-    }
+    TaskWorker::Loop(int(reinterpret_cast<intptr_t>(arg)));
     // Cleanup from task thread and exit
 #if !defined(PBRT_IS_WINDOWS)
     pthread_exit(NULL);
@@ -860,18 +1138,85 @@ static void *taskEntry(void *arg) {
 
 #endif // !PBRT_USE_GRAND_CENTRAL_DISPATCH
 void WaitForAllTasks() {
-    if (PbrtOptions.nCores == 1)
-        return; // enqueue just runs them immediately in this case
-#ifdef PBRT_USE_GRAND_CENTRAL_DISPATCH
-    dispatch_group_wait(gcdGroup, DISPATCH_TIME_FOREVER);
-#else
-    if (!tasksRunningCondition)
-        return;  // no tasks have been enqueued, so TasksInit() never called
-    tasksRunningCondition->Lock();
-    while (numUnfinishedTasks > 0)
-        tasksRunningCondition->Wait();
-    tasksRunningCondition->Unlock();
-#endif
+    DefaultTaskGroup()->Wait();
+}
+
+
+// ParallelForTask Declarations
+class ParallelForTask : public Task {
+public:
+    ParallelForTask(int64_t b, int64_t e,
+                    const std::function<void(int64_t)> &f)
+        : begin(b), end(e), func(f) { }
+    void Run() {
+        for (int64_t i = begin; i < end; ++i)
+            func(i);
+    }
+private:
+    const int64_t begin, end;
+    const std::function<void(int64_t)> &func;
+};
+
+
+void ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                 const std::function<void(int64_t)> &func) {
+    if (begin >= end)
+        return;
+    // By default, split the range into a few chunks per core so that
+    // stealing can even out uneven iterations
+    if (grain <= 0)
+        grain = max(int64_t(1), (end - begin) / (8 * NumSystemCores()));
+    if (PbrtOptions.nCores == 1 || end - begin <= grain) {
+        for (int64_t i = begin; i < end; ++i)
+            func(i);
+        return;
+    }
+    vector<Task *> tasks;
+    tasks.reserve((end - begin + grain - 1) / grain);
+    for (int64_t i = begin; i < end; i += grain)
+        tasks.push_back(new ParallelForTask(i, min(i + grain, end), func));
+    TaskGroup group;
+    group.Enqueue(tasks);
+    group.Wait();
+    for (uint32_t i = 0; i < tasks.size(); ++i)
+        delete tasks[i];
+}
+
+
+// ThreadSlot Declarations
+// Holds the index of a thread and hands it back when the thread exits, so
+// that the indices stay below the number of threads running at once
+struct ThreadSlot {
+    ThreadSlot() : index(-1) { }
+    ~ThreadSlot();
+    int index;
+};
+
+
+static Mutex *threadSlotMutex = Mutex::Create();
+static vector<int> freeThreadSlots;
+static int nThreadSlots = 0;
+ThreadSlot::~ThreadSlot() {
+    if (index < 0) return;
+    MutexLock lock(*threadSlotMutex);
+    freeThreadSlots.push_back(index);
+}
+
+
+// Returns a small index that is unique among the running threads; the
+// index of a thread that exited is given to the next new one
+int ThreadIndex() {
+    static thread_local ThreadSlot slot;
+    if (slot.index < 0) {
+        MutexLock lock(*threadSlotMutex);
+        if (freeThreadSlots.empty())
+            slot.index = nThreadSlots++;
+        else {
+            slot.index = freeThreadSlots.back();
+            freeThreadSlots.pop_back();
+        }
+    }
+    return slot.index;
 }
 
 
@@ -49,6 +49,7 @@
 #include <semaphore.h>
 #endif
 #include "core/probes.h"
+#include <functional>
 
 // Parallel Declarations
 #if defined(PBRT_IS_WINDOWS)
@@ -313,6 +314,7 @@ public:
     void Unlock();
     void Wait();
     void Signal();
+    void Broadcast();
 private:
     // ConditionVariable Private Data
 #if !defined(PBRT_IS_WINDOWS)
@@ -332,15 +334,47 @@ private:
 
 void TasksInit();
 void TasksCleanup();
+class TaskGroup;
 class Task {
 public:
+    Task() : group(NULL) { }
     virtual ~Task();
     virtual void Run() = 0;
+private:
+    // Task Private Data
+    friend class TaskGroup;
+    friend struct TaskWorker;
+    TaskGroup *group;
+};
+
+
+// A set of tasks that can be waited on independently of the tasks other
+// code has in flight; groups may be created and waited on from inside a
+// running task
+class TaskGroup {
+public:
+    // TaskGroup Public Methods
+    TaskGroup();
+    ~TaskGroup();
+    void Enqueue(Task *task);
+    void Enqueue(const vector<Task *> &tasks);
+    void Wait();
+private:
+    // TaskGroup Private Methods
+    friend struct TaskWorker;
+    TaskGroup(const TaskGroup &);
+    TaskGroup &operator=(const TaskGroup &);
+
+    // TaskGroup Private Data
+    AtomicInt32 nUnfinished;
 };
 
 
 void EnqueueTasks(const vector<Task *> &tasks);
 void WaitForAllTasks();
+void ParallelFor(int64_t begin, int64_t end, int64_t grain,
+                 const std::function<void(int64_t)> &func);
 int NumSystemCores();
+int ThreadIndex();
 
 #endif // PBRT_CORE_PARALLEL_H
@@ -64,12 +64,24 @@ void ParamSet::AddFloat(const string &name, const float *data,
 }
 
 
+void ParamSet::AddFloat(const string &name, vector<float> &&values) {
+    EraseFloat(name);
+    floats.push_back(new ParamSetItem<float>(name, std::move(values)));
+}
+
+
 void ParamSet::AddInt(const string &name, const int *data, int nItems) {
     EraseInt(name);
     ADD_PARAM_TYPE(int, ints);
 }
 
 
+void ParamSet::AddInt(const string &name, vector<int> &&values) {
+    EraseInt(name);
+    ints.push_back(new ParamSetItem<int>(name, std::move(values)));
+}
+
+
 void ParamSet::AddBool(const string &name, const bool *data, int nItems) {
     EraseBool(name);
     ADD_PARAM_TYPE(bool, bools);
@@ -82,18 +94,36 @@ void ParamSet::AddPoint(const string &name, const Point *data, int nItems) {
 }
 
 
+void ParamSet::AddPoint(const string &name, vector<Point> &&values) {
+    ErasePoint(name);
+    points.push_back(new ParamSetItem<Point>(name, std::move(values)));
+}
+
+
 void ParamSet::AddVector(const string &name, const Vector *data, int nItems) {
     EraseVector(name);
     ADD_PARAM_TYPE(Vector, vectors);
 }
 
 
+void ParamSet::AddVector(const string &name, vector<Vector> &&values) {
+    EraseVector(name);
+    vectors.push_back(new ParamSetItem<Vector>(name, std::move(values)));
+}
+
+
 void ParamSet::AddNormal(const string &name, const Normal *data, int nItems) {
     EraseNormal(name);
     ADD_PARAM_TYPE(Normal, normals);
 }
 
 
+void ParamSet::AddNormal(const string &name, vector<Normal> &&values) {
+    EraseNormal(name);
+    normals.push_back(new ParamSetItem<Normal>(name, std::move(values)));
+}
+
+
 void ParamSet::AddRGBSpectrum(const string &name, const float *data, int nItems) {
     EraseSpectrum(name);
     Assert(nItems % 3 == 0);
@@ -183,24 +213,30 @@ void ParamSet::AddSampledSpectrumFiles(const string &name, const char **names,
             float *wls_specified, *v_specified;
             wls_specified = new float[nSpectralSamples];
             v_specified = new float[nSpectralSamples];
+            vector<int> counts(nSpectralSamples, 0);
             for (int j = 0; j < nSpectralSamples; j++) {
-                wls_specified[j] = sampledLambdaStart + j;
+                wls_specified[j] = SpectrumSampleWavelength(j);
                 v_specified[j] = 0;
             }
             // Read only the samples that are withing the range between
             // _sampledLambdaStart_ and _sampledLambdaEnd_.
             // NOTE: This function assumes no interpolation between the
-            // spectral samples and thus the spectrum should be sample at each
-            // unit sample.
+            // spectral samples. If the spectral samples are wider than the
+            // sampling of the file, the values falling in each sample are
+            // averaged.
             for (uint32_t j = 0; j < vals.size() / 2; j++) {
-                const int index = wls.at(j) - sampledLambdaStart;
-                if (index >= 0 && index < nSpectralSamples) {
-                    wls_specified[index] = wls.at(j);
-                    v_specified[index] = v.at(j);
+                const int index = SpectrumSampleIndex(wls.at(j));
+                if (index >= 0) {
+                    v_specified[index] += v.at(j);
+                    counts[index]++;
                 }
             }
+            for (int j = 0; j < nSpectralSamples; j++)
+                if (counts[j] > 1) v_specified[j] /= counts[j];
             s[i] = Spectrum::LoadSampledSpectrum(wls_specified, v_specified,
                                                  nSpectralSamples);
+            delete[] wls_specified;
+            delete[] v_specified;
         }
         cachedSpectra[fn] = s[i];
     }
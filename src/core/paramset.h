@@ -55,11 +55,16 @@ public:
     // ParamSet Public Methods
     ParamSet() { }
     void AddFloat(const string &, const float *, int nItems = 1);
+    void AddFloat(const string &, vector<float> &&values);
     void AddInt(const string &, const int *, int nItems);
+    void AddInt(const string &, vector<int> &&values);
     void AddBool(const string &, const bool *, int nItems);
     void AddPoint(const string &, const Point *, int nItems);
+    void AddPoint(const string &, vector<Point> &&values);
     void AddVector(const string &, const Vector *, int nItems);
+    void AddVector(const string &, vector<Vector> &&values);
     void AddNormal(const string &, const Normal *, int nItems);
+    void AddNormal(const string &, vector<Normal> &&values);
     void AddString(const string &, const string *, int nItems);
     void AddTexture(const string &, const string &);
     void AddRGBSpectrum(const string &, const float *, int nItems);
@@ -121,8 +126,9 @@ private:
 template <typename T> struct ParamSetItem : public ReferenceCounted {
     // ParamSetItem Public Methods
     ParamSetItem(const string &name, const T *val, int nItems = 1);
+    ParamSetItem(const string &name, vector<T> &&val);
     ~ParamSetItem() {
-        delete[] data;
+        if (values.empty()) delete[] data;
     }
 
     // ParamSetItem Data
@@ -130,6 +136,7 @@ template <typename T> struct ParamSetItem : public ReferenceCounted {
     int nItems;
     T *data;
     mutable bool lookedUp;
+    vector<T> values; // Values moved in, pointed to by _data_
 };
 
 
@@ -145,6 +152,16 @@ ParamSetItem<T>::ParamSetItem(const string &n, const T *v, int ni) {
 }
 
 
+template <typename T>
+ParamSetItem<T>::ParamSetItem(const string &n, vector<T> &&v)
+    : values(std::move(v)) {
+    name = n;
+    nItems = int(values.size());
+    data = values.empty() ? NULL : &values[0];
+    lookedUp = false;
+}
+
+
 
 // TextureParams Declarations
 class TextureParams {
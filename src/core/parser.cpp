@@ -33,36 +33,973 @@
 // core/parser.cpp*
 #include "stdafx.h"
 #include "parser.h"
+#include "api.h"
+#include "paramset.h"
 #include "fileutil.h"
+#include "parallel.h"
+#include <climits>
+#include <stdio.h>
 
-// Parsing Global Interface
-bool ParseFile(const string &filename) {
-    extern FILE *yyin;
-    extern int yyparse(void);
-    extern string current_file;
-    extern int line_num;
-    extern int yydebug;
+// Parsing Global Variables, used by _Error()_ to report the location
+int line_num = 0;
+string current_file;
 
-    if (getenv("PBRT_YYDEBUG") != NULL)
-        yydebug = 1;
+// Parsing Local Declarations
+enum Directive {
+    ACCELERATOR, ACTIVETRANSFORM, AREALIGHTSOURCE, ATTRIBUTEBEGIN,
+    ATTRIBUTEEND, CAMERA, CONCATTRANSFORM, COORDINATESYSTEM,
+    COORDSYSTRANSFORM, FILM, IDENTITY, INCLUDE, LIGHTSOURCE, LOOKAT,
+    MAKENAMEDMATERIAL, MATERIAL, NAMEDMATERIAL, OBJECTBEGIN, OBJECTEND,
+    OBJECTINSTANCE, PIXELFILTER, RENDERER, REVERSEORIENTATION, ROTATE,
+    SAMPLER, SCALE, SENSOR, SHAPE, SURFACEINTEGRATOR, TEXTURE,
+    TRANSFORMBEGIN, TRANSFORMEND, TRANSFORMTIMES, TRANSFORM, TRANSLATE,
+    VOLUME, VOLUMEINTEGRATOR, WORLDBEGIN, WORLDEND, NUM_DIRECTIVES,
+    // Diagnostics of the tokenizer and the parser, in file order
+    PARSE_ERROR, PARSE_FATAL_ERROR
+};
 
-    if (filename == "-")
-        yyin = stdin;
-    else {
-        yyin = fopen(filename.c_str(), "r");
-        SetSearchDirectory(DirectoryContaining(filename));
+
+// Arguments of each directive: its strings, its numbers, a number array
+// and a parameter list
+struct DirectiveSyntax {
+    const char *name;
+    int nStrings, nNumbers;
+    bool numberArray, parameters;
+};
+
+
+static const DirectiveSyntax directiveSyntax[NUM_DIRECTIVES] = {
+    { "Accelerator",        1, 0, false, true  },
+    { "ActiveTransform",    0, 0, false, false },
+    { "AreaLightSource",    1, 0, false, true  },
+    { "AttributeBegin",     0, 0, false, false },
+    { "AttributeEnd",       0, 0, false, false },
+    { "Camera",             1, 0, false, true  },
+    { "ConcatTransform",    0, 0, true,  false },
+    { "CoordinateSystem",   1, 0, false, false },
+    { "CoordSysTransform",  1, 0, false, false },
+    { "Film",               1, 0, false, true  },
+    { "Identity",           0, 0, false, false },
+    { "Include",            1, 0, false, false },
+    { "LightSource",        1, 0, false, true  },
+    { "LookAt",             0, 9, false, false },
+    { "MakeNamedMaterial",  1, 0, false, true  },
+    { "Material",           1, 0, false, true  },
+    { "NamedMaterial",      1, 0, false, false },
+    { "ObjectBegin",        1, 0, false, false },
+    { "ObjectEnd",          0, 0, false, false },
+    { "ObjectInstance",     1, 0, false, false },
+    { "PixelFilter",        1, 0, false, true  },
+    { "Renderer",           1, 0, false, true  },
+    { "ReverseOrientation", 0, 0, false, false },
+    { "Rotate",             0, 4, false, false },
+    { "Sampler",            1, 0, false, true  },
+    { "Scale",              0, 3, false, false },
+    { "Sensor",             1, 0, false, true  },
+    { "Shape",              1, 0, false, true  },
+    { "SurfaceIntegrator",  1, 0, false, true  },
+    { "Texture",            3, 0, false, true  },
+    { "TransformBegin",     0, 0, false, false },
+    { "TransformEnd",       0, 0, false, false },
+    { "TransformTimes",     0, 2, false, false },
+    { "Transform",          0, 0, true,  false },
+    { "Translate",          0, 3, false, false },
+    { "Volume",             1, 0, false, true  },
+    { "VolumeIntegrator",   1, 0, false, true  },
+    { "WorldBegin",         0, 0, false, false },
+    { "WorldEnd",           0, 0, false, false },
+};
+
+
+// A "type name" [ values ] entry of a parameter list; the values are
+// handed to the _ParamSet_ by move where its types allow it
+struct ParsedParam {
+    string declaration;
+    bool isString;
+    vector<float> numbers;
+    vector<int> integers; // The numbers of "integer" parameters
+    // The numbers of "point", "vector" and "normal" parameters, by triples;
+    // the values left over from the last triple stay in _numbers_
+    vector<Point> points;
+    vector<Vector> vectors;
+    vector<Normal> normals;
+    vector<string> strings;
+};
+
+
+struct ParsedFile;
+struct ParsedStatement {
+    ParsedStatement(Directive d, int l)
+        : directive(d), line(l), include(NULL) { }
+    Directive directive;
+    int line;
+    vector<string> strings;
+    vector<float> numbers;
+    vector<ParsedParam> params;
+    ParsedFile *include;
+};
+
+
+// The statements of a scene file; the files are run as they are read,
+// except for those included by the top-level file, which are parsed ahead
+// of their execution
+struct ParsedFile {
+    ParsedFile(const string &fn, int d)
+        : filename(fn), depth(d), opened(false), task(NULL), group(NULL),
+          includedAt(NULL), nextInclude(0), nStarted(0) { }
+    ~ParsedFile();
+    string filename;
+    int depth;
+    bool opened;
+    vector<ParsedStatement> statements;
+    // The files included by the top-level file are parsed in a group of
+    // their own, a few ahead of the one that is run, in file order
+    Task *task;
+    TaskGroup *group;
+    const char *includedAt;
+    vector<ParsedFile *> includes;
+    uint32_t nextInclude, nStarted;
+};
+
+
+// Tokens of the scene files, which point into the mapped file
+enum TokenType {
+    TOKEN_END, TOKEN_IDENTIFIER, TOKEN_STRING, TOKEN_NUMBER, TOKEN_LBRACK,
+    TOKEN_RBRACK
+};
+
+
+struct Token {
+    TokenType type;
+    const char *begin, *end;
+    int line;
+};
+
+
+class SceneTokenizer {
+public:
+    // SceneTokenizer Public Methods
+    SceneTokenizer(const char *b, const char *e, ParsedFile *f)
+        : pos(b), end(e), line(1), file(f), peeked(false) { }
+    const Token &Peek() {
+        if (!peeked) {
+            next = Read();
+            peeked = true;
+        }
+        return next;
+    }
+    Token Next() {
+        if (peeked) {
+            peeked = false;
+            return next;
+        }
+        return Read();
+    }
+private:
+    // SceneTokenizer Private Methods
+    Token Read();
+    void Diagnostic(Directive d, int l, const char *message);
+
+    // SceneTokenizer Private Data
+    const char *pos, *end;
+    int line;
+    ParsedFile *file;
+    bool peeked;
+    Token next;
+};
+
+
+static void ParseSceneFile(ParsedFile *file, const char *data, uint64_t size);
+static bool ParseStatement(SceneTokenizer &tokens, ParsedFile *file);
+class SceneParseTask : public Task {
+public:
+    SceneParseTask(ParsedFile *f) : file(f) { }
+    void Run();
+private:
+    ParsedFile *file;
+};
+
+
+static inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+static inline bool IsIdentifierChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' ||
+           IsDigit(c);
+}
+
+
+// Converts the number tokens exactly: mantissas of up to 15 digits scaled
+// by up to 10^22 are exact doubles, which are rounded once as _strtod()_
+// would, the others go through _strtod()_
+static const double powersOf10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+static inline double ParseNumber(const Token &token) {
+    const char *p = token.begin;
+    bool negative = false;
+    if (*p == '-' || *p == '+')
+        negative = *p++ == '-';
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    for (; p < token.end && IsDigit(*p); ++p) {
+        mantissa = 10 * mantissa + (*p - '0');
+        if (mantissa) ++digits;
+    }
+    if (p < token.end && *p == '.')
+        for (++p; p < token.end && IsDigit(*p); ++p) {
+            mantissa = 10 * mantissa + (*p - '0');
+            if (mantissa) ++digits;
+            --exponent;
+        }
+    if (p < token.end) {
+        // Exponent, the tokenizer only accepts [eE][-+]?[0-9]+ here
+        ++p;
+        bool negativeExponent = false;
+        if (*p == '-' || *p == '+')
+            negativeExponent = *p++ == '-';
+        int e = 0;
+        for (; p < token.end && e < 10000; ++p)
+            e = 10 * e + (*p - '0');
+        exponent += negativeExponent ? -e : e;
+    }
+    if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+        double value = double(mantissa);
+        value = exponent < 0 ? value / powersOf10[-exponent] :
+                               value * powersOf10[exponent];
+        return negative ? -value : value;
+    }
+    return strtod(string(token.begin, token.end).c_str(), NULL);
+}
+
+
+static inline int ParseInteger(const Token &token) {
+    // The values of "integer" parameters are read exactly when they are
+    // written as integers and truncated from floats otherwise
+    const char *p = token.begin;
+    bool negative = false;
+    if (*p == '-' || *p == '+')
+        negative = *p++ == '-';
+    int64_t value = 0;
+    for (; p < token.end && IsDigit(*p) && value <= INT_MAX; ++p)
+        value = 10 * value + (*p - '0');
+    if (p == token.end && value <= INT_MAX)
+        return int(negative ? -value : value);
+    return int(float(ParseNumber(token)));
+}
+
+
+static string DecodeString(const Token &token) {
+    string s;
+    s.reserve(token.end - token.begin);
+    for (const char *p = token.begin; p < token.end; ++p) {
+        if (*p == '\n') continue; // Reported by the tokenizer
+        if (*p != '\\') {
+            s += *p;
+            continue;
+        }
+        ++p;
+        switch (*p) {
+        case 'n': s += '\n'; break;
+        case 't': s += '\t'; break;
+        case 'r': s += '\r'; break;
+        case 'b': s += '\b'; break;
+        case 'f': s += '\f'; break;
+        case '\n': break; // Line continuation
+        default:
+            if (p + 2 < token.end && IsDigit(p[0]) && IsDigit(p[1]) &&
+                IsDigit(p[2])) {
+                int val = 100 * (p[0] - '0') + 10 * (p[1] - '0') + p[2] - '0';
+                while (val > 256)
+                    val -= 256;
+                s += char(val);
+                p += 2;
+            }
+            else
+                s += *p;
+        }
+    }
+    return s;
+}
+
+
+// Parsing Method Definitions
+ParsedFile::~ParsedFile() {
+    delete group;
+    for (uint32_t i = 0; i < statements.size(); ++i)
+        delete statements[i].include;
+    for (uint32_t i = nextInclude; i < includes.size(); ++i)
+        delete includes[i];
+    delete task;
+}
+
+
+void SceneTokenizer::Diagnostic(Directive d, int l, const char *message) {
+    // The scan for the included files reports nothing
+    if (!file) return;
+    file->statements.push_back(ParsedStatement(d, l));
+    file->statements.back().strings.push_back(message);
+}
+
+
+Token SceneTokenizer::Read() {
+    Token token;
+    while (pos < end) {
+        const char c = *pos;
+        token.begin = pos;
+        token.line = line;
+        if (c == ' ' || c == '\t' || c == '\r') {
+            ++pos;
+            continue;
+        }
+        if (c == '\n') {
+            ++line;
+            ++pos;
+            continue;
+        }
+        if (c == '#') {
+            while (pos < end && *pos != '\n') ++pos;
+            continue;
+        }
+        if (c == '[' || c == ']') {
+            token.type = c == '[' ? TOKEN_LBRACK : TOKEN_RBRACK;
+            token.end = ++pos;
+            return token;
+        }
+        if (c == '"') {
+            // The string is decoded by _DecodeString()_ when it is used
+            token.type = TOKEN_STRING;
+            token.begin = ++pos;
+            while (pos < end && *pos != '"') {
+                if (*pos == '\n') {
+                    Diagnostic(PARSE_ERROR, line, "Unterminated string!");
+                    ++line;
+                }
+                else if (*pos == '\\' && pos + 1 < end) {
+                    if (pos[1] == '\n') ++line;
+                    ++pos;
+                }
+                ++pos;
+            }
+            if (pos == end) {
+                Diagnostic(PARSE_FATAL_ERROR, token.line,
+                           "Parsing error: unterminated string");
+                token.type = TOKEN_END;
+                return token;
+            }
+            token.end = pos++;
+            return token;
+        }
+        if (IsIdentifierChar(c) && !IsDigit(c)) {
+            token.type = TOKEN_IDENTIFIER;
+            while (pos < end && IsIdentifierChar(*pos)) ++pos;
+            token.end = pos;
+            return token;
+        }
+        // Numbers, [-+]?([0-9]+|[0-9]+\.[0-9]*|\.[0-9]+)([eE][-+]?[0-9]+)?
+        const char *p = pos;
+        if (*p == '-' || *p == '+') ++p;
+        const char *digits = p;
+        while (p < end && IsDigit(*p)) ++p;
+        bool isNumber = p > digits;
+        if (p < end && *p == '.') {
+            ++p;
+            const char *fraction = p;
+            while (p < end && IsDigit(*p)) ++p;
+            isNumber = isNumber || p > fraction;
+        }
+        if (isNumber) {
+            if (p < end && (*p == 'e' || *p == 'E')) {
+                const char *q = p + 1;
+                if (q < end && (*q == '-' || *q == '+')) ++q;
+                if (q < end && IsDigit(*q)) {
+                    while (q < end && IsDigit(*q)) ++q;
+                    p = q;
+                }
+            }
+            token.type = TOKEN_NUMBER;
+            token.end = pos = p;
+            return token;
+        }
+        char message[64];
+        snprintf(message, sizeof(message), "Illegal character: %c (0x%x)",
+                 c, int(c));
+        Diagnostic(PARSE_ERROR, line, message);
+        ++pos;
+    }
+    token.type = TOKEN_END;
+    token.begin = token.end = pos;
+    token.line = line;
+    return token;
+}
+
+
+void SceneParseTask::Run() {
+    MappedFile *mapped = MappedFile::Open(file->filename);
+    if (!mapped)
+        return;
+    file->opened = true;
+    ParseSceneFile(file, (const char *)mapped->Data(), mapped->Size());
+    delete mapped;
+}
+
+
+enum ParsedValues { FLOAT_VALUES, INTEGER_VALUES, POINT_VALUES,
+    VECTOR_VALUES, NORMAL_VALUES };
+static inline void AddNumber(ParsedParam &param, ParsedValues values,
+                             float value) {
+    param.numbers.push_back(value);
+    if (values == FLOAT_VALUES || param.numbers.size() < 3)
+        return;
+    const float *v = &param.numbers[0];
+    if (values == POINT_VALUES)
+        param.points.push_back(Point(v[0], v[1], v[2]));
+    else if (values == VECTOR_VALUES)
+        param.vectors.push_back(Vector(v[0], v[1], v[2]));
+    else
+        param.normals.push_back(Normal(v[0], v[1], v[2]));
+    param.numbers.clear();
+}
+
+
+static bool ParseParameterList(SceneTokenizer &tokens,
+                               vector<ParsedParam> &params) {
+    while (tokens.Peek().type == TOKEN_STRING) {
+        params.push_back(ParsedParam());
+        ParsedParam &param = params.back();
+        param.declaration = DecodeString(tokens.Next());
+        // The values are read in the layout of the _ParamSet_ item they
+        // are moved to, the type names are matched as _LookupType()_ does
+        const char *type = param.declaration.c_str();
+        while (*type && isspace(*type)) ++type;
+        ParsedValues values = FLOAT_VALUES;
+        if (strncmp(type, "integer", 7) == 0)     values = INTEGER_VALUES;
+        else if (strncmp(type, "point", 5) == 0)  values = POINT_VALUES;
+        else if (strncmp(type, "vector", 6) == 0) values = VECTOR_VALUES;
+        else if (strncmp(type, "normal", 6) == 0) values = NORMAL_VALUES;
+
+        const Token first = tokens.Next();
+        const bool bracketed = first.type == TOKEN_LBRACK;
+        Token value = bracketed ? tokens.Next() : first;
+        param.isString = value.type == TOKEN_STRING;
+        if (value.type != TOKEN_STRING && value.type != TOKEN_NUMBER)
+            return false;
+        while (true) {
+            if (value.type != (param.isString ? TOKEN_STRING : TOKEN_NUMBER))
+                return false;
+            if (param.isString)
+                param.strings.push_back(DecodeString(value));
+            else if (values == INTEGER_VALUES)
+                param.integers.push_back(ParseInteger(value));
+            else
+                AddNumber(param, values, float(ParseNumber(value)));
+            if (!bracketed) break;
+            value = tokens.Next();
+            if (value.type == TOKEN_RBRACK) break;
+        }
+    }
+    return true;
+}
+
+
+static int FindDirective(const Token &token) {
+    if (token.type != TOKEN_IDENTIFIER)
+        return NUM_DIRECTIVES;
+    int d = 0;
+    for (; d < NUM_DIRECTIVES; ++d)
+        if (size_t(token.end - token.begin) ==
+                strlen(directiveSyntax[d].name) &&
+            !strncmp(token.begin, directiveSyntax[d].name,
+                     token.end - token.begin))
+            break;
+    return d;
+}
+
+
+static void ParseSceneFile(ParsedFile *file, const char *data, uint64_t size) {
+    SceneTokenizer tokens(data, data + size, file);
+    while (ParseStatement(tokens, file))
+        ;
+}
+
+
+static void StartIncludes(ParsedFile *file) {
+    // Parses the files included by the top-level file up to one per core
+    // ahead of the one that is run, which bounds the parsed statements
+    // held in memory to those of a few files
+    const uint32_t end = min(uint32_t(file->includes.size()),
+                             file->nextInclude + uint32_t(NumSystemCores()));
+    for (; file->nStarted < end; ++file->nStarted) {
+        ParsedFile *include = file->includes[file->nStarted];
+        include->group = new TaskGroup;
+        include->task = new SceneParseTask(include);
+        include->group->Enqueue(include->task);
+    }
+}
+
+
+static inline const char *FindChar(const char *p, const char *end, char c) {
+    const char *q = (const char *)memchr(p, c, end - p);
+    return q ? q : end;
+}
+
+
+static void FindIncludes(ParsedFile *file, const char *data, uint64_t size) {
+    // Skims the top-level file for its Include statements, jumping from one
+    // comment, string or 'I' to the next over the long runs of numbers; an
+    // Include this misses, e.g. one written right after a number, is run
+    // as it is read
+    const char *p = data, *end = data + size;
+    const char *comment = FindChar(p, end, '#');
+    const char *quote = FindChar(p, end, '"');
+    const char *letter = FindChar(p, end, 'I');
+    while ((p = min(comment, min(quote, letter))) < end) {
+        if (p == comment)
+            p = FindChar(p, end, '\n');
+        else if (p == quote) {
+            for (++p; p < end && *p != '"'; ++p)
+                if (*p == '\\') ++p;
+            ++p;
+        }
+        else if ((p == data || !IsIdentifierChar(p[-1])) && end - p > 7 &&
+                 !strncmp(p, "Include", 7) && !IsIdentifierChar(p[7])) {
+            SceneTokenizer tokens(p + 7, end, NULL);
+            const Token name = tokens.Next();
+            if (name.type != TOKEN_STRING)
+                return;
+            ParsedFile *include = new ParsedFile(
+                AbsolutePath(ResolveFilename(DecodeString(name))),
+                file->depth + 1);
+            include->includedAt = p;
+            file->includes.push_back(include);
+            p = name.end + 1;
+        }
+        else
+            ++p;
+        if (p >= end)
+            return;
+        if (comment < p) comment = FindChar(p, end, '#');
+        if (quote < p) quote = FindChar(p, end, '"');
+        if (letter < p) letter = FindChar(p, end, 'I');
+    }
+}
+
+
+static bool ParseStatement(SceneTokenizer &tokens, ParsedFile *file) {
+    // Appends the next statement of the file to its _statements_, after
+    // the diagnostics of the tokenizer; returns false at the end of the file
+    // or after a fatal error
+    Token token = tokens.Next();
+    if (token.type == TOKEN_END) return false;
+
+    // Find the directive of the statement
+    const char *begin = token.begin;
+    const int d = FindDirective(token);
+    if (d == NUM_DIRECTIVES) {
+        file->statements.push_back(ParsedStatement(PARSE_FATAL_ERROR,
+                                                   token.line));
+        file->statements.back().strings.push_back(
+            "Parsing error: syntax error, unexpected \"" +
+            string(token.begin, token.end) + "\"");
+        return false;
+    }
+    const DirectiveSyntax &syntax = directiveSyntax[d];
+    ParsedStatement statement(Directive(d), token.line);
+
+    // Read the arguments of the directive
+    bool valid = true;
+    if (d == ACTIVETRANSFORM) {
+        token = tokens.Next();
+        const string which(token.begin, token.end);
+        valid = token.type == TOKEN_IDENTIFIER && (which == "All" ||
+                which == "StartTime" || which == "EndTime");
+        statement.strings.push_back(which);
+    }
+    for (int i = 0; valid && i < syntax.nStrings; ++i) {
+        token = tokens.Next();
+        valid = token.type == TOKEN_STRING;
+        if (valid) statement.strings.push_back(DecodeString(token));
+    }
+    for (int i = 0; valid && i < syntax.nNumbers; ++i) {
+        token = tokens.Next();
+        valid = token.type == TOKEN_NUMBER;
+        if (valid) statement.numbers.push_back(float(ParseNumber(token)));
     }
+    if (valid && syntax.numberArray) {
+        token = tokens.Next();
+        if (token.type == TOKEN_NUMBER)
+            statement.numbers.push_back(float(ParseNumber(token)));
+        else if (token.type == TOKEN_LBRACK) {
+            while ((token = tokens.Next()).type == TOKEN_NUMBER)
+                statement.numbers.push_back(float(ParseNumber(token)));
+            valid = token.type == TOKEN_RBRACK &&
+                    statement.numbers.size() > 0;
+        }
+        else
+            valid = false;
+    }
+    if (valid && syntax.parameters)
+        valid = ParseParameterList(tokens, statement.params);
+    if (!valid) {
+        file->statements.push_back(ParsedStatement(PARSE_FATAL_ERROR,
+                                                   token.line));
+        file->statements.back().strings.push_back(
+            string("Parsing error: syntax error in \"") + syntax.name +
+            "\"");
+        return false;
+    }
+
+    if (d == INCLUDE && file->depth == 0 &&
+        file->nextInclude < file->includes.size() &&
+        file->includes[file->nextInclude]->includedAt == begin) {
+        // Included by the top-level file and found by _FindIncludes()_
+        statement.include = file->includes[file->nextInclude++];
+        StartIncludes(file);
+    }
+    else if (d == INCLUDE) {
+        // Run as it is read when the statement is executed
+        if (file->depth > 32) {
+            file->statements.push_back(ParsedStatement(PARSE_FATAL_ERROR,
+                                                       token.line));
+            file->statements.back().strings.push_back(
+                "Only 32 levels of nested Include allowed in scene files.");
+            return false;
+        }
+        statement.include = new ParsedFile(
+            AbsolutePath(ResolveFilename(statement.strings[0])),
+            file->depth + 1);
+    }
+    file->statements.push_back(std::move(statement));
+    return true;
+}
 
-    if (yyin != NULL) {
-        current_file = filename;
-        if (yyin == stdin) current_file = "<standard input>";
-        line_num = 1;
-        yyparse();
-        if (yyin != stdin) fclose(yyin);
+
+static bool LookupType(const char *name, int *type, string &sname);
+static const char *ParamTypeToName(int type);
+enum { PARAM_TYPE_INT, PARAM_TYPE_BOOL, PARAM_TYPE_FLOAT, PARAM_TYPE_POINT,
+    PARAM_TYPE_VECTOR, PARAM_TYPE_NORMAL, PARAM_TYPE_RGB, PARAM_TYPE_XYZ,
+    PARAM_TYPE_BLACKBODY, PARAM_TYPE_SPECTRUM,
+    PARAM_TYPE_STRING, PARAM_TYPE_TEXTURE };
+static void InitParamSet(ParamSet &ps, vector<ParsedParam> &params) {
+    for (uint32_t i = 0; i < params.size(); ++i) {
+        ParsedParam &param = params[i];
+        const char *declaration = param.declaration.c_str();
+        int type;
+        string name;
+        if (!LookupType(declaration, &type, name)) {
+            Warning("Type of parameter \"%s\" is unknown", declaration);
+            continue;
+        }
+        if (type == PARAM_TYPE_TEXTURE || type == PARAM_TYPE_STRING ||
+            type == PARAM_TYPE_BOOL) {
+            if (!param.isString) {
+                Error("Expected string parameter value for parameter \"%s\" with type \"%s\". Ignoring.",
+                      name.c_str(), ParamTypeToName(type));
+                continue;
+            }
+        }
+        else if (type != PARAM_TYPE_SPECTRUM) { /* spectrum can be either... */
+            if (param.isString) {
+                Error("Expected numeric parameter value for parameter \"%s\" with type \"%s\".  Ignoring.",
+                      name.c_str(), ParamTypeToName(type));
+                continue;
+            }
+        }
+        const int nItems = int(param.numbers.size());
+        const float *data = nItems ? &param.numbers[0] : NULL;
+        if (type == PARAM_TYPE_INT)
+            ps.AddInt(name, std::move(param.integers));
+        else if (type == PARAM_TYPE_BOOL) {
+            // strings -> bools
+            const int nBools = int(param.strings.size());
+            bool *bdata = new bool[nBools];
+            for (int j = 0; j < nBools; ++j) {
+                const string &s = param.strings[j];
+                if (s == "true") bdata[j] = true;
+                else if (s == "false") bdata[j] = false;
+                else {
+                    Warning("Value \"%s\" unknown for boolean parameter \"%s\"."
+                        "Using \"false\".", s.c_str(), declaration);
+                    bdata[j] = false;
+                }
+            }
+            ps.AddBool(name, bdata, nBools);
+            delete[] bdata;
+        }
+        else if (type == PARAM_TYPE_FLOAT)
+            ps.AddFloat(name, std::move(param.numbers));
+        else if (type == PARAM_TYPE_POINT) {
+            // The triples were read apart, _numbers_ holds what is left
+            if (nItems != 0)
+                Warning("Excess values given with point parameter \"%s\". "
+                        "Ignoring last %d of them", declaration, nItems);
+            ps.AddPoint(name, std::move(param.points));
+        } else if (type == PARAM_TYPE_VECTOR) {
+            if (nItems != 0)
+                Warning("Excess values given with vector parameter \"%s\". "
+                        "Ignoring last %d of them", declaration, nItems);
+            ps.AddVector(name, std::move(param.vectors));
+        } else if (type == PARAM_TYPE_NORMAL) {
+            if (nItems != 0)
+                Warning("Excess values given with normal parameter \"%s\". "
+                        "Ignoring last %d of them", declaration, nItems);
+            ps.AddNormal(name, std::move(param.normals));
+        } else if (type == PARAM_TYPE_RGB) {
+            if ((nItems % 3) != 0)
+                Warning("Excess RGB values given with parameter \"%s\". "
+                        "Ignoring last %d of them", declaration, nItems % 3);
+            ps.AddRGBSpectrum(name, data, nItems);
+        } else if (type == PARAM_TYPE_XYZ) {
+            if ((nItems % 3) != 0)
+                Warning("Excess XYZ values given with parameter \"%s\". "
+                        "Ignoring last %d of them", declaration, nItems % 3);
+            ps.AddXYZSpectrum(name, data, nItems);
+        } else if (type == PARAM_TYPE_BLACKBODY) {
+            if ((nItems % 2) != 0)
+                Warning("Excess value given with blackbody parameter \"%s\". "
+                        "Ignoring extra one.", declaration);
+            ps.AddBlackbodySpectrum(name, data, nItems);
+        } else if (type == PARAM_TYPE_SPECTRUM) {
+            if (param.isString) {
+                vector<const char *> files(param.strings.size());
+                for (uint32_t j = 0; j < files.size(); ++j)
+                    files[j] = param.strings[j].c_str();
+                ps.AddSampledSpectrumFiles(name, &files[0], int(files.size()));
+            }
+            else {
+                if ((nItems % 2) != 0)
+                    Warning("Non-even number of values given with sampled spectrum "
+                            "parameter \"%s\". Ignoring extra.", declaration);
+                ps.AddSampledSpectrum(name, data, nItems);
+            }
+        } else if (type == PARAM_TYPE_STRING)
+            ps.AddString(name, &param.strings[0], int(param.strings.size()));
+        else if (type == PARAM_TYPE_TEXTURE) {
+            if (param.strings.size() == 1)
+                ps.AddTexture(name, param.strings[0]);
+            else
+                Error("Only one string allowed for \"texture\" parameter \"%s\"",
+                    name.c_str());
+        }
     }
+}
+
+
+static void ExecuteSceneFile(ParsedFile *file);
+static void RunSceneFile(ParsedFile *file);
+static void ExecuteStatement(ParsedFile *file, ParsedStatement &s) {
+    line_num = s.line;
+    ParamSet params;
+    if (s.directive < NUM_DIRECTIVES &&
+        directiveSyntax[s.directive].parameters)
+        InitParamSet(params, s.params);
+    const float *n = s.numbers.size() ? &s.numbers[0] : NULL;
+    switch (s.directive) {
+    case ACCELERATOR:        pbrtAccelerator(s.strings[0], params); break;
+    case ACTIVETRANSFORM:
+        if (s.strings[0] == "All")            pbrtActiveTransformAll();
+        else if (s.strings[0] == "EndTime")   pbrtActiveTransformEndTime();
+        else                                  pbrtActiveTransformStartTime();
+        break;
+    case AREALIGHTSOURCE:    pbrtAreaLightSource(s.strings[0], params); break;
+    case ATTRIBUTEBEGIN:     pbrtAttributeBegin(); break;
+    case ATTRIBUTEEND:       pbrtAttributeEnd(); break;
+    case CAMERA:             pbrtCamera(s.strings[0], params); break;
+    case CONCATTRANSFORM:
+    case TRANSFORM:
+        if (s.numbers.size() != 16)
+            Error("\"%s\" requires a %d element array! (%d found)",
+                  directiveSyntax[s.directive].name, 16,
+                  int(s.numbers.size()));
+        else if (s.directive == TRANSFORM)
+            pbrtTransform(&s.numbers[0]);
+        else
+            pbrtConcatTransform(&s.numbers[0]);
+        break;
+    case COORDINATESYSTEM:   pbrtCoordinateSystem(s.strings[0]); break;
+    case COORDSYSTRANSFORM:  pbrtCoordSysTransform(s.strings[0]); break;
+    case FILM:               pbrtFilm(s.strings[0], params); break;
+    case IDENTITY:           pbrtIdentity(); break;
+    case INCLUDE:
+        if (s.include->group) {
+            s.include->group->Wait();
+            if (s.include->opened)
+                ExecuteSceneFile(s.include);
+        }
+        else
+            RunSceneFile(s.include);
+        if (!s.include->opened)
+            Error("Unable to open included scene file \"%s\"",
+                  s.include->filename.c_str());
+        else
+            current_file = file->filename;
+        delete s.include;
+        s.include = NULL;
+        break;
+    case LIGHTSOURCE:        pbrtLightSource(s.strings[0], params); break;
+    case LOOKAT:
+        pbrtLookAt(n[0], n[1], n[2], n[3], n[4], n[5], n[6], n[7], n[8]);
+        break;
+    case MAKENAMEDMATERIAL:  pbrtMakeNamedMaterial(s.strings[0], params); break;
+    case MATERIAL:           pbrtMaterial(s.strings[0], params); break;
+    case NAMEDMATERIAL:      pbrtNamedMaterial(s.strings[0]); break;
+    case OBJECTBEGIN:        pbrtObjectBegin(s.strings[0]); break;
+    case OBJECTEND:          pbrtObjectEnd(); break;
+    case OBJECTINSTANCE:     pbrtObjectInstance(s.strings[0]); break;
+    case PIXELFILTER:        pbrtPixelFilter(s.strings[0], params); break;
+    case RENDERER:           pbrtRenderer(s.strings[0], params); break;
+    case REVERSEORIENTATION: pbrtReverseOrientation(); break;
+    case ROTATE:             pbrtRotate(n[0], n[1], n[2], n[3]); break;
+    case SAMPLER:            pbrtSampler(s.strings[0], params); break;
+    case SCALE:              pbrtScale(n[0], n[1], n[2]); break;
+    case SENSOR:             pbrtSensor(s.strings[0], params); break;
+    case SHAPE:              pbrtShape(s.strings[0], params); break;
+    case SURFACEINTEGRATOR:  pbrtSurfaceIntegrator(s.strings[0], params); break;
+    case TEXTURE:
+        pbrtTexture(s.strings[0], s.strings[1], s.strings[2], params);
+        break;
+    case TRANSFORMBEGIN:     pbrtTransformBegin(); break;
+    case TRANSFORMEND:       pbrtTransformEnd(); break;
+    case TRANSFORMTIMES:     pbrtTransformTimes(n[0], n[1]); break;
+    case TRANSLATE:          pbrtTranslate(n[0], n[1], n[2]); break;
+    case VOLUME:             pbrtVolume(s.strings[0], params); break;
+    case VOLUMEINTEGRATOR:   pbrtVolumeIntegrator(s.strings[0], params); break;
+    case WORLDBEGIN:         pbrtWorldBegin(); break;
+    case WORLDEND:           pbrtWorldEnd(); break;
+    case PARSE_ERROR:        Error("%s", s.strings[0].c_str()); break;
+    case PARSE_FATAL_ERROR:
+        Error("%s", s.strings[0].c_str());
+        exit(1);
+    default:
+        Severe("Unknown statement in scene file");
+    }
+    // Release the arguments that were not moved to the _ParamSet_
+    s = ParsedStatement(s.directive, s.line);
+}
+
+
+static void ExecuteSceneFile(ParsedFile *file) {
+    current_file = file->filename;
+    for (uint32_t i = 0; i < file->statements.size(); ++i)
+        ExecuteStatement(file, file->statements[i]);
+}
+
+
+static void RunSceneFile(ParsedFile *file, const char *data, uint64_t size) {
+    // The file is run statement by statement while it is read, so that
+    // only one statement's arguments are held at a time
+    if (file->depth == 0) {
+        FindIncludes(file, data, size);
+        StartIncludes(file);
+    }
+    current_file = file->filename;
+    SceneTokenizer tokens(data, data + size, file);
+    bool more = true;
+    while (more) {
+        more = ParseStatement(tokens, file);
+        for (uint32_t i = 0; i < file->statements.size(); ++i)
+            ExecuteStatement(file, file->statements[i]);
+        file->statements.clear();
+    }
+}
+
+
+static void RunSceneFile(ParsedFile *file) {
+    MappedFile *mapped = MappedFile::Open(file->filename);
+    if (!mapped)
+        return;
+    file->opened = true;
+    RunSceneFile(file, (const char *)mapped->Data(), mapped->Size());
+    delete mapped;
+}
+
+
+// Parsing Global Interface
+bool ParseFile(const string &filename) {
+    // The scene files are run as they are parsed, except for the files
+    // included by the top-level file, which are parsed ahead in parallel
+    ParsedFile *file;
+    if (filename == "-") {
+        string text;
+        char buffer[65536];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), stdin)) > 0)
+            text.append(buffer, n);
+        file = new ParsedFile("<standard input>", 0);
+        file->opened = true;
+        RunSceneFile(file, text.data(), text.size());
+    }
+    else {
+        SetSearchDirectory(DirectoryContaining(filename));
+        file = new ParsedFile(filename, 0);
+        MappedFile *mapped = MappedFile::Open(filename);
+        if (mapped) {
+            file->opened = true;
+            RunSceneFile(file, (const char *)mapped->Data(), mapped->Size());
+            delete mapped;
+        }
+    }
+    const bool opened = file->opened;
+    delete file;
     current_file = "";
     line_num = 0;
-    return (yyin != NULL);
+    return opened;
 }
 
 
+static const char *ParamTypeToName(int type) {
+    switch (type) {
+    case PARAM_TYPE_INT: return "int";
+    case PARAM_TYPE_BOOL: return "bool";
+    case PARAM_TYPE_FLOAT: return "float";
+    case PARAM_TYPE_POINT: return "point";
+    case PARAM_TYPE_VECTOR: return "vector";
+    case PARAM_TYPE_NORMAL: return "normal";
+    case PARAM_TYPE_RGB: return "rgb/color";
+    case PARAM_TYPE_XYZ: return "xyz";
+    case PARAM_TYPE_BLACKBODY: return "blackbody";
+    case PARAM_TYPE_SPECTRUM: return "spectrum";
+    case PARAM_TYPE_STRING: return "string";
+    case PARAM_TYPE_TEXTURE: return "texture";
+    default: Severe("Error in paramTypeToName"); return NULL;
+    }
+}
+
+
+static bool LookupType(const char *name, int *type, string &sname) {
+    Assert(name != NULL);
+    *type = 0;
+    const char *strp = name;
+    while (*strp && isspace(*strp))
+        ++strp;
+    if (!*strp) {
+        Error("Parameter \"%s\" doesn't have a type declaration?!", name);
+        return false;
+    }
+#define TRY_DECODING_TYPE(name, mask) \
+        if (strncmp(name, strp, strlen(name)) == 0) { \
+            *type = mask; strp += strlen(name); \
+        }
+         TRY_DECODING_TYPE("float",     PARAM_TYPE_FLOAT)
+    else TRY_DECODING_TYPE("integer",   PARAM_TYPE_INT)
+    else TRY_DECODING_TYPE("bool",      PARAM_TYPE_BOOL)
+    else TRY_DECODING_TYPE("point",     PARAM_TYPE_POINT)
+    else TRY_DECODING_TYPE("vector",    PARAM_TYPE_VECTOR)
+    else TRY_DECODING_TYPE("normal",    PARAM_TYPE_NORMAL)
+    else TRY_DECODING_TYPE("string",    PARAM_TYPE_STRING)
+    else TRY_DECODING_TYPE("texture",   PARAM_TYPE_TEXTURE)
+    else TRY_DECODING_TYPE("color",     PARAM_TYPE_RGB)
+    else TRY_DECODING_TYPE("rgb",       PARAM_TYPE_RGB)
+    else TRY_DECODING_TYPE("xyz",       PARAM_TYPE_XYZ)
+    else TRY_DECODING_TYPE("blackbody", PARAM_TYPE_BLACKBODY)
+    else TRY_DECODING_TYPE("spectrum",  PARAM_TYPE_SPECTRUM)
+    else {
+        Error("Unable to decode type for name \"%s\"", name);
+        return false;
+    }
+    while (*strp && isspace(*strp))
+        ++strp;
+    sname = string(strp);
+    return true;
+}
@@ -135,12 +135,28 @@ template <typename T> struct ParamSetItem;
 struct Options {
     Options() { nCores = 0;
                 quickRender = quiet = openWindow = verbose = false;
-                imageFile = ""; }
+                imageFile = "";
+                lambdaStart = lambdaEnd = 0;
+                spectralSamples = 0;
+                checkpointFile = "";
+                checkpointInterval = 600.f;
+                resume = false;
+                shardIndex = 0; nShards = 1; }
     int nCores;
     bool quickRender;
     bool quiet, verbose;
     bool openWindow;
     string imageFile;
+    // Spectral range in nm and number of samples, the defaults are used
+    // if zero
+    int lambdaStart, lambdaEnd;
+    int spectralSamples;
+    // Snapshot of the long renders, none if empty, and its period in seconds
+    string checkpointFile;
+    float checkpointInterval;
+    bool resume;
+    // Part of the work done by this process, see core/shard.h
+    int shardIndex, nShards;
 };
 
 
@@ -163,8 +179,11 @@ class GeometricPrimitive;
 template <int nSamples> class CoefficientSpectrum;
 class RGBSpectrum;
 class SampledSpectrum;
+#ifdef PBRT_SAMPLED_SPECTRUM
+typedef SampledSpectrum Spectrum;
+#else
 typedef RGBSpectrum Spectrum;
-//typedef SampledSpectrum Spectrum;
+#endif
 class Camera;
 class ProjectiveCamera;
 class Sampler;
@@ -0,0 +1,118 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+
+// core/photontracer.cpp*
+#include "stdafx.h"
+#include "photontracer.h"
+#include "parallel.h"
+#include "progressreporter.h"
+#include "checkpoint.h"
+#include "shard.h"
+#include "sensor.h"
+
+// PhotonTracerTask Declarations
+class PhotonTracerTask : public Task {
+public:
+    // PhotonTracerTask Public Methods
+    PhotonTracerTask(PhotonTracer *t, uint64_t c, uint64_t n, uint32_t s,
+                     ProgressReporter &pr)
+        : tracer(t), chunk(c), nPhotons(n), seed(s), reporter(pr) { }
+    void Run();
+    void Flush() { hits.Flush(); }
+private:
+    // PhotonTracerTask Private Data
+    PhotonTracer *tracer;
+    const uint64_t chunk, nPhotons;
+    const uint32_t seed;
+    ProgressReporter &reporter;
+    SensorHits hits;
+};
+
+
+
+// PhotonTracer Method Definitions
+PhotonTracer::~PhotonTracer() {
+}
+
+
+uint32_t PhotonChunkSeed(uint64_t chunk, uint32_t seed) {
+    // Mix the chunk index to decorrelate the streams of neighbouring chunks
+    uint64_t h = chunk * 0x9E3779B97F4A7C15ULL + seed;
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDULL;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ULL;
+    h ^= h >> 33;
+    return uint32_t(h);
+}
+
+
+void PhotonTracerTask::Run() {
+    const uint64_t begin = chunk * photonChunkSize;
+    const uint64_t end = min(begin + photonChunkSize, nPhotons);
+    RNG rng(PhotonChunkSeed(chunk, seed));
+    SensorHits *previous = SetThreadSensorHits(&hits);
+    for (uint64_t photon = begin; photon < end; ++photon)
+        tracer->Trace(photon, rng);
+    SetThreadSensorHits(previous);
+    reporter.Update();
+}
+
+
+void TracePhotons(PhotonTracer *tracer, uint64_t nPhotons,
+                  const string &title, uint32_t seed,
+                  CheckpointState *state, bool sharded) {
+    if (nPhotons == 0) return;
+    const uint64_t nChunks = (nPhotons + photonChunkSize - 1) / photonChunkSize;
+    // A shard traces a contiguous range of the chunks of the whole render
+    uint64_t firstChunk = 0, endChunk = nChunks;
+    if (sharded) ShardRange(nChunks, &firstChunk, &endChunk);
+    ProgressReporter reporter(int(endChunk - firstChunk), title);
+    vector<PhotonTracerTask *> chunks;
+    chunks.reserve(endChunk - firstChunk);
+    for (uint64_t i = firstChunk; i < endChunk; ++i)
+        chunks.push_back(new PhotonTracerTask(tracer, i, nPhotons, seed,
+                                              reporter));
+    vector<Task *> tasks(chunks.begin(), chunks.end());
+    // The chunks seed their own RNG, skipping the finished ones on resume
+    // leaves the streams of the others unchanged.  The hits of each batch
+    // are added once it is finished, in chunk order
+    RunTasksWithCheckpoints(tasks, title, nPhotons ^ (uint64_t(seed) << 40),
+                            state, reporter,
+                            [&](uint64_t begin, uint64_t end) {
+        for (uint64_t i = begin; i < end; ++i)
+            chunks[i]->Flush();
+    });
+    for (uint32_t i = 0; i < tasks.size(); ++i)
+        delete tasks[i];
+    reporter.Done();
+}
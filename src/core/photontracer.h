@@ -0,0 +1,68 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#ifndef PBRT_CORE_PHOTONTRACER_H
+#define PBRT_CORE_PHOTONTRACER_H
+
+// core/photontracer.h*
+#include "pbrt.h"
+#include "rng.h"
+class CheckpointState;
+
+// Number of photons traced with the same RNG stream
+static const uint64_t photonChunkSize = 1024;
+
+// PhotonTracer Declarations
+// Traces independent photons on the task system. The photons are split in
+// chunks of fixed size and the RNG of every chunk is seeded from the index
+// of its first photon, so each photon draws the same random numbers
+// regardless of the number of cores.  The sensor hits of a chunk are
+// logged and added to the films in chunk order, which keeps the films
+// bit-identical for any number of cores as well.  Sharded renders trace the
+// chunks of their shard only.
+class PhotonTracer {
+public:
+    // PhotonTracer Interface
+    virtual ~PhotonTracer();
+    virtual void Trace(uint64_t photon, RNG &rng) = 0;
+};
+
+
+void TracePhotons(PhotonTracer *tracer, uint64_t nPhotons,
+                  const string &title, uint32_t seed = 0,
+                  CheckpointState *state = NULL, bool sharded = false);
+uint32_t PhotonChunkSeed(uint64_t chunk, uint32_t seed);
+
+#endif // PBRT_CORE_PHOTONTRACER_H
@@ -84,6 +84,7 @@ public:
                   const Transform &ObjectToWorld, MemoryArena &arena) const;
     BSSRDF *GetBSSRDF(const DifferentialGeometry &dg,
                       const Transform &ObjectToWorld, MemoryArena &arena) const;
+    const Reference<Shape> &GetShape() const { return shape; }
 private:
     // GeometricPrimitive Private Data
     Reference<Shape> shape;
@@ -47,6 +47,7 @@ Scene::~Scene() {
     delete volumeRegion;
     for (uint32_t i = 0; i < lights.size(); ++i)
         delete lights[i];
+    delete sensorAccel;
     for (uint32_t i = 0; i < sensors.size(); ++i)
             delete sensors[i];
 }
@@ -57,6 +58,7 @@ Scene::Scene(Primitive *accel, const vector<Light *> &lts,
              const vector<Bead*> &bds) {
     lights = lts;
     sensors = snsrs;
+    sensorAccel = new SensorBVH(sensors);
     beads = bds;
     aggregate = accel;
     volumeRegion = vr;
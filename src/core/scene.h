@@ -41,6 +41,7 @@
 #include "primitive.h"
 #include "integrator.h"
 #include "sensor.h"
+#include "sensorbvh.h"
 #include "shapes/bead.h"
 
 // Scene Declarations
@@ -62,6 +63,9 @@ public:
         PBRT_FINISHED_RAY_INTERSECTIONP(const_cast<Ray *>(&ray), int(hit));
         return hit;
     }
+    Sensor *HitSensor(const Ray &ray, float tMax, float *tHit) const {
+        return sensorAccel->Hit(ray, tMax, tHit);
+    }
     const BBox &WorldBound() const;
 
     // Scene Public Data
@@ -69,6 +73,7 @@ public:
     vector<Light *> lights;
     VolumeRegion *volumeRegion;
     vector<Sensor *> sensors;
+    SensorBVH *sensorAccel;
     vector<Bead *> beads;
     BBox bound;
 };
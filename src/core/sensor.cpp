@@ -37,25 +37,97 @@
 #include "sensor.h"
 #include "paramset.h"
 #include "imageio.h"
+#include "herowavelength.h"
+#include "parallel.h"
+#include "sensorfile.h"
+#include "checkpoint.h"
+#include "shard.h"
+#include "shapes/disk.h"
 #include <typeinfo>
 #include <fstream>
 #include <math.h>
 #include <stdio.h>
 #include <iostream>
 #include <cmath>
-#include <mutex>
 
 using namespace std;
 
-std::mutex locker;
+// SensorHits Method Definitions
+void SensorHits::Add(Sensor *sensor, uint64_t index, const Spectrum &L,
+                     float energy, const Record *record, int64_t angularBin,
+                     const HeroWavelengths *wavelengths) {
+    Hit hit;
+    hit.sensor = sensor;
+    hit.index = index;
+    hit.L = L;
+    hit.energy = energy;
+    hit.angularBin = angularBin;
+    hit.hasRecord = (record != NULL);
+    if (record)
+        records.push_back(*record);
+    hit.nSamples = -1;
+    if (wavelengths) {
+        // Keep the spectral samples the wavelengths fall in
+        hit.nSamples = 0;
+        for (int i = 0; i < wavelengths->Count(); i++) {
+            const int sample = SpectrumSampleIndex(wavelengths->Wavelength(i));
+            if (sample < 0) continue;
+            samples.push_back(make_pair(sample, wavelengths->Weight(i)));
+            hit.nSamples++;
+        }
+    }
+    hits.push_back(hit);
+}
+
+
+void SensorHits::Flush(void) {
+    // Add the hits in the order they were logged, locking each film once
+    // per run of hits on the same sensor
+    size_t record = 0, sample = 0;
+    for (size_t i = 0; i < hits.size(); ) {
+        Sensor *sensor = hits[i].sensor;
+        MutexLock lock(*sensor->filmMutex);
+        for (; i < hits.size() && hits[i].sensor == sensor; i++) {
+            const Hit &hit = hits[i];
+            const int nSamples = max(hit.nSamples, 0);
+            sensor->AddHit(hit.index, hit.L, hit.energy,
+                           hit.hasRecord ? &records[record] : NULL,
+                           hit.angularBin, hit.nSamples,
+                           nSamples > 0 ? &samples[sample] : NULL);
+            if (hit.hasRecord) record++;
+            sample += nSamples;
+        }
+    }
+    Clear();
+}
 
 
+void SensorHits::Clear(void) {
+    hits.clear();
+    records.clear();
+    samples.clear();
+}
+
+
+static thread_local SensorHits *threadHits = NULL;
+SensorHits *SetThreadSensorHits(SensorHits *hits) {
+    SensorHits *previous = threadHits;
+    threadHits = hits;
+    return previous;
+}
+
+
+// Sensor Method Definitions
 Sensor::Sensor(const std::string shapeid, const std::string shaperef,
                const Shape* surface, const uint64_t xres, const uint64_t yres,
-               const float widthum, const float heightum, const float fov)
-    : surfaceShape(shapeid), reference(shaperef), shape(surface),
+               const float widthum, const float heightum, const float fov,
+               const bool binaryoutput, const bool spectralcube)
+    : surfaceShape(shapeid), reference(shaperef),
+      outputName(ShardFileName(shaperef)),
+      shape(surface),
       xPixels(xres), yPixels(yres),
-      xLength_um(widthum), yLength_um(heightum), fieldOfView(fov) {
+      xLength_um(widthum), yLength_um(heightum), fieldOfView(fov),
+      binaryOutput(binaryoutput), writeSpectralCube(spectralcube) {
     pixelArea = xres * yres;
     area_um2 = widthum * heightum;
     hitCount = 0;
@@ -65,53 +137,141 @@ Sensor::Sensor(const std::string shapeid, const std::string shaperef,
         Lpixels[i] = Spectrum(0.f);
         recordedEnergy[i] = 0.f;
     }
+    spectralEnergy = new float[nSpectralSamples];
+    for (int i = 0; i < nSpectralSamples; i++)
+        spectralEnergy[i] = 0.f;
+    spectralHitCount = 0;
+
+    // Cache the surface in world space, the hit tests then only intersect
+    // the plane and check the extent. A disk lies at its height while a
+    // rectangle is intersected at z = 0 whatever its height
+    const BBox objectBound = shape->ObjectBound();
+    const Disk *disk = dynamic_cast<const Disk *>(shape);
+    isDisk = (disk != NULL);
+    planePoint = (*shape->ObjectToWorld)(
+        Point(0.f, 0.f, isDisk ? objectBound.pMin.z : 0.f));
+    planeNormal = Normalize((*shape->ObjectToWorld)(Normal(0, 0, 1)));
+    shape->Sample(0.5f, 0.5f, &frontNormal);
+    xHalfLength = objectBound.pMax.x;
+    yHalfLength = objectBound.pMax.y;
+    innerRadius2 = disk ? disk->InnerRadius() * disk->InnerRadius() : 0.f;
+    phiMax = disk ? disk->PhiMax() : 2.f * M_PI;
+    cosFieldOfView = cosf(Radians(fov));
+    worldBound = shape->WorldBound();
+    worldBound.Expand(1e-4f * Distance(worldBound.pMin, worldBound.pMax));
+
+    // Keep the raw records until an angular histogram is requested
+    thetaBins = phiBins = 0;
+    angularTile = 1;
+    thetaMax = 90.f;
+    xTiles = yTiles = 0;
+    angularBins = 0;
+    angularEnergy = NULL;
+
+    // Leave room for the worker threads as well as the OpenMP ones
+    buffers.resize(4 * NumSystemCores(), NULL);
+    filmMutex = Mutex::Create();
 }
 
 
-bool Sensor::Intersect(const Ray &ray, float *tHit) {
-    DifferentialGeometry dgLight;
-    float rayEpsilon;
-    if (shape->Intersect(ray, tHit, &rayEpsilon, &dgLight)) {
-        // Obtain the normal on the surface.
-        Normal surfaceNormal;
-        shape->Sample(0.f, 0.f, &surfaceNormal);
-
-        // Make sure that the ray is coming in the direction of the surface
-        // of the sensor.
-        const float theta = Degrees(acos(Dot(-surfaceNormal, ray.d)));
-        if (abs(theta) >= 0.f && abs(theta) < 90.0)
-            return true;
-    }
-    return false;
-}
-
-
-bool Sensor::Hit(const Ray &ray, float *tHit, float tMax) {
-    // Check if the ray hits the sensor
-    if (!Intersect(ray, tHit))
+bool Sensor::HitSurface(const Ray &ray, float tMax, bool checkFieldOfView,
+                        float *tHit) const {
+    // Make sure that the ray is coming in the direction of the surface
+    // of the sensor, and within the angle of acceptance if asked; the
+    // direction of the ray need not be normalized
+    if (!(Dot(-frontNormal, ray.d) > 0.f))
         return false;
-    if (tMax < *tHit)
+    const float dDotN = Dot(planeNormal, ray.d);
+    if (checkFieldOfView && fieldOfView > 0.f &&
+        -dDotN < cosFieldOfView * ray.d.Length())
         return false;
 
-    // Check if the ray hits within the range of the angle of acceptance
-    // Get the normal on the sensor
-    Normal normal = Normalize((*shape->ObjectToWorld)(Normal(0,0,1)));
-    const float theta = Degrees(acos(Dot(-normal, ray.d)));
-    if (fieldOfView > 0) {
-        if (theta > fieldOfView) {
+    // Intersect the plane of the sensor, in the parametrization of the ray
+    const float t = Dot(planePoint - ray.o, planeNormal) / dDotN;
+    if (!(t >= ray.mint && t <= ray.maxt && t <= tMax))
+        return false;
+
+    // See if the hit point is inside the extent of the surface
+    const Point Pobj = (*shape->WorldToObject)(ray(t));
+    if (isDisk) {
+        const float dist2 = Pobj.x * Pobj.x + Pobj.y * Pobj.y;
+        if (dist2 > xHalfLength * xHalfLength || dist2 < innerRadius2)
             return false;
+        if (phiMax < 2.f * M_PI) {
+            float phi = atan2f(Pobj.y, Pobj.x);
+            if (phi < 0) phi += 2. * M_PI;
+            if (phi > phiMax)
+                return false;
         }
     }
-
+    else if (fabsf(Pobj.x) > xHalfLength || fabsf(Pobj.y) > yHalfLength)
+        return false;
+    *tHit = t;
     return true;
 }
 
 
-void Sensor::RecordHit(const Point& point, const Spectrum& energy) {
+bool Sensor::Intersect(const Ray &ray, float *tHit) const {
+    return HitSurface(ray, INFINITY, false, tHit);
+}
 
-    locker.lock();
-    hitCount++;
 
+bool Sensor::Hit(const Ray &ray, float *tHit, float tMax) const {
+    // Check if the ray hits the sensor within the range of the angle of
+    // acceptance
+    return HitSurface(ray, tMax, true, tHit);
+}
+
+
+const BBox &Sensor::WorldBound(void) const {
+    return worldBound;
+}
+
+
+void Sensor::FilmPosition(const Point &p, float *xPixel, float *yPixel,
+                          float *depth) const {
+    // Project the point along the normal of the sensor, on the same pixel
+    // grid as PixelIndex
+    const Point Pobj = (*shape->WorldToObject)(p);
+    const BBox sensorExtent = shape->ObjectBound();
+    *xPixel = (Pobj.x - sensorExtent.pMin.x) /
+        (sensorExtent.pMax.x - sensorExtent.pMin.x) * xPixels;
+    *yPixel = (Pobj.y - sensorExtent.pMin.y) /
+        (sensorExtent.pMax.y - sensorExtent.pMin.y) * yPixels;
+
+    // Distance in front of the sensor, where the recorded photons come from
+    *depth = Dot(p - planePoint, frontNormal);
+}
+
+
+Point Sensor::FilmPoint(float xPixel, float yPixel, float depth) const {
+    // Inverse of FilmPosition
+    const BBox sensorExtent = shape->ObjectBound();
+    const Point Pobj(Lerp(xPixel / xPixels, sensorExtent.pMin.x,
+                          sensorExtent.pMax.x),
+                     Lerp(yPixel / yPixels, sensorExtent.pMin.y,
+                          sensorExtent.pMax.y),
+                     sensorExtent.pMin.z);
+    return (*shape->ObjectToWorld)(Pobj) + depth * Vector(frontNormal);
+}
+
+
+void Sensor::AddFilm(const float *energy) {
+    // Add an image computed without tracing photons, e.g. a convolution;
+    // the hit count then keeps the expected number of hits
+    MergeBuffers();
+    double total = 0.0;
+    for (uint64_t i = 0; i < pixelArea; i++) {
+        Lpixels[i] += Spectrum(energy[i]);
+        recordedEnergy[i] += energy[i];
+        total += energy[i];
+    }
+    hitCount += uint64_t(max(total, 0.0) + 0.5);
+}
+
+
+uint64_t Sensor::PixelIndex(const Point& point, uint64_t *xPixel,
+                            uint64_t *yPixel) const {
     // Translate the point to the object space.
     Point Pobj = (*shape->WorldToObject)(point);
 
@@ -125,60 +285,246 @@ void Sensor::RecordHit(const Point& point, const Spectrum& energy) {
     const float yRelativeOffset = yDistance / ySensorLength;
 
     // Find the corresponding pixel.
-    const uint64_t xPixel = Floor2Int(xRelativeOffset * xPixels);
-    const uint64_t yPixel = Floor2Int(yRelativeOffset * yPixels);
-    const uint64_t index = xPixel + xPixels * yPixel;
+    *xPixel = Floor2Int(xRelativeOffset * xPixels);
+    *yPixel = Floor2Int(yRelativeOffset * yPixels);
+    return *xPixel + xPixels * *yPixel;
+}
+
+
+void Sensor::RecordHit(const Point& point, const Spectrum& energy) {
+
+    // Find the pixel that corresponds to the point.
+    uint64_t xPixel, yPixel;
+    const uint64_t index = PixelIndex(point, &xPixel, &yPixel);
 
     // Add the energy contribution to the pixel.
-    Lpixels[index] += energy;
-    recordedEnergy[index] += energy.y();
-    locker.unlock();
+    Accumulate(index, energy, energy.y(), NULL, -1, NULL);
 }
 
 
 void Sensor::RecordHitAndAngles(const Point& point, const Spectrum& energy,
         const Ray &ray) {
 
-    locker.lock();
-    hitCount++;
+    // Find the pixel that corresponds to the point.
+    uint64_t xPixel, yPixel;
+    const uint64_t index = PixelIndex(point, &xPixel, &yPixel);
 
-    // Translate the point to the object space.
-    Point Pobj = (*shape->WorldToObject)(point);
+    // Compute theta
+    const float theta = Degrees(acos(Dot(-planeNormal, ray.d)));
 
-    // Compute the relative offsets of the points on the sensor.
-    BBox sensorExtent = shape->ObjectBound();
-    const float xDistance = (Pobj.x - sensorExtent.pMin.x);
-    const float xSensorLength = (sensorExtent.pMax.x - sensorExtent.pMin.x);
-    const float xRelativeOffset = xDistance / xSensorLength;
-    const float yDistance = (Pobj.y - sensorExtent.pMin.y);
-    const float ySensorLength = (sensorExtent.pMax.y - sensorExtent.pMin.y);
-    const float yRelativeOffset = yDistance / ySensorLength;
+    // Bin the angle, or keep the raw record without a histogram
+    if (thetaBins > 0) {
+        const int64_t bin = AngularBin(xPixel, yPixel, theta, ray);
+        Accumulate(index, energy, energy.y(), NULL, bin, NULL);
+        return;
+    }
+    Record record;
+    record.x = xPixel;
+    record.y = yPixel;
+    record.theta = theta;
+
+    // Add the energy contribution to the pixel.
+    Accumulate(index, energy, energy.y(), &record, -1, NULL);
+}
+
+
+void Sensor::RecordHit(const Point& point,
+                       const HeroWavelengths& wavelengths) {
+
+    // Find the pixel that corresponds to the point.
+    uint64_t xPixel, yPixel;
+    const uint64_t index = PixelIndex(point, &xPixel, &yPixel);
+
+    // Add the energy contribution to the pixel and the spectrum.
+    const float energy = wavelengths.Energy();
+    Accumulate(index, Spectrum(energy), energy, NULL, -1, &wavelengths);
+}
 
-    // Find the corresponding pixel.
-    const uint64_t xPixel = Floor2Int(xRelativeOffset * xPixels);
-    const uint64_t yPixel = Floor2Int(yRelativeOffset * yPixels);
-    const uint64_t index = xPixel + xPixels * yPixel;
 
-    // Compute the normal and theta
-    Normal normal = Normalize((*shape->ObjectToWorld)(Normal(0,0,1)));
-    const float theta = Degrees(acos(Dot(-normal, ray.d)));
+void Sensor::RecordHitAndAngles(const Point& point,
+                                const HeroWavelengths& wavelengths,
+                                const Ray &ray) {
 
+    // Find the pixel that corresponds to the point.
+    uint64_t xPixel, yPixel;
+    const uint64_t index = PixelIndex(point, &xPixel, &yPixel);
+
+    // Compute theta
+    const float theta = Degrees(acos(Dot(-planeNormal, ray.d)));
+
+    // Add the energy contribution to the pixel and the spectrum.
+    const float energy = wavelengths.Energy();
+    if (thetaBins > 0) {
+        const int64_t bin = AngularBin(xPixel, yPixel, theta, ray);
+        Accumulate(index, Spectrum(energy), energy, NULL, bin, &wavelengths);
+        return;
+    }
     Record record;
     record.x = xPixel;
     record.y = yPixel;
     record.theta = theta;
-    records.push_back(record);
+    Accumulate(index, Spectrum(energy), energy, &record, -1, &wavelengths);
+}
+
+
+int64_t Sensor::AngularBin(uint64_t xPixel, uint64_t yPixel, float theta,
+                           const Ray &ray) const {
+    // Hits beyond the binned range only count in the film
+    if (!(theta >= 0.f) || theta >= thetaMax)
+        return -1;
+    const uint32_t thetaBin = min(uint32_t(theta / thetaMax * thetaBins),
+                                  thetaBins - 1);
+
+    // Measure phi in the plane of the sensor, from its x axis
+    uint32_t phiBin = 0;
+    if (phiBins > 1) {
+        const Vector w = -(*shape->WorldToObject)(ray.d);
+        float phi = atan2f(w.y, w.x);
+        if (phi < 0.f) phi += 2.f * M_PI;
+        phiBin = min(uint32_t(phi * INV_TWOPI * phiBins), phiBins - 1);
+    }
+    const uint64_t xTile = min(xPixel / angularTile, xTiles - 1);
+    const uint64_t yTile = min(yPixel / angularTile, yTiles - 1);
+    const uint64_t bin = uint64_t(thetaBin) * phiBins + phiBin;
+    return int64_t(bin * xTiles * yTiles + xTile + xTiles * yTile);
+}
+
+
+void Sensor::Accumulate(uint64_t index, const Spectrum &L, float energy,
+                        const Record *record, int64_t angularBin,
+                        const HeroWavelengths *wavelengths) {
+    // A photon tracer task logs the hits of its chunk, they are added in
+    // the order of the chunks
+    if (threadHits) {
+        threadHits->Add(this, index, L, energy, record, angularBin,
+                        wavelengths);
+        return;
+    }
+
+    // Other threads log their hits without locking and add them to the
+    // film whenever their log is full
+    const int thread = ThreadIndex();
+    if (thread < int(buffers.size())) {
+        if (!buffers[thread])
+            buffers[thread] = new SensorHits;
+        SensorHits *hits = buffers[thread];
+        hits->Add(this, index, L, energy, record, angularBin, wavelengths);
+        if (hits->Size() >= sensorHitsCapacity)
+            hits->Flush();
+        return;
+    }
+
+    // Threads beyond the available slots add their hits one at a time
+    SensorHits hits;
+    hits.Add(this, index, L, energy, record, angularBin, wavelengths);
+    hits.Flush();
+}
+
+
+void Sensor::AddHit(uint64_t index, const Spectrum &L, float energy,
+                    const Record *record, int64_t angularBin, int nSamples,
+                    const pair<int, float> *samples) {
+    hitCount++;
+    Lpixels[index] += L;
+    recordedEnergy[index] += energy;
+    if (record)
+        records.push_back(*record);
+    if (angularBin >= 0)
+        angularEnergy[angularBin] += energy;
+    if (nSamples >= 0) {
+        spectralHitCount++;
+        for (int i = 0; i < nSamples; i++)
+            spectralEnergy[samples[i].first] += samples[i].second;
+    }
+}
+
+
+void Sensor::MergeBuffers(void) {
+    // Add the hits the threads still hold; the hits must no longer be
+    // recorded concurrently
+    for (size_t i = 0; i < buffers.size(); i++)
+        if (buffers[i]) buffers[i]->Flush();
+}
+
+
+void Sensor::Reset(void) {
+    // Drop the hits of the previous frame, recorded or still buffered
+    for (size_t i = 0; i < buffers.size(); i++)
+        if (buffers[i]) buffers[i]->Clear();
+    for (uint64_t i = 0; i < pixelArea; i++) {
+        Lpixels[i] = Spectrum(0.f);
+        recordedEnergy[i] = 0.f;
+    }
+    for (int i = 0; i < nSpectralSamples; i++)
+        spectralEnergy[i] = 0.f;
+    for (uint64_t i = 0; i < angularBins; i++)
+        angularEnergy[i] = 0.f;
+    hitCount = 0;
+    spectralHitCount = 0;
+    records.clear();
+}
+
+
+bool Sensor::WriteCheckpoint(FILE *file) {
+    // Save everything recorded so far, including the buffered hits
+    MergeBuffers();
+    return WriteCheckpointArray(file, Lpixels, pixelArea) &&
+           WriteCheckpointArray(file, recordedEnergy, pixelArea) &&
+           WriteCheckpointArray(file, spectralEnergy,
+                                uint64_t(nSpectralSamples)) &&
+           WriteCheckpointArray(file, angularEnergy, angularBins) &&
+           WriteCheckpointArray(file, &hitCount, 1) &&
+           WriteCheckpointArray(file, &spectralHitCount, 1) &&
+           WriteCheckpointVector(file, records);
+}
+
+
+bool Sensor::ReadCheckpoint(FILE *file) {
+    // Replace the hits recorded so far by the ones of the snapshot
+    Reset();
+    return ReadCheckpointArray(file, Lpixels, pixelArea) &&
+           ReadCheckpointArray(file, recordedEnergy, pixelArea) &&
+           ReadCheckpointArray(file, spectralEnergy,
+                               uint64_t(nSpectralSamples)) &&
+           ReadCheckpointArray(file, angularEnergy, angularBins) &&
+           ReadCheckpointArray(file, &hitCount, 1) &&
+           ReadCheckpointArray(file, &spectralHitCount, 1) &&
+           ReadCheckpointVector(file, &records);
+}
 
-    // Add the energy contribution to the pixel.
-    Lpixels[index] += energy;
-    recordedEnergy[index] += energy.y();
 
-    locker.unlock();
+void Sensor::SetOutputName(const std::string &name) {
+    outputName = ShardFileName(name);
 }
 
+
+void Sensor::SetAngularHistogram(uint32_t thetabins, uint32_t phibins,
+                                 uint32_t tilesize, float thetamax) {
+    // Start over from the hits recorded so far
+    Reset();
+    delete [] angularEnergy;
+    angularEnergy = NULL;
+    thetaBins = thetabins;
+    phiBins = max(phibins, 1u);
+    angularTile = max(tilesize, 1u);
+    thetaMax = thetamax;
+    xTiles = (xPixels + angularTile - 1) / angularTile;
+    yTiles = (yPixels + angularTile - 1) / angularTile;
+    angularBins = 0;
+    if (thetaBins == 0)
+        return;
+
+    // The memory of the histogram is bounded by the tiles and bins
+    angularBins = xTiles * yTiles * thetaBins * phiBins;
+    angularEnergy = new float[angularBins];
+    for (uint64_t i = 0; i < angularBins; i++)
+        angularEnergy[i] = 0.f;
+}
+
+
 bool Sensor::ComputeRefractedRay(const Ray &ray, float tHit, Ray& refractedRay) const {
     // Get the normal on the sensor
-    Normal normal = Normalize((*shape->ObjectToWorld)(Normal(0,0,1)));
+    const Normal &normal = planeNormal;
     const float theta1 = acos(Dot(-normal, ray.d));
 
     // Use Snell's law to get theta2
@@ -246,17 +592,20 @@ float Sensor::FOV(void) const {
 }
 
 
-Spectrum* Sensor::FilmRadiance(void) const {
+Spectrum* Sensor::FilmRadiance(void) {
+    MergeBuffers();
     return Lpixels;
 }
 
 
-uint64_t Sensor::HitCount(void) const {
+uint64_t Sensor::HitCount(void) {
+    MergeBuffers();
     return hitCount;
 }
 
 
 void Sensor::WriteFilm(void) {
+    MergeBuffers();
     float *rgb = new float[3*pixelArea];
     int offset = 0;
     int index = 0;
@@ -273,40 +622,159 @@ void Sensor::WriteFilm(void) {
         }
     }
 
-    // Write an RGB image
-    const string sensorImageName = reference + ".exr";
-    ::WriteImage(sensorImageName, rgb, NULL, xPixels, yPixels,
-                 xPixels, yPixels, 0, 0);
+    // Write an RGB image, pbrtmerge writes the one of sharded renders
+    const string sensorImageName = outputName + ".exr";
+    if (!Sharded())
+        ::WriteImage(sensorImageName, rgb, NULL, xPixels, yPixels,
+                     xPixels, yPixels, 0, 0);
 
     // Write the VSD image
-    const string file =  reference + ".vsd";
-    fstream stream(file.c_str(), ios::out);
-    for (uint64_t x = 0; x < xPixels; ++x)
-        for (uint64_t y = 0; y < yPixels; ++y)
-            stream << x << " " << y << " "
-                   << recordedEnergy[x + xPixels* y] << endl;
-    stream.close();
+    if (binaryOutput)
+        WriteBinaryFile(outputName + ".sensor", writeSpectralCube, false);
+    else {
+        const string file =  outputName + ".vsd";
+        fstream stream(file.c_str(), ios::out);
+        for (uint64_t x = 0; x < xPixels; ++x)
+            for (uint64_t y = 0; y < yPixels; ++y)
+                stream << x << " " << y << " "
+                       << recordedEnergy[x + xPixels* y] << endl;
+        stream.close();
+    }
 
      printf("Recorded photons [%zu] \n", hitCount);
 
     delete [] rgb;
+
+    // Write the spectrum if the hits were recorded per wavelength
+    if (spectralHitCount > 0)
+        WriteSpectrum();
 }
 
 
 void Sensor::WriteRecords(void)
 {
+    MergeBuffers();
+    if (thetaBins > 0) {
+        WriteAngularHistogram();
+        return;
+    }
+
     // Write the records
-    const string file =  reference + ".photons";
+    const string file =  outputName + ".photons";
+    if (binaryOutput)
+        WriteBinaryFile(file, false, true);
+    else {
+        fstream stream(file.c_str(), ios::out);
+        for(size_t i = 0; i < records.size(); i++) {
+            stream << records[i].x << " " << records[i].y << " "
+                   << records[i].theta << "\n";
+        }
+        stream.close();
+    }
+
+    printf("Photos recorded [%zu] \n", records.size());
+}
+
+void Sensor::WriteAngularHistogram(void)
+{
+    const string file =  outputName + ".angular";
+    if (binaryOutput) {
+        // One plane of tiles per angular bin
+        SensorFileHeader header;
+        memset(&header, 0, sizeof(header));
+        header.flags = sensorFileAngular;
+        header.xPixels = xTiles;
+        header.yPixels = yTiles;
+        header.hitCount = hitCount;
+        header.width_um = xLength_um;
+        header.height_um = yLength_um;
+        header.fov = fieldOfView;
+        header.nPlanes = thetaBins * phiBins;
+        header.thetaBins = thetaBins;
+        header.phiBins = phiBins;
+        header.tileSize = angularTile;
+        header.thetaMax = thetaMax;
+        ::WriteSensorFile(file, header, angularEnergy, NULL, NULL);
+    }
+    else {
+        // Only the bins that recorded any energy
+        fstream stream(file.c_str(), ios::out);
+        const uint64_t nTiles = xTiles * yTiles;
+        for (uint64_t i = 0; i < angularBins; i++) {
+            if (angularEnergy[i] == 0.f)
+                continue;
+            const uint64_t tile = i % nTiles, bin = i / nTiles;
+            stream << tile % xTiles << " " << tile / xTiles << " "
+                   << bin / phiBins << " " << bin % phiBins << " "
+                   << angularEnergy[i] << "\n";
+        }
+        stream.close();
+    }
+
+    printf("Angular histogram of [%zu] photons, %u x %u bins \n", hitCount,
+           thetaBins, phiBins);
+}
+
+
+void Sensor::WriteBinaryFile(const std::string &file, bool spectra,
+                             bool photons)
+{
+    // Describe the sensor
+    SensorFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.xPixels = xPixels;
+    header.yPixels = yPixels;
+    header.hitCount = hitCount;
+    header.width_um = xLength_um;
+    header.height_um = yLength_um;
+    header.fov = fieldOfView;
+    header.lambdaStart = sampledLambdaStart;
+    header.lambdaEnd = sampledLambdaEnd;
+    header.nPlanes = photons ? 0 : 4;
+    header.nSpectralSamples = spectra ? nSpectralSamples : 0;
+
+    // The energy plane followed by the X, Y and Z planes
+    float *planes = NULL;
+    if (!photons) {
+        planes = new float[4 * pixelArea];
+        memcpy(planes, recordedEnergy, pixelArea * sizeof(float));
+        for (uint64_t i = 0; i < pixelArea; i++) {
+            float xyz[3];
+            Lpixels[i].ToXYZ(xyz);
+            planes[pixelArea + i] = xyz[0];
+            planes[2 * pixelArea + i] = xyz[1];
+            planes[3 * pixelArea + i] = xyz[2];
+        }
+    }
+    float *cube = NULL;
+    if (spectra) {
+        cube = new float[nSpectralSamples * pixelArea];
+        for (int s = 0; s < nSpectralSamples; s++)
+            for (uint64_t i = 0; i < pixelArea; i++)
+                cube[s * pixelArea + i] =
+                    Lpixels[i].GetSampleValueAtWavelengthIndex(s);
+    }
+    ::WriteSensorFile(file, header, planes, cube, photons ? &records : NULL);
+    delete[] planes;
+    delete[] cube;
+}
+
+
+void Sensor::WriteSpectrum(void)
+{
+    // Write the energy recorded at each spectral sample
+    const string file =  outputName + ".spectrum";
     fstream stream(file.c_str(), ios::out);
-    for(size_t i = 0; i < records.size(); i++) {
-        stream << records[i].x << " " << records[i].y << " "
-               << records[i].theta << "\n";
+    for (int i = 0; i < nSpectralSamples; i++) {
+        stream << SpectrumSampleWavelength(i) << " "
+               << spectralEnergy[i] << "\n";
     }
     stream.close();
 
-    printf("Photos recorded [%zu] \n", records.size());
+    printf("Spectral hits recorded [%zu] \n", spectralHitCount);
 }
 
+
 Sensor* CreateSensor(const std::string shapeId, Shape* shape,
                      const ParamSet &params)
 {
@@ -315,20 +783,50 @@ Sensor* CreateSensor(const std::string shapeId, Shape* shape,
     const uint64_t xPixels = params.FindOneInt("xpixels", 0);
     const uint64_t yPixels = params.FindOneInt("ypixels", 0);
     const float fov = params.FindOneFloat("fov", 0.f);
+    // "binary" writes .sensor files, "ascii" the former text files
+    const string format = params.FindOneString("outputformat", "binary");
+    bool binary = (format != string("ascii"));
+    if (!binary && Sharded()) {
+        Warning("Sharded renders write binary sensor files for pbrtmerge");
+        binary = true;
+    }
+    bool spectralCube = params.FindOneBool("spectralcube", false);
+#ifndef PBRT_SAMPLED_SPECTRUM
+    // RGBSpectrum has no samples per wavelength, the cube would be zeros
+    if (spectralCube) {
+        Warning("\"spectralcube\" needs a build with PBRT_SAMPLED_SPECTRUM, "
+                "no spectral cube is written for \"%s\"", reference.c_str());
+        spectralCube = false;
+    }
+#endif
+    // "histogram" bins the hit angles on-line, "records" keeps every hit
+    const string angular = params.FindOneString("angularoutput", "histogram");
+    const int thetaBins = params.FindOneInt("thetabins", 90);
+    const int phiBins = params.FindOneInt("phibins", 1);
+    const int angularTile = params.FindOneInt("angulartile", 16);
+    const float thetaMax = params.FindOneFloat("thetamax", 90.f);
 
     if (shapeId == std::string("disk")) {
         float radius = params.FindOneFloat("radius", 0.f);
         sensor = new Sensor(shapeId, reference, shape,
-                            xPixels, yPixels, 2 * radius, 2 * radius, fov);
+                            xPixels, yPixels, 2 * radius, 2 * radius, fov,
+                            binary, spectralCube);
     } else if (shapeId == std::string("rectangle")) {
         float x = params.FindOneFloat("x", 0.f);
         float y = params.FindOneFloat("y", 0.f);
         sensor = new Sensor(shapeId, reference, shape,
-                            xPixels, yPixels, x, y, fov);
+                            xPixels, yPixels, x, y, fov,
+                            binary, spectralCube);
     } else {
         Error("The sensor is defined for disk and rectangle shapes only");
         exit(0);
     }
+    if (angular == string("histogram"))
+        sensor->SetAngularHistogram(max(thetaBins, 1), max(phiBins, 1),
+                                    max(angularTile, 1), thetaMax);
+    else if (angular != string("records"))
+        Warning("Unknown angular output \"%s\", keeping the raw records",
+                angular.c_str());
 
     return sensor;
 }
@@ -336,5 +834,11 @@ Sensor* CreateSensor(const std::string shapeId, Shape* shape,
 
 // Shape Method Definitions
 Sensor::~Sensor() {
+    for (size_t i = 0; i < buffers.size(); i++)
+        delete buffers[i];
+    Mutex::Destroy(filmMutex);
     delete [] Lpixels;
+    delete [] recordedEnergy;
+    delete [] spectralEnergy;
+    delete [] angularEnergy;
 }
@@ -35,6 +35,7 @@
 // core/sensor.h*
 #include "pbrt.h"
 #include "geometry.h"
+#include "spectrum.h"
 #include "transform.h"
 #include "diffgeom.h"
 #include "memory.h"
@@ -49,18 +50,62 @@ struct Record
 
 typedef std::vector< Record > Records;
 
+class HeroWavelengths;
+class Sensor;
+class Mutex;
+
+// Number of hits a thread logs before adding them to the film
+static const uint64_t sensorHitsCapacity = 1024;
+
+// SensorHits Declarations
+// Hits logged without locking by a single thread and added to their sensor
+// films, in the order they were logged, when the log is flushed.  A log
+// keeps a bounded number of hits rather than a copy of the film.
+class SensorHits {
+public:
+    void Add(Sensor *sensor, uint64_t index, const Spectrum &L, float energy,
+        const Record *record, int64_t angularBin,
+        const HeroWavelengths *wavelengths);
+    uint64_t Size(void) const { return hits.size(); }
+    void Flush(void);
+    void Clear(void);
+
+private:
+    struct Hit {
+        Sensor *sensor;
+        uint64_t index;
+        Spectrum L;
+        float energy;
+        int64_t angularBin;
+        bool hasRecord; // The next entry of _records_ belongs to the hit.
+        int nSamples; // Entries of _samples_, or -1 without wavelengths.
+    };
+    std::vector<Hit> hits;
+    Records records;
+    std::vector<std::pair<int, float> > samples;
+};
+
 class Sensor : public ReferenceCounted
 {
 public:
     Sensor(const std::string shapeid, const std::string shaperef,
            const Shape* surface, const uint64_t xres, const uint64_t yres,
-           const float widthum, const float heightum, const float fov);
-
-    bool Intersect(const Ray &ray, float *tHit);
-    bool Hit(const Ray &ray, float *tHit, float tMax);
+           const float widthum, const float heightum, const float fov,
+           const bool binaryoutput = true, const bool spectralcube = false);
+
+    bool Intersect(const Ray &ray, float *tHit) const;
+    bool Hit(const Ray &ray, float *tHit, float tMax) const;
+    const BBox &WorldBound(void) const;
+    void FilmPosition(const Point &p, float *xPixel, float *yPixel,
+        float *depth) const;
+    Point FilmPoint(float xPixel, float yPixel, float depth) const;
+    void AddFilm(const float *energy);
     void RecordHit(const Point& point, const Spectrum& energy);
     void RecordHitAndAngles(const Point& point, const Spectrum& energy,
         const Ray &ray);
+    void RecordHit(const Point& point, const HeroWavelengths& wavelengths);
+    void RecordHitAndAngles(const Point& point,
+        const HeroWavelengths& wavelengths, const Ray &ray);
     bool ComputeRefractedRay(const Ray &ray, float tHit, Ray& refractedRay) const;
     std::string ReferenceString(void) const;
     float SurfaceArea(void) const;
@@ -71,17 +116,50 @@ public:
     float FilmHeight_um(void) const;
     float FilmArea_um2(void) const;
     float FOV(void) const;
-    Spectrum* FilmRadiance(void) const;
-    uint64_t HitCount(void) const;
+    Spectrum* FilmRadiance(void);
+    uint64_t HitCount(void);
     void WriteFilm(void);
     void WriteRecords(void);
+    void WriteSpectrum(void);
+    void MergeBuffers(void);
+    void Reset(void);
+    bool WriteCheckpoint(FILE *file);
+    bool ReadCheckpoint(FILE *file);
+    void SetOutputName(const std::string &name);
+    void SetAngularHistogram(uint32_t thetabins, uint32_t phibins,
+                             uint32_t tilesize, float thetamax);
 
     ~Sensor();
 
 private:
+    friend class SensorHits;
+    bool HitSurface(const Ray &ray, float tMax, bool checkFieldOfView,
+        float *tHit) const;
+    uint64_t PixelIndex(const Point& point, uint64_t *xPixel,
+        uint64_t *yPixel) const;
+    void Accumulate(uint64_t index, const Spectrum &L, float energy,
+        const Record *record, int64_t angularBin,
+        const HeroWavelengths *wavelengths);
+    void AddHit(uint64_t index, const Spectrum &L, float energy,
+        const Record *record, int64_t angularBin, int nSamples,
+        const std::pair<int, float> *samples);
+    int64_t AngularBin(uint64_t xPixel, uint64_t yPixel, float theta,
+        const Ray &ray) const;
+    void WriteAngularHistogram(void);
+    void WriteBinaryFile(const std::string &file, bool spectra, bool photons);
+
     const std::string surfaceShape; // The shape of the surface.
     const std::string reference; // Reference name to the sensor.
+    std::string outputName; // Prefix of the files the sensor writes.
     const Shape* shape; // Sensor shape object.
+    Point planePoint; // World-space point on the sensor plane.
+    Normal planeNormal; // World-space normal of the sensor plane.
+    Normal frontNormal; // The plane normal as oriented by the shape.
+    bool isDisk; // Disk sensor, rectangular otherwise.
+    float xHalfLength, yHalfLength; // Object-space half extent.
+    float innerRadius2, phiMax; // Disk hole and sweep, in object space.
+    float cosFieldOfView; // Cosine of the field of view.
+    BBox worldBound; // World-space bounds of the sensor surface.
     uint64_t hitCount; // Total number of hits recorded/
     const uint64_t xPixels; // Number of pixels in x.
     const uint64_t yPixels; // Number of pixels in y.
@@ -90,11 +168,28 @@ private:
     const float yLength_um; // Sensor surface height in um.
     float area_um2; // Sensor surface area in um2.
     const float fieldOfView; // Sensor field of view.
+    const bool binaryOutput; // Write .sensor files instead of text files.
+    const bool writeSpectralCube; // Add the per-pixel spectra to them.
     Spectrum* Lpixels; // Radiance distribution recorded by the sensor.
     float* recordedEnergy; // Energy recorded by the sensor.
     Records records; // Keeps track on angle and pixel locations
+    uint32_t thetaBins; // Histogram bins in theta, no histogram if zero.
+    uint32_t phiBins; // Histogram bins in phi per theta bin.
+    uint32_t angularTile; // Sensor pixels per histogram tile side.
+    float thetaMax; // Largest angle binned, in degrees.
+    uint64_t xTiles, yTiles; // Histogram tiles in x and y.
+    uint64_t angularBins; // Total number of histogram bins.
+    float* angularEnergy; // Energy recorded per tile and angular bin.
+    float* spectralEnergy; // Energy recorded per spectral sample.
+    uint64_t spectralHitCount; // Number of hits recorded per wavelength.
+    std::vector<SensorHits*> buffers; // Hits logged by each thread.
+    Mutex* filmMutex; // Guards the film while hits are added to it.
 };
 
+// Makes the calling thread log its hits on every sensor to _hits_, or to
+// the logs of the sensors if NULL; returns the log it replaces
+SensorHits *SetThreadSensorHits(SensorHits *hits);
+
 Sensor* CreateSensor(const std::string shapeid, Shape* shape, const ParamSet &params);
 
 #endif // PBRT_CORE_SENSOR_H
@@ -0,0 +1,182 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+// core/sensorbvh.cpp*
+#include "stdafx.h"
+#include "sensorbvh.h"
+#include "sensor.h"
+
+// SensorBVH Local Declarations
+struct SensorBVHNode {
+    BBox bounds;
+    uint32_t offset;    // first sensor of a leaf, second child otherwise
+    uint16_t nSensors;  // 0 -> interior node
+    uint8_t axis;       // interior node: xyz
+    uint8_t pad;
+};
+
+
+struct CompareSensorCentroids {
+    CompareSensorCentroids(int a) : axis(a) { }
+    bool operator()(const Sensor *a, const Sensor *b) const {
+        const BBox &ba = a->WorldBound(), &bb = b->WorldBound();
+        return ba.pMin[axis] + ba.pMax[axis] < bb.pMin[axis] + bb.pMax[axis];
+    }
+    int axis;
+};
+
+
+static inline bool IntersectP(const BBox &bounds, const Ray &ray,
+        float tMax, const Vector &invDir, const uint32_t dirIsNeg[3]) {
+    // Check for ray intersection against $x$ and $y$ slabs
+    float tmin =  (bounds[  dirIsNeg[0]].x - ray.o.x) * invDir.x;
+    float tmax =  (bounds[1-dirIsNeg[0]].x - ray.o.x) * invDir.x;
+    float tymin = (bounds[  dirIsNeg[1]].y - ray.o.y) * invDir.y;
+    float tymax = (bounds[1-dirIsNeg[1]].y - ray.o.y) * invDir.y;
+    if ((tmin > tymax) || (tymin > tmax))
+        return false;
+    if (tymin > tmin) tmin = tymin;
+    if (tymax < tmax) tmax = tymax;
+
+    // Check for ray intersection against $z$ slab
+    float tzmin = (bounds[  dirIsNeg[2]].z - ray.o.z) * invDir.z;
+    float tzmax = (bounds[1-dirIsNeg[2]].z - ray.o.z) * invDir.z;
+    if ((tmin > tzmax) || (tzmin > tmax))
+        return false;
+    if (tzmin > tmin)
+        tmin = tzmin;
+    if (tzmax < tmax)
+        tmax = tzmax;
+    return (tmin <= min(ray.maxt, tMax)) && (tmax >= ray.mint);
+}
+
+
+// Sensors per leaf; a leaf costs a plane test per sensor
+static const uint32_t maxSensorsInNode = 2;
+
+// SensorBVH Method Definitions
+SensorBVH::SensorBVH(const vector<Sensor *> &s)
+    : sensors(s), nodes(NULL), nNodes(0) {
+    if (sensors.empty())
+        return;
+    vector<SensorBVHNode> buildNodes;
+    buildNodes.reserve(2 * sensors.size());
+    Build(0, sensors.size(), buildNodes);
+    nNodes = buildNodes.size();
+    nodes = AllocAligned<SensorBVHNode>(nNodes);
+    memcpy(nodes, &buildNodes[0], nNodes * sizeof(SensorBVHNode));
+}
+
+
+SensorBVH::~SensorBVH() {
+    FreeAligned(nodes);
+}
+
+
+uint32_t SensorBVH::Build(uint32_t start, uint32_t end,
+                          vector<SensorBVHNode> &buildNodes) {
+    // Bound the sensors and their centroids
+    BBox bounds, centroidBounds;
+    for (uint32_t i = start; i < end; ++i) {
+        const BBox &b = sensors[i]->WorldBound();
+        bounds = Union(bounds, b);
+        centroidBounds = Union(centroidBounds, .5f * b.pMin + .5f * b.pMax);
+    }
+    const uint32_t nodeNum = buildNodes.size();
+    buildNodes.push_back(SensorBVHNode());
+    buildNodes[nodeNum].bounds = bounds;
+    const int axis = centroidBounds.MaximumExtent();
+    if (end - start <= maxSensorsInNode ||
+        centroidBounds.pMax[axis] == centroidBounds.pMin[axis]) {
+        // Create leaf node; coincident sensors all go in the same leaf
+        buildNodes[nodeNum].offset = start;
+        buildNodes[nodeNum].nSensors = end - start;
+        buildNodes[nodeNum].axis = 0;
+        return nodeNum;
+    }
+
+    // Split the sensors at the median of their centroids
+    const uint32_t mid = (start + end) / 2;
+    std::nth_element(&sensors[start], &sensors[mid], &sensors[end-1]+1,
+                     CompareSensorCentroids(axis));
+    Build(start, mid, buildNodes);
+    const uint32_t second = Build(mid, end, buildNodes);
+    buildNodes[nodeNum].offset = second;
+    buildNodes[nodeNum].nSensors = 0;
+    buildNodes[nodeNum].axis = axis;
+    return nodeNum;
+}
+
+
+Sensor *SensorBVH::Hit(const Ray &ray, float tMax, float *tHit) const {
+    if (!nodes) return NULL;
+    Sensor *hit = NULL;
+    float tClosest = tMax;
+    Vector invDir(1.f / ray.d.x, 1.f / ray.d.y, 1.f / ray.d.z);
+    uint32_t dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+    // Follow the segment through the nodes, keeping the closest sensor hit
+    uint32_t todoOffset = 0, nodeNum = 0;
+    uint32_t todo[64];
+    while (true) {
+        const SensorBVHNode *node = &nodes[nodeNum];
+        if (::IntersectP(node->bounds, ray, tClosest, invDir, dirIsNeg)) {
+            if (node->nSensors > 0) {
+                for (uint32_t i = 0; i < node->nSensors; ++i) {
+                    Sensor *sensor = sensors[node->offset + i];
+                    float t;
+                    if (sensor->Hit(ray, &t, tClosest)) {
+                        hit = sensor;
+                        tClosest = t;
+                    }
+                }
+                if (todoOffset == 0) break;
+                nodeNum = todo[--todoOffset];
+            }
+            else {
+                // Put far node on _todo_ stack, advance to near node
+                if (dirIsNeg[node->axis]) {
+                   todo[todoOffset++] = nodeNum + 1;
+                   nodeNum = node->offset;
+                }
+                else {
+                   todo[todoOffset++] = node->offset;
+                   nodeNum = nodeNum + 1;
+                }
+            }
+        }
+        else {
+            if (todoOffset == 0) break;
+            nodeNum = todo[--todoOffset];
+        }
+    }
+    if (hit) *tHit = tClosest;
+    return hit;
+}
@@ -0,0 +1,67 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#ifndef PBRT_CORE_SENSORBVH_H
+#define PBRT_CORE_SENSORBVH_H
+
+// core/sensorbvh.h*
+#include "pbrt.h"
+#include "geometry.h"
+
+class Sensor;
+struct SensorBVHNode;
+
+// SensorBVH Declarations
+// Bounding volume hierarchy over the sensors of a scene, so that each photon
+// segment is only tested against the sensors whose bounds it crosses.
+class SensorBVH {
+public:
+    // SensorBVH Public Methods
+    SensorBVH(const vector<Sensor *> &sensors);
+    ~SensorBVH();
+    Sensor *Hit(const Ray &ray, float tMax, float *tHit) const;
+
+private:
+    // SensorBVH Private Methods
+    uint32_t Build(uint32_t start, uint32_t end,
+                   vector<SensorBVHNode> &nodes);
+
+    // SensorBVH Private Data
+    vector<Sensor *> sensors;
+    SensorBVHNode *nodes;
+    uint32_t nNodes;
+};
+
+
+#endif // PBRT_CORE_SENSORBVH_H
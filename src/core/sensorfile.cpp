@@ -0,0 +1,242 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+
+// core/sensorfile.cpp*
+#include "stdafx.h"
+#include "sensorfile.h"
+#include "sensor.h"
+#include <half.h>
+#include <zlib.h>
+
+// SensorFile Local Definitions
+static bool CompressColumn(const void *data, uint32_t nBytes,
+                           vector<uint8_t> &buffer, uint32_t *compressedBytes) {
+    uLongf size = compressBound(nBytes);
+    buffer.resize(size);
+    if (compress2(&buffer[0], &size, (const Bytef *)data, nBytes,
+                  Z_BEST_SPEED) != Z_OK)
+        return false;
+    *compressedBytes = uint32_t(size);
+    return true;
+}
+
+
+static bool WriteRecordBlocks(FILE *file, const vector<Record> &records) {
+    vector<uint16_t> xs, ys;
+    vector<half> thetas;
+    vector<uint8_t> buffers[3];
+    for (size_t first = 0; first < records.size();
+         first += sensorRecordBlockSize) {
+        // Split the block into columns
+        const uint32_t count = uint32_t(min(size_t(sensorRecordBlockSize),
+                                            records.size() - first));
+        xs.resize(count);
+        ys.resize(count);
+        thetas.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            const Record &record = records[first + i];
+            xs[i] = uint16_t(record.x);
+            ys[i] = uint16_t(record.y);
+            thetas[i] = half(record.theta);
+        }
+
+        // Compress the columns first, the block header then goes out with
+        // their sizes and the file is never sought back, whatever its size
+        uint32_t blockHeader[4] = { count, 0, 0, 0 };
+        if (!CompressColumn(&xs[0], count * sizeof(uint16_t), buffers[0],
+                            &blockHeader[1]) ||
+            !CompressColumn(&ys[0], count * sizeof(uint16_t), buffers[1],
+                            &blockHeader[2]) ||
+            !CompressColumn(&thetas[0], count * sizeof(half), buffers[2],
+                            &blockHeader[3]) ||
+            fwrite(blockHeader, sizeof(blockHeader), 1, file) != 1)
+            return false;
+        for (int c = 0; c < 3; c++)
+            if (fwrite(&buffers[c][0], 1, blockHeader[c + 1], file) !=
+                blockHeader[c + 1])
+                return false;
+    }
+    return true;
+}
+
+
+// Seeks to a 64-bit offset, _long_ is 32 bits on Windows
+static bool SeekFile(FILE *file, uint64_t offset) {
+#ifdef PBRT_IS_WINDOWS
+    return _fseeki64(file, __int64(offset), SEEK_SET) == 0;
+#else
+    return fseeko(file, off_t(offset), SEEK_SET) == 0;
+#endif
+}
+
+
+static bool ReadColumn(FILE *file, void *data, uint32_t nBytes,
+                       uint32_t compressedBytes, vector<uint8_t> &buffer) {
+    buffer.resize(compressedBytes);
+    if (fread(&buffer[0], 1, compressedBytes, file) != compressedBytes)
+        return false;
+    uLongf size = nBytes;
+    return uncompress((Bytef *)data, &size, &buffer[0], compressedBytes) ==
+           Z_OK && size == nBytes;
+}
+
+
+static bool ReadRecordBlocks(FILE *file, uint64_t nRecords,
+                             vector<Record> *records) {
+    vector<uint16_t> xs, ys;
+    vector<half> thetas;
+    vector<uint8_t> buffer;
+    records->reserve(records->size() + nRecords);
+    while (nRecords > 0) {
+        uint32_t blockHeader[4];
+        if (fread(blockHeader, sizeof(blockHeader), 1, file) != 1)
+            return false;
+        const uint32_t count = blockHeader[0];
+        if (count == 0 || count > nRecords) return false;
+        xs.resize(count);
+        ys.resize(count);
+        thetas.resize(count);
+        if (!ReadColumn(file, &xs[0], count * sizeof(uint16_t),
+                        blockHeader[1], buffer) ||
+            !ReadColumn(file, &ys[0], count * sizeof(uint16_t),
+                        blockHeader[2], buffer) ||
+            !ReadColumn(file, &thetas[0], count * sizeof(half),
+                        blockHeader[3], buffer))
+            return false;
+        for (uint32_t i = 0; i < count; i++) {
+            Record record;
+            record.x = xs[i];
+            record.y = ys[i];
+            record.theta = thetas[i];
+            records->push_back(record);
+        }
+        nRecords -= count;
+    }
+    return true;
+}
+
+
+// SensorFile Function Definitions
+// The caller describes the sensor and sets _flags_, _nPlanes_ and
+// _nSpectralSamples_ (zero without a spectral cube); the layout fields are
+// filled in here.
+bool WriteSensorFile(const string &filename, SensorFileHeader &header,
+                     const float *planes, const float *cube,
+                     const vector<Record> *records) {
+    Assert(sizeof(SensorFileHeader) == 128);
+    const uint64_t nPixels = header.xPixels * header.yPixels;
+    memcpy(header.magic, "PBRTSENS", 8);
+    header.version = 1;
+    memset(header.reserved, 0, sizeof(header.reserved));
+    header.planesOffset = sizeof(SensorFileHeader);
+    uint64_t offset = header.planesOffset +
+        header.nPlanes * nPixels * sizeof(float);
+    header.cubeOffset = 0;
+    if (cube && header.nSpectralSamples > 0) {
+        header.cubeOffset = offset;
+        offset += header.nSpectralSamples * nPixels * sizeof(float);
+    }
+    else
+        header.nSpectralSamples = 0;
+    header.recordsOffset = 0;
+    header.nRecords = 0;
+    header.recordBlockSize = sensorRecordBlockSize;
+    if (records && !records->empty()) {
+        // The columns store the pixels as 16-bit values
+        if (header.xPixels > 65536 || header.yPixels > 65536)
+            Warning("Photon records of sensors wider than 65536 pixels "
+                    "cannot be stored in \"%s\"", filename.c_str());
+        else {
+            header.recordsOffset = offset;
+            header.nRecords = records->size();
+        }
+    }
+
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        Error("Cannot open the sensor file \"%s\" for writing",
+              filename.c_str());
+        return false;
+    }
+    bool written = fwrite(&header, sizeof(header), 1, file) == 1;
+    if (written && header.nPlanes > 0)
+        written = fwrite(planes, sizeof(float), header.nPlanes * nPixels,
+                         file) == header.nPlanes * nPixels;
+    if (written && header.cubeOffset)
+        written = fwrite(cube, sizeof(float),
+                         header.nSpectralSamples * nPixels, file) ==
+                  header.nSpectralSamples * nPixels;
+    if (written && header.recordsOffset)
+        written = WriteRecordBlocks(file, *records);
+    fclose(file);
+    if (!written)
+        Error("Writing the sensor file \"%s\" failed", filename.c_str());
+    return written;
+}
+
+
+// Reads the planes, the cube and the records of a file written by
+// WriteSensorFile(); the records are appended to _records_
+bool ReadSensorFile(const string &filename, SensorFileHeader *header,
+                    vector<float> *planes, vector<float> *cube,
+                    vector<Record> *records) {
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (!file) {
+        Error("Cannot open the sensor file \"%s\"", filename.c_str());
+        return false;
+    }
+    if (fread(header, sizeof(*header), 1, file) != 1 ||
+        memcmp(header->magic, "PBRTSENS", 8) != 0 || header->version != 1) {
+        fclose(file);
+        Error("\"%s\" is not a sensor file", filename.c_str());
+        return false;
+    }
+    const uint64_t nPixels = header->xPixels * header->yPixels;
+    planes->resize(header->nPlanes * nPixels);
+    cube->resize(header->cubeOffset ? header->nSpectralSamples * nPixels : 0);
+    bool read = true;
+    if (!planes->empty())
+        read = SeekFile(file, header->planesOffset) &&
+               fread(&(*planes)[0], sizeof(float), planes->size(), file) ==
+               planes->size();
+    if (read && !cube->empty())
+        read = SeekFile(file, header->cubeOffset) &&
+               fread(&(*cube)[0], sizeof(float), cube->size(), file) ==
+               cube->size();
+    if (read && header->recordsOffset)
+        read = SeekFile(file, header->recordsOffset) &&
+               ReadRecordBlocks(file, header->nRecords, records);
+    fclose(file);
+    if (!read)
+        Error("Reading the sensor file \"%s\" failed", filename.c_str());
+    return read;
+}
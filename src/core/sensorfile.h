@@ -0,0 +1,94 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#ifndef PBRT_CORE_SENSORFILE_H
+#define PBRT_CORE_SENSORFILE_H
+
+// core/sensorfile.h*
+#include "pbrt.h"
+
+struct Record;
+
+// Number of photon records compressed together in one block
+static const uint32_t sensorRecordBlockSize = 1 << 16;
+
+// SensorFileHeader flags
+// The planes hold angular histograms rather than the sensor film
+static const uint32_t sensorFileAngular = 1 << 0;
+
+// SensorFileHeader Declarations
+// Binary sensor files start with this 128-byte little-endian header.  It is
+// followed by _nPlanes_ float planes of _xPixels_ x _yPixels_ values, x
+// varying fastest, at _planesOffset_: the recorded energy, then the X, Y and
+// Z of the recorded radiance.  When _cubeOffset_ is not zero, the radiance
+// at each of the _nSpectralSamples_ wavelengths follows as one plane per
+// wavelength.  When _recordsOffset_ is not zero, the photon records follow
+// in blocks of at most _recordBlockSize_ records: four uint32 (the record
+// count and the compressed size of each column) and then three zlib
+// streams holding the x and y pixels as uint16 and the angles as half.
+// Angular histograms (_sensorFileAngular_) store one plane per bin, the
+// _phiBins_ bins of each of the _thetaBins_ theta bins being consecutive,
+// over tiles of _tileSize_ x _tileSize_ sensor pixels.
+struct SensorFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t flags;
+    uint64_t xPixels, yPixels;
+    uint64_t hitCount;
+    uint64_t nRecords;
+    uint64_t planesOffset;
+    uint64_t cubeOffset;
+    uint64_t recordsOffset;
+    float width_um, height_um;
+    float fov;
+    float lambdaStart, lambdaEnd;
+    uint32_t nSpectralSamples;
+    uint32_t nPlanes;
+    uint32_t recordBlockSize;
+    uint32_t thetaBins, phiBins;
+    uint32_t tileSize;
+    float thetaMax;
+    uint8_t reserved[8];
+};
+
+
+bool WriteSensorFile(const string &filename, SensorFileHeader &header,
+                     const float *planes, const float *cube,
+                     const vector<Record> *records);
+bool ReadSensorFile(const string &filename, SensorFileHeader *header,
+                    vector<float> *planes, vector<float> *cube,
+                    vector<Record> *records);
+
+#endif // PBRT_CORE_SENSORFILE_H
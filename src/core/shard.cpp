@@ -0,0 +1,76 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+// core/shard.cpp*
+#include "stdafx.h"
+#include "shard.h"
+
+// Shard Function Definitions
+// Splits _n_ work items in contiguous ranges of at most one item of
+// difference and returns the range of this shard
+void ShardRange(uint64_t n, uint64_t *begin, uint64_t *end) {
+    const uint64_t i = PbrtOptions.shardIndex, count = PbrtOptions.nShards;
+    *begin = n / count * i + min(i, n % count);
+    *end = *begin + n / count + (i < n % count ? 1 : 0);
+}
+
+
+// Names the partial output of this shard: <prefix>.shard<i>of<N>
+string ShardFileName(const string &prefix) {
+    if (!Sharded()) return prefix;
+    char suffix[64];
+    sprintf(suffix, ".shard%dof%d", PbrtOptions.shardIndex,
+            PbrtOptions.nShards);
+    return prefix + suffix;
+}
+
+
+// Splits a name built by ShardFileName(), followed by an extension, into
+// the prefix and the shard
+bool ParseShardFileName(const string &filename, string *prefix,
+                        int *shardIndex, int *nShards) {
+    size_t pos = filename.rfind(".shard");
+    while (pos != string::npos) {
+        int i, n, length;
+        if (sscanf(filename.c_str() + pos, ".shard%dof%d%n", &i, &n,
+                   &length) == 2 &&
+            (pos + length == filename.size() ||
+             filename[pos + length] == '.')) {
+            *prefix = filename.substr(0, pos);
+            *shardIndex = i;
+            *nShards = n;
+            return true;
+        }
+        if (pos == 0) break;
+        pos = filename.rfind(".shard", pos - 1);
+    }
+    return false;
+}
@@ -34,7 +34,45 @@
 #include "stdafx.h"
 #include "spectrum.h"
 
+// Spectrum Global Data
+int nSpectralSamples = maxSpectralSamples;
+int sampledLambdaStart = defaultLambdaStart;
+int sampledLambdaEnd = defaultLambdaEnd;
+
+// Instantiate the storage sizes that are commonly selected with
+// _PBRT_SPECTRAL_SAMPLES_, so they are all checked when the library builds
+template class CoefficientSpectrum<1>;
+template class CoefficientSpectrum<4>;
+template class CoefficientSpectrum<16>;
+template class CoefficientSpectrum<64>;
+template class CoefficientSpectrum<500>;
+
 // Spectrum Method Definitions
+bool SetSpectralSamples(int n) {
+    if (n <= 0 || n > maxSpectralSamples) {
+        Error("Invalid number of spectral samples %d, this build stores up "
+              "to %d.", n, maxSpectralSamples);
+        return false;
+    }
+    nSpectralSamples = n;
+    return true;
+}
+
+
+bool SetSpectralRange(int lambdaStart, int lambdaEnd) {
+    if (lambdaStart <= 0 || lambdaEnd <= lambdaStart) {
+        Error("Invalid spectral range [%d, %d] nm.", lambdaStart, lambdaEnd);
+        return false;
+    }
+    if (float(lambdaEnd - lambdaStart) / float(nSpectralSamples) < 1.f)
+        Warning("Spectral range [%d, %d] nm is sampled below 1 nm with %d "
+                "samples.", lambdaStart, lambdaEnd, nSpectralSamples);
+    sampledLambdaStart = lambdaStart;
+    sampledLambdaEnd = lambdaEnd;
+    return true;
+}
+
+
 bool SpectrumSamplesSorted(const float *lambda, const float *vals, int n) {
     for (int i = 0; i < n-1; ++i)
         if (lambda[i] > lambda[i+1]) return false;
@@ -42,13 +42,48 @@
 #include "parallel.h"
 
 // Spectrum Utility Declarations
-static const int sampledLambdaStart = 300;
-static const int sampledLambdaEnd = 800;
-static const int nSpectralSamples = 500; // 500;
+// _SampledSpectrum_ stores _maxSpectralSamples_ coefficients, fixed at
+// compile time, and uses the first _nSpectralSamples_ of them.  The number
+// of samples and the wavelength range they cover are selected at run time
+// with _SetSpectralSamples()_ and _SetSpectralRange()_.
+#ifndef PBRT_SPECTRAL_SAMPLES
+#define PBRT_SPECTRAL_SAMPLES 500
+#endif
+#if PBRT_SPECTRAL_SAMPLES == 3
+#error "PBRT_SPECTRAL_SAMPLES must differ from the 3 coefficients of RGBSpectrum"
+#endif
+static const int maxSpectralSamples = PBRT_SPECTRAL_SAMPLES;
+static const int defaultLambdaStart = 300;
+static const int defaultLambdaEnd = 800;
+extern int nSpectralSamples;
+extern int sampledLambdaStart;
+extern int sampledLambdaEnd;
+extern bool SetSpectralSamples(int n);
+extern bool SetSpectralRange(int lambdaStart, int lambdaEnd);
 extern bool SpectrumSamplesSorted(const float *lambda, const float *vals, int n);
 extern void SortSpectrumSamples(float *lambda, float *vals, int n);
 extern float AverageSpectrumSamples(const float *lambda, const float *vals,
     int n, float lambdaStart, float lambdaEnd);
+inline float SpectrumSampleWidth() {
+    return float(sampledLambdaEnd - sampledLambdaStart) / float(nSpectralSamples);
+}
+
+
+// Maps a wavelength in nm to the index of the sample that covers it, or -1
+// if the wavelength is outside the active spectral range.
+inline int SpectrumSampleIndex(float lambda) {
+    if (lambda < sampledLambdaStart || lambda >= sampledLambdaEnd) return -1;
+    return min(Floor2Int((lambda - sampledLambdaStart) / SpectrumSampleWidth()),
+               nSpectralSamples - 1);
+}
+
+
+// Returns the wavelength in nm at the start of the _i_th spectral sample.
+inline int SpectrumSampleWavelength(int i) {
+    return sampledLambdaStart + Floor2Int(i * SpectrumSampleWidth());
+}
+
+
 inline void XYZToRGB(const float xyz[3], float rgb[3]) {
     rgb[0] =  3.240479f*xyz[0] - 1.537150f*xyz[1] - 0.498535f*xyz[2];
     rgb[1] = -0.969256f*xyz[0] + 1.875991f*xyz[1] + 0.041556f*xyz[2];
@@ -101,82 +136,87 @@ extern const float RGBIllum2SpectBlue[nRGB2SpectSamples];
 template <int nSamples> class CoefficientSpectrum {
 public:
     // CoefficientSpectrum Public Methods
+    // Number of coefficients in use, _SampledSpectrum_ leaves the ones past
+    // _nSpectralSamples_ unused
+    static int Count() {
+        return nSamples == maxSpectralSamples ? nSpectralSamples : nSamples;
+    }
     CoefficientSpectrum(float v = 0.f) {
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             c[i] = v;
         Assert(!HasNaNs());
     }
 #ifdef DEBUG
     CoefficientSpectrum(const CoefficientSpectrum &s) {
         Assert(!s.HasNaNs());
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             c[i] = s.c[i];
     }
     
     CoefficientSpectrum &operator=(const CoefficientSpectrum &s) {
         Assert(!s.HasNaNs());
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             c[i] = s.c[i];
         return *this;
     }
 #endif // DEBUG
     void Print(FILE *f) const {
         fprintf(f, "[ ");
-        for (int i = 0; i < nSamples; ++i) {
+        for (int i = 0; i < Count(); ++i) {
             fprintf(f, "%f", c[i]);
-            if (i != nSamples-1) fprintf(f, ", ");
+            if (i != Count()-1) fprintf(f, ", ");
         }
         fprintf(f, "]");
     }
     CoefficientSpectrum &operator+=(const CoefficientSpectrum &s2) {
         Assert(!s2.HasNaNs());
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             c[i] += s2.c[i];
         return *this;
     }
     CoefficientSpectrum operator+(const CoefficientSpectrum &s2) const {
         Assert(!s2.HasNaNs());
         CoefficientSpectrum ret = *this;
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             ret.c[i] += s2.c[i];
         return ret;
     }
     CoefficientSpectrum operator-(const CoefficientSpectrum &s2) const {
         Assert(!s2.HasNaNs());
         CoefficientSpectrum ret = *this;
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             ret.c[i] -= s2.c[i];
         return ret;
     }
     CoefficientSpectrum operator/(const CoefficientSpectrum &s2) const {
         Assert(!s2.HasNaNs());
         CoefficientSpectrum ret = *this;
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             ret.c[i] /= s2.c[i];
         return ret;
     }
     CoefficientSpectrum operator*(const CoefficientSpectrum &sp) const {
         Assert(!sp.HasNaNs());
         CoefficientSpectrum ret = *this;
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             ret.c[i] *= sp.c[i];
         return ret;
     }
     CoefficientSpectrum &operator*=(const CoefficientSpectrum &sp) {
         Assert(!sp.HasNaNs());
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             c[i] *= sp.c[i];
         return *this;
     }
     CoefficientSpectrum operator*(float a) const {
         CoefficientSpectrum ret = *this;
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             ret.c[i] *= a;
         Assert(!ret.HasNaNs());
         return ret;
     }
     CoefficientSpectrum &operator*=(float a) {
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             c[i] *= a;
         Assert(!HasNaNs());
         return *this;
@@ -189,19 +229,19 @@ public:
     CoefficientSpectrum operator/(float a) const {
         Assert(!isnan(a));
         CoefficientSpectrum ret = *this;
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             ret.c[i] /= a;
         Assert(!ret.HasNaNs());
         return ret;
     }
     CoefficientSpectrum &operator/=(float a) {
         Assert(!isnan(a));
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             c[i] /= a;
         return *this;
     }
     bool operator==(const CoefficientSpectrum &sp) const {
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             if (c[i] != sp.c[i]) return false;
         return true;
     }
@@ -209,13 +249,13 @@ public:
         return !(*this == sp);
     }
     bool IsBlack() const {
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             if (c[i] != 0.) return false;
         return true;
     }
     friend CoefficientSpectrum Sqrt(const CoefficientSpectrum &s) {
         CoefficientSpectrum ret;
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             ret.c[i] = sqrtf(s.c[i]);
         Assert(!ret.HasNaNs());
         return ret;
@@ -223,39 +263,39 @@ public:
     template <int n> friend inline CoefficientSpectrum<n> Pow(const CoefficientSpectrum<n> &s, float e);
     CoefficientSpectrum operator-() const {
         CoefficientSpectrum ret;
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             ret.c[i] = -c[i];
         return ret;
     }
     friend CoefficientSpectrum Exp(const CoefficientSpectrum &s) {
         CoefficientSpectrum ret;
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             ret.c[i] = expf(s.c[i]);
         Assert(!ret.HasNaNs());
         return ret;
     }
     CoefficientSpectrum Clamp(float low = 0, float high = INFINITY) const {
         CoefficientSpectrum ret;
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             ret.c[i] = ::Clamp(c[i], low, high);
         Assert(!ret.HasNaNs());
         return ret;
     }
     bool HasNaNs() const {
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             if (isnan(c[i])) return true;
         return false;
     }
     bool Write(FILE *f) const {
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             if (fprintf(f, "%f ", c[i]) < 0) return false;
         return true;
     }
     bool WriteSPD(std::string fileName) const {
         std::string file = fileName + ".spd";
         FILE* f = fopen(file.c_str(), "w");
-        for (int i = 0; i < nSpectralSamples; ++i)
-            fprintf(f, "%d %f\n", (i + sampledLambdaStart), c[i]);
+        for (int i = 0; i < Count(); ++i)
+            fprintf(f, "%d %f\n", SpectrumSampleWavelength(i), c[i]);
         fclose(f);
         return true;
     }
@@ -263,15 +303,15 @@ public:
     /// for example, [401 1.2323]
     /// This file will be used to plot spectral distributions.
     bool WriteWavelengthIntensity(FILE *f) const {
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
         {
-            const int lambda = sampledLambdaStart + i;
+            const int lambda = SpectrumSampleWavelength(i);
             if (fprintf(f, "%d %f\n", lambda, c[i]) < 0) return false;
         }
         return true;
     }
     bool Read(FILE *f) {
-        for (int i = 0; i < nSamples; ++i)
+        for (int i = 0; i < Count(); ++i)
             if (fscanf(f, "%f ", &c[i]) != 1) return false;
         return true;
     }
@@ -282,7 +322,7 @@ protected:
 };
 
 
-class SampledSpectrum : public CoefficientSpectrum<nSpectralSamples> {
+class SampledSpectrum : public CoefficientSpectrum<maxSpectralSamples> {
 public:
     // SampledSpectrum Public Methods
     SampledSpectrum(float v = 0.f) {
@@ -334,38 +374,38 @@ public:
     }
     void PrintSpectrumDistribution_f() const {
         for (int i = 0; i < nSpectralSamples; ++i)
-            printf("[%d] %f ", i + sampledLambdaStart, c[i]);
+            printf("[%d] %f ", SpectrumSampleWavelength(i), c[i]);
         printf("\n");
     }
     void PrintSpectrumDistribution_e() const {
         for (int i = 0; i < nSpectralSamples; ++i)
-            printf("[%d] %e ", i + sampledLambdaStart, c[i]);
+            printf("[%d] %e ", SpectrumSampleWavelength(i), c[i]);
         printf("\n");
     }
     void PrintSpectrumDistribution() const {
         for (int i = 0; i < nSpectralSamples; ++i)
-            printf("[%d] %f(%e) ", i + sampledLambdaStart, c[i], c[i]);
+            printf("[%d] %f(%e) ", SpectrumSampleWavelength(i), c[i], c[i]);
         printf("\n");
     }
     void PrintSpectrumDistributionTransposed_f() const {
         for (int i = 0; i < nSpectralSamples; ++i)
-            printf("[%d] %f \n", i + sampledLambdaStart, c[i]);
+            printf("[%d] %f \n", SpectrumSampleWavelength(i), c[i]);
         printf("\n");
     }
     void PrintSpectrumDistributionTransposed_e() const {
         for (int i = 0; i < nSpectralSamples; ++i)
-            printf("[%d] %e \n", i + sampledLambdaStart, c[i]);
+            printf("[%d] %e \n", SpectrumSampleWavelength(i), c[i]);
         printf("\n");
     }
     void PrintSpectrumDistributionTransposed() const {
         for (int i = 0; i < nSpectralSamples; ++i)
-            printf("[%d] %f(%e) \n", i + sampledLambdaStart, c[i], c[i]);
+            printf("[%d] %f(%e) \n", SpectrumSampleWavelength(i), c[i], c[i]);
         printf("\n");
     }
     void PrintNonZeroSpectrum_f() const {
         for (int i = 0; i < nSpectralSamples; ++i) {
             if (c[i] > 0) {
-                printf("%d, %f ", i + sampledLambdaStart, c[i]);
+                printf("%d, %f ", SpectrumSampleWavelength(i), c[i]);
             }
         }
         printf("\n");
@@ -373,7 +413,7 @@ public:
     void PrintNonZeroSpectrum_e() const {
         for (int i = 0; i < nSpectralSamples; ++i) {
             if (c[i] > 0) {
-                printf("%d, %e ", i + sampledLambdaStart, c[i]);
+                printf("%d, %e ", SpectrumSampleWavelength(i), c[i]);
             }
         }
         printf("\n");
@@ -381,7 +421,7 @@ public:
     void PrintNonZeroSpectrum() const {
         for (int i = 0; i < nSpectralSamples; ++i) {
             if (c[i] > 0) {
-                printf("%d, %f(%e) ", i + sampledLambdaStart, c[i], c[i]);
+                printf("%d, %f(%e) ", SpectrumSampleWavelength(i), c[i], c[i]);
             }
         }
         printf("\n");
@@ -389,7 +429,7 @@ public:
     void PrintNonZeroSpectrumTransposed_f() const {
         for (int i = 0; i < nSpectralSamples; ++i) {
             if (c[i] > 0) {
-                printf("%d, %f \n", i + sampledLambdaStart, c[i]);
+                printf("%d, %f \n", SpectrumSampleWavelength(i), c[i]);
             }
         }
         printf("\n");
@@ -397,7 +437,7 @@ public:
     void PrintNonZeroSpectrumTransposed_e() const {
         for (int i = 0; i < nSpectralSamples; ++i) {
             if (c[i] > 0) {
-                printf("%d, %e\n", i + sampledLambdaStart, c[i]);
+                printf("%d, %e\n", SpectrumSampleWavelength(i), c[i]);
             }
         }
         printf("\n");
@@ -405,7 +445,7 @@ public:
     void PrintNonZeroSpectrumTransposed() const {
         for (int i = 0; i < nSpectralSamples; ++i) {
             if (c[i] > 0) {
-                printf("%d, %f(%e) \n", i + sampledLambdaStart, c[i], c[i]);
+                printf("%d, %f(%e) \n", SpectrumSampleWavelength(i), c[i], c[i]);
             }
         }
         printf("\n");
@@ -431,16 +471,18 @@ public:
                     "between sampledLambdaStart & sampledLambdaEnd");
     }
     void SetSampleValueAtWavelength(int lambda, float value) {
-        if ((lambda < sampledLambdaEnd && lambda > sampledLambdaStart))
-            c[lambda - sampledLambdaStart] = value;
+        const int index = SpectrumSampleIndex(lambda);
+        if (index >= 0)
+            c[index] = value;
         else
             Warning("The specified wavelength in the function "
                     "SetSampleValueAtWavelength() is not in the range "
                     "between sampledLambdaStart & sampledLambdaEnd");
     }
     float GetSampleValueAtWavelength(int lambda) const {
-        if ((lambda < sampledLambdaEnd && lambda > sampledLambdaStart))
-            return c[lambda - sampledLambdaStart];
+        const int index = SpectrumSampleIndex(lambda);
+        if (index >= 0)
+            return c[index];
         else
             Warning("The specified wavelength in the function "
                     "SetSampleValueAtWavelength() is not in the range "
@@ -504,12 +546,12 @@ public:
         return -1;
     }
     int GetLaserWavelength() const {
-        return (GetLaserWavelengthIndex() + sampledLambdaStart);
+        return SpectrumSampleWavelength(GetLaserWavelengthIndex());
     }
     bool VerifyLaser(int &wavelength, int & wavelengthIndex) const {
         wavelengthIndex = GetLaserWavelengthIndex();
         if (wavelengthIndex > -1 ) {
-            wavelength = wavelengthIndex + sampledLambdaStart;
+            wavelength = SpectrumSampleWavelength(wavelengthIndex);
             return true;
         }
         wavelength = -1;
@@ -522,8 +564,8 @@ public:
     float GetLaserEmissionPower(const int lambdaIndex) const {
         return (c[lambdaIndex]);
     }
-    SampledSpectrum(const CoefficientSpectrum<nSpectralSamples> &v)
-        : CoefficientSpectrum<nSpectralSamples>(v) { }
+    SampledSpectrum(const CoefficientSpectrum<maxSpectralSamples> &v)
+        : CoefficientSpectrum<maxSpectralSamples>(v) { }
     static SampledSpectrum FromSampled(const float *lambda,
                                        const float *v, int n) {
         // Sort samples if unordered, use sorted for returned spectrum
@@ -648,7 +690,7 @@ public:
     }
     int WavelengthIndex(const int &wl) const {
         Assert(wl >= sampledLambdaStart && wl < sampledLambdaEnd);
-        return wl - sampledLambdaStart;
+        return SpectrumSampleIndex(wl);
     }
     float Power(const int &wl) const {
         return c[WavelengthIndex(wl)];
@@ -665,12 +707,13 @@ public:
         else _wl2 = wl2;
 
         /// Find the index of the sample
-        /// If _wl1 = 400, then wl1_index = 0
-        /// If _wl1 = 500, then wl1_index = 100
-        const int wl1_Index = (_wl1 - sampledLambdaStart);
+        /// At 1 nm sampling from 400 nm, _wl1 = 500 gives wl1_index = 100
+        const int wl1_Index = SpectrumSampleIndex(_wl1);
 
-        /// If _wl2 = 600, then wl2_Index = 200;
-        const int wl2_Index =  (_wl2 - sampledLambdaStart);
+        /// The upper bound is inclusive, so it may lie on sampledLambdaEnd
+        const int wl2_Index = (_wl2 >= sampledLambdaEnd) ? nSpectralSamples - 1 :
+            SpectrumSampleIndex(_wl2);
+        if (wl1_Index < 0 || wl2_Index < 0) return;
 
         /// Filter out the spectrum from the unwanted signals
         for (int i = 0; i < nSpectralSamples; i++)
@@ -778,7 +821,12 @@ public:
         xyz[2] /= yint;
         return FromXYZ(xyz);
     }
-    float Power(const int &) const { return 0.f; }
+    // Approximates the power at _wl_ with the RGB channel covering it
+    float Power(const int &wl) const {
+        if (wl < 490) return c[2];
+        if (wl < 580) return c[1];
+        return c[0];
+    }
     void PrintSpectrum_f() const {
         Warning("RGB Spectrum cannot handle PrintSpectrum_f()!");
     }
@@ -872,7 +920,7 @@ public:
 template <int nSamples> inline CoefficientSpectrum<nSamples>
 Pow(const CoefficientSpectrum<nSamples> &s, float e) {
     CoefficientSpectrum<nSamples> ret;
-    for (int i = 0; i < nSamples; ++i)
+    for (int i = 0; i < ret.Count(); ++i)
         ret.c[i] = powf(s.c[i], e);
     Assert(!ret.HasNaNs());
     return ret;
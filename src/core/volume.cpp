@@ -199,6 +199,20 @@ bool VolumeRegion::SkipEmptySpace(const Ray &r, float *tSkip) const {
 }
 
 
+// Returns false, with empty properties, if _p_ is outside the region
+bool VolumeRegion::Lookup(const Point &p, MediumProperties *mp) const {
+    // Generic version built from the separate queries
+    if (!WorldBound().Inside(p)) {
+        mp->Clear();
+        return false;
+    }
+    const Vector w(0, 0, 0);
+    mp->Set(Sigma_a(p, w, 0.f), Sigma_s(p, w, 0.f), Sigma_t(p, w, 0.f), 0.f,
+            0);
+    return true;
+}
+
+
 float VolumeRegion::PhotonDensity(const Point &p) const {
     Severe("Unimplemented VolumeRegion::PhotonDensity() method called");
     return 0.f;
@@ -356,25 +370,202 @@ bool VolumeRegion::SampleDirection(const Point &, const Vector&, Vector &,
 }
 
 
+bool DensityRegion::Lookup(const Point &p, MediumProperties *mp) const {
+    if (!WorldBound().Inside(p)) {
+        mp->Clear();
+        return false;
+    }
+    const float d = Density(WorldToVolume(p));
+    mp->Set(d * sigma_a, d * sigma_s, d * (sigma_a + sigma_s), g, 0);
+    return true;
+}
+
+
 AggregateVolume::AggregateVolume(const vector<VolumeRegion *> &r) {
     regions = r;
+    regionBounds.reserve(regions.size());
+    for (uint32_t i = 0; i < regions.size(); ++i) {
+        regionBounds.push_back(regions[i]->WorldBound());
+        bound = Union(bound, regionBounds.back());
+    }
+
+    // Index the region bounds so that the queries only visit the regions
+    // they overlap
+    if (regions.empty()) return;
+    vector<uint32_t> order(regions.size());
     for (uint32_t i = 0; i < regions.size(); ++i)
-        bound = Union(bound, regions[i]->WorldBound());
+        order[i] = i;
+    nodes.reserve(2 * regions.size() - 1);
+    BuildIndex(order, 0, regions.size());
+}
+
+
+struct CompareRegionCentroids {
+    CompareRegionCentroids(const vector<BBox> &b, int a)
+        : bounds(b), axis(a) { }
+    bool operator()(uint32_t a, uint32_t b) const {
+        return bounds[a].pMin[axis] + bounds[a].pMax[axis] <
+               bounds[b].pMin[axis] + bounds[b].pMax[axis];
+    }
+    const vector<BBox> &bounds;
+    int axis;
+};
+
+
+uint32_t AggregateVolume::BuildIndex(vector<uint32_t> &order, uint32_t start,
+                                     uint32_t end) {
+    const uint32_t nodeNum = nodes.size();
+    nodes.push_back(LinearVolumeNode());
+    BBox bbox, centroidBounds;
+    for (uint32_t i = start; i < end; ++i) {
+        const BBox &b = regionBounds[order[i]];
+        bbox = Union(bbox, b);
+        centroidBounds = Union(centroidBounds, .5f * b.pMin + .5f * b.pMax);
+    }
+    nodes[nodeNum].bounds = bbox;
+    if (end - start == 1) {
+        nodes[nodeNum].offset = order[start];
+        nodes[nodeNum].axis = 0;
+        nodes[nodeNum].leaf = true;
+        return nodeNum;
+    }
+
+    // Split the regions at the median of their centroids along the largest
+    // extent, the first child follows its parent
+    const int axis = centroidBounds.MaximumExtent();
+    const uint32_t mid = (start + end) / 2;
+    nth_element(order.begin() + start, order.begin() + mid,
+                order.begin() + end, CompareRegionCentroids(regionBounds, axis));
+    BuildIndex(order, start, mid);
+    const uint32_t secondChild = BuildIndex(order, mid, end);
+    nodes[nodeNum].offset = secondChild;
+    nodes[nodeNum].axis = axis;
+    nodes[nodeNum].leaf = false;
+    return nodeNum;
+}
+
+
+template <typename Visitor>
+void AggregateVolume::VisitRegions(const Point &p, const Visitor &visit) const {
+    if (nodes.empty()) return;
+    uint32_t todo[64];
+    uint32_t todoOffset = 0, nodeNum = 0;
+    while (true) {
+        const LinearVolumeNode &node = nodes[nodeNum];
+        if (node.bounds.Inside(p)) {
+            if (node.leaf)
+                visit(regions[node.offset]);
+            else {
+                todo[todoOffset++] = node.offset;
+                nodeNum = nodeNum + 1;
+                continue;
+            }
+        }
+        if (todoOffset == 0) break;
+        nodeNum = todo[--todoOffset];
+    }
+}
+
+
+static inline bool IntersectP(const BBox &bounds, const Ray &ray,
+        const Vector &invDir, const uint32_t dirIsNeg[3]) {
+    // Check for ray intersection against $x$ and $y$ slabs
+    float tmin =  (bounds[  dirIsNeg[0]].x - ray.o.x) * invDir.x;
+    float tmax =  (bounds[1-dirIsNeg[0]].x - ray.o.x) * invDir.x;
+    float tymin = (bounds[  dirIsNeg[1]].y - ray.o.y) * invDir.y;
+    float tymax = (bounds[1-dirIsNeg[1]].y - ray.o.y) * invDir.y;
+    if ((tmin > tymax) || (tymin > tmax))
+        return false;
+    if (tymin > tmin) tmin = tymin;
+    if (tymax < tmax) tmax = tymax;
+
+    // Check for ray intersection against $z$ slab
+    float tzmin = (bounds[  dirIsNeg[2]].z - ray.o.z) * invDir.z;
+    float tzmax = (bounds[1-dirIsNeg[2]].z - ray.o.z) * invDir.z;
+    if ((tmin > tzmax) || (tzmin > tmax))
+        return false;
+    if (tzmin > tmin)
+        tmin = tzmin;
+    if (tzmax < tmax)
+        tmax = tzmax;
+    // Written so that the NaNs of axis-aligned rays starting on a slab keep
+    // the region
+    return !(tmin > ray.maxt) && !(tmax < ray.mint);
+}
+
+
+template <typename Visitor>
+void AggregateVolume::VisitRegions(const Ray &ray, const Visitor &visit) const {
+    // Visit the regions overlapped by _ray_ from front to back
+    if (nodes.empty()) return;
+    const Vector invDir(1.f / ray.d.x, 1.f / ray.d.y, 1.f / ray.d.z);
+    const uint32_t dirIsNeg[3] = { invDir.x < 0, invDir.y < 0, invDir.z < 0 };
+    uint32_t todo[64];
+    uint32_t todoOffset = 0, nodeNum = 0;
+    while (true) {
+        const LinearVolumeNode &node = nodes[nodeNum];
+        if (::IntersectP(node.bounds, ray, invDir, dirIsNeg)) {
+            if (node.leaf)
+                visit(regions[node.offset]);
+            else {
+                if (dirIsNeg[node.axis]) {
+                    todo[todoOffset++] = nodeNum + 1;
+                    nodeNum = node.offset;
+                }
+                else {
+                    todo[todoOffset++] = node.offset;
+                    nodeNum = nodeNum + 1;
+                }
+                continue;
+            }
+        }
+        if (todoOffset == 0) break;
+        nodeNum = todo[--todoOffset];
+    }
+}
+
+
+bool AggregateVolume::Lookup(const Point &p, MediumProperties *mp) const {
+    if (!bound.Inside(p)) {
+        mp->Clear();
+        return false;
+    }
+    if (regions.size() == 1)
+        return regions[0]->Lookup(p, mp);
+
+    // Sum the coefficients of the regions overlapping _p_, the phase
+    // function asymmetry is averaged over their scattering
+    Spectrum sigma_a(0.f), sigma_s(0.f), sigma_t(0.f);
+    float g = 0.f, gWeight = 0.f;
+    int tag = 0;
+    MediumProperties region;
+    VisitRegions(p, [&](const VolumeRegion *r) {
+        if (!r->Lookup(p, &region))
+            return;
+        sigma_a += region.sigma_a;
+        sigma_s += region.sigma_s;
+        sigma_t += region.sigma_t;
+        const float weight = region.sigma_s.y();
+        g += weight * region.g;
+        gWeight += weight;
+        if (!tag) tag = region.tag;
+    });
+    mp->Set(sigma_a, sigma_s, sigma_t, gWeight > 0.f ? g / gWeight : 0.f,
+            tag);
+    return true;
 }
 
 
 float AggregateVolume::Density(const Point &Pobj) const {
     float d = 0.;
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        d += regions[i]->Density(Pobj);
+    VisitRegions(Pobj, [&](const VolumeRegion *r) { d += r->Density(Pobj); });
     return d;
 }
 
 
 float AggregateVolume::PhotonDensity(const Point &p) const {
     float d = 0.;
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        d += regions[i]->PhotonDensity(p);
+    VisitRegions(p, [&](const VolumeRegion *r) { d += r->PhotonDensity(p); });
     return d;
 }
 
@@ -390,11 +581,10 @@ bool AggregateVolume::HasNonClearedFluorescentVolumes() const {
 
 float AggregateVolume::Fluorescence(const Point &Pobj) const {
     bool flu = false;
-    for (uint32_t i = 0; i < regions.size(); ++i) {
-        if(regions[i]->Fluorescence(Pobj))
-            flu |= true;
-        else flu |= false;
-    }
+    VisitRegions(Pobj, [&](const VolumeRegion *r) {
+        if (!flu && r->Fluorescence(Pobj))
+            flu = true;
+    });
     return flu;
 }
 
@@ -420,8 +610,7 @@ float AggregateVolume::MaxSigma_t(const int &wl) const {
 Spectrum AggregateVolume::Sigma_a(const Point &p, const Vector &w,
                                   float time) const {
     Spectrum s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Sigma_a(p, w, time);
+    VisitRegions(p, [&](const VolumeRegion *r) { s += r->Sigma_a(p, w, time); });
     return s;
 }
 
@@ -429,8 +618,9 @@ Spectrum AggregateVolume::Sigma_a(const Point &p, const Vector &w,
 float AggregateVolume::Sigma_a(const Point &p, const Vector &w,
                                float time, const int &wl) const {
     float s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Sigma_a(p, w, time, wl);
+    VisitRegions(p, [&](const VolumeRegion *r) {
+        s += r->Sigma_a(p, w, time, wl);
+    });
     return s;
 }
 
@@ -438,8 +628,7 @@ float AggregateVolume::Sigma_a(const Point &p, const Vector &w,
 Spectrum AggregateVolume::Sigma_af(const Point &p, const Vector &w,
                                   float time) const {
     Spectrum s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Sigma_af(p, w, time);
+    VisitRegions(p, [&](const VolumeRegion *r) { s += r->Sigma_af(p, w, time); });
     return s;
 }
 
@@ -447,8 +636,9 @@ Spectrum AggregateVolume::Sigma_af(const Point &p, const Vector &w,
 float AggregateVolume::Sigma_af(const Point &p, const Vector &w,
                                 float time, const int &wl) const {
     float s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Sigma_af(p, w, time, wl);
+    VisitRegions(p, [&](const VolumeRegion *r) {
+        s += r->Sigma_af(p, w, time, wl);
+    });
     return s;
 }
 
@@ -464,8 +654,7 @@ float AggregateVolume::MaxSigma_tf(const int &wl) const {
 
 Spectrum AggregateVolume::Sigma_s(const Point &p, const Vector &w, float time) const {
     Spectrum s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Sigma_s(p, w, time);
+    VisitRegions(p, [&](const VolumeRegion *r) { s += r->Sigma_s(p, w, time); });
     return s;
 }
 
@@ -473,8 +662,9 @@ Spectrum AggregateVolume::Sigma_s(const Point &p, const Vector &w, float time) c
 float AggregateVolume::Sigma_s(const Point &p, const Vector &w,
                                 float time, const int &wl) const {
     float s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Sigma_s(p, w, time, wl);
+    VisitRegions(p, [&](const VolumeRegion *r) {
+        s += r->Sigma_s(p, w, time, wl);
+    });
     return s;
 }
 
@@ -482,16 +672,16 @@ float AggregateVolume::Sigma_s(const Point &p, const Vector &w,
 float AggregateVolume::Sigma_sf(const Point &p, const Vector &w,
                                 float time, const int &wl) const {
     float s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Sigma_sf(p, w, time, wl);
+    VisitRegions(p, [&](const VolumeRegion *r) {
+        s += r->Sigma_sf(p, w, time, wl);
+    });
     return s;
 }
 
 
 Spectrum AggregateVolume::Mu(const Point &p, const Vector &w, float time) const {
     Spectrum s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Mu(p, w, time);
+    VisitRegions(p, [&](const VolumeRegion *r) { s += r->Mu(p, w, time); });
     return s;
 }
 
@@ -499,16 +689,14 @@ Spectrum AggregateVolume::Mu(const Point &p, const Vector &w, float time) const
 float AggregateVolume::Mu(const Point &p, const Vector &w,
                                 float time, const int &wl) const {
     float s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Mu(p, w, time, wl);
+    VisitRegions(p, [&](const VolumeRegion *r) { s += r->Mu(p, w, time, wl); });
     return s;
 }
 
 
 Spectrum AggregateVolume::Lve(const Point &p, const Vector &w, float time) const {
     Spectrum L(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        L += regions[i]->Lve(p, w, time);
+    VisitRegions(p, [&](const VolumeRegion *r) { L += r->Lve(p, w, time); });
     return L;
 }
 
@@ -516,8 +704,7 @@ Spectrum AggregateVolume::Lve(const Point &p, const Vector &w, float time) const
 float AggregateVolume::Lve(const Point &p, const Vector &w, float time,
                            const int &wl) const {
     float L(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        L += regions[i]->Lve(p, w, time, wl);
+    VisitRegions(p, [&](const VolumeRegion *r) { L += r->Lve(p, w, time, wl); });
     return L;
 }
 
@@ -525,11 +712,11 @@ float AggregateVolume::Lve(const Point &p, const Vector &w, float time,
 float AggregateVolume::p(const Point &p, const Vector &w, const Vector &wp,
         float time) const {
     float ph = 0, sumWt = 0;
-    for (uint32_t i = 0; i < regions.size(); ++i) {
-        float wt = regions[i]->Sigma_s(p, w, time).y();
+    VisitRegions(p, [&](const VolumeRegion *r) {
+        float wt = r->Sigma_s(p, w, time).y();
         sumWt += wt;
-        ph += wt * regions[i]->p(p, w, wp, time);
-    }
+        ph += wt * r->p(p, w, wp, time);
+    });
     return ph / sumWt;
 }
 
@@ -537,19 +724,18 @@ float AggregateVolume::p(const Point &p, const Vector &w, const Vector &wp,
 float AggregateVolume::pf(const Point &p, const Vector &w, const Vector &wp,
         float time) const {
     float ph = 0, sumWt = 0;
-    for (uint32_t i = 0; i < regions.size(); ++i) {
-        float wt = regions[i]->Sigma_s(p, w, time).y();
+    VisitRegions(p, [&](const VolumeRegion *r) {
+        float wt = r->Sigma_s(p, w, time).y();
         sumWt += wt;
-        ph += wt * regions[i]->pf(p, w, wp, time);
-    }
+        ph += wt * r->pf(p, w, wp, time);
+    });
     return ph / sumWt;
 }
 
 
 Spectrum AggregateVolume::Sigma_t(const Point &p, const Vector &w, float time) const {
     Spectrum s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Sigma_t(p, w, time);
+    VisitRegions(p, [&](const VolumeRegion *r) { s += r->Sigma_t(p, w, time); });
     return s;
 }
 
@@ -557,8 +743,9 @@ Spectrum AggregateVolume::Sigma_t(const Point &p, const Vector &w, float time) c
 float AggregateVolume::Sigma_t(const Point &p, const Vector &w, float time,
                                const int &wl) const {
     float s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Sigma_t(p, w, time, wl);
+    VisitRegions(p, [&](const VolumeRegion *r) {
+        s += r->Sigma_t(p, w, time, wl);
+    });
     return s;
 }
 
@@ -566,11 +753,14 @@ float AggregateVolume::Sigma_t(const Point &p, const Vector &w, float time,
 float AggregateVolume::Sigma_tf(const Point &p, const Vector &w, float time,
                                const int &wl) const {
     float s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->Sigma_tf(p, w, time, wl);
+    VisitRegions(p, [&](const VolumeRegion *r) {
+        s += r->Sigma_tf(p, w, time, wl);
+    });
     return s;
 }
 
+// The fluorophore spectra and yield do not depend on the position, they are
+// gathered over all the regions
 Spectrum AggregateVolume::fEx(const Point &p) const {
     Spectrum s(0.);
     for (uint32_t i = 0; i < regions.size(); ++i)
@@ -613,8 +803,7 @@ float AggregateVolume::Yeild(const Point &p) const {
 
 Spectrum AggregateVolume::STER(const Point &p, const Vector &w, float time) const {
     Spectrum s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->STER(p, w, time);
+    VisitRegions(p, [&](const VolumeRegion *r) { s += r->STER(p, w, time); });
     return s;
 }
 
@@ -622,16 +811,14 @@ Spectrum AggregateVolume::STER(const Point &p, const Vector &w, float time) cons
 float AggregateVolume::STER(const Point &p, const Vector &w, float time,
                               const int &wl) const {
     float s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->STER(p, w, time, wl);
+    VisitRegions(p, [&](const VolumeRegion *r) { s += r->STER(p, w, time, wl); });
     return s;
 }
 
 
 Spectrum AggregateVolume::ATER(const Point &p, const Vector &w, float time) const {
     Spectrum s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->ATER(p, w, time);
+    VisitRegions(p, [&](const VolumeRegion *r) { s += r->ATER(p, w, time); });
     return s;
 }
 
@@ -639,16 +826,16 @@ Spectrum AggregateVolume::ATER(const Point &p, const Vector &w, float time) cons
 float AggregateVolume::ATER(const Point &p, const Vector &w, float time,
                               const int &wl) const {
     float s(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        s += regions[i]->ATER(p, w, time, wl);
+    VisitRegions(p, [&](const VolumeRegion *r) { s += r->ATER(p, w, time, wl); });
     return s;
 }
 
 
 Spectrum AggregateVolume::tau(const Ray &ray, float step, float offset) const {
     Spectrum t(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        t += regions[i]->tau(ray, step, offset);
+    VisitRegions(ray, [&](const VolumeRegion *r) {
+        t += r->tau(ray, step, offset);
+    });
     return t;
 }
 
@@ -656,8 +843,19 @@ Spectrum AggregateVolume::tau(const Ray &ray, float step, float offset) const {
 float AggregateVolume::tauLambda(const Ray &ray, float step, float offset,
                                  const int &wl) const {
     float t(0.);
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        t += regions[i]->tauLambda(ray, step, offset, wl);
+    VisitRegions(ray, [&](const VolumeRegion *r) {
+        t += r->tauLambda(ray, step, offset, wl);
+    });
+    return t;
+}
+
+
+float AggregateVolume::tauLambda_f(const Ray &ray, float step, float offset,
+                                   const int &wl) const {
+    float t(0.);
+    VisitRegions(ray, [&](const VolumeRegion *r) {
+        t += r->tauLambda_f(ray, step, offset, wl);
+    });
     return t;
 }
 
@@ -666,13 +864,13 @@ bool AggregateVolume::IntersectP(const Ray &ray,
                                  float *t0, float *t1) const {
     *t0 = INFINITY;
     *t1 = -INFINITY;
-    for (uint32_t i = 0; i < regions.size(); ++i) {
+    VisitRegions(ray, [&](const VolumeRegion *r) {
         float tr0, tr1;
-        if (regions[i]->IntersectP(ray, &tr0, &tr1)) {
+        if (r->IntersectP(ray, &tr0, &tr1)) {
             *t0 = min(*t0, tr0);
             *t1 = max(*t1, tr1);
         }
-    }
+    });
     return (*t0 < *t1);
 }
 
@@ -687,31 +885,85 @@ bool AggregateVolume::SkipEmptySpace(const Ray &ray, float *tSkip) const {
 }
 
 
+// Every region crossed by the ray samples its own collision, the nearest one
+// that lies inside its region is kept. A region that samples no collision
+// (an infinite distance or one past its exit) does not hide the regions
+// behind it or overlapping it
 bool AggregateVolume::SampleDistance(const Ray &ray, float* tDist,
                                      Point &Psample, float* pdf, RNG &rng) const {
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        if(regions[i]->SampleDistance(ray, tDist, Psample, pdf, rng))
-            return true;
-    return false;
+    bool sampled = false, collided = false;
+    VisitRegions(ray, [&](const VolumeRegion *r) {
+        float t, regionPdf, t0, t1;
+        Point p;
+        if (!r->SampleDistance(ray, &t, p, &regionPdf, rng))
+            return;
+        if (!sampled) {
+            *tDist = t;
+            Psample = p;
+            *pdf = regionPdf;
+            sampled = true;
+        }
+        if (isinf(t) || !r->IntersectP(ray, &t0, &t1) || t > t1)
+            return;
+        if (!collided || t < *tDist) {
+            *tDist = t;
+            Psample = p;
+            *pdf = regionPdf;
+            collided = true;
+        }
+    });
+    if (sampled && !collided) {
+        // No collision in any region, the photon leaves the volume
+        *tDist = INFINITY;
+        Psample = ray(INFINITY);
+        *pdf = 1.f;
+    }
+    return sampled;
 }
 
 
 bool AggregateVolume::SampleDistance(const Ray &ray, float* tDist,
                                      Point &Psample, float* pdf, RNG &rng,
                                      const int& wl) const {
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        if(regions[i]->SampleDistance(ray, tDist, Psample, pdf, rng, wl))
-            return true;
-    return false;
+    bool sampled = false, collided = false;
+    VisitRegions(ray, [&](const VolumeRegion *r) {
+        float t, regionPdf, t0, t1;
+        Point p;
+        if (!r->SampleDistance(ray, &t, p, &regionPdf, rng, wl))
+            return;
+        if (!sampled) {
+            *tDist = t;
+            Psample = p;
+            *pdf = regionPdf;
+            sampled = true;
+        }
+        if (isinf(t) || !r->IntersectP(ray, &t0, &t1) || t > t1)
+            return;
+        if (!collided || t < *tDist) {
+            *tDist = t;
+            Psample = p;
+            *pdf = regionPdf;
+            collided = true;
+        }
+    });
+    if (sampled && !collided) {
+        // No collision in any region, the photon leaves the volume
+        *tDist = INFINITY;
+        Psample = ray(INFINITY);
+        *pdf = 1.f;
+    }
+    return sampled;
 }
 
 
 bool AggregateVolume::SampleDirection(const Point& p, const Vector& wi,
                                       Vector& wo, float* pdf, RNG &rng) const {
-    for (uint32_t i = 0; i < regions.size(); ++i)
-        if(regions[i]->SampleDirection(p, wi, wo, pdf, rng))
-            return true;
-    return false;
+    bool sampled = false;
+    VisitRegions(p, [&](const VolumeRegion *r) {
+        if (!sampled)
+            sampled = r->SampleDirection(p, wi, wo, pdf, rng);
+    });
+    return sampled;
 }
 
 
@@ -102,6 +102,30 @@ struct VolumeVertex {
 
 typedef std::vector<VolumeVertex> VolumeVertexList;
 
+// MediumProperties Declarations
+// The optical properties of a volume region at one point, computed by
+// VolumeRegion::Lookup() with a single transformation and voxel fetch
+// instead of one per coefficient.
+struct MediumProperties {
+    MediumProperties() : g(0.f), tag(0) { }
+    void Set(const Spectrum &sa, const Spectrum &ss, const Spectrum &st,
+             float gg, int t) {
+        sigma_a = sa;
+        sigma_s = ss;
+        sigma_t = st;
+        albedo = st.IsBlack() ? Spectrum(0.f) : ss / st;
+        g = gg;
+        tag = t;
+    }
+    void Clear() { Set(0.f, 0.f, 0.f, 0.f, 0); }
+
+    Spectrum sigma_a, sigma_s, sigma_t;
+    Spectrum albedo; // sigma_s / sigma_t, black where the medium is empty
+    float g; // Asymmetry of the Henyey-Greenstein phase function
+    int tag; // Annotation or fluorophore tag of the voxel, zero if none
+};
+
+
 class VolumeRegion {
 public:
     // VolumeRegion Interface
@@ -113,6 +137,7 @@ public:
     virtual BBox WorldBound() const = 0;
     virtual bool IntersectP(const Ray &ray, float *t0, float *t1) const = 0;
     virtual bool SkipEmptySpace(const Ray &r, float *tSkip) const;
+    virtual bool Lookup(const Point &p, MediumProperties *mp) const;
     virtual float Density(const Point &Pobj) const { return 0.f;}
     virtual float PhotonDensity(const Point &p) const;
     virtual float Fluorescence(const Point &p) const;
@@ -135,6 +160,7 @@ public:
     virtual float Sigma_tf(const Point &p, const Vector &wo, float t, const int &wl) const { return 0.0; }
     virtual float MaxSigma_t(const int &wl) const;
     virtual float MaxSigma_tf(const int &wl) const { return 0.0; }
+    virtual float tauLambda_f(const Ray &r, float step, float offset, const int &wl) const { return 0.0; }
     virtual float STER(const Point &p, const Vector &wo, float t, const int &wl) const;
     virtual float ATER(const Point &p, const Vector &wo, float t, const int &wl) const;
     virtual float Lve(const Point &p, const Vector &wo, float t, const int &wl) const;
@@ -151,6 +177,7 @@ public:
     virtual bool SampleDistance(const Ray &r, float *tDis, Point &Psample, float *pdf, RNG &rng, const int &wl) const;
 
     virtual bool SampleDistance_f(const Ray &r, float *tDis, Point &Psample, float *pdf, RNG &rng) const { return false; }
+    virtual bool SampleDistance_f(const Ray &r, float *tDis, Point &Psample, float *pdf, RNG &rng, const int &wl) const { return false; }
     virtual bool SampleDirection_f(const Point &p, const Vector &wi, Vector &wo, float *pdf, RNG &rng) const { return false; }
 
 };
@@ -163,6 +190,7 @@ public:
             const Spectrum &em, const Transform &v2w)
         : sigma_a(sa), sigma_s(ss), le(em), g(gg),
           WorldToVolume(Inverse(v2w)) { }
+    bool Lookup(const Point &p, MediumProperties *mp) const;
     Spectrum Sigma_a(const Point &p, const Vector &, float) const {
         return Density(WorldToVolume(p)) * sigma_a;
     }
@@ -219,6 +247,15 @@ protected:
 };
 
 
+// AggregateVolume Local Declarations
+struct LinearVolumeNode {
+    BBox bounds;
+    uint32_t offset; // Region of a leaf, second child of an interior node
+    uint8_t axis;    // Split axis of an interior node
+    bool leaf;
+};
+
+
 class AggregateVolume : public VolumeRegion {
 public:
     // AggregateVolume Public Methods
@@ -227,6 +264,7 @@ public:
     BBox WorldBound() const;
     bool IntersectP(const Ray &ray, float *t0, float *t1) const;
     bool SkipEmptySpace(const Ray &ray, float *tSkip) const;
+    bool Lookup(const Point &p, MediumProperties *mp) const;
     float Density(const Point &Pobj) const;
     float PhotonDensity(const Point &p) const;
     bool HasNonClearedFluorescentVolumes() const;
@@ -254,6 +292,7 @@ public:
     float ATER(const Point &p, const Vector &wo, float t, const int &wl) const;
     float Lve(const Point &, const Vector &, float, const int &wl) const;
     float tauLambda(const Ray &ray, float, float, const int &wl) const;
+    float tauLambda_f(const Ray &ray, float, float, const int &wl) const;
     float Fluorescence(const Point &Pobj) const;
     Spectrum fEx(const Point &p) const;
     Spectrum fEm(const Point &p) const;
@@ -268,8 +307,18 @@ public:
     bool SampleDistance(const Ray& ray, float* tDis, Point &Psample,
             float* pdf, RNG &rng, const int &wl) const;
 private:
+    // AggregateVolume Private Methods
+    uint32_t BuildIndex(vector<uint32_t> &order, uint32_t start,
+                        uint32_t end);
+    template <typename Visitor>
+    void VisitRegions(const Point &p, const Visitor &visit) const;
+    template <typename Visitor>
+    void VisitRegions(const Ray &ray, const Visitor &visit) const;
+
     // AggregateVolume Private Data
     vector<VolumeRegion *> regions;
+    vector<BBox> regionBounds;
+    vector<LinearVolumeNode> nodes;
     BBox bound;
 };
 
@@ -42,6 +42,16 @@
 using namespace std;
 using namespace std::chrono;
 
+// VolumeUtil Local Functions
+static MappedFile *MapRawVolume(const string &filename, uint64 nBytes) {
+    MappedFile *volume = MappedFile::Open(filename, nBytes);
+    if (!volume)
+        Error("Cannot map the raw volume file %s, or its size does not "
+              "match the specified dimensions", filename.c_str());
+    return volume;
+}
+
+
 void ReadHeader(const string &prefix, int &nx, int &ny, int &nz) {
     std::string header = prefix + std::string(".hdr");
     std::ifstream headerFile(header.c_str());
@@ -70,79 +80,46 @@ void ReadHeader(const string &prefix, uint64 &nx, uint64 &ny, uint64 &nz) {
 }
 
 
-float* ReadFloatVolume(const std::string &prefix, uint64 &nx, uint64 &ny, uint64 &nz) {
+MappedFile* MapVolume(const std::string &prefix, uint64 &nx, uint64 &ny, uint64 &nz) {
     ReadHeader(prefix, nx, ny, nz);
+    high_resolution_clock::time_point start = high_resolution_clock::now();
 
-    float* data = new float[nx*ny*nz];
-    std::string volume = prefix + std::string(".img");
-
-    // Read the volume data
-    std::ifstream volumeFile(volume.c_str(), std::ios::in | std::ios::binary);
-    if(volumeFile.is_open()) {
-        // Get the length of the file
-        volumeFile.seekg(0, std::ios::end);
-        const uint64_t dataCount = volumeFile.tellg();
-        if (dataCount != uint64_t(nx*ny*nz)) {
-            Error("The volume size does not match the specified dimensions");
-            return NULL;
-        }
-        volumeFile.clear();
-        volumeFile.seekg(0);
-        int counter = 0;
-        while(volumeFile.tellg() != dataCount){
-            unsigned char value;
-            volumeFile.read((char*)&value, sizeof(unsigned char));
-            data[counter] = float(value);
-            counter++;
-        }
-    } else {
-        Error("Cannot open the raw volume file %s\n", prefix.c_str());
-        return NULL;
-    }
-    volumeFile.close();
-    return data;
-}
+    MappedFile *volume = MapRawVolume(prefix + std::string(".img"),
+                                      nx * ny * nz);
 
+    high_resolution_clock::time_point end = high_resolution_clock::now();
 
-uint8* ReadIntVolume(const std::string &prefix, uint64 &nx, uint64 &ny, uint64 &nz) {
-    ReadHeader(prefix, nx, ny, nz);
+    duration<double> interval = duration_cast<duration<double>>(end - start);
+    cout << "Mapping volume in [" << interval.count() << "] seconds." << endl;
 
-    using namespace std::chrono;
-    high_resolution_clock::time_point start = high_resolution_clock::now();
+    return volume;
+}
 
-    uchar* data = new uchar[nx*ny*nz];
-    std::string volume = prefix + std::string(".img");
 
-    // Read the volume data
-    std::ifstream volumeFile(volume.c_str(), std::ios::in | std::ios::binary);
-    if(volumeFile.is_open()) {
-        // Get the length of the file
-        volumeFile.seekg(0, std::ios::end);
-        const uint64_t dataCount = volumeFile.tellg();
-        if (dataCount != uint64_t(nx*ny*nz)) {
-            Error("The volume size does not match the specified dimensions");
-            return NULL;
-        }
-        volumeFile.clear();
-        volumeFile.seekg(0);
-        int counter = 0;
-        while(volumeFile.tellg() != dataCount){
-            unsigned char value;
-            volumeFile.read((char*)&value, sizeof(unsigned char));
-            data[counter] = value;
-            counter++;
-        }
-    } else {
-        Error("Cannot open the raw volume file %s\n", prefix.c_str());
+float* ReadFloatVolume(const std::string &prefix, uint64 &nx, uint64 &ny, uint64 &nz) {
+    MappedFile *volume = MapVolume(prefix, nx, ny, nz);
+    if (!volume)
         return NULL;
-    }
-    volumeFile.close();
 
-    high_resolution_clock::time_point end = high_resolution_clock::now();
+    // Convert the 8-bit voxels
+    const uint8 *voxels = volume->Data();
+    float* data = new float[nx*ny*nz];
+    #pragma omp parallel for
+    for (size_t i = 0; i < nx * ny * nz; i++)
+        data[i] = float(voxels[i]);
+    delete volume;
+    return data;
+}
 
-    duration<double> interval = duration_cast<duration<double>>(end - start);
-    cout << "Loading volume in [" << interval.count() << "] seconds." << endl;
 
+uint8* ReadIntVolume(const std::string &prefix, uint64 &nx, uint64 &ny, uint64 &nz) {
+    MappedFile *volume = MapVolume(prefix, nx, ny, nz);
+    if (!volume)
+        return NULL;
+
+    uchar* data = new uchar[nx*ny*nz];
+    memcpy(data, volume->Data(), nx*ny*nz);
+    delete volume;
     return data;
 }
 
@@ -257,7 +234,7 @@ float* ReadVSDVolume(const std::string &prefix, uint64& nx, uint64& ny, uint64&
 
     #pragma omp parallel for
     for(size_t i = 0; i < nx * ny * nz; i++) {
-        data[i] = (10000.0/ 100.0) * rawData[i];
+        data[i] = vsdVoxelScale * rawData[i];
     }
 
     delete [] rawData;
@@ -270,4 +247,21 @@ float* ReadVSDVolume(const std::string &prefix, uint64& nx, uint64& ny, uint64&
 }
 
 
+MappedFile* MapVSDVolume(const std::string &prefix, uint64& nx, uint64& ny,
+        uint64& nz, float &p0x, float &p0y, float &p0z, float &p1x, float &p1y,
+        float &p1z, float &maxValue) {
+    ReadVSDHeader(prefix, nx, ny, nz, p0x, p0y, p0z, p1x, p1y, p1z, maxValue);
+    return MapRawVolume(prefix + std::string(".raw"), nx * ny * nz);
+}
+
+
+MappedFile* MapVSDFloatVolume(const std::string &prefix, uint64& nx,
+        uint64& ny, uint64& nz, float &p0x, float &p0y, float &p0z, float &p1x,
+        float &p1y, float &p1z, float &maxValue) {
+    ReadVSDHeader(prefix, nx, ny, nz, p0x, p0y, p0z, p1x, p1y, p1z, maxValue);
+    return MapRawVolume(prefix + std::string(".fraw"),
+                        nx * ny * nz * sizeof(float));
+}
+
+
 
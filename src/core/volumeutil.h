@@ -37,11 +37,16 @@
 #define PBRT_CORE_VOLUMEUTIL_H
 
 #include "bitarray.h"
+#include "fileutil.h"
+
+// Raw VSD volumes store the signal as a percentage of this value
+static const float vsdVoxelScale = 10000.f / 100.f;
 
 void ReadHeader(const std::string &prefix, uint64 &nx, uint64 &ny, uint64 &nz);
 uint8* ReadIntVolume(const std::string &prefix, uint64 &nx, uint64 &ny, uint64 &nz);
 float* ReadFloatVolume(const std::string &prefix, uint64 &nx, uint64 &ny, uint64 &nz);
 uint8* ReadIndices(const std::string &prefix, uint64& nx, uint64& ny, uint64& nz);
+MappedFile* MapVolume(const std::string &prefix, uint64 &nx, uint64 &ny, uint64 &nz);
 void ReadColorTaggedHeader(const std::string &prefix, int &nx, int &ny, int &nz,
         int &ntags, float *density, Spectrum *sa, Spectrum *ss, Spectrum *le);
 void ReadColorTaggedVolume(const std::string &prefix, int &nx, int &ny, int &nz,
@@ -55,5 +60,11 @@ void ReadVSDHeader(const std::string &prefix, int &nx, int &ny, int &nz,
 float* ReadVSDVolume(const std::string &prefix, uint64 &nx, uint64 &ny, uint64 &nz,
     float &p0x, float &p0y, float &p0z, float &p1x, float &p1y, float &p1z,
     float &maxValue);
+MappedFile* MapVSDVolume(const std::string &prefix, uint64 &nx, uint64 &ny,
+    uint64 &nz, float &p0x, float &p0y, float &p0z, float &p1x, float &p1y,
+    float &p1z, float &maxValue);
+MappedFile* MapVSDFloatVolume(const std::string &prefix, uint64 &nx,
+    uint64 &ny, uint64 &nz, float &p0x, float &p0y, float &p0z, float &p1x,
+    float &p1y, float &p1z, float &maxValue);
 
 #endif // PBRT_CORE_VOLUMEUTIL_H
@@ -37,6 +37,9 @@
 #include "spectrum.h"
 #include "parallel.h"
 #include "imageio.h"
+#include "checkpoint.h"
+#include "shard.h"
+#include "filters/box.h"
 
 #include <fstream>
 #include <math.h>
@@ -58,11 +61,67 @@ void strip(std::string &fullString, const std::string subString)
 }
 
 
+// ImagePixelPlanes Method Definitions
+ImagePixelPlanes::ImagePixelPlanes(int xres, int yres, int nbands, bool splats)
+    : xRes(xres), yRes(yres), nPixels(uint64_t(xres) * uint64_t(yres)),
+      nBands(nbands) {
+    for (int i = 0; i < 3; ++i) {
+        xyz[i] = (float *)AllocAligned(nPixels * sizeof(float));
+        splatXYZ[i] = splats ?
+            (float *)AllocAligned(nPixels * sizeof(float)) : NULL;
+    }
+    weightSum = (float *)AllocAligned(nPixels * sizeof(float));
+    spectra = nBands > 0 ?
+        (float *)AllocAligned(nBands * nPixels * sizeof(float)) : NULL;
+    Clear();
+}
+
+
+ImagePixelPlanes::~ImagePixelPlanes() {
+    for (int i = 0; i < 3; ++i) {
+        FreeAligned(xyz[i]);
+        if (splatXYZ[i]) FreeAligned(splatXYZ[i]);
+    }
+    FreeAligned(weightSum);
+    if (spectra) FreeAligned(spectra);
+}
+
+
+void ImagePixelPlanes::Clear() {
+    for (int i = 0; i < 3; ++i) {
+        memset(xyz[i], 0, nPixels * sizeof(float));
+        if (splatXYZ[i]) memset(splatXYZ[i], 0, nPixels * sizeof(float));
+    }
+    memset(weightSum, 0, nPixels * sizeof(float));
+    if (spectra) memset(spectra, 0, nBands * nPixels * sizeof(float));
+}
+
+
+
+// ImageFilmTile Method Definitions
+ImageFilmTile::ImageFilmTile(ImageFilm *f, int x0, int x1, int y0, int y1,
+                             int nBands)
+    : film(f), xStart(x0), yStart(y0), planes(x1 - x0, y1 - y0, nBands, false) {
+}
+
+
+void ImageFilmTile::AddSample(const CameraSample &sample, const Spectrum &L) {
+    // Samples whose filter footprint leaves the tile go straight to the film
+    if (!film->AccumulateSample(sample, L, &planes, xStart, yStart, false)) {
+        MutexLock lock(*film->tileMutex);
+        film->AccumulateSample(sample, L, film->pixels, film->xPixelStart,
+                               film->yPixelStart, false);
+    }
+}
+
+
+
 // ImageFilm Method Definitions
 ImageFilm::ImageFilm(int xres, int yres, float filmwidth, float filmheight,
         Filter *filt, const float crop[4], const string &fn, bool openWindow,
         bool pixelspectra, bool avgfilmspectrum,
-        bool usefilter, int lambdamin, int lambdamax, bool valid)
+        bool usefilter, int lambdamin, int lambdamax, bool valid,
+        int spectralBands)
     : Film(xres, yres) {
     filter = filt;
     memcpy(cropWindow, crop, 4 * sizeof(float));
@@ -85,8 +144,33 @@ ImageFilm::ImageFilm(int xres, int yres, float filmwidth, float filmheight,
     lambdaMax = lambdamax;
     validate = valid;
 
+    // Map spectral samples to the bands stored per pixel; the film keeps
+    // no spectra at all unless they are written out
+    nSpectralBands = (writePixelsSpectra || writeImageSpectrum) ?
+        Clamp(spectralBands, 1, nSpectralSamples) : 0;
+    sampleBand = NULL;
+    bandScale = NULL;
+    if (nSpectralBands > 0) {
+        sampleBand = new int[nSpectralSamples];
+        bandScale = new float[nSpectralBands];
+        for (int b = 0; b < nSpectralBands; ++b)
+            bandScale[b] = 0.f;
+        for (int i = 0; i < nSpectralSamples; ++i) {
+            sampleBand[i] = int((int64_t)i * nSpectralBands / nSpectralSamples);
+            bandScale[sampleBand[i]] += 1.f;
+        }
+        for (int b = 0; b < nSpectralBands; ++b)
+            bandScale[b] = 1.f / bandScale[b];
+    }
+
     // Allocate film image storage
-    pixels = new BlockedArray<Pixel>(xPixelCount, yPixelCount);
+    pixels = new ImagePixelPlanes(xPixelCount, yPixelCount, nSpectralBands,
+                                  true);
+    tileMutex = Mutex::Create();
+    Info("Film storage: %d x %d pixels, %d spectral bands (%.1f MB)",
+         xPixelCount, yPixelCount, nSpectralBands,
+         float(pixels->nPixels * (7 + nSpectralBands) * sizeof(float)) /
+         (1024.f * 1024.f));
 
     // Precompute filter weight table
 #define FILTER_TABLE_SIZE 16
@@ -109,8 +193,26 @@ ImageFilm::ImageFilm(int xres, int yres, float filmwidth, float filmheight,
 }
 
 
+ImageFilm::~ImageFilm() {
+    delete pixels;
+    Mutex::Destroy(tileMutex);
+    delete[] sampleBand;
+    delete[] bandScale;
+    delete filter;
+    delete[] filterTable;
+}
+
+
 void ImageFilm::AddSample(const CameraSample &sample,
                           const Spectrum &L) {
+    bool syncNeeded = (filter->xWidth > 0.5f || filter->yWidth > 0.5f);
+    AccumulateSample(sample, L, pixels, xPixelStart, yPixelStart, syncNeeded);
+}
+
+
+bool ImageFilm::AccumulateSample(const CameraSample &sample,
+        const Spectrum &L, ImagePixelPlanes *planes, int xOffset, int yOffset,
+        bool atomic) const {
     // Compute sample's raster extent
     float dimageX = sample.imageX - 0.5f;
     float dimageY = sample.imageY - 0.5f;
@@ -125,9 +227,14 @@ void ImageFilm::AddSample(const CameraSample &sample,
     if ((x1-x0) < 0 || (y1-y0) < 0)
     {
         PBRT_SAMPLE_OUTSIDE_IMAGE_EXTENT(const_cast<CameraSample *>(&sample));
-        return;
+        return true;
     }
 
+    // Reject the sample if its footprint is not covered by _planes_
+    if (x0 < xOffset || x1 >= xOffset + planes->xRes ||
+        y0 < yOffset || y1 >= yOffset + planes->yRes)
+        return false;
+
     // Clone the input spectrum to the film
     Spectrum Lfilter(0.);
     if (useFilter) {
@@ -148,6 +255,18 @@ void ImageFilm::AddSample(const CameraSample &sample,
 
     LImage.ToXYZ(xyz);
 
+    // Collapse the sample spectrum into the film's spectral bands once,
+    // rather than once per filter tap
+    float *bands = NULL;
+    if (nSpectralBands > 0) {
+        bands = ALLOCA(float, nSpectralBands);
+        for (int b = 0; b < nSpectralBands; ++b)
+            bands[b] = 0.f;
+        for (int i = 0; i < nSpectralSamples; i++)
+            bands[sampleBand[i]] += bandScale[sampleBand[i]] *
+                LImage.GetSampleValueAtWavelengthIndex(i);
+    }
+
     // Precompute $x$ and $y$ filter table offsets
     int *ifx = ALLOCA(int, x1 - x0 + 1);
     for (int x = x0; x <= x1; ++x) {
@@ -161,49 +280,86 @@ void ImageFilm::AddSample(const CameraSample &sample,
                          filter->invYWidth * FILTER_TABLE_SIZE);
         ify[y-y0] = min(Floor2Int(fy), FILTER_TABLE_SIZE-1);
     }
-    bool syncNeeded = (filter->xWidth > 0.5f || filter->yWidth > 0.5f);
     for (int y = y0; y <= y1; ++y) {
         for (int x = x0; x <= x1; ++x) {
             // Evaluate filter value at $(x,y)$ pixel
             int offset = ify[y-y0]*FILTER_TABLE_SIZE + ifx[x-x0];
             float filterWt = filterTable[offset];
 
-            // Update pixel values with filtered sample contribution
-            Pixel &pixel = (*pixels)(x - xPixelStart, y - yPixelStart);
-            if (!syncNeeded) {
-                pixel.Lxyz[0] += filterWt * xyz[0];
-                pixel.Lxyz[1] += filterWt * xyz[1];
-                pixel.Lxyz[2] += filterWt * xyz[2];
-                pixel.weightSum += filterWt;
-
-                if (writePixelsSpectra || writeImageSpectrum) {
-                    for (int i = 0; i < nSpectralSamples; i++) {
-                        // Add the pixel area into the calculations to account
-                        // for the CCD size
-                        pixel.L.GetRefToSampleValueAtWavelengthIndex(i) +=
-            pixelArea * filterWt * LImage.GetSampleValueAtWavelengthIndex(i);
-                    }
-                }
+            // Update pixel values with filtered sample contribution; the
+            // pixel area accounts for the CCD size in the spectra
+            uint64_t p = uint64_t(x - xOffset) +
+                         uint64_t(y - yOffset) * planes->xRes;
+            float spectralWt = pixelArea * filterWt;
+            if (!atomic) {
+                planes->xyz[0][p] += filterWt * xyz[0];
+                planes->xyz[1][p] += filterWt * xyz[1];
+                planes->xyz[2][p] += filterWt * xyz[2];
+                planes->weightSum[p] += filterWt;
+                for (int b = 0; b < nSpectralBands; ++b)
+                    planes->Band(b)[p] += spectralWt * bands[b];
             }
             else {
-                // Safely update _Lxyz_ and _weightSum_ even with concurrency
-                AtomicAdd(&pixel.Lxyz[0], filterWt * xyz[0]);
-                AtomicAdd(&pixel.Lxyz[1], filterWt * xyz[1]);
-                AtomicAdd(&pixel.Lxyz[2], filterWt * xyz[2]);
-                AtomicAdd(&pixel.weightSum, filterWt);
-
-                // Add the sample (SampledSpectrum sample) to the pixel
-                if (writePixelsSpectra || writeImageSpectrum) {
-                    for (int i = 0; i < nSpectralSamples; i++) {
-                        // Add the pixel area into the calculations to account
-                        // for the CCD size
-                        AtomicAdd(&pixel.L.GetRefToSampleValueAtWavelengthIndex(i),
-            pixelArea * filterWt * LImage.GetSampleValueAtWavelengthIndex(i));
-                    }
-                }
+                // Safely update _xyz_ and _weightSum_ even with concurrency
+                AtomicAdd(&planes->xyz[0][p], filterWt * xyz[0]);
+                AtomicAdd(&planes->xyz[1][p], filterWt * xyz[1]);
+                AtomicAdd(&planes->xyz[2][p], filterWt * xyz[2]);
+                AtomicAdd(&planes->weightSum[p], filterWt);
+                for (int b = 0; b < nSpectralBands; ++b)
+                    AtomicAdd(&planes->Band(b)[p], spectralWt * bands[b]);
+            }
+        }
+    }
+    return true;
+}
+
+
+FilmTile *ImageFilm::GetFilmTile(int xstart, int xend, int ystart, int yend) {
+    // Bound the pixels reached by samples in $[xstart,xend) \times [ystart,yend)$
+    int x0 = max(Ceil2Int(xstart - 0.5f - filter->xWidth), xPixelStart);
+    int x1 = min(Floor2Int(xend - 0.5f + filter->xWidth),
+                 xPixelStart + xPixelCount - 1) + 1;
+    int y0 = max(Ceil2Int(ystart - 0.5f - filter->yWidth), yPixelStart);
+    int y1 = min(Floor2Int(yend - 0.5f + filter->yWidth),
+                 yPixelStart + yPixelCount - 1) + 1;
+    if (x1 <= x0 || y1 <= y0) return NULL;
+    return new ImageFilmTile(this, x0, x1, y0, y1, nSpectralBands);
+}
+
+
+void ImageFilm::MergeFilmTile(FilmTile *t) {
+    ImageFilmTile *tile = (ImageFilmTile *)t;
+    const ImagePixelPlanes &src = tile->planes;
+    {
+        MutexLock lock(*tileMutex);
+        for (int y = 0; y < src.yRes; ++y) {
+            uint64_t s = uint64_t(y) * src.xRes;
+            uint64_t d = uint64_t(tile->xStart - xPixelStart) +
+                uint64_t(tile->yStart - yPixelStart + y) * xPixelCount;
+            for (int i = 0; i < 3; ++i)
+                for (int x = 0; x < src.xRes; ++x)
+                    pixels->xyz[i][d + x] += src.xyz[i][s + x];
+            for (int x = 0; x < src.xRes; ++x)
+                pixels->weightSum[d + x] += src.weightSum[s + x];
+            for (int b = 0; b < nSpectralBands; ++b) {
+                const float *srcBand = src.Band(b) + s;
+                float *dstBand = pixels->Band(b) + d;
+                for (int x = 0; x < src.xRes; ++x)
+                    dstBand[x] += srcBand[x];
             }
         }
     }
+    delete tile;
+}
+
+
+Spectrum ImageFilm::PixelSpectrum(uint64_t offset) const {
+    // Expand the stored bands back to the full set of spectral samples
+    Spectrum L(0.f);
+    for (int i = 0; i < nSpectralSamples; i++)
+        L.SetSampleValueAtWavelengthIndex(i,
+            pixels->Band(sampleBand[i])[offset]);
+    return L;
 }
 
 
@@ -217,10 +373,42 @@ void ImageFilm::Splat(const CameraSample &sample, const Spectrum &L) {
     int x = Floor2Int(sample.imageX), y = Floor2Int(sample.imageY);
     if (x < xPixelStart || x - xPixelStart >= xPixelCount ||
         y < yPixelStart || y - yPixelStart >= yPixelCount) return;
-    Pixel &pixel = (*pixels)(x - xPixelStart, y - yPixelStart);
-    AtomicAdd(&pixel.splatXYZ[0], xyz[0]);
-    AtomicAdd(&pixel.splatXYZ[1], xyz[1]);
-    AtomicAdd(&pixel.splatXYZ[2], xyz[2]);
+    uint64_t p = uint64_t(x - xPixelStart) +
+                 uint64_t(y - yPixelStart) * xPixelCount;
+    AtomicAdd(&pixels->splatXYZ[0][p], xyz[0]);
+    AtomicAdd(&pixels->splatXYZ[1][p], xyz[1]);
+    AtomicAdd(&pixels->splatXYZ[2][p], xyz[2]);
+}
+
+
+bool ImageFilm::WriteCheckpoint(FILE *file) const {
+    // Save the accumulated planes, the tiles are merged at the end of tasks
+    const uint64_t nPixels = pixels->nPixels;
+    for (int i = 0; i < 3; ++i) {
+        if (!WriteCheckpointArray(file, pixels->xyz[i], nPixels))
+            return false;
+        if (pixels->splatXYZ[i] &&
+            !WriteCheckpointArray(file, pixels->splatXYZ[i], nPixels))
+            return false;
+    }
+    return WriteCheckpointArray(file, pixels->weightSum, nPixels) &&
+           WriteCheckpointArray(file, pixels->spectra,
+                                uint64_t(nSpectralBands) * nPixels);
+}
+
+
+bool ImageFilm::ReadCheckpoint(FILE *file) {
+    const uint64_t nPixels = pixels->nPixels;
+    for (int i = 0; i < 3; ++i) {
+        if (!ReadCheckpointArray(file, pixels->xyz[i], nPixels))
+            return false;
+        if (pixels->splatXYZ[i] &&
+            !ReadCheckpointArray(file, pixels->splatXYZ[i], nPixels))
+            return false;
+    }
+    return ReadCheckpointArray(file, pixels->weightSum, nPixels) &&
+           ReadCheckpointArray(file, pixels->spectra,
+                               uint64_t(nSpectralBands) * nPixels);
 }
 
 
@@ -246,6 +434,11 @@ void ImageFilm::GetPixelExtent(int *xstart, int *xend,
 
 
 void ImageFilm::WriteImage(float splatScale) {
+    if (Sharded()) {
+        WriteShard(splatScale);
+        return;
+    }
+
     // Convert image to RGB and compute final pixel values
     int nPix = xPixelCount * yPixelCount;
     float* recordedEnergy = new float[nPix];
@@ -253,10 +446,12 @@ void ImageFilm::WriteImage(float splatScale) {
     int offset = 0;
     for (int y = 0; y < yPixelCount; ++y) {
         for (int x = 0; x < xPixelCount; ++x) {
-            XYZToRGB((*pixels)(x, y).Lxyz, &rgb[3*offset]);
-            float r = (*pixels)(x, y).Lxyz[0];
-            float g = (*pixels)(x, y).Lxyz[1];
-            float b = (*pixels)(x, y).Lxyz[2];
+            float xyz[3] = { pixels->xyz[0][offset], pixels->xyz[1][offset],
+                             pixels->xyz[2][offset] };
+            XYZToRGB(xyz, &rgb[3*offset]);
+            float r = xyz[0];
+            float g = xyz[1];
+            float b = xyz[2];
             float average = splatScale * (r + g + b) / 3.f;
             recordedEnergy[offset] = average;
             if(rgb[3 * offset    ] != 0 &&
@@ -265,7 +460,7 @@ void ImageFilm::WriteImage(float splatScale) {
                 this->nIlluminatedPixels += 1;
             }
 
-            float weightSum = (*pixels)(x, y).weightSum;
+            float weightSum = pixels->weightSum[offset];
             if (weightSum != 0.f) {
                 float invWt = 1.f / weightSum;
                 rgb[3*offset  ] = max(0.f, rgb[3*offset  ] * invWt);
@@ -273,8 +468,11 @@ void ImageFilm::WriteImage(float splatScale) {
                 rgb[3*offset+2] = max(0.f, rgb[3*offset+2] * invWt);
             }
 
+            float splatXYZ[3] = { pixels->splatXYZ[0][offset],
+                                  pixels->splatXYZ[1][offset],
+                                  pixels->splatXYZ[2][offset] };
             float splatRGB[3];
-            XYZToRGB((*pixels)(x, y).splatXYZ, splatRGB);
+            XYZToRGB(splatXYZ, splatRGB);
             rgb[3*offset  ] += splatScale * splatRGB[0];
             rgb[3*offset+1] += splatScale * splatRGB[1];
             rgb[3*offset+2] += splatScale * splatRGB[2];
@@ -289,10 +487,10 @@ void ImageFilm::WriteImage(float splatScale) {
     // Write the VSD image
     const string vsdFile =  fileNamePrefix + ".vsd";
     std::fstream stream(vsdFile.c_str(), ios::out);
-    for (uint64_t x = 0; x < xResolution; ++x)
-        for (uint64_t y = 0; y < yResolution; ++y)
-            stream << x << " " << y << " "
-                   << recordedEnergy[x + xResolution* y] << endl;
+    for (int x = 0; x < xPixelCount; ++x)
+        for (int y = 0; y < yPixelCount; ++y)
+            stream << x + xPixelStart << " " << y + yPixelStart << " "
+                   << recordedEnergy[x + xPixelCount * y] << endl;
     stream.close();
 
     // Release temporary image memory
@@ -304,9 +502,73 @@ void ImageFilm::WriteImage(float splatScale) {
 }
 
 
+void ImageFilm::WriteShard(float splatScale) {
+    // Save the raw planes, pbrtmerge sums the shards and writes the film
+    strip(fileNamePrefix, ".exr");
+    const string file = ShardFileName(fileNamePrefix) + ".imagefilm";
+    ImageFilmShardHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "PBRTFILM", 8);
+    header.version = 2;
+    header.xResolution = xResolution;
+    header.yResolution = yResolution;
+    header.xPixelStart = xPixelStart;
+    header.yPixelStart = yPixelStart;
+    header.xPixelCount = xPixelCount;
+    header.yPixelCount = yPixelCount;
+    header.splatScale = splatScale;
+    memcpy(header.cropWindow, cropWindow, 4 * sizeof(float));
+    header.filmWidth = filmWidth;
+    header.filmHeight = filmHeight;
+    header.lambdaStart = sampledLambdaStart;
+    header.lambdaEnd = sampledLambdaEnd;
+    header.nSpectralSamples = nSpectralSamples;
+    header.nSpectralBands = nSpectralBands;
+    header.writePixelsSpectra = writePixelsSpectra;
+    header.writeImageSpectrum = writeImageSpectrum;
+    header.validate = validate;
+    FILE *f = fopen(file.c_str(), "wb");
+    if (!f) {
+        Error("Cannot open the film shard \"%s\" for writing", file.c_str());
+        return;
+    }
+    const uint64_t nPixels = pixels->nPixels;
+    bool written = fwrite(&header, sizeof(header), 1, f) == 1;
+    const float *planes[7] = { pixels->xyz[0], pixels->xyz[1], pixels->xyz[2],
+                               pixels->weightSum, pixels->splatXYZ[0],
+                               pixels->splatXYZ[1], pixels->splatXYZ[2] };
+    for (int i = 0; i < 7 && written; ++i)
+        written = fwrite(planes[i], sizeof(float), nPixels, f) == nPixels;
+    for (int b = 0; b < nSpectralBands && written; ++b)
+        written = fwrite(pixels->Band(b), sizeof(float), nPixels, f) ==
+                  nPixels;
+    fclose(f);
+    if (!written)
+        Error("Writing the film shard \"%s\" failed", file.c_str());
+}
+
+
+bool ImageFilm::AddShard(FILE *file) {
+    // Add the planes following the header of a shard of this film
+    const uint64_t nPixels = pixels->nPixels;
+    float *planes[7] = { pixels->xyz[0], pixels->xyz[1], pixels->xyz[2],
+                         pixels->weightSum, pixels->splatXYZ[0],
+                         pixels->splatXYZ[1], pixels->splatXYZ[2] };
+    vector<float> plane(nPixels);
+    for (int i = 0; i < 7 + nSpectralBands; ++i) {
+        if (fread(&plane[0], sizeof(float), nPixels, file) != nPixels)
+            return false;
+        float *dst = i < 7 ? planes[i] : pixels->Band(i - 7);
+        for (uint64_t p = 0; p < nPixels; ++p)
+            dst[p] += plane[p];
+    }
+    return true;
+}
+
+
 void ImageFilm::WriteValidationImage(float splatScale) {
     int nPix = xPixelCount * yPixelCount;
-    float *rgbPixel = new float[3*nPix];
+    float *rgbPixel = new float[3*nPix]();
     // Compute the average spectrum for the entire image
     Spectrum LImage(0.);
     if (writePixelsSpectra || writeImageSpectrum) {
@@ -318,8 +580,8 @@ void ImageFilm::WriteValidationImage(float splatScale) {
         int offset = 0;
         for (int y = 0; y < yPixelCount; ++y) {
             for (int x = 0; x < xPixelCount; ++x) {
-                Spectrum LPixel = (*pixels)(x, y).L;
-                float weightSum = (*pixels)(x, y).weightSum;
+                Spectrum LPixel = PixelSpectrum(offset);
+                float weightSum = pixels->weightSum[offset];
                 if (weightSum != 0.f) {
                     float invWt = 1.f / weightSum;
                     for (int i = 0; i < nSpectralSamples; i++) {
@@ -460,7 +722,21 @@ ImageFilm *CreateImageFilm(const ParamSet &params, Filter *filter) {
     bool spectralfilter = params.FindOneBool("spectralfilter", false);
     int filterBandMin = params.FindOneInt("filter1bandmin", 400);
     int filterBandMax = params.FindOneInt("filter1bandmax", 700);
+    // Number of spectral bands kept per pixel when spectra are written
+    int spectralBands = params.FindOneInt("spectralbands", nSpectralSamples);
     return new ImageFilm(xres, yres, pixelWidth_um, pixelHeight_um,
             filter, crop, filename, openwin, writeSpectrum, writeAverageSpectrum,
-            spectralfilter, filterBandMin, filterBandMax, validate);
+            spectralfilter, filterBandMin, filterBandMax, validate,
+            spectralBands);
+}
+
+
+ImageFilm *CreateImageFilm(const ImageFilmShardHeader &header,
+                           const string &filename) {
+    // The film of the shards, the samples were already filtered
+    return new ImageFilm(header.xResolution, header.yResolution,
+            header.filmWidth, header.filmHeight, new BoxFilter(.5f, .5f),
+            header.cropWindow, filename, false, header.writePixelsSpectra,
+            header.writeImageSpectrum, false, 0, 0, header.validate,
+            header.nSpectralBands);
 }
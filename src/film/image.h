@@ -45,6 +45,68 @@
 #include "paramset.h"
 #include "spectrum.h"
 
+// ImagePixelPlanes Declarations
+// Structure-of-arrays pixel storage: one plane per XYZ channel, one for the
+// filter weights, optionally one per splat channel and one per spectral
+// band.  The spectral planes are only allocated when the film is asked to
+// write spectra, and may use fewer bands than _nSpectralSamples_.
+struct ImagePixelPlanes {
+    ImagePixelPlanes(int xres, int yres, int nbands, bool splats);
+    ~ImagePixelPlanes();
+    void Clear();
+    float *Band(int b) { return spectra + uint64_t(b) * nPixels; }
+    const float *Band(int b) const { return spectra + uint64_t(b) * nPixels; }
+
+    int xRes, yRes;
+    uint64_t nPixels;
+    int nBands;
+    float *xyz[3];
+    float *weightSum;
+    float *splatXYZ[3];
+    float *spectra;
+};
+
+
+// ImageFilmShardHeader Declarations
+// Header of the partial films written by sharded renders.  It is followed
+// by seven float planes of _xPixelCount_ x _yPixelCount_ pixels, x varying
+// fastest: the unnormalised X, Y and Z, the filter weights and the splatted
+// X, Y and Z, then by one plane per spectral band.  The header also keeps
+// the film settings and spectral sampling pbrtmerge needs to write the same
+// outputs as the film.
+struct ImageFilmShardHeader {
+    char magic[8];
+    uint32_t version;
+    int32_t xResolution, yResolution;
+    int32_t xPixelStart, yPixelStart;
+    int32_t xPixelCount, yPixelCount;
+    float splatScale;
+    float cropWindow[4];
+    float filmWidth, filmHeight;
+    int32_t lambdaStart, lambdaEnd, nSpectralSamples;
+    int32_t nSpectralBands;
+    int32_t writePixelsSpectra, writeImageSpectrum, validate;
+};
+
+
+class ImageFilm;
+
+// ImageFilmTile Declarations
+class ImageFilmTile : public FilmTile {
+public:
+    // ImageFilmTile Public Methods
+    ImageFilmTile(ImageFilm *film, int x0, int x1, int y0, int y1,
+                  int nBands);
+    void AddSample(const CameraSample &sample, const Spectrum &L);
+private:
+    // ImageFilmTile Private Data
+    friend class ImageFilm;
+    ImageFilm *film;
+    int xStart, yStart;
+    ImagePixelPlanes planes;
+};
+
+
 // ImageFilm Declarations
 class ImageFilm : public Film {
 public:
@@ -52,17 +114,20 @@ public:
     ImageFilm(int xres, int yres, float filmwidth, float filmheight,
             Filter *filt, const float crop[4], const string &fileNamePrefix,
             bool openWindow, bool pixelspectra, bool avgfilmspectrum,
-            bool filter, int lambdamin, int lambdamax, bool valid);
-    ~ImageFilm() {
-        delete pixels;
-        delete filter;
-        delete[] filterTable;
-    }
+            bool filter, int lambdamin, int lambdamax, bool valid,
+            int spectralBands);
+    ~ImageFilm();
     void AddSample(const CameraSample &sample, const Spectrum &L);
     void Splat(const CameraSample &sample, const Spectrum &L);
+    FilmTile *GetFilmTile(int xstart, int xend, int ystart, int yend);
+    void MergeFilmTile(FilmTile *tile);
     void GetSampleExtent(int *xstart, int *xend, int *ystart, int *yend) const;
     void GetPixelExtent(int *xstart, int *xend, int *ystart, int *yend) const;
     void WriteImage(float splatScale);
+    void WriteShard(float splatScale);
+    bool AddShard(FILE *file);
+    bool WriteCheckpoint(FILE *file) const;
+    bool ReadCheckpoint(FILE *file);
     void WriteValidationImage(float splatScale);
     void UpdateDisplay(int x0, int y0, int x1, int y1, float splatScale);
     float GetFilmWidth() const { return filmWidth; }
@@ -72,6 +137,13 @@ public:
     float GetPixelHeight() const { return pixelHeight; }
     float GetPixelArea() const { return pixelArea; }
 private:
+    // ImageFilm Private Methods
+    friend class ImageFilmTile;
+    bool AccumulateSample(const CameraSample &sample, const Spectrum &L,
+                          ImagePixelPlanes *planes, int xOffset, int yOffset,
+                          bool atomic) const;
+    Spectrum PixelSpectrum(uint64_t offset) const;
+
     // ImageFilm Private Data
     Filter *filter;
     float cropWindow[4];
@@ -79,20 +151,11 @@ private:
     int xPixelStart, yPixelStart, xPixelCount, yPixelCount;
     float filmWidth, filmHeight, filmArea;
     float pixelWidth, pixelHeight, pixelArea;
-
-    struct Pixel {
-        Pixel() {
-            for (int i = 0; i < 3; ++i) Lxyz[i] = splatXYZ[i] = 0.f;
-            weightSum = 0.f;
-            L = Spectrum(0.);
-        }
-        float Lxyz[3];
-        float weightSum;
-        float splatXYZ[3];
-        float pad;
-        Spectrum L;
-    };
-    BlockedArray<Pixel> *pixels;
+    ImagePixelPlanes *pixels;
+    Mutex *tileMutex;
+    int nSpectralBands;
+    int *sampleBand;
+    float *bandScale;
     float *filterTable;
     int nIlluminatedPixels;
     bool useFilter;
@@ -105,6 +168,8 @@ private:
 
 
 ImageFilm *CreateImageFilm(const ParamSet &params, Filter *filter);
+ImageFilm *CreateImageFilm(const ImageFilmShardHeader &header,
+                           const string &filename);
 
 
 #endif // PBRT_FILM_IMAGE_H
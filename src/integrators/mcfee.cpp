@@ -39,15 +39,29 @@
 #include "mcfee.h"
 #include "core/light.h"
 #include "shapes/bead.h"
+#include "photontracer.h"
+#include "checkpoint.h"
 #include <sstream>
 #include <iostream>
 #include <fstream>
-#include <omp.h>
 #include <inttypes.h>
 #include <cstdio>
 #include <cinttypes>
 
 
+// MCFEEPhotonTracer Declarations
+class MCFEEPhotonTracer : public PhotonTracer {
+public:
+    MCFEEPhotonTracer(MCFEE *i, const Scene *s) : integrator(i), scene(s) { }
+    void Trace(uint64_t photon, RNG &rng) {
+        integrator->TracePhoton(scene, rng);
+    }
+private:
+    MCFEE *integrator;
+    const Scene *scene;
+};
+
+
 // MCFEE Method Definitions
 void MCFEE::RequestSamples(Sampler *sampler, Sample *sample, const Scene *scene) {
     tauSampleOffset = sample->Add1D(1);
@@ -92,7 +106,8 @@ bool MCFEE::ExcitationPath(const Scene *scene, Light* fiber, RNG &rng, Point &hi
     Vector wo = ray->d;
 
     // Start a MC random walk
-    while(vr->WorldBound().Inside(p)) {
+    MediumProperties mp;
+    while(vr->Lookup(p, &mp)) {
 
         // Build a new ray along the new direction.
         Ray ray(p, wo, 0, INFINITY);
@@ -101,8 +116,8 @@ bool MCFEE::ExcitationPath(const Scene *scene, Light* fiber, RNG &rng, Point &hi
         pPrev = p;
 
         // Get the optical properties of the tissue
-        float scatteringCoff = vr->Sigma_s(p, wo, 0.0).y();
-        float attenuationCoeff = vr->Sigma_t(p, wo, 0.0).y();
+        float scatteringCoff = mp.sigma_s.y();
+        float attenuationCoeff = mp.sigma_t.y();
         float scatteringProb = scatteringCoff / attenuationCoeff;
 
         // printf("%f ", scatteringProb);
@@ -182,6 +197,147 @@ void MCFEE::EmissionPath(const Scene *scene, RNG &rng, const Point &hitPoint) {
     }
 }
 
+bool MCFEE::HeroExcitationPath(const Scene *scene, Light* fiber, RNG &rng,
+                               Point &hitPoint) {
+    // Volume region
+    VolumeRegion *vr = scene->volumeRegion;
+
+    // Create a light sample
+    LightSample ls(rng);
+
+    // Sample the light source
+    Ray ray; Normal n; float pdf = 0.0;
+    Spectrum lightIntensity = fiber->Sample_L(scene, ls, rng.RandomFloat(),
+        rng.RandomFloat(), 0, &ray, &n, &pdf);
+
+    // The excitation is done at the laser wavelength if the fiber has one,
+    // otherwise at a wavelength sampled over the spectral range
+    int wl = lightIntensity.GetLaserWavelength();
+    if (wl < 0)
+        wl = HeroWavelengths(rng.RandomFloat(), 1).Hero();
+
+    // Photon position and direction, initially from the sampled ray
+    Point p = ray.o;
+    Vector wo = ray.d;
+
+    // Start a MC random walk
+    while(vr->WorldBound().Inside(p)) {
+
+        // Build a new ray along the new direction.
+        Ray ray(p, wo, 0, INFINITY);
+
+        // Get the optical properties of the tissue at _wl_
+        float scatteringCoff = vr->Sigma_s(p, wo, 0.0, wl);
+        float attenuationCoeff = vr->Sigma_t(p, wo, 0.0, wl);
+
+        float distancePdf, tDist;
+        if (scatteringCoff > rng.RandomFloat() * attenuationCoeff) {
+            // Sample a distance along the volume
+            if (!vr->SampleDistance(ray, &tDist, p, &distancePdf, rng, wl))
+                break;
+        } else {
+            // Photon absorption
+            break;
+        }
+
+        // If the photon hits the bead return true
+        for (size_t i = 0; i < scene->beads.size(); i++) {
+            if (scene->beads[i]->IntersectP(ray)) {
+                hitPoint = p;
+                return true;
+            }
+        }
+
+        // Uniformly sample a direction from the fluorescent event.
+        wo = UniformSampleSphere(rng.RandomFloat(), rng.RandomFloat());
+
+        // Get the new interaction point
+        p = ray(tDist);
+    }
+
+    // If the photon exists the volume area, return false
+    return false;
+}
+
+
+void MCFEE::HeroEmissionPath(const Scene *scene, RNG &rng,
+                             const Point &hitPoint) {
+
+    // Volume region
+    VolumeRegion *vr = scene->volumeRegion;
+
+    // The emitted photon carries the hero and companion wavelengths through
+    // the emission band of the medium
+    HeroWavelengths wavelengths(rng.RandomFloat(), nWavelengths, true);
+    const int wl = wavelengths.Hero();
+
+    // Photon positions
+    Point p = hitPoint, pPrev;
+
+    // Photon direction
+    Vector wo;
+
+    while(vr->WorldBound().Inside(p)) {
+        // Uniformly sample a direction from the fluorescent event.
+        wo = UniformSampleSphere(rng.RandomFloat(), rng.RandomFloat());
+
+        // Build a new ray along the new direction.
+        Ray ray(p, wo, 0, INFINITY);
+
+        // Save the old point.
+        pPrev = p;
+
+        // Get the emission optical properties of the tissue at the hero
+        // wavelength
+        float scatteringCoff = vr->Sigma_sf(p, wo, 0.0, wl);
+        float attenuationCoeff = vr->Sigma_tf(p, wo, 0.0, wl);
+
+        float distancePdf, tDist;
+        if (scatteringCoff > rng.RandomFloat() * attenuationCoeff) {
+            // Sample a distance along the volume
+            if (!vr->SampleDistance_f(ray, &tDist, p, &distancePdf, rng, wl))
+                break;
+        } else {
+            // Photon absorption
+            break;
+        }
+        wavelengths.Survive(vr, pPrev, wo, 0.0);
+
+        for (uint64_t i= 0; i < scene->sensors.size(); i++) {
+            float tHit;
+            if (scene->sensors[i]->Hit(ray, &tHit, tDist)) {
+                HeroWavelengths hit = wavelengths;
+                hit.Transmit(vr, Ray(pPrev, ray(tHit) - pPrev, 0.f, 1.f),
+                             stepSize, rng.RandomFloat());
+                scene->sensors[i]->RecordHit(ray(tHit), hit);
+                break;
+            }
+        }
+
+        // Get the new interaction point
+        p = ray(tDist);
+        if (!vr->WorldBound().Inside(p))
+            break;
+        wavelengths.Transmit(vr, Ray(pPrev, p - pPrev, 0.f, 1.f), stepSize,
+                             rng.RandomFloat());
+        wavelengths.Collide(vr, p, wo, 0.0);
+    }
+}
+
+
+void MCFEE::TracePhoton(const Scene *scene, RNG &rng) {
+    // If the excitation path excites a bead in the scene
+    Point hitPoint;
+    if (heroWavelength) {
+        if (HeroExcitationPath(scene, scene->lights[0], rng, hitPoint))
+            HeroEmissionPath(scene, rng, hitPoint);
+    }
+    else if (ExcitationPath(scene, scene->lights[0], rng, hitPoint)) {
+        // Activate the emission path
+        EmissionPath(scene, rng, hitPoint);
+    }
+}
+
 
 /**
  * @brief MCFEE::Preprocess
@@ -192,7 +348,6 @@ void MCFEE::EmissionPath(const Scene *scene, RNG &rng, const Point &hitPoint) {
  */
 void MCFEE::Preprocess(const Scene *scene, const Camera *, const Renderer *) {
 
-    RNG rng;
     printf("Number of photons use in the simulation [%zu] \n", numberPhotons);
 
     // If no volume, terminate.
@@ -214,29 +369,10 @@ void MCFEE::Preprocess(const Scene *scene, const Camera *, const Renderer *) {
         exit(EXIT_SUCCESS);
     }
 
-    // This is to double check until further notice ...
-    size_t progress = 0;
-    #pragma omp parallel for
-    for (uint64_t i = 0; i < numberPhotons; i++) {
-        // OMP
-        #pragma omp atomic
-        ++progress;
-
-        // Update progress
-        if( omp_get_thread_num() == 0 ) {
-            double percentage = 100.0 * progress / numberPhotons;
-            printf("\r * Running Simulation [%2.2f %%]", percentage);
-            fflush(stdout);
-        }
-
-        // If the excitation path excites a bead in the scene
-        Point hitPoint;
-        if (ExcitationPath(scene, scene->lights[0], rng, hitPoint)) {
-            // Activate the emission path
-            EmissionPath(scene, rng, hitPoint);
-        }
-    }
-    printf("\n");
+    MCFEEPhotonTracer tracer(this, scene);
+    SensorCheckpointState state(scene->sensors);
+    TracePhotons(&tracer, numberPhotons, "Running Simulation", 0, &state,
+                 true);
 
     uint64 totalHits = 0;
     for (uint64 i = 0; i < scene->sensors.size(); i++) {
@@ -267,5 +403,7 @@ Spectrum MCFEE::Li(const Scene *scene, const Renderer *renderer,
 
 MCFEE *CreateMCFEE(const ParamSet &params) {
     uint64_t numberPhotons = params.FindOneInt("numberphotons", 10000);
-    return new MCFEE(numberPhotons);
+    bool heroWavelength = params.FindOneBool("herowavelength", false);
+    int nWavelengths = params.FindOneInt("wavelengths", nHeroWavelengths);
+    return new MCFEE(numberPhotons, heroWavelength, nWavelengths);
 }
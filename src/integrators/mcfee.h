@@ -40,6 +40,7 @@
 // integrators/mcfee.h*
 #include "volume.h"
 #include "integrator.h"
+#include "herowavelength.h"
 #include "shapes/bead.h"
 #include <vsd/vsdsprite.h>
 #include <vector>
@@ -51,16 +52,23 @@
 class MCFEE : public VolumeIntegrator {
 public:
     // MCFEE Public Methods
-    MCFEE(const uint64_t numPhotons) {
+    MCFEE(const uint64_t numPhotons, bool hero = false,
+          int nwavelengths = nHeroWavelengths) {
         numberPhotons = numPhotons;
         stepSize = 0.1f;
         photonState = EXCITATION;
+        heroWavelength = hero;
+        nWavelengths = nwavelengths;
     }
     void Preprocess(const Scene *, const Camera *, const Renderer *);
+    void TracePhoton(const Scene *scene, RNG &rng);
     void RunSimulationWithSingleBead(const Scene *scene, Bead *bead);
     void RunSimulationWithMultipleBeads(const Scene *scene);
     bool ExcitationPath(const Scene *scene, Light *fiber, RNG &rng, Point &hitPoint);
     void EmissionPath(const Scene *scene, RNG &rng, const Point &hitPoint);
+    bool HeroExcitationPath(const Scene *scene, Light *fiber, RNG &rng,
+        Point &hitPoint);
+    void HeroEmissionPath(const Scene *scene, RNG &rng, const Point &hitPoint);
 
 
     void PhotonPacketRandomWalk(const Scene *scene, FluorescentEvent &event, RNG& rng);
@@ -84,6 +92,8 @@ private:
     float stepSize;
     PHOTON_STATE photonState; // Photon state
     uint64_t numberPhotons; // Number of photons from the fiber
+    bool heroWavelength; // Transport a few wavelengths with scalar weights
+    int nWavelengths; // Number of wavelengths carried by an emitted photon
 };
 
 MCFEE* CreateMCFEE(const ParamSet &params);
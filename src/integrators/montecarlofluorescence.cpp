@@ -40,11 +40,27 @@
 #include <sstream>
 #include <iostream>
 #include <fstream>
-#include <omp.h>
+#include "photontracer.h"
+#include "checkpoint.h"
 #include <inttypes.h>
 #include <cstdio>
 #include <cinttypes>
- 
+
+
+// MonteCarloFluorescencePhotonTracer Declarations
+class MonteCarloFluorescencePhotonTracer : public PhotonTracer {
+public:
+    MonteCarloFluorescencePhotonTracer(MonteCarloFluorescenceIntegrator *i,
+                                       const Scene *s)
+        : integrator(i), scene(s) { }
+    void Trace(uint64_t photon, RNG &rng) {
+        integrator->TracePhoton(scene, rng);
+    }
+private:
+    MonteCarloFluorescenceIntegrator *integrator;
+    const Scene *scene;
+};
+
 
 // MonteCarloFluorescenceIntegrator Method Definitions
 void MonteCarloFluorescenceIntegrator::RequestSamples(Sampler *sampler, Sample *sample,
@@ -72,108 +88,183 @@ Spectrum MonteCarloFluorescenceIntegrator::Transmittance(const Scene *scene,
 }
 
 
-void MonteCarloFluorescenceIntegrator::Preprocess(const Scene *scene, const Camera *camera,
-                               const Renderer *renderer) {
+void MonteCarloFluorescenceIntegrator::HeroRandomWalk(const Scene *scene,
+        Sensor *sensor, Sensor *interface, RNG &rng) {
+    VolumeRegion *vr = scene->volumeRegion;
 
-    RNG rng;
-    printf("Number of photons use in the simulation [%zu] \n", numberPhotons);
+    // The photon carries the hero and companion wavelengths
+    HeroWavelengths wavelengths(rng.RandomFloat(), nWavelengths);
+    const int wl = wavelengths.Hero();
 
-    // This random walk assumes the generation of a photon from an emitter
-    // within the volume. The photon will be scattered or absorbed randomly
-    // based on the optical properties of the medium.
+    // The photon will move between p and pPrev in the direction wo.
+    Point p = beadPosition, pPrev;
+    Vector wo = UniformSampleSphere(rng.RandomFloat(), rng.RandomFloat());
 
-    // If no volume, terminate.
+    while(vr->WorldBound().Inside(p)) {
+
+        // Build a new ray along the new direction.
+        Ray ray(p, wo, 0, INFINITY);
+
+        // Save the old point.
+        pPrev = p;
+
+        // Get the optical properties of the tissue at the hero wavelength
+        float scatteringCoff = vr->Sigma_s(p, wo, 0.0, wl);
+        float attenuationCoeff = vr->Sigma_t(p, wo, 0.0, wl);
+
+        float distancePdf, tDist;
+        if (scatteringCoff > rng.RandomFloat() * attenuationCoeff) {
+            // Sample a distance along the volume
+            if (!vr->SampleDistance(ray, &tDist, p, &distancePdf, rng, wl))
+                break;
+        } else {
+            // Photon absorption
+            break;
+        }
+        wavelengths.Survive(vr, pPrev, wo, 0.0);
+
+        // If the sensor hits the interface
+        float tHitInterface;
+        if (interface->Hit(ray, &tHitInterface, tDist)) {
+            HeroWavelengths hit = wavelengths;
+            hit.Transmit(vr, Ray(pPrev, ray(tHitInterface) - pPrev, 0.f, 1.f),
+                         stepSize, rng.RandomFloat());
+            interface->RecordHitAndAngles(ray(tHitInterface), hit, ray);
+
+            // If the ray is refracted, check if it hits the sensor
+            Ray refractedRay;
+            if(interface->ComputeRefractedRay(ray, tHitInterface, refractedRay)) {
+                float tHitSensor;
+                if (sensor->Intersect(refractedRay, &tHitSensor))
+                    sensor->RecordHitAndAngles(refractedRay(tHitSensor), hit,
+                                               refractedRay);
+            }
+            break;
+        }
+
+        // Get the new interaction point
+        p = ray(tDist);
+        if (!vr->WorldBound().Inside(p))
+            break;
+        wavelengths.Transmit(vr, Ray(pPrev, p - pPrev, 0.f, 1.f), stepSize,
+                             rng.RandomFloat());
+        wavelengths.Collide(vr, p, wo, 0.0);
+
+        // Get the new direction based on the HG phase function
+        float directionPdf;
+        vr->SampleDirection(p, ray.d, wo, &directionPdf, rng);
+    }
+}
+
+
+void MonteCarloFluorescenceIntegrator::TracePhoton(const Scene *scene,
+                                                   RNG &rng) {
     VolumeRegion *vr = scene->volumeRegion;
-    if (!vr) return;
 
-    // Get a reference to the sensor,
+    // Get a reference to the sensor and the interface
     Sensor* sensor = scene->sensors[0];
-
-    // Get a reference to the interface
     Sensor* interface = scene->sensors[1];
 
-    // This is to double check until further notice ...
-    size_t progress = 0;
-    #pragma omp parallel for
-    for (uint64_t i = 0; i < numberPhotons; i++) {
-        #pragma omp atomic
-        ++progress;
-
-        if( omp_get_thread_num() == 0 ) {
-            double percentage = 100.0 * progress / numberPhotons;
-            printf("\r * Running Simulation [%2.2f %%]", percentage);
-            fflush(stdout);
-        }
+    if (heroWavelength) {
+        HeroRandomWalk(scene, sensor, interface, rng);
+        return;
+    }
 
-        // The photon will move between p and pPrev in the direction wo.
-        Point p, pPrev;
+    // The photon will move between p and pPrev in the direction wo.
+    Point p, pPrev;
 
-        // Initially, sample w0 uniformly
-        Vector wo = UniformSampleSphere(rng.RandomFloat(), rng.RandomFloat());
+    // Initially, sample w0 uniformly
+    Vector wo = UniformSampleSphere(rng.RandomFloat(), rng.RandomFloat());
 
-        // Initially, p is the origin of the photon.
-        p = beadPosition;
+    // Initially, p is the origin of the photon.
+    p = beadPosition;
 
-        int bounce = 0;
-        while(vr->WorldBound().Inside(p)) {
+    int bounce = 0;
+    MediumProperties mp;
+    while(vr->Lookup(p, &mp)) {
 
-            // Build a new ray along the new direction.
-            Ray ray(p, wo, 0, INFINITY);
+        // Build a new ray along the new direction.
+        Ray ray(p, wo, 0, INFINITY);
 
-            // Save the old point.
-            pPrev = p;
+        // Save the old point.
+        pPrev = p;
 
-            // Get the optical properties of the tissue
-            float scatteringCoff = vr->Sigma_s(p, wo, 0.0).y();
-            float attenuationCoeff = vr->Sigma_t(p, wo, 0.0).y();
-            float scatteringProb = scatteringCoff / attenuationCoeff;
+        // Get the optical properties of the tissue
+        float scatteringCoff = mp.sigma_s.y();
+        float attenuationCoeff = mp.sigma_t.y();
+        float scatteringProb = scatteringCoff / attenuationCoeff;
 
-            float distancePdf, tDist;
-            if (scatteringProb > rng.RandomFloat()) {
-                // Sample a distance along the volume
-                vr->SampleDistance(ray, &tDist, p, &distancePdf, rng);
-            } else {
-                // Photon absorption
-                break;
-            }
+        float distancePdf, tDist;
+        if (scatteringProb > rng.RandomFloat()) {
+            // Sample a distance along the volume
+            vr->SampleDistance(ray, &tDist, p, &distancePdf, rng);
+        } else {
+            // Photon absorption
+            break;
+        }
 
-            // If the sensor hits the interface
-            float tHitInterface;
-            if (interface->Hit(ray, &tHitInterface, tDist)) {
-                 interface->RecordHitAndAngles(ray(tHitInterface), Spectrum(1.0), ray);
-                /// Find the refracted ray
-                Ray refractedRay;
-
-                // If the ray is refracted
-                if(interface->ComputeRefractedRay(ray, tHitInterface, refractedRay)) {
-                    // Hits the sensor
-                    float tHitSensor;
-                    if (sensor->Intersect(refractedRay, &tHitSensor)){
-                        sensor->RecordHitAndAngles(refractedRay(tHitSensor), Spectrum(1.0), refractedRay);
-                    }
-
-                    // Escaped
-                    break;
+        // If the sensor hits the interface
+        float tHitInterface;
+        if (interface->Hit(ray, &tHitInterface, tDist)) {
+             interface->RecordHitAndAngles(ray(tHitInterface), Spectrum(1.0), ray);
+            /// Find the refracted ray
+            Ray refractedRay;
+
+            // If the ray is refracted
+            if(interface->ComputeRefractedRay(ray, tHitInterface, refractedRay)) {
+                // Hits the sensor
+                float tHitSensor;
+                if (sensor->Intersect(refractedRay, &tHitSensor)){
+                    sensor->RecordHitAndAngles(refractedRay(tHitSensor), Spectrum(1.0), refractedRay);
                 }
 
-                // Otherwise reflected, we don't consider the reflected rays.
+                // Escaped
                 break;
             }
 
+            // Otherwise reflected, we don't consider the reflected rays.
+            break;
+        }
+
 //            float tHit;
 //            if (sensor->Hit(ray, &tHit, tDist)) {
 //                sensor->RecordHit(ray(tHit), Spectrum(1.0));
 //                break;
 //            }
 
-            // Get the new interaction point
-            p = ray(tDist);
+        // Get the new interaction point
+        p = ray(tDist);
 
-            // Get the new direction based on the HG phase function
-            float directionPdf;
-            vr->SampleDirection(p, ray.d, wo, &directionPdf, rng);
-        }
+        // Get the new direction based on the HG phase function
+        float directionPdf;
+        vr->SampleDirection(p, ray.d, wo, &directionPdf, rng);
+    }
+}
+
+
+void MonteCarloFluorescenceIntegrator::Preprocess(const Scene *scene, const Camera *camera,
+                               const Renderer *renderer) {
+
+    printf("Number of photons use in the simulation [%zu] \n", numberPhotons);
+
+    // This random walk assumes the generation of a photon from an emitter
+    // within the volume. The photon will be scattered or absorbed randomly
+    // based on the optical properties of the medium.
+
+    // If no volume, terminate.
+    VolumeRegion *vr = scene->volumeRegion;
+    if (!vr) return;
+
+    // The photons are recorded by a sensor behind an interface
+    if (scene->sensors.size() < 2) {
+        Error("The integrator needs a sensor and an interface");
+        return;
     }
+
+    MonteCarloFluorescencePhotonTracer tracer(this, scene);
+    SensorCheckpointState state(scene->sensors);
+    TracePhotons(&tracer, numberPhotons, "Running Simulation", 0, &state,
+                 true);
     printf("\n");
 
     uint64_t totalHits = 0;
@@ -204,5 +295,8 @@ Spectrum MonteCarloFluorescenceIntegrator::Li(const Scene *scene, const Renderer
 MonteCarloFluorescenceIntegrator *CreateMonteCarloFluorescenceIntegrator(const ParamSet &params) {
     Point beadPosition = params.FindOnePoint("beadposition", Point());
     uint64_t numberPhotons = params.FindOneInt("numberphotons", 10000);
-    return new MonteCarloFluorescenceIntegrator(beadPosition, numberPhotons);
+    bool heroWavelength = params.FindOneBool("herowavelength", false);
+    int nWavelengths = params.FindOneInt("wavelengths", nHeroWavelengths);
+    return new MonteCarloFluorescenceIntegrator(beadPosition, numberPhotons,
+                                                heroWavelength, nWavelengths);
 }
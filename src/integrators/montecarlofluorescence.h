@@ -40,6 +40,7 @@
 // integrators/montecarlofluorescence.h*
 #include "volume.h"
 #include "integrator.h"
+#include "herowavelength.h"
 #include <vsd/vsdsprite.h>
 #include <vector>
 #include <iostream>
@@ -49,12 +50,19 @@ class MonteCarloFluorescenceIntegrator : public VolumeIntegrator {
 public:
     // MonteCarloFluorescenceIntegrator Public Methods
     MonteCarloFluorescenceIntegrator(const Point &beadPos,
-                                     const uint64_t numPhotons) {
+                                     const uint64_t numPhotons,
+                                     bool hero = false,
+                                     int nwavelengths = nHeroWavelengths) {
         beadPosition = beadPos;
         numberPhotons = numPhotons;
         stepSize = 0.1;
+        heroWavelength = hero;
+        nWavelengths = nwavelengths;
     }
     void Preprocess(const Scene *, const Camera *, const Renderer *);
+    void TracePhoton(const Scene *scene, RNG &rng);
+    void HeroRandomWalk(const Scene *scene, Sensor *sensor, Sensor *interface,
+        RNG &rng);
     void PhotonPacketRandomWalk(const Scene *scene, FluorescentEvent &event, RNG& rng);
     void PhotonRandomWalk(const Scene *scene, FluorescentEvent &event, RNG& rng);
     Spectrum Transmittance(const Scene *, const Renderer *,
@@ -71,6 +79,8 @@ private:
 
     Point beadPosition; // Bead position in XYZ
     uint64_t numberPhotons; // Number of photons launched from the bead
+    bool heroWavelength; // Transport a few wavelengths with scalar weights
+    int nWavelengths; // Number of wavelengths carried by a photon
 };
 
 MonteCarloFluorescenceIntegrator*
@@ -37,6 +37,22 @@
 #include "scene.h"
 #include "paramset.h"
 #include "montecarlo.h"
+#include "photontracer.h"
+#include "checkpoint.h"
+
+// SensorPhotonTracer Declarations
+class SensorPhotonTracer : public PhotonTracer {
+public:
+    SensorPhotonTracer(SensorIntegrator *i, const Scene *s)
+        : integrator(i), scene(s) { }
+    void Trace(uint64_t photon, RNG &rng) {
+        integrator->TracePhoton(scene, rng);
+    }
+private:
+    SensorIntegrator *integrator;
+    const Scene *scene;
+};
+
 
 // SensorIntegrator Method Definitions
 void SensorIntegrator::RequestSamples(Sampler *sampler, Sample *sample,
@@ -104,7 +120,9 @@ void SensorIntegrator::PhotonRandomWalk(const Scene *scene, Photon& photon,
 
     // To keep track on the photon bounces in the volume.
     int bounce = 0;
-    while(vr->WorldBound().Inside(p)) {
+    MediumProperties mp;
+    if (!vr->WorldBound().Inside(p)) return;
+    for (;;) {
 
         // Uniformly sample a direction from the fluorescent event.
         wo = UniformSampleSphere(rng.RandomFloat(), rng.RandomFloat());
@@ -124,13 +142,9 @@ void SensorIntegrator::PhotonRandomWalk(const Scene *scene, Photon& photon,
         }
 
         // Check for photon escaping the volume
-        for (uint64_t sensorId = 0; sensorId < scene->sensors.size(); sensorId++) {
-            Sensor* sensor = scene->sensors[sensorId];
-            float tHit;
-            if (sensor->Hit(ray, &tHit, tDist)) {
-                sensor->RecordHit(ray(tHit), Spectrum(1.0));
-                break;
-            }
+        float tHit;
+        if (Sensor *sensor = scene->HitSensor(ray, tDist, &tHit)) {
+            sensor->RecordHit(ray(tHit), Spectrum(1.0));
         }
 
         // Get the new interaction point
@@ -138,9 +152,9 @@ void SensorIntegrator::PhotonRandomWalk(const Scene *scene, Photon& photon,
 
         // Find the optical properties at the new interaction point to decide if
         // it is a scattering event or an absorbtion.
-        const Spectrum sigma_a = vr->Sigma_a(p, Vector(0, 0, 0), 0);
-        const Spectrum sigma_t = vr->Sigma_t(p, Vector(0, 0, 0), 0);
-        const float absorbtivity = (sigma_a.y() / sigma_t.y());
+        if (!vr->Lookup(p, &mp))
+            break;
+        const float absorbtivity = (mp.sigma_a.y() / mp.sigma_t.y());
         if (absorbtivity > rng.RandomFloat())
             break;
         bounce++;
@@ -148,6 +162,70 @@ void SensorIntegrator::PhotonRandomWalk(const Scene *scene, Photon& photon,
 }
 
 
+void SensorIntegrator::HeroRandomWalk(const Scene *scene, Photon& photon,
+                                      RNG& rng) {
+
+    // Same walk as PhotonRandomWalk, but all the sampling is done at a
+    // single hero wavelength and the photon carries scalar weights for the
+    // hero and its companion wavelengths instead of a full spectrum.
+    VolumeRegion *vr = scene->volumeRegion;
+    if (!vr) return;
+
+    HeroWavelengths wavelengths(rng.RandomFloat(), nWavelengths);
+    wavelengths.Scale(photon.L);
+    const int wl = wavelengths.Hero();
+
+    Point p, pPrev;
+    Vector wo;
+    p = photon.ray.o;
+
+    while(vr->WorldBound().Inside(p)) {
+
+        // Uniformly sample a direction from the fluorescent event.
+        wo = UniformSampleSphere(rng.RandomFloat(), rng.RandomFloat());
+
+        // Build a new ray along the new direction.
+        Ray ray(p, wo, 0, INFINITY);
+
+        // Save the old point.
+        pPrev = p;
+
+        // Sample a distance along the volume at the hero wavelength
+        float distancePdf;
+        float tDist;
+        if(!vr->SampleDistance(ray, &tDist, p, &distancePdf, rng, wl)) {
+            Warning("Distance sampling error");
+            return;
+        }
+
+        // Check for photon escaping the volume
+        float tHit;
+        if (Sensor *sensor = scene->HitSensor(ray, tDist, &tHit)) {
+            HeroWavelengths hit = wavelengths;
+            hit.Transmit(vr, Ray(pPrev, ray(tHit) - pPrev, 0.f, 1.f),
+                         stepSize, rng.RandomFloat());
+            sensor->RecordHit(ray(tHit), hit);
+        }
+
+        // Get the new interaction point
+        p = ray(tDist);
+        if (!vr->WorldBound().Inside(p))
+            break;
+        wavelengths.Transmit(vr, Ray(pPrev, p - pPrev, 0.f, 1.f), stepSize,
+                             rng.RandomFloat());
+
+        // Absorption is decided at the hero wavelength only
+        const float sigma_a = vr->Sigma_a(p, Vector(0, 0, 0), 0, wl);
+        const float sigma_t = vr->Sigma_t(p, Vector(0, 0, 0), 0, wl);
+        if (sigma_a > rng.RandomFloat() * sigma_t)
+            break;
+        wavelengths.Scatter(vr, p, wo, 0);
+        if (wavelengths.IsBlack())
+            break;
+    }
+}
+
+
 void SensorIntegrator::VolumeRandomWalk(const Scene *scene,
                                         Photon& photon, RNG& rng) {
     // After sampling a photon from the light source, do a Monte Carlo
@@ -162,7 +240,9 @@ void SensorIntegrator::VolumeRandomWalk(const Scene *scene,
     p = photon.ray.o;
 
     int bounce = 0;
-    while(vr->WorldBound().Inside(p)) {
+    MediumProperties mp;
+    if (!vr->WorldBound().Inside(p)) return;
+    for (;;) {
 
         // Find a new direction
         float directionPdf;
@@ -183,13 +263,9 @@ void SensorIntegrator::VolumeRandomWalk(const Scene *scene,
         }
 
         // Check for photon escaping the volume
-        for (uint64_t sensorId = 0; sensorId < scene->sensors.size(); sensorId++) {
-            Sensor* sensor = scene->sensors[sensorId];
-            float tHit;
-            if (sensor->Hit(ray, &tHit, tDist)) {
-                sensor->RecordHit(ray(tHit), Tr * photon.L);
-                break;
-            }
+        float tHit;
+        if (Sensor *sensor = scene->HitSensor(ray, tDist, &tHit)) {
+            sensor->RecordHit(ray(tHit), Tr * photon.L);
         }
 
         p = ray(tDist);
@@ -211,9 +287,9 @@ void SensorIntegrator::VolumeRandomWalk(const Scene *scene,
         // Check if the next event is scattering or not !
         // Find the optical properties at the new interaction point to decide if
         // it is a scattering event or an absorbtion.
-        const Spectrum sigma_a = vr->Sigma_a(p, Vector(0, 0, 0), 0);
-        const Spectrum sigma_t = vr->Sigma_t(p, Vector(0, 0, 0), 0);
-        const float absorbtivity = (sigma_a.y() / sigma_t.y());
+        if (!vr->Lookup(p, &mp))
+            break;
+        const float absorbtivity = (mp.sigma_a.y() / mp.sigma_t.y());
         if (absorbtivity > rng.RandomFloat())
             break;
         bounce++;
@@ -221,6 +297,20 @@ void SensorIntegrator::VolumeRandomWalk(const Scene *scene,
 }
 
 
+void SensorIntegrator::TracePhoton(const Scene *scene, RNG &rng) {
+    Photon photon;
+    Normal normal;
+    if (!SamplePhoton(scene, rng, photon, &normal))
+        return;
+
+    // Do a random walk in the volume.
+    if (heroWavelength)
+        HeroRandomWalk(scene, photon, rng);
+    else
+        PhotonRandomWalk(scene, photon, rng);
+}
+
+
 void SensorIntegrator::Preprocess(const Scene *scene, const Camera *camera,
                                const Renderer *renderer) {
 
@@ -233,26 +323,9 @@ void SensorIntegrator::Preprocess(const Scene *scene, const Camera *camera,
     printf("The volume region has the size [%.1f x %.1f x %.1f] \n",
            sx, sy, sz);
 
-    RNG rng;
-    // #pragma omp parallel for
-    for (uint64_t iphoton = 0; iphoton < photonCount; iphoton++) {
-
-        // Compute the percentage of the photons being sent to the propagate in
-        // the volume
-        const double percentage = (double(iphoton) / double(photonCount)) * 100;
-        fprintf(stderr,"\r%f", percentage);
-
-        Photon photon;
-        Normal normal;
-        if (!SamplePhoton(scene, rng, photon, &normal)) {
-            continue;
-        }
-
-        // Do a random walk in the volume.
-        // VolumeRandomWalk(scene, photon, rng);
-
-         PhotonRandomWalk(scene, photon, rng);
-    }
+    SensorPhotonTracer tracer(this, scene);
+    SensorCheckpointState state(scene->sensors);
+    TracePhotons(&tracer, photonCount, "Tracing photons", 0, &state, true);
 
     printf("\nResults \n");
     uint64_t totalHits = 0;
@@ -352,7 +425,10 @@ Spectrum SensorIntegrator::Li(const Scene *scene, const Renderer *renderer,
 SensorIntegrator *CreateSensorIntegrator(const ParamSet &params) {
     float stepSize  = params.FindOneFloat("stepsize", 1.f);
     int photonCount = params.FindOneInt("photoncount", 1000);
-    return new SensorIntegrator(stepSize, uint64_t(photonCount));
+    bool heroWavelength = params.FindOneBool("herowavelength", false);
+    int nWavelengths = params.FindOneInt("wavelengths", nHeroWavelengths);
+    return new SensorIntegrator(stepSize, uint64_t(photonCount),
+                                heroWavelength, nWavelengths);
 }
 
 
@@ -39,6 +39,7 @@
 // integrators/sensor.h*
 #include "volume.h"
 #include "integrator.h"
+#include "herowavelength.h"
 
 struct Photon {
     Spectrum L;
@@ -49,13 +50,18 @@ struct Photon {
 class SensorIntegrator : public VolumeIntegrator {
 public:
     // SensorIntegrator Public Methods
-    SensorIntegrator(float ss, uint64_t photons) {
+    SensorIntegrator(float ss, uint64_t photons, bool hero = false,
+                     int nwavelengths = nHeroWavelengths) {
         stepSize = ss;
         photonCount = photons;
+        heroWavelength = hero;
+        nWavelengths = nwavelengths;
     }
     void Preprocess(const Scene *, const Camera *, const Renderer *);
+    void TracePhoton(const Scene *scene, RNG &rng);
     void VolumeRandomWalk(const Scene *scene, Photon& photon, RNG& rng);
     void PhotonRandomWalk(const Scene *scene, Photon& photon, RNG& rng);
+    void HeroRandomWalk(const Scene *scene, Photon& photon, RNG& rng);
     Spectrum Transmittance(const Scene *, const Renderer *,
         const RayDifferential &ray, const Sample *sample, RNG &rng,
         MemoryArena &arena) const;
@@ -69,6 +75,8 @@ private:
     // SensorIntegrator Private Data
     float stepSize;
     uint64_t photonCount;
+    bool heroWavelength; // Transport a few wavelengths with scalar weights
+    int nWavelengths; // Number of wavelengths carried by a photon
     int tauSampleOffset, scatterSampleOffset;
 };
 
@@ -128,11 +128,12 @@ void VolumeBDPTIntegrator::EyeRandomWalk(const Scene *scene, const Ray &eyeRay,
     RayDifferential ray(eyeRay);
     Point p = ray(t0), pPrev;
     uint64_t bounces = 0;
-    while(vr->WorldBound().Inside(p)) {
+    MediumProperties mp;
+    while(vr->Lookup(p, &mp)) {
         Vector wi = -ray.d;
-        const Spectrum sigma_a = vr->Sigma_a(p, wi, eyeRay.time);
-        const Spectrum sigma_s = vr->Sigma_s(p, wi, eyeRay.time);
-        const Spectrum STER = vr->STER(p, wi, eyeRay.time);
+        const Spectrum &sigma_a = mp.sigma_a;
+        const Spectrum &sigma_s = mp.sigma_s;
+        const Spectrum &STER = mp.albedo;
         // Construct and add the _eyeVertex_ to the _vertexList_
         VolumeVertex eyeVertex(p, wi, sigma_a, sigma_s, cummulative, 1.0);
         vertexList.push_back(eyeVertex);
@@ -230,12 +231,13 @@ void VolumeBDPTIntegrator::LightRandomWalk(const Scene *scene,
     // Find the intersection point between the sampled light ray and the volume
     Point p = ray(t0), pPrev;
     uint64_t bounces = 0;
-    while(vr->WorldBound().Inside(p)) {
+    MediumProperties mp;
+    while(vr->Lookup(p, &mp)) {
         // Construct and add the _eyeVertex_ to the _vertexList_
         Vector wi = -ray.d;
-        const Spectrum simga_a = vr->Sigma_a(p, wi, ray.time);
-        const Spectrum sigma_s = vr->Sigma_s(p, wi, ray.time);
-        const Spectrum STER = vr->STER(p, wi, ray.time);
+        const Spectrum &simga_a = mp.sigma_a;
+        const Spectrum &sigma_s = mp.sigma_s;
+        const Spectrum &STER = mp.albedo;
         VolumeVertex vertex(p, wi, simga_a, sigma_s, cummulative, 1.0);
         vertexList.push_back(vertex);
 
@@ -40,6 +40,21 @@
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include "photontracer.h"
+
+// VSDForwardScatteringPhotonTracer Declarations
+class VSDForwardScatteringPhotonTracer : public PhotonTracer {
+public:
+    VSDForwardScatteringPhotonTracer(VSDForwardScatteringIntegrator *i,
+                                     const Scene *s)
+        : integrator(i), scene(s) { }
+    void Trace(uint64_t event, RNG &rng) {
+        integrator->TraceEvent(scene, event);
+    }
+private:
+    VSDForwardScatteringIntegrator *integrator;
+    const Scene *scene;
+};
 
 // VSDForwardScatteringIntegrator Method Definitions
 void VSDForwardScatteringIntegrator::RequestSamples(Sampler *sampler, Sample *sample,
@@ -67,24 +82,25 @@ Spectrum VSDForwardScatteringIntegrator::Transmittance(const Scene *scene,
 }
 
 
+void VSDForwardScatteringIntegrator::TraceEvent(const Scene *scene,
+                                                uint64_t event) {
+    // Initiate the ray from the event towards the sensor
+    Point p = sprite.GetEventPosition(event);
+    Ray ray(p, Vector(0, 1, 0), 0.f, INFINITY, 0.f, 0.f);
+
+    // Check for photon intersection with the sensor
+    float tHit;
+    if (scene->sensors[0]->Intersect(ray, &tHit)) {
+        scene->sensors[0]->RecordHit(ray(tHit), 1.0);
+    }
+}
+
+
 void VSDForwardScatteringIntegrator::Preprocess(const Scene *scene, const Camera *camera,
                                const Renderer *renderer) {
-    const uint64_t numberVSDEvents = sprite.GetNumberEvents();
-    for (uint64_t i = 0; i < numberVSDEvents; i++) {
-        const double percentage =
-                (double(i) / double(numberVSDEvents)) * 100;
-        fprintf(stderr,"\r %f ", percentage);
-
-        // Initiate the ray from the event towards the sensor
-        Point p = sprite.GetEventPosition(i);
-        Ray ray(p, Vector(0, 1, 0), 0.f, INFINITY, 0.f, 0.f);
-
-        // Check for photon intersection with the sensor
-        float tHit;
-        if (scene->sensors[0]->Intersect(ray, &tHit)) {
-            scene->sensors[0]->RecordHit(ray(tHit), 1.0);
-        }
-    }
+    VSDForwardScatteringPhotonTracer tracer(this, scene);
+    TracePhotons(&tracer, sprite.GetNumberEvents(), "Projecting events", 0,
+                 NULL, true);
 
     uint64_t totalHits = 0;
     for (uint64_t isensor = 0; isensor < scene->sensors.size(); isensor++) {
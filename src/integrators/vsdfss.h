@@ -56,6 +56,7 @@ public:
         stepSize = 0.1;
     }
     void Preprocess(const Scene *, const Camera *, const Renderer *);
+    void TraceEvent(const Scene *scene, uint64_t event);
     void PhotonPacketRandomWalk(const Scene *scene, FluorescentEvent &event, RNG& rng);
     void PhotonRandomWalk(const Scene *scene, FluorescentEvent &event, RNG& rng);
     Spectrum Transmittance(const Scene *, const Renderer *,
@@ -40,6 +40,20 @@
 #include <sstream>
 #include <iostream>
 #include <fstream>
+#include "photontracer.h"
+
+// VSDLinearSpritePhotonTracer Declarations
+class VSDLinearSpritePhotonTracer : public PhotonTracer {
+public:
+    VSDLinearSpritePhotonTracer(VSDLinearSpriteIntegrator *i, const Scene *s)
+        : integrator(i), scene(s) { }
+    void Trace(uint64_t event, RNG &rng) {
+        integrator->TraceEvent(scene, event, rng);
+    }
+private:
+    VSDLinearSpriteIntegrator *integrator;
+    const Scene *scene;
+};
 
 // VSDLinearSpriteIntegrator Method Definitions
 void VSDLinearSpriteIntegrator::RequestSamples(Sampler *sampler, Sample *sample,
@@ -107,13 +121,9 @@ void VSDLinearSpriteIntegrator::PhotonRandomWalk(const Scene *scene, Fluorescent
         }
 
         // Check for photon escaping the volume
-        for (uint64_t sensorId = 0; sensorId < scene->sensors.size(); sensorId++) {
-            Sensor* sensor = scene->sensors[sensorId];
-            float tHit;
-            if (sensor->Hit(ray, &tHit, tDist)) {
-                sensor->RecordHit(ray(tHit), Spectrum(1.0));
-                break;
-            }
+        float tHit;
+        if (Sensor *sensor = scene->HitSensor(ray, tDist, &tHit)) {
+            sensor->RecordHit(ray(tHit), Spectrum(1.0));
         }
 
         // Get the new interaction point
@@ -166,13 +176,9 @@ void VSDLinearSpriteIntegrator::PhotonPacketRandomWalk(const Scene *scene,
         }
 
         // Check for photon escaping the volume
-        for (uint64_t sensorId = 0; sensorId < scene->sensors.size(); sensorId++) {
-            Sensor* sensor = scene->sensors[sensorId];
-            float tHit;
-            if (sensor->Hit(ray, &tHit, tDist)) {
-                sensor->RecordHit(ray(tHit), Tr * event.L);
-                break;
-            }
+        float tHit;
+        if (Sensor *sensor = scene->HitSensor(ray, tDist, &tHit)) {
+            sensor->RecordHit(ray(tHit), Tr * event.L);
         }
 
         p = ray(tDist);
@@ -204,35 +210,77 @@ void VSDLinearSpriteIntegrator::PhotonPacketRandomWalk(const Scene *scene,
 }
 
 
-void VSDLinearSpriteIntegrator::Preprocess(const Scene *scene, const Camera *camera,
-                               const Renderer *renderer) {
+// Transmittance of the emission band along _segment_, averaged over the
+// wavelengths of the spectral range, which is what the hero wavelengths
+// estimate
+static float EmissionTransmittance(const VolumeRegion *vr,
+        const Ray &segment, float step, float offset) {
+    float tr = 0.f;
+    for (int wl = sampledLambdaStart; wl < sampledLambdaEnd; ++wl)
+        tr += expf(-vr->tauLambda_f(segment, step, offset, wl));
+    return tr / float(sampledLambdaEnd - sampledLambdaStart);
+}
 
-    // Get the size of the volume region
-    /*
-    VolumeRegion *vr = scene->volumeRegion;
-    if (!vr) return;
-    const float sx = vr->WorldBound().pMax.x - vr->WorldBound().pMin.x;
-    const float sy = vr->WorldBound().pMax.y - vr->WorldBound().pMin.y;
-    const float sz = vr->WorldBound().pMax.z - vr->WorldBound().pMin.z;
-    printf("The volume region has the size [%.1f x %.1f x %.1f] \n",
-           sx, sy, sz);
-    */
 
-    const uint64_t numberEvents = sprite.GetNumberEvents();
-    for (uint64_t i = 0; i < numberEvents; i++) {
-        const double percentage =
-                (double(i) / double(numberEvents)) * 100;
-        fprintf(stderr,"\r %f ", percentage);
+void VSDLinearSpriteIntegrator::TraceEvent(const Scene *scene, uint64_t event,
+                                           RNG &rng) {
+    VolumeRegion *vr = scene->volumeRegion;
 
-        // Initiate the ray from the event towards the sensor
-        Point p = sprite.GetEventPosition(i);
-        Ray ray(p, Vector(0, 1, 0), 0.f, INFINITY, 0.f, 0.f);
+    // Initiate the ray from the event towards the sensors
+    Point p = sprite.GetEventPosition(event);
+    Ray ray(p, Vector(0, 1, 0), 0.f, INFINITY, 0.f, 0.f);
 
-        // Check for photon intersection with the sensor
+    // The fluorescence is attenuated in the emission band on its way to
+    // every sensor it hits
+    for (uint32_t isensor = 0; isensor < scene->sensors.size(); isensor++) {
+        Sensor *sensor = scene->sensors[isensor];
         float tHit;
-        if (scene->sensors[0]->Intersect(ray, &tHit)) {
-            scene->sensors[0]->RecordHit(ray(tHit), 1.0);//sprite.GetEventIntensity(i));
+        if (!sensor->Intersect(ray, &tHit))
+            continue;
+        const Ray segment(p, ray(tHit) - p, 0.f, 1.f);
+        if (heroWavelength) {
+            // Attenuate the sampled wavelengths along the path to the
+            // sensor instead of carrying a full spectrum
+            HeroWavelengths wavelengths(rng.RandomFloat(), nWavelengths,
+                                        true);
+            if (vr)
+                wavelengths.Attenuate(vr, segment, stepSize,
+                                      rng.RandomFloat());
+            sensor->RecordHit(ray(tHit), wavelengths);
+        }
+        else {
+            const float Tr = vr ? EmissionTransmittance(vr, segment,
+                                      stepSize, rng.RandomFloat()) : 1.f;
+            sensor->RecordHit(ray(tHit), Spectrum(Tr));
+        }
+    }
+}
+
+
+void VSDLinearSpriteIntegrator::RenderFrame(const Scene *scene,
+        const std::string &pshfile, const std::string &frame) {
+    // Swap the emitters only; the volume, the sensors and the accelerators
+    // stay resident from one frame to the next
+    sprite.Read(dataDirectory, pshfile, false, shift);
+    for (uint64_t isensor = 0; isensor < scene->sensors.size(); isensor++) {
+        Sensor *sensor = scene->sensors[isensor];
+        if (!frame.empty()) {
+            sensor->Reset();
+            sensor->SetOutputName(sensor->ReferenceString() + "_" + frame);
         }
+        else if (!psfs.empty())
+            sensor->Reset();
+    }
+
+    if (!psfs.empty()) {
+        // The convolution gives the expected film of each sensor
+        for (uint64_t isensor = 0; isensor < scene->sensors.size(); isensor++)
+            psfs[isensor]->Render(sprite, scene->sensors[isensor]);
+    }
+    else {
+        VSDLinearSpritePhotonTracer tracer(this, scene);
+        TracePhotons(&tracer, sprite.GetNumberEvents(), "Projecting events",
+                     0, NULL, true);
     }
 
     uint64_t totalHits = 0;
@@ -247,6 +295,56 @@ void VSDLinearSpriteIntegrator::Preprocess(const Scene *scene, const Camera *cam
     }
 
     printf("Total hists %zu \n", totalHits);
+}
+
+
+void VSDLinearSpriteIntegrator::Preprocess(const Scene *scene, const Camera *camera,
+                               const Renderer *renderer) {
+
+    // Get the size of the volume region
+    /*
+    VolumeRegion *vr = scene->volumeRegion;
+    if (!vr) return;
+    const float sx = vr->WorldBound().pMax.x - vr->WorldBound().pMin.x;
+    const float sy = vr->WorldBound().pMax.y - vr->WorldBound().pMin.y;
+    const float sz = vr->WorldBound().pMax.z - vr->WorldBound().pMin.z;
+    printf("The volume region has the size [%.1f x %.1f x %.1f] \n",
+           sx, sy, sz);
+    */
+
+    const std::vector<std::string> frames =
+        ExpandSpriteSequence(dataDirectory, pshFiles);
+    if (frames.empty())
+        Severe("No sprites to render in \"%s\"", dataDirectory.c_str());
+
+    // The point-spread functions only depend on the tissue and the sensors,
+    // so all the frames share them; each sensor has its own, cached in a
+    // file of its own when there are several
+    if (psfPhotons > 0) {
+        if (scene->sensors.empty())
+            Severe("The point-spread function needs a sensor");
+        for (uint64_t isensor = 0; isensor < scene->sensors.size(); isensor++) {
+            Sensor *sensor = scene->sensors[isensor];
+            std::string cache = psfFile;
+            if (!cache.empty() && scene->sensors.size() > 1)
+                cache += "." + sensor->ReferenceString();
+            psfs.push_back(new VSDPointSpreadFunction(psfDepths, psfRadius,
+                                                      psfPhotons));
+            psfs.back()->Prepare(cache, scene, sensor);
+        }
+    }
+
+    // Name the outputs of a time series after the sprite of each frame
+    for (size_t i = 0; i < frames.size(); i++) {
+        std::string frame;
+        if (frames.size() > 1) {
+            frame = frames[i].substr(frames[i].find_last_of('/') + 1);
+            frame = frame.substr(0, frame.find_last_of('.'));
+            printf("Frame %zu/%zu [%s] \n", i + 1, frames.size(),
+                   frame.c_str());
+        }
+        RenderFrame(scene, frames[i], frame);
+    }
     exit(EXIT_SUCCESS);
 }
 
@@ -262,10 +360,33 @@ Spectrum VSDLinearSpriteIntegrator::Li(const Scene *scene, const Renderer *rende
 VSDLinearSpriteIntegrator *CreateVSDLinearSpriteIntegrator(const ParamSet &params) {
     const std::string vsdDataDirectory =
             params.FindOneString("vsddatadirectory", "");
-    const std::string pshFileName = params.FindOneString("pshfile", "");
+    // Either a single sprite, or a time series given as a list of sprites
+    // and/or wildcard patterns, e.g. "string pshfile" [ "*.psh" ]
+    int nPshFiles = 0;
+    const std::string *pshFileNames = params.FindString("pshfile", &nPshFiles);
+    std::vector<std::string> pshFiles;
+    for (int i = 0; i < nPshFiles; i++)
+        pshFiles.push_back(pshFileNames[i]);
     Vector shift;
     shift.x = params.FindOneFloat("xshift", 0);
     shift.y = params.FindOneFloat("yshift", 0);
     shift.z = params.FindOneFloat("zshift", 0);
-    return new VSDLinearSpriteIntegrator(vsdDataDirectory, pshFileName, shift);
+    bool heroWavelength = params.FindOneBool("herowavelength", false);
+    int nWavelengths = params.FindOneInt("wavelengths", nHeroWavelengths);
+    VSDLinearSpriteIntegrator *integrator =
+        new VSDLinearSpriteIntegrator(vsdDataDirectory, pshFiles, shift,
+                                      heroWavelength, nWavelengths);
+
+    // "photons" traces every event, "psf" convolves the events with a
+    // depth-binned point-spread function estimated once
+    const std::string mode = params.FindOneString("mode", "photons");
+    if (mode == "psf")
+        integrator->UsePointSpreadFunction(
+            params.FindOneString("psffile", "psf.bin"),
+            max(params.FindOneInt("psfdepths", 32), 1),
+            max(params.FindOneInt("psfradius", 32), 0),
+            max(params.FindOneInt("psfphotons", 1000000), 1));
+    else if (mode != "photons")
+        Warning("Unknown mode \"%s\", tracing photons", mode.c_str());
+    return integrator;
 }
@@ -39,7 +39,9 @@
 // integrators/vsdlinearspriteh*
 #include "volume.h"
 #include "integrator.h"
+#include "herowavelength.h"
 #include <vsd/vsdsprite.h>
+#include <vsd/vsdpsf.h>
 #include <vector>
 #include <iostream>
 
@@ -47,13 +49,39 @@
 class VSDLinearSpriteIntegrator : public VolumeIntegrator {
 public:
     // VSDLinearSpriteIntegrator Public Methods
+    // A single sprite is rendered as before; several sprites render a time
+    // series, with one set of sensor outputs per sprite
     VSDLinearSpriteIntegrator(const std::string datadirectory,
-                              const std::string pshfile,
-                              const Vector &shift) {
-        sprite.Read(datadirectory, pshfile, false, shift);
+                              const std::vector<std::string> &pshfiles,
+                              const Vector &shift, bool hero = false,
+                              int nwavelengths = nHeroWavelengths) {
+        dataDirectory = datadirectory;
+        pshFiles = pshfiles;
+        this->shift = shift;
         stepSize = 0.1;
+        heroWavelength = hero;
+        nWavelengths = nwavelengths;
+        psfDepths = psfRadius = 0;
+        psfPhotons = 0;
+    }
+    ~VSDLinearSpriteIntegrator() {
+        for (uint32_t i = 0; i < psfs.size(); i++)
+            delete psfs[i];
+    }
+    // Render the sprites by convolution with a point-spread function per
+    // sensor, estimated once or read from _psffile_, instead of tracing
+    // photons
+    void UsePointSpreadFunction(const std::string &psffile, int nDepths,
+                                int radius, uint64_t nPhotons) {
+        psfFile = psffile;
+        psfDepths = nDepths;
+        psfRadius = radius;
+        psfPhotons = nPhotons;
     }
     void Preprocess(const Scene *, const Camera *, const Renderer *);
+    void TraceEvent(const Scene *scene, uint64_t event, RNG &rng);
+    void RenderFrame(const Scene *scene, const std::string &pshfile,
+                     const std::string &frame);
     void PhotonPacketRandomWalk(const Scene *scene, FluorescentEvent &event, RNG& rng);
     void PhotonRandomWalk(const Scene *scene, FluorescentEvent &event, RNG& rng);
     Spectrum Transmittance(const Scene *, const Renderer *,
@@ -68,7 +96,15 @@ private:
     int tauSampleOffset, scatterSampleOffset;
     float stepSize;
     VSDSprite sprite;
+    std::string dataDirectory;
+    std::vector<std::string> pshFiles;
     Vector shift;
+    bool heroWavelength; // Attenuate a few wavelengths with scalar weights
+    int nWavelengths; // Number of wavelengths carried by a photon
+    std::vector<VSDPointSpreadFunction *> psfs; // Replace the photons
+    std::string psfFile; // Cache of the point-spread functions
+    uint32_t psfDepths, psfRadius;
+    uint64_t psfPhotons; // No point-spread functions if 0
 };
 
 VSDLinearSpriteIntegrator *CreateVSDLinearSpriteIntegrator(const ParamSet &params);
@@ -37,6 +37,15 @@
 #include "parser.h"
 #include "parallel.h"
 
+static void PrintUsage(FILE *f) {
+    fprintf(f, "usage: pbrt [--ncores n] [--outfile filename] [--quick] [--quiet] "
+            "[--verbose] [--spectralrange start end] [--spectralsamples n] "
+            "[--checkpoint filename] [--checkpointinterval seconds] "
+            "[--resume] [--shard i/N] [--help] "
+            "<filename.pbrt> ...\n");
+}
+
+
 // main program
 int main(int argc, char *argv[]) {
     Options options;
@@ -48,13 +57,56 @@ int main(int argc, char *argv[]) {
         else if (!strcmp(argv[i], "--quick")) options.quickRender = true;
         else if (!strcmp(argv[i], "--quiet")) options.quiet = true;
         else if (!strcmp(argv[i], "--verbose")) options.verbose = true;
+        else if (!strcmp(argv[i], "--spectralrange")) {
+            if (i + 2 >= argc) {
+                fprintf(stderr, "--spectralrange expects start and end "
+                        "wavelengths\n");
+                return 1;
+            }
+            options.lambdaStart = atoi(argv[++i]);
+            options.lambdaEnd = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--spectralsamples")) {
+            if (i + 1 == argc) {
+                fprintf(stderr, "--spectralsamples expects a number of "
+                        "samples\n");
+                return 1;
+            }
+            options.spectralSamples = atoi(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--checkpoint")) {
+            if (i + 1 == argc) {
+                PrintUsage(stderr);
+                return 1;
+            }
+            options.checkpointFile = argv[++i];
+        }
+        else if (!strcmp(argv[i], "--checkpointinterval")) {
+            if (i + 1 == argc) {
+                PrintUsage(stderr);
+                return 1;
+            }
+            options.checkpointInterval = atof(argv[++i]);
+        }
+        else if (!strcmp(argv[i], "--resume")) options.resume = true;
+        else if (!strcmp(argv[i], "--shard")) {
+            if (i + 1 == argc ||
+                sscanf(argv[++i], "%d/%d", &options.shardIndex,
+                       &options.nShards) != 2 ||
+                options.nShards < 1 || options.shardIndex < 0 ||
+                options.shardIndex >= options.nShards) {
+                fprintf(stderr, "--shard expects i/N with 0 <= i < N\n");
+                return 1;
+            }
+        }
         else if (!strcmp(argv[i], "--help") || !strcmp(argv[i], "-h")) {
-            printf("usage: pbrt [--ncores n] [--outfile filename] [--quick] [--quiet] "
-                   "[--verbose] [--help] <filename.pbrt> ...\n");
+            PrintUsage(stdout);
             return 0;
         }
         else filenames.push_back(argv[i]);
     }
+    if (options.resume && options.checkpointFile.empty())
+        options.checkpointFile = "pbrt.checkpoint";
 
     // Print welcome banner
     if (!options.quiet) {
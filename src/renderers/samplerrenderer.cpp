@@ -41,6 +41,8 @@
 #include "progressreporter.h"
 #include "camera.h"
 #include "intersection.h"
+#include "checkpoint.h"
+#include "shard.h"
 
 using namespace std;
 
@@ -82,6 +84,10 @@ void SamplerRendererTask::Run() {
     Spectrum *Ts = new Spectrum[maxSamples];
     Intersection *isects = new Intersection[maxSamples];
 
+    // Accumulate image samples into a tile private to this task
+    FilmTile *filmTile = camera->film->GetFilmTile(sampler->xPixelStart,
+        sampler->xPixelEnd+1, sampler->yPixelStart, sampler->yPixelEnd+1);
+
     // Get samples from _Sampler_ and update image
     int sampleCount;
     while ((sampleCount = sampler->GetMoreSamples(samples, rng)) > 0) {
@@ -144,7 +150,10 @@ void SamplerRendererTask::Run() {
             for (int i = 0; i < sampleCount; ++i)
             {
                 PBRT_STARTED_ADDING_IMAGE_SAMPLE(&samples[i], &rays[i], &Ls[i], &Ts[i]);
-                camera->film->AddSample(samples[i], Ls[i]);
+                if (filmTile)
+                    filmTile->AddSample(samples[i], Ls[i]);
+                else
+                    camera->film->AddSample(samples[i], Ls[i]);
                 PBRT_FINISHED_ADDING_IMAGE_SAMPLE();
             }
         }
@@ -154,6 +163,8 @@ void SamplerRendererTask::Run() {
     }
 
     // Clean up after _SamplerRendererTask_ is done with its image region
+    if (filmTile)
+        camera->film->MergeFilmTile(filmTile);
     camera->film->UpdateDisplay(sampler->xPixelStart,
         sampler->yPixelStart, sampler->xPixelEnd+1, sampler->yPixelEnd+1);
     delete sampler;
@@ -206,15 +217,22 @@ void SamplerRenderer::Render(const Scene *scene) {
     int nPixels = camera->film->xResolution * camera->film->yResolution;
     int nTasks = max(32 * NumSystemCores(), nPixels / (16*16));
     nTasks = RoundUpPow2(nTasks);
-    ProgressReporter reporter(nTasks, "Rendering");
+    // Sharded renders take a contiguous range of the tasks, i.e. of the
+    // image tiles
+    uint64_t firstTask, endTask;
+    ShardRange(nTasks, &firstTask, &endTask);
+    ProgressReporter reporter(int(endTask - firstTask), "Rendering");
     vector<Task *> renderTasks;
-    for (int i = 0; i < nTasks; ++i)
+    for (int i = int(firstTask); i < int(endTask); ++i)
         renderTasks.push_back(new SamplerRendererTask(scene, this, camera,
                                                       reporter, sampler, sample, 
                                                       visualizeObjectIds, 
                                                       nTasks-1-i, nTasks));
-    EnqueueTasks(renderTasks);
-    WaitForAllTasks();
+    // Every task seeds its RNG with its number, the film state is enough to
+    // skip the tasks finished before an interruption
+    FilmCheckpointState state(camera->film);
+    RunTasksWithCheckpoints(renderTasks, "Rendering",
+        uint64_t(nPixels) * sampler->samplesPerPixel, &state, reporter);
     for (uint32_t i = 0; i < renderTasks.size(); ++i)
         delete renderTasks[i];
     reporter.Done();
@@ -52,6 +52,8 @@ public:
     float Area() const;
     Point Sample(float u1, float u2, Normal *Ns) const;
     bool Projects(const Point &p, Point &ps, Normal &ns) const;
+    float InnerRadius() const { return innerRadius; }
+    float PhiMax() const { return phiMax; }
 private:
     // Disk Private Data
     float height, radius, innerRadius, phiMax;
@@ -0,0 +1,459 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+
+// shapes/plymesh.cpp*
+#include "stdafx.h"
+#include "shapes/plymesh.h"
+#include "paramset.h"
+#include "fileutil.h"
+#include "textures/constant.h"
+#include <climits>
+#include <sstream>
+
+// PLYMesh Local Declarations
+enum PLYType {
+    PLY_NONE, PLY_INT8, PLY_UINT8, PLY_INT16, PLY_UINT16, PLY_INT32,
+    PLY_UINT32, PLY_FLOAT32, PLY_FLOAT64
+};
+
+
+static const uint32_t plyTypeSize[] = { 0, 1, 1, 2, 2, 4, 4, 4, 8 };
+
+
+struct PLYProperty {
+    string name;
+    PLYType type;       // Type of the value, or of the list entries
+    PLYType countType;  // Type of the list length, _PLY_NONE_ if not a list
+};
+
+
+struct PLYElement {
+    string name;
+    uint64_t count;
+    vector<PLYProperty> properties;
+};
+
+
+struct PLYFile {
+    PLYFile() : file(NULL), data(NULL), size(0), vertices(NULL),
+        nVertices(0), vertexSize(0), faces(NULL), nFaces(0), nTriangles(0),
+        faceIndices(-1) {
+        for (int c = 0; c < 3; ++c) {
+            pOffset[c] = nOffset[c] = 0;
+            pType[c] = nType[c] = PLY_NONE;
+        }
+        uvOffset[0] = uvOffset[1] = 0;
+        uvType[0] = uvType[1] = PLY_NONE;
+    }
+    ~PLYFile() { delete file; }
+    bool Open(const string &filename);
+    bool ParseHeader(const string &filename);
+
+    // The mapped file
+    MappedFile *file;
+    const uint8_t *data;
+    uint64_t size;
+
+    // Vertex element, fixed size records of _vertexSize_ bytes
+    const uint8_t *vertices;
+    uint64_t nVertices;
+    uint32_t vertexSize;
+    uint32_t pOffset[3], nOffset[3], uvOffset[2];
+    PLYType pType[3], nType[3], uvType[2];
+
+    // Face element, _faceIndices_ is the list of vertex indices
+    const uint8_t *faces;
+    uint64_t nFaces, nTriangles;
+    PLYElement faceElement;
+    int faceIndices;
+};
+
+
+static PLYType PLYTypeFromName(const string &name) {
+    if (name == "char"   || name == "int8")    return PLY_INT8;
+    if (name == "uchar"  || name == "uint8")   return PLY_UINT8;
+    if (name == "short"  || name == "int16")   return PLY_INT16;
+    if (name == "ushort" || name == "uint16")  return PLY_UINT16;
+    if (name == "int"    || name == "int32")   return PLY_INT32;
+    if (name == "uint"   || name == "uint32")  return PLY_UINT32;
+    if (name == "float"  || name == "float32") return PLY_FLOAT32;
+    if (name == "double" || name == "float64") return PLY_FLOAT64;
+    return PLY_NONE;
+}
+
+
+static inline double ReadPLYValue(const uint8_t *ptr, PLYType type) {
+    // The records are packed, values are read with _memcpy()_ since they
+    // are not aligned
+    switch (type) {
+    case PLY_INT8:    return *(const int8_t *)ptr;
+    case PLY_UINT8:   return *ptr;
+    case PLY_INT16:   { int16_t v;  memcpy(&v, ptr, 2); return v; }
+    case PLY_UINT16:  { uint16_t v; memcpy(&v, ptr, 2); return v; }
+    case PLY_INT32:   { int32_t v;  memcpy(&v, ptr, 4); return v; }
+    case PLY_UINT32:  { uint32_t v; memcpy(&v, ptr, 4); return v; }
+    case PLY_FLOAT32: { float v;    memcpy(&v, ptr, 4); return v; }
+    case PLY_FLOAT64: { double v;   memcpy(&v, ptr, 8); return v; }
+    default:          return 0.;
+    }
+}
+
+
+static inline int64_t ReadPLYInteger(const uint8_t *ptr, PLYType type) {
+    switch (type) {
+    case PLY_INT8:    return *(const int8_t *)ptr;
+    case PLY_UINT8:   return *ptr;
+    case PLY_INT16:   { int16_t v;  memcpy(&v, ptr, 2); return v; }
+    case PLY_UINT16:  { uint16_t v; memcpy(&v, ptr, 2); return v; }
+    case PLY_INT32:   { int32_t v;  memcpy(&v, ptr, 4); return v; }
+    case PLY_UINT32:  { uint32_t v; memcpy(&v, ptr, 4); return v; }
+    default:          return int64_t(ReadPLYValue(ptr, type));
+    }
+}
+
+
+// Returns the end of the record of _element_ at _ptr_, or NULL if the file
+// ends before; the entries of the list property _listProp_ are returned in
+// _list_ and _count_
+static inline const uint8_t *ReadPLYRecord(const PLYElement &element,
+        int listProp, const uint8_t *ptr, const uint8_t *end,
+        const uint8_t **list = NULL, int64_t *count = NULL) {
+    for (uint32_t i = 0; i < element.properties.size(); ++i) {
+        const PLYProperty &prop = element.properties[i];
+        if (prop.countType == PLY_NONE) {
+            ptr += plyTypeSize[prop.type];
+            continue;
+        }
+        if (ptr + plyTypeSize[prop.countType] > end) return NULL;
+        const int64_t n = ReadPLYInteger(ptr, prop.countType);
+        if (n < 0) return NULL;
+        ptr += plyTypeSize[prop.countType];
+        if (int(i) == listProp) {
+            *list = ptr;
+            *count = n;
+        }
+        ptr += n * plyTypeSize[prop.type];
+    }
+    return ptr <= end ? ptr : NULL;
+}
+
+
+// PLYMesh Method Definitions
+bool PLYFile::Open(const string &filename) {
+    file = MappedFile::Open(filename);
+    if (!file) {
+        Error("Cannot open the PLY file \"%s\"", filename.c_str());
+        return false;
+    }
+    data = (const uint8_t *)file->Data();
+    size = file->Size();
+    return true;
+}
+
+
+bool PLYFile::ParseHeader(const string &filename) {
+    const char *name = filename.c_str();
+    // Find the end of the ASCII header
+    const char *text = (const char *)data;
+    const char endHeader[] = "end_header";
+    const char *headerEnd = NULL;
+    for (uint64_t i = 0; i + sizeof(endHeader) <= size; ++i)
+        if (text[i] == 'e' && !memcmp(text + i, endHeader, sizeof(endHeader) - 1) &&
+            (i == 0 || text[i-1] == '\n')) {
+            headerEnd = text + i + sizeof(endHeader) - 1;
+            break;
+        }
+    if (size < 4 || memcmp(text, "ply", 3) != 0 || !headerEnd) {
+        Error("\"%s\" is not a PLY file", name);
+        return false;
+    }
+    while (headerEnd < text + size && *headerEnd != '\n') ++headerEnd;
+    if (headerEnd == text + size) {
+        Error("PLY file \"%s\" is truncated", name);
+        return false;
+    }
+
+    // Read the elements and their properties
+    vector<PLYElement> elements;
+    std::istringstream header(string(text, headerEnd));
+    string line;
+    bool binaryLittleEndian = false;
+    while (std::getline(header, line)) {
+        std::istringstream words(line);
+        string keyword;
+        words >> keyword;
+        if (keyword == "format") {
+            string format;
+            words >> format;
+            binaryLittleEndian = format == "binary_little_endian";
+        }
+        else if (keyword == "element") {
+            PLYElement element;
+            words >> element.name >> element.count;
+            elements.push_back(element);
+        }
+        else if (keyword == "property" && elements.size()) {
+            PLYProperty prop;
+            string type;
+            words >> type;
+            prop.countType = PLY_NONE;
+            if (type == "list") {
+                string countType;
+                words >> countType >> type;
+                prop.countType = PLYTypeFromName(countType);
+            }
+            prop.type = PLYTypeFromName(type);
+            words >> prop.name;
+            if (prop.type == PLY_NONE || (type == "list" &&
+                                          prop.countType == PLY_NONE)) {
+                Error("Unknown property type in \"%s\" of PLY file \"%s\"",
+                      line.c_str(), name);
+                return false;
+            }
+            elements.back().properties.push_back(prop);
+        }
+    }
+    const uint16_t one = 1;
+    if (!binaryLittleEndian || *(const uint8_t *)&one != 1) {
+        Error("PLY file \"%s\" is not binary little-endian; convert it "
+              "with ply2pbrt", name);
+        return false;
+    }
+
+    // Locate the vertex and face records, the other elements are skipped
+    const uint8_t *ptr = (const uint8_t *)headerEnd + 1;
+    const uint8_t *end = data + size;
+    vertices = faces = NULL;
+    int64_t maxIndex = -1;
+    for (uint32_t e = 0; e < elements.size(); ++e) {
+        const PLYElement &element = elements[e];
+        if (element.name == "vertex") {
+            vertices = ptr;
+            nVertices = element.count;
+            vertexSize = 0;
+            int pFound = 0, nFound = 0, uvFound = 0;
+            const char *axes[3][3] = { { "x", "nx", "u" },
+                                       { "y", "ny", "v" },
+                                       { "z", "nz", NULL } };
+            const char *texAxes[2][2] = { { "s", "texture_u" },
+                                          { "t", "texture_v" } };
+            for (uint32_t i = 0; i < element.properties.size(); ++i) {
+                const PLYProperty &prop = element.properties[i];
+                if (prop.countType != PLY_NONE) {
+                    Error("List property \"%s\" of the vertices in PLY file "
+                          "\"%s\" is not supported", prop.name.c_str(), name);
+                    return false;
+                }
+                for (int c = 0; c < 3; ++c) {
+                    if (prop.name == axes[c][0]) {
+                        pOffset[c] = vertexSize; pType[c] = prop.type;
+                        pFound |= 1 << c;
+                    }
+                    else if (prop.name == axes[c][1]) {
+                        nOffset[c] = vertexSize; nType[c] = prop.type;
+                        nFound |= 1 << c;
+                    }
+                    else if (c < 2 && (prop.name == axes[c][2] ||
+                                       prop.name == texAxes[c][0] ||
+                                       prop.name == texAxes[c][1])) {
+                        uvOffset[c] = vertexSize; uvType[c] = prop.type;
+                        uvFound |= 1 << c;
+                    }
+                }
+                vertexSize += plyTypeSize[prop.type];
+            }
+            if (pFound != 7) {
+                Error("PLY file \"%s\" has no vertex positions", name);
+                return false;
+            }
+            if (nFound != 7) nType[0] = PLY_NONE;
+            if (uvFound != 3) uvType[0] = PLY_NONE;
+            if (nVertices > uint64_t(end - ptr) / max(vertexSize, 1u)) {
+                Error("PLY file \"%s\" is truncated", name);
+                return false;
+            }
+            ptr += nVertices * vertexSize;
+        }
+        else if (element.name == "face") {
+            faces = ptr;
+            nFaces = element.count;
+            faceElement = element;
+            faceIndices = -1;
+            for (uint32_t i = 0; i < element.properties.size(); ++i)
+                if (element.properties[i].countType != PLY_NONE &&
+                    (element.properties[i].name == "vertex_indices" ||
+                     element.properties[i].name == "vertex_index"))
+                    faceIndices = i;
+            if (faceIndices < 0) {
+                Error("PLY file \"%s\" has no face vertex indices", name);
+                return false;
+            }
+            // Count the triangles of the faces, which are split in fans,
+            // and check the records once before the mesh is filled. The
+            // largest index is checked after the loop, since the vertex
+            // element may come after the faces
+            const PLYType indexType =
+                element.properties[faceIndices].type;
+            nTriangles = 0;
+            for (uint64_t f = 0; f < nFaces; ++f) {
+                const uint8_t *indices = NULL;
+                int64_t count = 0;
+                ptr = ReadPLYRecord(element, faceIndices, ptr, end,
+                                    &indices, &count);
+                if (!ptr) {
+                    Error("PLY file \"%s\" is truncated", name);
+                    return false;
+                }
+                for (int64_t i = 0; i < count; ++i) {
+                    const int64_t index = ReadPLYInteger(
+                        indices + i * plyTypeSize[indexType], indexType);
+                    if (index < 0 || index > maxIndex) {
+                        if (index < 0) {
+                            Error("PLY file \"%s\" has out of-bounds vertex "
+                                  "index %lld", name, (long long)index);
+                            return false;
+                        }
+                        maxIndex = index;
+                    }
+                }
+                if (count >= 3) nTriangles += count - 2;
+            }
+        }
+        else {
+            for (uint64_t i = 0; i < element.count && ptr; ++i)
+                ptr = ReadPLYRecord(element, -1, ptr, end);
+            if (!ptr) {
+                Error("PLY file \"%s\" is truncated", name);
+                return false;
+            }
+        }
+        if (vertices && faces) break;
+    }
+    if (!vertices || !faces) {
+        Error("PLY file \"%s\" has no %s", name, vertices ? "faces" :
+              "vertices");
+        return false;
+    }
+    if (maxIndex >= 0 && uint64_t(maxIndex) >= nVertices) {
+        Error("PLY file \"%s\" has out of-bounds vertex index %lld", name,
+              (long long)maxIndex);
+        return false;
+    }
+    if (nVertices > uint64_t(INT_MAX) || 3 * nTriangles > uint64_t(INT_MAX)) {
+        Error("PLY file \"%s\" is too large for a triangle mesh", name);
+        return false;
+    }
+    return true;
+}
+
+
+PLYMesh::PLYMesh(const Transform *o2w, const Transform *w2o, bool ro,
+        const PLYFile &ply, const Reference<Texture<float> > &atex)
+    : TriangleMesh(o2w, w2o, ro, int(ply.nTriangles), int(ply.nVertices),
+                   ply.nType[0] != PLY_NONE, ply.uvType[0] != PLY_NONE, atex) {
+    // Decode the vertices, transformed to world space
+    const uint8_t *vertex = ply.vertices;
+    for (int i = 0; i < nverts; ++i, vertex += ply.vertexSize) {
+        Point P(ReadPLYValue(vertex + ply.pOffset[0], ply.pType[0]),
+                ReadPLYValue(vertex + ply.pOffset[1], ply.pType[1]),
+                ReadPLYValue(vertex + ply.pOffset[2], ply.pType[2]));
+        p[i] = (*ObjectToWorld)(P);
+        if (n)
+            n[i] = Normal(ReadPLYValue(vertex + ply.nOffset[0], ply.nType[0]),
+                          ReadPLYValue(vertex + ply.nOffset[1], ply.nType[1]),
+                          ReadPLYValue(vertex + ply.nOffset[2], ply.nType[2]));
+        if (uvs) {
+            uvs[2*i]   = ReadPLYValue(vertex + ply.uvOffset[0], ply.uvType[0]);
+            uvs[2*i+1] = ReadPLYValue(vertex + ply.uvOffset[1], ply.uvType[1]);
+        }
+    }
+
+    // Split the faces in triangle fans, the records were checked by
+    // _PLYFile::ParseHeader()_
+    const PLYType indexType =
+        ply.faceElement.properties[ply.faceIndices].type;
+    const uint32_t indexSize = plyTypeSize[indexType];
+    const uint8_t *face = ply.faces, *end = ply.data + ply.size;
+    int *vi = vertexIndex;
+    for (uint64_t f = 0; f < ply.nFaces; ++f) {
+        const uint8_t *indices = NULL;
+        int64_t count = 0;
+        face = ReadPLYRecord(ply.faceElement, ply.faceIndices, face, end,
+                             &indices, &count);
+        if (count < 3) continue;
+        const int first = int(ReadPLYInteger(indices, indexType));
+        int previous = int(ReadPLYInteger(indices + indexSize, indexType));
+        for (int64_t i = 2; i < count; ++i) {
+            const int next = int(ReadPLYInteger(indices + i * indexSize,
+                                                indexType));
+            *vi++ = first;
+            *vi++ = previous;
+            *vi++ = next;
+            previous = next;
+        }
+    }
+    Assert(vi == vertexIndex + 3 * ntris);
+}
+
+
+TriangleMesh *CreatePLYMeshShape(const Transform *o2w, const Transform *w2o,
+        bool reverseOrientation, const ParamSet &params,
+        map<string, Reference<Texture<float> > > *floatTextures) {
+    string filename = params.FindOneFilename("filename", "");
+    if (filename == "") {
+        Error("No \"filename\" given for the \"plymesh\" shape");
+        return NULL;
+    }
+    PLYFile ply;
+    if (!ply.Open(filename) || !ply.ParseHeader(filename))
+        return NULL;
+    if (ply.nTriangles == 0) {
+        Warning("PLY file \"%s\" has no triangles", filename.c_str());
+        return NULL;
+    }
+
+    Reference<Texture<float> > alphaTex = NULL;
+    string alphaTexName = params.FindTexture("alpha");
+    if (alphaTexName != "") {
+        if (floatTextures->find(alphaTexName) != floatTextures->end())
+            alphaTex = (*floatTextures)[alphaTexName];
+        else
+            Error("Couldn't find float texture \"%s\" for \"alpha\" parameter",
+                  alphaTexName.c_str());
+    }
+    else if (params.FindOneFloat("alpha", 1.f) == 0.f)
+        alphaTex = new ConstantTexture<float>(0.f);
+    PLYMesh *mesh = new PLYMesh(o2w, w2o, reverseOrientation, ply, alphaTex);
+    Info("Read %d vertices and %d triangles from PLY file \"%s\"",
+         int(ply.nVertices), int(ply.nTriangles), filename.c_str());
+    return mesh;
+}
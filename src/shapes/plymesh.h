@@ -0,0 +1,59 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#ifndef PBRT_SHAPES_PLYMESH_H
+#define PBRT_SHAPES_PLYMESH_H
+
+// shapes/plymesh.h*
+#include "shapes/trianglemesh.h"
+struct PLYFile;
+
+// PLYMesh Declarations
+// A triangle mesh read from a binary little-endian PLY file; the vertices,
+// normals, uvs and faces are decoded from the mapped file directly into
+// the buffers of the mesh
+class PLYMesh : public TriangleMesh {
+public:
+    // PLYMesh Public Methods
+    PLYMesh(const Transform *o2w, const Transform *w2o, bool ro,
+            const PLYFile &ply, const Reference<Texture<float> > &atex);
+};
+
+
+TriangleMesh *CreatePLYMeshShape(const Transform *o2w, const Transform *w2o,
+        bool reverseOrientation, const ParamSet &params,
+        map<string, Reference<Texture<float> > > *floatTextures = NULL);
+
+#endif // PBRT_SHAPES_PLYMESH_H
@@ -72,6 +72,21 @@ TriangleMesh::TriangleMesh(const Transform *o2w, const Transform *w2o,
 }
 
 
+TriangleMesh::TriangleMesh(const Transform *o2w, const Transform *w2o,
+        bool ro, int nt, int nv, bool hasNormals, bool hasUVs,
+        const Reference<Texture<float> > &atex)
+    : Shape(o2w, w2o, ro), alphaTexture(atex) {
+    // Allocate the mesh data, filled in place by the subclass
+    ntris = nt;
+    nverts = nv;
+    vertexIndex = new int[3 * ntris];
+    p = new Point[nverts];
+    n = hasNormals ? new Normal[nverts] : NULL;
+    s = NULL;
+    uvs = hasUVs ? new float[2*nverts] : NULL;
+}
+
+
 TriangleMesh::~TriangleMesh() {
     delete[] vertexIndex;
     delete[] p;
@@ -105,6 +120,24 @@ void TriangleMesh::Refine(vector<Reference<Shape> > &refined) const {
 }
 
 
+void TriangleMesh::GetFaceUVs(int face, float uv[3][2]) const {
+    const int *v = &vertexIndex[3*face];
+    if (uvs) {
+        uv[0][0] = uvs[2*v[0]];
+        uv[0][1] = uvs[2*v[0]+1];
+        uv[1][0] = uvs[2*v[1]];
+        uv[1][1] = uvs[2*v[1]+1];
+        uv[2][0] = uvs[2*v[2]];
+        uv[2][1] = uvs[2*v[2]+1];
+    }
+    else {
+        uv[0][0] = 0.; uv[0][1] = 0.;
+        uv[1][0] = 1.; uv[1][1] = 0.;
+        uv[2][0] = 1.; uv[2][1] = 1.;
+    }
+}
+
+
 BBox Triangle::ObjectBound() const {
     // Get triangle vertices in _p1_, _p2_, and _p3_
     const Point &p1 = mesh->p[v[0]];
@@ -124,15 +157,16 @@ BBox Triangle::WorldBound() const {
 }
 
 
-bool Triangle::Intersect(const Ray &ray, float *tHit, float *rayEpsilon,
-                         DifferentialGeometry *dg) const {
-    PBRT_RAY_TRIANGLE_INTERSECTION_TEST(const_cast<Ray *>(&ray), const_cast<Triangle *>(this));
+bool TriangleMesh::IntersectFace(int face, const Ray &ray, float *tHit,
+        float *rayEpsilon, DifferentialGeometry *dg,
+        const Shape *shape) const {
     // Compute $\VEC{s}_1$
 
     // Get triangle vertices in _p1_, _p2_, and _p3_
-    const Point &p1 = mesh->p[v[0]];
-    const Point &p2 = mesh->p[v[1]];
-    const Point &p3 = mesh->p[v[2]];
+    const int *v = &vertexIndex[3*face];
+    const Point &p1 = p[v[0]];
+    const Point &p2 = p[v[1]];
+    const Point &p3 = p[v[2]];
     Vector e1 = p2 - p1;
     Vector e2 = p3 - p1;
     Vector s1 = Cross(ray.d, e2);
@@ -143,13 +177,13 @@ bool Triangle::Intersect(const Ray &ray, float *tHit, float *rayEpsilon,
     float invDivisor = 1.f / divisor;
 
     // Compute first barycentric coordinate
-    Vector s = ray.o - p1;
-    float b1 = Dot(s, s1) * invDivisor;
+    Vector d = ray.o - p1;
+    float b1 = Dot(d, s1) * invDivisor;
     if (b1 < 0. || b1 > 1.)
         return false;
 
     // Compute second barycentric coordinate
-    Vector s2 = Cross(s, e1);
+    Vector s2 = Cross(d, e1);
     float b2 = Dot(ray.d, s2) * invDivisor;
     if (b2 < 0. || b1 + b2 > 1.)
         return false;
@@ -161,14 +195,14 @@ bool Triangle::Intersect(const Ray &ray, float *tHit, float *rayEpsilon,
 
     // Compute triangle partial derivatives
     Vector dpdu, dpdv;
-    float uvs[3][2];
-    GetUVs(uvs);
+    float uv[3][2];
+    GetFaceUVs(face, uv);
 
     // Compute deltas for triangle partial derivatives
-    float du1 = uvs[0][0] - uvs[2][0];
-    float du2 = uvs[1][0] - uvs[2][0];
-    float dv1 = uvs[0][1] - uvs[2][1];
-    float dv2 = uvs[1][1] - uvs[2][1];
+    float du1 = uv[0][0] - uv[2][0];
+    float du2 = uv[1][0] - uv[2][0];
+    float dv1 = uv[0][1] - uv[2][1];
+    float dv2 = uv[1][1] - uv[2][1];
     Vector dp1 = p1 - p3, dp2 = p2 - p3;
     float determinant = du1 * dv2 - dv1 * du2;
     if (determinant == 0.f) {
@@ -183,16 +217,16 @@ bool Triangle::Intersect(const Ray &ray, float *tHit, float *rayEpsilon,
 
     // Interpolate $(u,v)$ triangle parametric coordinates
     float b0 = 1 - b1 - b2;
-    float tu = b0*uvs[0][0] + b1*uvs[1][0] + b2*uvs[2][0];
-    float tv = b0*uvs[0][1] + b1*uvs[1][1] + b2*uvs[2][1];
+    float tu = b0*uv[0][0] + b1*uv[1][0] + b2*uv[2][0];
+    float tv = b0*uv[0][1] + b1*uv[1][1] + b2*uv[2][1];
 
     // Test intersection against alpha texture, if present
     if (ray.depth != -1) {
-    if (mesh->alphaTexture) {
+    if (alphaTexture) {
         DifferentialGeometry dgLocal(ray(t), dpdu, dpdv,
                                      Normal(0,0,0), Normal(0,0,0),
-                                     tu, tv, this);
-        if (mesh->alphaTexture->Evaluate(dgLocal) == 0.f)
+                                     tu, tv, shape);
+        if (alphaTexture->Evaluate(dgLocal) == 0.f)
             return false;
     }
     }
@@ -200,7 +234,8 @@ bool Triangle::Intersect(const Ray &ray, float *tHit, float *rayEpsilon,
     // Fill in _DifferentialGeometry_ from triangle hit
     *dg = DifferentialGeometry(ray(t), dpdu, dpdv,
                                Normal(0,0,0), Normal(0,0,0),
-                               tu, tv, this);
+                               tu, tv, shape);
+    dg->faceIndex = face;
     *tHit = t;
     *rayEpsilon = 1e-3f * *tHit;
     PBRT_RAY_TRIANGLE_INTERSECTION_HIT(const_cast<Ray *>(&ray), t);
@@ -208,14 +243,22 @@ bool Triangle::Intersect(const Ray &ray, float *tHit, float *rayEpsilon,
 }
 
 
-bool Triangle::IntersectP(const Ray &ray) const {
-    PBRT_RAY_TRIANGLE_INTERSECTIONP_TEST(const_cast<Ray *>(&ray), const_cast<Triangle *>(this));
+bool Triangle::Intersect(const Ray &ray, float *tHit, float *rayEpsilon,
+                         DifferentialGeometry *dg) const {
+    PBRT_RAY_TRIANGLE_INTERSECTION_TEST(const_cast<Ray *>(&ray), const_cast<Triangle *>(this));
+    return mesh->IntersectFace(Face(), ray, tHit, rayEpsilon, dg, this);
+}
+
+
+bool TriangleMesh::IntersectPFace(int face, const Ray &ray,
+                                  const Shape *shape) const {
     // Compute $\VEC{s}_1$
 
     // Get triangle vertices in _p1_, _p2_, and _p3_
-    const Point &p1 = mesh->p[v[0]];
-    const Point &p2 = mesh->p[v[1]];
-    const Point &p3 = mesh->p[v[2]];
+    const int *v = &vertexIndex[3*face];
+    const Point &p1 = p[v[0]];
+    const Point &p2 = p[v[1]];
+    const Point &p3 = p[v[2]];
     Vector e1 = p2 - p1;
     Vector e2 = p3 - p1;
     Vector s1 = Cross(ray.d, e2);
@@ -243,17 +286,17 @@ bool Triangle::IntersectP(const Ray &ray) const {
         return false;
 
     // Test shadow ray intersection against alpha texture, if present
-    if (ray.depth != -1 && mesh->alphaTexture) {
+    if (ray.depth != -1 && alphaTexture) {
         // Compute triangle partial derivatives
         Vector dpdu, dpdv;
-        float uvs[3][2];
-        GetUVs(uvs);
+        float uv[3][2];
+        GetFaceUVs(face, uv);
 
         // Compute deltas for triangle partial derivatives
-        float du1 = uvs[0][0] - uvs[2][0];
-        float du2 = uvs[1][0] - uvs[2][0];
-        float dv1 = uvs[0][1] - uvs[2][1];
-        float dv2 = uvs[1][1] - uvs[2][1];
+        float du1 = uv[0][0] - uv[2][0];
+        float du2 = uv[1][0] - uv[2][0];
+        float dv1 = uv[0][1] - uv[2][1];
+        float dv2 = uv[1][1] - uv[2][1];
         Vector dp1 = p1 - p3, dp2 = p2 - p3;
         float determinant = du1 * dv2 - dv1 * du2;
         if (determinant == 0.f) {
@@ -268,12 +311,12 @@ bool Triangle::IntersectP(const Ray &ray) const {
 
         // Interpolate $(u,v)$ triangle parametric coordinates
         float b0 = 1 - b1 - b2;
-        float tu = b0*uvs[0][0] + b1*uvs[1][0] + b2*uvs[2][0];
-        float tv = b0*uvs[0][1] + b1*uvs[1][1] + b2*uvs[2][1];
+        float tu = b0*uv[0][0] + b1*uv[1][0] + b2*uv[2][0];
+        float tv = b0*uv[0][1] + b1*uv[1][1] + b2*uv[2][1];
         DifferentialGeometry dgLocal(ray(t), dpdu, dpdv,
                                      Normal(0,0,0), Normal(0,0,0),
-                                     tu, tv, this);
-        if (mesh->alphaTexture->Evaluate(dgLocal) == 0.f)
+                                     tu, tv, shape);
+        if (alphaTexture->Evaluate(dgLocal) == 0.f)
             return false;
     }
     PBRT_RAY_TRIANGLE_INTERSECTIONP_HIT(const_cast<Ray *>(&ray), t);
@@ -281,6 +324,12 @@ bool Triangle::IntersectP(const Ray &ray) const {
 }
 
 
+bool Triangle::IntersectP(const Ray &ray) const {
+    PBRT_RAY_TRIANGLE_INTERSECTIONP_TEST(const_cast<Ray *>(&ray), const_cast<Triangle *>(this));
+    return mesh->IntersectPFace(Face(), ray, this);
+}
+
+
 float Triangle::Area() const {
     // Get triangle vertices in _p1_, _p2_, and _p3_
     const Point &p1 = mesh->p[v[0]];
@@ -290,10 +339,10 @@ float Triangle::Area() const {
 }
 
 
-void Triangle::GetShadingGeometry(const Transform &obj2world,
-        const DifferentialGeometry &dg,
+void TriangleMesh::GetFaceShadingGeometry(int face,
+        const Transform &obj2world, const DifferentialGeometry &dg,
         DifferentialGeometry *dgShading) const {
-    if (!mesh->n && !mesh->s) {
+    if (!n && !s) {
         *dgShading = dg;
         return;
     }
@@ -303,8 +352,9 @@ void Triangle::GetShadingGeometry(const Transform &obj2world,
     float b[3];
 
     // Initialize _A_ and _C_ matrices for barycentrics
+    const int *v = &vertexIndex[3*face];
     float uv[3][2];
-    GetUVs(uv);
+    GetFaceUVs(face, uv);
     float A[2][2] =
         { { uv[1][0] - uv[0][0], uv[2][0] - uv[0][0] },
           { uv[1][1] - uv[0][1], uv[2][1] - uv[0][1] } };
@@ -319,13 +369,13 @@ void Triangle::GetShadingGeometry(const Transform &obj2world,
     // Use _n_ and _s_ to compute shading tangents for triangle, _ss_ and _ts_
     Normal ns;
     Vector ss, ts;
-    if (mesh->n) ns = Normalize(obj2world(b[0] * mesh->n[v[0]] +
-                                          b[1] * mesh->n[v[1]] +
-                                          b[2] * mesh->n[v[2]]));
+    if (n) ns = Normalize(obj2world(b[0] * n[v[0]] +
+                                    b[1] * n[v[1]] +
+                                    b[2] * n[v[2]]));
     else   ns = dg.nn;
-    if (mesh->s) ss = Normalize(obj2world(b[0] * mesh->s[v[0]] +
-                                          b[1] * mesh->s[v[1]] +
-                                          b[2] * mesh->s[v[2]]));
+    if (s) ss = Normalize(obj2world(b[0] * s[v[0]] +
+                                    b[1] * s[v[1]] +
+                                    b[2] * s[v[2]]));
     else   ss = Normalize(dg.dpdu);
     
     ts = Cross(ss, ns);
@@ -338,16 +388,14 @@ void Triangle::GetShadingGeometry(const Transform &obj2world,
     Normal dndu, dndv;
 
     // Compute $\dndu$ and $\dndv$ for triangle shading geometry
-    if (mesh->n) {
-        float uvs[3][2];
-        GetUVs(uvs);
+    if (n) {
         // Compute deltas for triangle partial derivatives of normal
-        float du1 = uvs[0][0] - uvs[2][0];
-        float du2 = uvs[1][0] - uvs[2][0];
-        float dv1 = uvs[0][1] - uvs[2][1];
-        float dv2 = uvs[1][1] - uvs[2][1];
-        Normal dn1 = mesh->n[v[0]] - mesh->n[v[2]];
-        Normal dn2 = mesh->n[v[1]] - mesh->n[v[2]];
+        float du1 = uv[0][0] - uv[2][0];
+        float du2 = uv[1][0] - uv[2][0];
+        float dv1 = uv[0][1] - uv[2][1];
+        float dv2 = uv[1][1] - uv[2][1];
+        Normal dn1 = n[v[0]] - n[v[2]];
+        Normal dn2 = n[v[1]] - n[v[2]];
         float determinant = du1 * dv2 - dv1 * du2;
         if (determinant == 0.f)
             dndu = dndv = Normal(0,0,0);
@@ -362,12 +410,20 @@ void Triangle::GetShadingGeometry(const Transform &obj2world,
     *dgShading = DifferentialGeometry(dg.p, ss, ts,
         obj2world(dndu), obj2world(dndv),
         dg.u, dg.v, dg.shape);
+    dgShading->faceIndex = dg.faceIndex;
     dgShading->dudx = dg.dudx;  dgShading->dvdx = dg.dvdx;
     dgShading->dudy = dg.dudy;  dgShading->dvdy = dg.dvdy;
     dgShading->dpdx = dg.dpdx;  dgShading->dpdy = dg.dpdy;
 }
 
 
+void Triangle::GetShadingGeometry(const Transform &obj2world,
+        const DifferentialGeometry &dg,
+        DifferentialGeometry *dgShading) const {
+    mesh->GetFaceShadingGeometry(Face(), obj2world, dg, dgShading);
+}
+
+
 TriangleMesh *CreateTriangleMeshShape(const Transform *o2w, const Transform *w2o,
         bool reverseOrientation, const ParamSet &params,
         map<string, Reference<Texture<float> > > *floatTextures) {
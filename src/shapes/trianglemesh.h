@@ -54,10 +54,37 @@ public:
     BBox WorldBound() const;
     bool CanIntersect() const { return false; }
     void Refine(vector<Reference<Shape> > &refined) const;
+    virtual void GetShadingGeometry(const Transform &obj2world,
+            const DifferentialGeometry &dg,
+            DifferentialGeometry *dgShading) const {
+        GetFaceShadingGeometry(dg.faceIndex, obj2world, dg, dgShading);
+    }
+
+    // The faces of the mesh, intersected in place by the _Triangle_ shapes
+    // and by the accelerators that do not refine the mesh; _shape_ is the
+    // shape reported in the _DifferentialGeometry_
+    int FaceCount() const { return ntris; }
+    BBox FaceWorldBound(int face) const {
+        const int *v = &vertexIndex[3*face];
+        return Union(BBox(p[v[0]], p[v[1]]), p[v[2]]);
+    }
+    void GetFaceUVs(int face, float uv[3][2]) const;
+    bool IntersectFace(int face, const Ray &ray, float *tHit,
+                       float *rayEpsilon, DifferentialGeometry *dg,
+                       const Shape *shape) const;
+    bool IntersectPFace(int face, const Ray &ray, const Shape *shape) const;
+    void GetFaceShadingGeometry(int face, const Transform &obj2world,
+            const DifferentialGeometry &dg,
+            DifferentialGeometry *dgShading) const;
     friend class Triangle;
     template <typename T> friend class VertexTexture;
     bool Projects(const Point &p, Point &ps, Normal &ns) const { return false; }
 protected:
+    // TriangleMesh Protected Methods
+    TriangleMesh(const Transform *o2w, const Transform *w2o, bool ro,
+                 int ntris, int nverts, bool hasNormals, bool hasUVs,
+                 const Reference<Texture<float> > &atex);
+
     // TriangleMesh Protected Data
     int ntris, nverts;
     int *vertexIndex;
@@ -85,19 +112,7 @@ public:
                    DifferentialGeometry *dg) const;
     bool IntersectP(const Ray &ray) const;
     void GetUVs(float uv[3][2]) const {
-        if (mesh->uvs) {
-            uv[0][0] = mesh->uvs[2*v[0]];
-            uv[0][1] = mesh->uvs[2*v[0]+1];
-            uv[1][0] = mesh->uvs[2*v[1]];
-            uv[1][1] = mesh->uvs[2*v[1]+1];
-            uv[2][0] = mesh->uvs[2*v[2]];
-            uv[2][1] = mesh->uvs[2*v[2]+1];
-        }
-        else {
-            uv[0][0] = 0.; uv[0][1] = 0.;
-            uv[1][0] = 1.; uv[1][1] = 0.;
-            uv[2][0] = 1.; uv[2][1] = 1.;
-        }
+        mesh->GetFaceUVs(Face(), uv);
     }
     float Area() const;
     virtual void GetShadingGeometry(const Transform &obj2world,
@@ -107,6 +122,9 @@ public:
     bool Projects(const Point &p, Point &ps, Normal &ns) const { return false; }
 
 private:
+    // Triangle Private Methods
+    int Face() const { return int(v - mesh->vertexIndex) / 3; }
+
     // Triangle Private Data
     Reference<TriangleMesh> mesh;
     int *v;
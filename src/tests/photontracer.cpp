@@ -0,0 +1,73 @@
+#include "pbrt.h"
+#include "sensor.h"
+#include "photontracer.h"
+#include "parallel.h"
+#include "transform.h"
+#include "../shapes/disk.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Records a few hits of random energy per photon on a small film, so that
+// the pixels sum up many hits whose order changes the rounding
+class HitTracer : public PhotonTracer {
+public:
+    HitTracer(Sensor *s) : sensor(s) { }
+    void Trace(uint64_t photon, RNG &rng) {
+        const int nHits = 1 + rng.RandomUInt() % 4;
+        for (int i = 0; i < nHits; i++) {
+            const float x = rng.RandomFloat() - .5f;
+            const float y = rng.RandomFloat() - .5f;
+            sensor->RecordHit(Point(x, y, 0.f),
+                              Spectrum(rng.RandomFloat() * 1e3f));
+        }
+    }
+private:
+    Sensor *sensor;
+};
+
+
+// Traces the photons with _nCores_ threads and returns the film
+static vector<Spectrum> TraceFilm(int nCores, Shape *disk, uint64_t *hits) {
+    PbrtOptions.nCores = nCores;
+    Sensor sensor("disk", "photontracer", disk, 8, 8, 10.f, 10.f, 0.f);
+    HitTracer tracer(&sensor);
+    TracePhotons(&tracer, 64 * photonChunkSize + 17, "Tracing photons", 7);
+    const Spectrum *L = sensor.FilmRadiance();
+    *hits = sensor.HitCount();
+    return vector<Spectrum>(L, L + sensor.NumberPixels());
+}
+
+
+// Checks that the films traced with one and with several threads are
+// identical to the bit
+int main(int argc, char *argv[])
+{
+    PbrtOptions.quiet = true;
+    Transform objectToWorld, worldToObject;
+    Disk disk(&objectToWorld, &worldToObject, false, 0.f, 1.f, 0.f, 360.f);
+
+    uint64_t serialHits, parallelHits;
+    const vector<Spectrum> serial = TraceFilm(1, &disk, &serialHits);
+    const vector<Spectrum> parallel = TraceFilm(4, &disk, &parallelHits);
+    TasksCleanup();
+
+    int failures = 0;
+    if (serialHits != parallelHits) {
+        fprintf(stderr, "photontracer: %llu hits with 1 thread, %llu with 4\n",
+                (unsigned long long)serialHits,
+                (unsigned long long)parallelHits);
+        failures++;
+    }
+    for (size_t i = 0; i < serial.size(); i++) {
+        if (memcmp(&serial[i], &parallel[i], sizeof(Spectrum)) != 0) {
+            fprintf(stderr, "photontracer: pixel %zu differs between 1 and "
+                    "4 threads\n", i);
+            failures++;
+        }
+    }
+
+    if (failures == 0)
+        printf("photontracer: ok\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,65 @@
+#include "pbrt.h"
+#include "../vsd/vsdsprite.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+// Checks that a time series globbed from unpadded frame names is ordered
+// by frame number and not by name
+int main(int argc, char *argv[])
+{
+    char directory[] = "/tmp/spritesequenceXXXXXX";
+    if (!mkdtemp(directory)) {
+        fprintf(stderr, "spritesequence: cannot create a temporary directory\n");
+        return 1;
+    }
+
+    // Create the frames out of order so that the file system order does
+    // not hide a missing sort
+    const int frames[] = { 10, 2, 12, 1, 11, 3, 9 };
+    const int nFrames = sizeof(frames) / sizeof(frames[0]);
+    for (int i = 0; i < nFrames; i++) {
+        char name[256];
+        snprintf(name, sizeof(name), "%s/frame%d.psh", directory, frames[i]);
+        FILE *f = fopen(name, "w");
+        if (!f) {
+            fprintf(stderr, "spritesequence: cannot create \"%s\"\n", name);
+            return 1;
+        }
+        fclose(f);
+    }
+
+    std::vector<std::string> patterns;
+    patterns.push_back("frame*.psh");
+    std::vector<std::string> sequence =
+        ExpandSpriteSequence(directory, patterns);
+
+    const int expected[] = { 1, 2, 3, 9, 10, 11, 12 };
+    int failures = 0;
+    if ((int)sequence.size() != nFrames) {
+        fprintf(stderr, "spritesequence: expected %d frames, got %d\n",
+                nFrames, (int)sequence.size());
+        failures++;
+    }
+    for (int i = 0; i < nFrames && i < (int)sequence.size(); i++) {
+        char name[64];
+        snprintf(name, sizeof(name), "frame%d.psh", expected[i]);
+        if (sequence[i] != name) {
+            fprintf(stderr, "spritesequence: frame %d is \"%s\", expected \"%s\"\n",
+                    i, sequence[i].c_str(), name);
+            failures++;
+        }
+    }
+
+    // Clean up
+    for (int i = 0; i < nFrames; i++) {
+        char name[256];
+        snprintf(name, sizeof(name), "%s/frame%d.psh", directory, frames[i]);
+        unlink(name);
+    }
+    rmdir(directory);
+
+    if (failures == 0)
+        printf("spritesequence: ok\n");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,227 @@
+#include "pbrt.h"
+#include "spectrum.h"
+#include "imageio.h"
+#include "sensor.h"
+#include "sensorfile.h"
+#include "shard.h"
+#include "film/image.h"
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// Sums the partial sensor files (.sensor, .photons, .angular) of the shards
+static bool MergeSensorFiles(const vector<string> &files,
+                             const string &prefix, const string &extension) {
+    SensorFileHeader header;
+    vector<float> planes, cube;
+    vector<Record> records;
+    for (uint32_t i = 0; i < files.size(); ++i) {
+        SensorFileHeader shardHeader;
+        vector<float> shardPlanes, shardCube;
+        if (!ReadSensorFile(files[i], &shardHeader, &shardPlanes, &shardCube,
+                            &records))
+            return false;
+        if (i == 0) {
+            header = shardHeader;
+            planes.swap(shardPlanes);
+            cube.swap(shardCube);
+            continue;
+        }
+        if (shardHeader.flags != header.flags ||
+            shardHeader.xPixels != header.xPixels ||
+            shardHeader.yPixels != header.yPixels ||
+            shardHeader.nPlanes != header.nPlanes ||
+            shardPlanes.size() != planes.size() ||
+            shardCube.size() != cube.size() ||
+            shardHeader.thetaBins != header.thetaBins ||
+            shardHeader.phiBins != header.phiBins ||
+            shardHeader.tileSize != header.tileSize) {
+            Error("\"%s\" was not written by the same sensor as \"%s\"",
+                  files[i].c_str(), files[0].c_str());
+            return false;
+        }
+        header.hitCount += shardHeader.hitCount;
+        for (size_t j = 0; j < planes.size(); ++j)
+            planes[j] += shardPlanes[j];
+        for (size_t j = 0; j < cube.size(); ++j)
+            cube[j] += shardCube[j];
+    }
+
+    const string file = prefix + "." + extension;
+    if (!WriteSensorFile(file, header, planes.empty() ? NULL : &planes[0],
+                         cube.empty() ? NULL : &cube[0],
+                         records.empty() ? NULL : &records))
+        return false;
+    printf("Recorded photons [%llu] in \"%s\" \n",
+           (unsigned long long)header.hitCount, file.c_str());
+
+    // Write the RGB image of the film, as the sensor does
+    if (header.nPlanes == 4 && !(header.flags & sensorFileAngular)) {
+        const uint64_t nPixels = header.xPixels * header.yPixels;
+        float *rgb = new float[3 * nPixels];
+        uint64_t offset = 0;
+        for (uint64_t y = 0; y < header.yPixels; ++y) {
+            for (uint64_t x = 0; x < header.xPixels; ++x, ++offset) {
+                const uint64_t index = (header.xPixels - x) +
+                                       header.xPixels * y;
+                float xyz[3] = { 0.f, 0.f, 0.f };
+                if (index < nPixels)
+                    for (int c = 0; c < 3; ++c)
+                        xyz[c] = planes[(c + 1) * nPixels + index];
+                XYZToRGB(xyz, &rgb[3 * offset]);
+            }
+        }
+        ::WriteImage(prefix + ".exr", rgb, NULL, header.xPixels,
+                     header.yPixels, header.xPixels, header.yPixels, 0, 0);
+        delete[] rgb;
+    }
+    return true;
+}
+
+
+// Sums the partial image films of the shards and writes the film they make
+static bool MergeFilmShards(const vector<string> &files,
+                            const string &prefix) {
+    ImageFilmShardHeader header = ImageFilmShardHeader();
+    ImageFilm *film = NULL;
+    for (uint32_t i = 0; i < files.size(); ++i) {
+        FILE *f = fopen(files[i].c_str(), "rb");
+        ImageFilmShardHeader shardHeader;
+        if (!f || fread(&shardHeader, sizeof(shardHeader), 1, f) != 1 ||
+            memcmp(shardHeader.magic, "PBRTFILM", 8) != 0 ||
+            shardHeader.version != 2) {
+            if (f) fclose(f);
+            Error("\"%s\" is not a film shard", files[i].c_str());
+            delete film;
+            return false;
+        }
+        if (i == 0) {
+            // Sample the spectra as the render did before making the film
+            header = shardHeader;
+            if (!SetSpectralSamples(header.nSpectralSamples) ||
+                !SetSpectralRange(header.lambdaStart, header.lambdaEnd)) {
+                fclose(f);
+                return false;
+            }
+            SampledSpectrum::Init();
+            film = CreateImageFilm(header, prefix);
+        }
+        else if (memcmp(&shardHeader, &header, sizeof(header)) != 0) {
+            fclose(f);
+            Error("\"%s\" was not written by the same film as \"%s\"",
+                  files[i].c_str(), files[0].c_str());
+            delete film;
+            return false;
+        }
+        const bool read = film->AddShard(f);
+        fclose(f);
+        if (!read) {
+            Error("Film shard \"%s\" is truncated", files[i].c_str());
+            delete film;
+            return false;
+        }
+    }
+    film->WriteImage(header.splatScale);
+    delete film;
+    return true;
+}
+
+
+// Sums the energy per wavelength of the .spectrum files of the sensors
+static bool MergeSpectra(const vector<string> &files, const string &prefix) {
+    vector<float> wavelengths, energy;
+    for (uint32_t i = 0; i < files.size(); ++i) {
+        std::ifstream stream(files[i].c_str());
+        if (!stream) {
+            Error("Cannot open the spectrum \"%s\"", files[i].c_str());
+            return false;
+        }
+        float lambda, value;
+        size_t n = 0;
+        while (stream >> lambda >> value) {
+            if (i == 0) {
+                wavelengths.push_back(lambda);
+                energy.push_back(value);
+            }
+            else if (n >= wavelengths.size() || wavelengths[n] != lambda) {
+                Error("\"%s\" was not sampled as \"%s\"", files[i].c_str(),
+                      files[0].c_str());
+                return false;
+            }
+            else
+                energy[n] += value;
+            ++n;
+        }
+    }
+    const string file = prefix + ".spectrum";
+    std::fstream stream(file.c_str(), ios::out);
+    for (size_t i = 0; i < wavelengths.size(); ++i)
+        stream << wavelengths[i] << " " << energy[i] << "\n";
+    stream.close();
+    return true;
+}
+
+
+int main(int argc, char** argv)
+{
+    string prefix;
+    vector<string> files;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--outfile") && i + 1 < argc)
+            prefix = argv[++i];
+        else
+            files.push_back(argv[i]);
+    }
+    if (files.empty()) {
+        fprintf(stderr, "usage: pbrtmerge [--outfile prefix] "
+                "<name.shard0ofN.ext> ... <name.shardN-1ofN.ext>\n"
+                "Sums the partial .sensor, .photons, .angular, .spectrum and "
+                ".imagefilm files of a render run with --shard i/N.\n");
+        return EXIT_FAILURE;
+    }
+
+    // All the shards of one output, written by the same render
+    const size_t dot = files[0].rfind('.');
+    const string extension = dot == string::npos ? "" :
+                             files[0].substr(dot + 1);
+    string shardPrefix;
+    int shardIndex, nShards;
+    if (!ParseShardFileName(files[0], &shardPrefix, &shardIndex, &nShards)) {
+        Error("\"%s\" is not a shard", files[0].c_str());
+        return EXIT_FAILURE;
+    }
+    vector<bool> found(nShards, false);
+    for (uint32_t i = 0; i < files.size(); ++i) {
+        string p;
+        int index, n;
+        if (!ParseShardFileName(files[i], &p, &index, &n) ||
+            p != shardPrefix || n != nShards || index < 0 || index >= n ||
+            files[i].substr(files[i].rfind('.') + 1) != extension) {
+            Error("\"%s\" is not a shard of \"%s\"", files[i].c_str(),
+                  files[0].c_str());
+            return EXIT_FAILURE;
+        }
+        if (found[index]) {
+            Error("Shard %d of \"%s\" is given twice", index,
+                  shardPrefix.c_str());
+            return EXIT_FAILURE;
+        }
+        found[index] = true;
+    }
+    if (files.size() != size_t(nShards))
+        Warning("Merging %d of the %d shards of \"%s\"", int(files.size()),
+                nShards, shardPrefix.c_str());
+    if (prefix.empty())
+        prefix = shardPrefix;
+
+    bool merged;
+    if (extension == "imagefilm")
+        merged = MergeFilmShards(files, prefix);
+    else if (extension == "spectrum")
+        merged = MergeSpectra(files, prefix);
+    else
+        merged = MergeSensorFiles(files, prefix, extension);
+    return merged ? EXIT_SUCCESS : EXIT_FAILURE;
+}
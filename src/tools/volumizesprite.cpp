@@ -9,11 +9,12 @@ using namespace std;
 int main(int argc, char** argv)
 {
     printf("Volumizing Sprite \n");
-    if(argc < 13) {
+    if(argc < 14) {
         Warning("arguments <PSH> <INPUT_DATA_DIRECTORY> "
                 "<OUTPUT_DATA_DIRECTORY> <SIMULATION_METHOD> <GRID_RESOLUTION> "
                 "<SENSOR_WIDTH> <SENSOR_HEIGHT> <SENSOR_CENTER_X> <SENSOR_CENTER_Y>"
-                "<SENSOR_RESOLUTION> <MOSAIC_WIDTH> <MOSAIC_HEIGHT> <MOSAIC_DEPTH>");
+                "<SENSOR_RESOLUTION> <MOSAIC_WIDTH> <MOSAIC_HEIGHT> <MOSAIC_DEPTH> "
+                "[nearest|trilinear|gaussian]");
         return EXIT_SUCCESS;
     }
 
@@ -31,6 +32,13 @@ int main(int argc, char** argv)
     // The translation vector required to align the sprite under the sensor
     Vector spriteTranslation(atof(argv[11]), atof(argv[12]), atof(argv[13]));
 
+    // The kernel used to spread the events over the voxels
+    VSDReconstruction reconstruction = VSD_RECONSTRUCTION_NEAREST;
+    if (argc > 14 && !VSDReconstructionFromString(argv[14], &reconstruction)) {
+        Warning("Unknown reconstruction kernel \"%s\"", argv[14]);
+        return EXIT_FAILURE;
+    }
+
 #ifdef DEBUG
     printf("Sprite Shift: %f %f %f \n",
            spriteTranslation.x, spriteTranslation.y, spriteTranslation.z);
@@ -43,7 +51,7 @@ int main(int argc, char** argv)
     sprite.PrintBoundingBox();
 
     // Voxelize the sprite and write the results to PBRT and RAW volumes
-    VSDGrid* grid = sprite.Voxelize(gridBaseResolution);
+    VSDGrid* grid = sprite.Voxelize(gridBaseResolution, reconstruction);
 
     grid->GeneratePBRTConfiguration(outputDataDirectory,
                                     sprite.GetTimeStep(),
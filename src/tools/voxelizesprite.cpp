@@ -22,7 +22,9 @@ int main(int argc, char** argv)
                 "<PSH> "
                 "<INPUT_DATA_DIRECTORY> "
                 "<OUTPUT_DATA_DIRECTORY> "
-                "<GRID_RESOLUTION>");
+                "<GRID_RESOLUTION> "
+                "[nearest|trilinear|gaussian] "
+                "[raw|floatraw]");
         return EXIT_SUCCESS;
     }
 
@@ -31,6 +33,12 @@ int main(int argc, char** argv)
     string inputDataDirectory(argv[2]);
     string outputDataDirectory(argv[3]);
     int gridBaseResolution = atoi(argv[4]);
+    VSDReconstruction reconstruction = VSD_RECONSTRUCTION_NEAREST;
+    if (argc > 5 && !VSDReconstructionFromString(argv[5], &reconstruction)) {
+        Warning("Unknown reconstruction kernel \"%s\"", argv[5]);
+        return EXIT_FAILURE;
+    }
+    string format(argc > 6 ? argv[6] : "raw");
 
     // Read the VSD sprite
     VSDSprite sprite;
@@ -39,10 +47,15 @@ int main(int argc, char** argv)
     sprite.PrintBoundingBox();
 
     // Voxelize the sprite and write the results to PBRT and RAW volumes
-    VSDGrid* grid = sprite.Voxelize(gridBaseResolution);
-
-
-    grid->WriteRAWVolumeFile(outputDataDirectory, pshFilePrefix, Vector(0.0, 0.0, 0.0));
+    VSDGrid* grid = sprite.Voxelize(gridBaseResolution, reconstruction);
+
+    if (format == "floatraw")
+        grid->WriteFloatVolumeFile(outputDataDirectory, pshFilePrefix,
+                                   Vector(0.0, 0.0, 0.0));
+    else
+        grid->WriteRAWVolumeFile(outputDataDirectory, pshFilePrefix,
+                                 Vector(0.0, 0.0, 0.0));
+    delete grid;
 
     printf("DONE Volumizing \n");
     return EXIT_SUCCESS;
@@ -52,6 +52,25 @@ float AnnotatedVolumeGrid::Density(const Point &Pobj) const {
 }
 
 
+bool AnnotatedVolumeGrid::Lookup(const Point &p, MediumProperties *mp) const {
+    if (!worldBound.Inside(p)) {
+        mp->Clear();
+        return false;
+    }
+    // One transformation and one voxel fetch for all the coefficients
+    const Point Pobj = WorldToVolume(p);
+    const int tagIndex = extent.Inside(Pobj) ? Index(Pobj) : 0;
+    if (tagIndex > 0) {
+        const float d = density[tagIndex-1];
+        mp->Set(d * sig_a[tagIndex-1], d * sig_s[tagIndex-1],
+                d * (sig_a[tagIndex-1] + sig_s[tagIndex-1]), g, tagIndex);
+    }
+    else
+        mp->Clear();
+    return true;
+}
+
+
 uint64 AnnotatedVolumeGrid::Index(const Point &Pobj) const {
     // Compute voxel coordinates and offsets for _Pobj_
     Vector vox = extent.Offset(Pobj);
@@ -93,7 +112,9 @@ AnnotatedVolumeGrid *CreateAnnotatedVolumeGrid(const Transform &volume2world,
     }
 
     uint64 nx, ny, nz;
-    uint8 *indices = ReadIndices(prefix, nx, ny, nz);
+    MappedFile *indices = MapVolume(prefix, nx, ny, nz);
+    if (!indices)
+        return NULL;
     return new AnnotatedVolumeGrid(sig_a, sig_s, g, le, BBox(p0, p1),
                 volume2world, nx, ny, nz, density, indices, numberTags);
 }
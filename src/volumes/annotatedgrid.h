@@ -38,6 +38,7 @@
 
 // volumes/annotatedgrid.h*
 #include "volume.h"
+#include "volumeutil.h"
 
 // AnnotatedVolumeGrid Declarations
 class AnnotatedVolumeGrid : public DensityRegion {
@@ -45,18 +46,21 @@ public:
     // AnnotatedVolumeGrid Public Methods
     AnnotatedVolumeGrid(const Spectrum *sa, const Spectrum *ss, float gg,
             const Spectrum *em, const BBox &e, const Transform &v2w,
-            uint64 x, uint64 y, uint64 z, float *d, uint8 *ind, const int &ntags)
+            uint64 x, uint64 y, uint64 z, float *d, MappedFile *ind,
+            const int &ntags)
         : DensityRegion(0.f, 0.f, 0.f, 0.f, v2w), sig_a(sa), sig_s(ss), le(em),
             nx(x), ny(y), nz(z), extent(e), nTags(ntags) {
-        indices = ind; density = d;
+        indices = ind->Data(); mapping = ind; density = d;
+        worldBound = Inverse(WorldToVolume)(extent);
         PreProcess();
     }
-     ~AnnotatedVolumeGrid() { delete[] indices; }
-    BBox WorldBound() const { return Inverse(WorldToVolume)(extent); }
+     ~AnnotatedVolumeGrid() { delete mapping; }
+    BBox WorldBound() const { return worldBound; }
     bool IntersectP(const Ray &r, float *t0, float *t1) const {
         Ray ray = WorldToVolume(r);
         return extent.IntersectP(ray, t0, t1);
     }
+    bool Lookup(const Point &p, MediumProperties *mp) const;
     uint64 Index(const Point &Pobj) const;
     float Density(const Point &Pobj) const;
     float D(int x, int y, int z) const {
@@ -92,10 +96,12 @@ private:
     const Spectrum *sig_s;
     const Spectrum *le;
     float *density;
-    uint8 *indices;
+    const uint8 *indices;
+    MappedFile *mapping;
     float manDensity, minDensity;
     uint64 nx, ny, nz;
     const BBox extent;
+    BBox worldBound;
     const int nTags;
 };
 
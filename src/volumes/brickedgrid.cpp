@@ -0,0 +1,278 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+
+// volumes/brickedgrid.cpp*
+#include "stdafx.h"
+#include "brickedgrid.h"
+#include "volumeutil.h"
+#include "paramset.h"
+#include "parallel.h"
+#include "montecarlo.h"
+
+// BrickedVolumeGrid Method Definitions
+BrickedVolumeGrid::BrickedVolumeGrid(const Spectrum &sa, const Spectrum &ss,
+        float gg, const Spectrum &em, const BBox &e, const Transform &v2w,
+        uint64 x, uint64 y, uint64 z, const float *d, const uint8 *v)
+    : DensityRegion(sa, ss, gg, em, v2w), nx(x), ny(y), nz(z), extent(e) {
+    // The bricks double as the cells of the majorant grid
+    bricks = new MajorantGrid(extent, nx, ny, nz, brickShift);
+    bricks->Build([&](uint64 index) { return v ? float(v[index]) : d[index]; });
+    const uint64 totalBricks = bricks->CellCount();
+    occupied = new BitArray(totalBricks);
+    brickSlot = new int32_t[totalBricks];
+    ParallelFor(0, totalBricks, 0, [&](int64_t b) {
+        const uint64 x0 = bricks->CellOrigin(b, 0);
+        const uint64 y0 = bricks->CellOrigin(b, 1);
+        const uint64 z0 = bricks->CellOrigin(b, 2);
+        bool stored = false;
+        for (uint64 k = z0; k < min(z0 + brickSize, nz) && !stored; ++k)
+            for (uint64 j = y0; j < min(y0 + brickSize, ny) && !stored; ++j)
+                for (uint64 i = x0; i < min(x0 + brickSize, nx); ++i) {
+                    const uint64 index = (k * ny + j) * nx + i;
+                    if ((v ? float(v[index]) : d[index]) != 0.f) {
+                        stored = true;
+                        break;
+                    }
+                }
+        brickSlot[b] = stored ? 0 : -1;
+    });
+
+    // Only bricks holding non-zero voxels get storage
+    int32_t nStored = 0;
+    for (uint64 b = 0; b < totalBricks; ++b) {
+        if (brickSlot[b] == 0)
+            brickSlot[b] = nStored++;
+        occupied->SetBit(b, bricks->Min(b) != 0.f || bricks->Max(b) != 0.f);
+    }
+    maxDensity = bricks->Max();
+    minDensity = bricks->Min();
+    const uint64 poolSize = uint64(nStored) * brickVoxels;
+    bytePool = v ? new uint8[poolSize] : NULL;
+    floatPool = v ? NULL : new float[poolSize];
+    ParallelFor(0, totalBricks, 0, [&](int64_t b) {
+        if (brickSlot[b] < 0) return;
+        const uint64 x0 = bricks->CellOrigin(b, 0);
+        const uint64 y0 = bricks->CellOrigin(b, 1);
+        const uint64 z0 = bricks->CellOrigin(b, 2);
+        uint64 voxel = uint64(brickSlot[b]) * brickVoxels;
+        for (uint64 k = z0; k < z0 + brickSize; ++k)
+            for (uint64 j = y0; j < y0 + brickSize; ++j)
+                for (uint64 i = x0; i < x0 + brickSize; ++i, ++voxel) {
+                    // Voxels past the end of the grid in partial bricks
+                    const bool inside = (i < nx && j < ny && k < nz);
+                    const uint64 index = (k * ny + j) * nx + i;
+                    if (v) bytePool[voxel] = inside ? v[index] : 0;
+                    else floatPool[voxel] = inside ? d[index] : 0.f;
+                }
+    });
+    Info("Bricked volume keeps %d of %zu bricks (%.1f%%)", nStored,
+         size_t(totalBricks), 100.f * nStored / max(totalBricks, uint64(1)));
+}
+
+
+BrickedVolumeGrid::~BrickedVolumeGrid() {
+    delete bricks;
+    delete occupied;
+    delete[] brickSlot;
+    delete[] bytePool;
+    delete[] floatPool;
+}
+
+
+float BrickedVolumeGrid::Density(const Point &Pobj) const {
+    if (!extent.Inside(Pobj)) return 0;
+    // Compute voxel coordinates and offsets for _Pobj_
+    Vector vox = extent.Offset(Pobj);
+    vox.x = vox.x * nx - .5f;
+    vox.y = vox.y * ny - .5f;
+    vox.z = vox.z * nz - .5f;
+
+    // Nothing to interpolate in an empty brick
+    const int bx = Clamp(Floor2Int(vox.x + .5f), 0, int(nx)-1) >> brickShift;
+    const int by = Clamp(Floor2Int(vox.y + .5f), 0, int(ny)-1) >> brickShift;
+    const int bz = Clamp(Floor2Int(vox.z + .5f), 0, int(nz)-1) >> brickShift;
+    if (!occupied->GetBit(bricks->CellIndex(bx, by, bz)))
+        return 0.f;
+
+    int vx = Floor2Int(vox.x), vy = Floor2Int(vox.y), vz = Floor2Int(vox.z);
+    float dx = vox.x - vx, dy = vox.y - vy, dz = vox.z - vz;
+
+    // Trilinearly interpolate density values to compute local density
+    float d00 = Lerp(dx, D(vx, vy, vz),     D(vx+1, vy, vz));
+    float d10 = Lerp(dx, D(vx, vy+1, vz),   D(vx+1, vy+1, vz));
+    float d01 = Lerp(dx, D(vx, vy, vz+1),   D(vx+1, vy, vz+1));
+    float d11 = Lerp(dx, D(vx, vy+1, vz+1), D(vx+1, vy+1, vz+1));
+    float d0 = Lerp(dy, d00, d10);
+    float d1 = Lerp(dy, d01, d11);
+    return Lerp(dz, d0, d1);
+}
+
+
+bool BrickedVolumeGrid::SkipEmptySpace(const Ray &ray, float *tSkip) const {
+    // Find the first brick along the ray with any density in it
+    Ray rayObj = WorldToVolume(ray);
+    float tHit0, tHit1;
+    if (!extent.IntersectP(rayObj, &tHit0, &tHit1))
+        return false;
+    MajorantWalker walker(*bricks, rayObj, tHit0, tHit1);
+    uint64 brick;
+    float t0, t1;
+    while (walker.Next(&brick, &t0, &t1)) {
+        if (occupied->GetBit(brick)) {
+            *tSkip = t0;
+            return true;
+        }
+    }
+    return false;
+}
+
+
+Spectrum BrickedVolumeGrid::tau(const Ray &r, float stepSize, float u) const {
+    float length = r.d.Length();
+    if (length == 0.f) return 0.f;
+    Ray rn(r.o, r.d / length, r.mint * length, r.maxt * length, r.time);
+    Ray rayObj = WorldToVolume(rn);
+    float tHit0, tHit1;
+    if (!extent.IntersectP(rayObj, &tHit0, &tHit1)) return 0.;
+
+    // Take the same steps as DensityRegion::tau() but only in occupied
+    // bricks, where the density can be non-zero
+    const float tStart = tHit0 + u * stepSize;
+    float density = 0.f;
+    MajorantWalker walker(*bricks, rayObj, tHit0, tHit1);
+    uint64 brick;
+    float t0, t1;
+    while (walker.Next(&brick, &t0, &t1)) {
+        if (!occupied->GetBit(brick)) continue;
+        float t = tStart + max(0.f, ceilf((t0 - tStart) / stepSize)) * stepSize;
+        for (; t < t1; t += stepSize)
+            density += Density(rayObj(t));
+    }
+    return (sigma_a + sigma_s) * density * stepSize;
+}
+
+
+float BrickedVolumeGrid::tauLambda(const Ray &r, float stepSize, float u,
+                                   const int &wl) const {
+    return tau(r, stepSize, u).Power(wl);
+}
+
+
+bool BrickedVolumeGrid::Track(const Ray &ray, float sigmaScale, float *tDis,
+        Point &Psample, float *pdf, RNG &rng) const {
+    Ray rayObj = WorldToVolume(ray);
+    float tHit0, tHit1;
+    if (!extent.IntersectP(rayObj, &tHit0, &tHit1))
+        return false;
+    float t, density;
+    if (bricks->Track(rayObj, tHit0, tHit1, sigmaScale * ray.d.Length(),
+            [this](const Point &Pobj) { return Density(Pobj); }, rng, &t,
+            &density)) {
+        Psample = ray(t);
+        *tDis = t;
+        *pdf = density * sigmaScale;
+        return true;
+    }
+
+    // The photon crossed the volume without a collision
+    *tDis = INFINITY;
+    Psample = ray(INFINITY);
+    *pdf = 1.f;
+    return true;
+}
+
+
+bool BrickedVolumeGrid::SampleDistance(const Ray& ray, float* tDis,
+        Point& Psample, float* pdf, RNG &rng) const {
+    return Track(ray, Spectrum(sigma_a + sigma_s).y(), tDis, Psample, pdf,
+                 rng);
+}
+
+
+bool BrickedVolumeGrid::SampleDistance(const Ray& ray, float* tDis,
+        Point &Psample, float* pdf, RNG &rng, const int &wl) const {
+    return Track(ray, sigma_a.Power(wl) + sigma_s.Power(wl), tDis, Psample,
+                 pdf, rng);
+}
+
+
+bool BrickedVolumeGrid::SampleDirection(const Point &p, const Vector& wi,
+        Vector& wo, float* pdf, RNG &rng) const {
+    wo = SampleHG(wi, g, rng.RandomFloat(), rng.RandomFloat());
+    *pdf = PhaseHG(wi, wo, g);
+    return true;
+}
+
+
+BrickedVolumeGrid *CreateBrickedGridVolumeRegion(const Transform &volume2world,
+        const ParamSet &params) {
+    // Initialize common volume region parameters
+    Spectrum sigma_a = params.FindOneSpectrum("sigma_a", 0.);
+    Spectrum sigma_s = params.FindOneSpectrum("sigma_s", 0.);
+    float g = params.FindOneFloat("g", 0.);
+    Spectrum Le = params.FindOneSpectrum("Le", 0.);
+    Point p0 = params.FindOnePoint("p0", Point(0,0,0));
+    Point p1 = params.FindOnePoint("p1", Point(1,1,1));
+    std::string format = params.FindOneString("format", "pbrt");
+    if (format == std::string("raw")) {
+        std::string prefix = params.FindOneString("prefix", "");
+        Info("Reading a RAW volume from %s \n", prefix.c_str());
+        uint64 nx, ny, nz;
+        MappedFile *voxels = MapVolume(prefix, nx, ny, nz);
+        if (!voxels)
+            return NULL;
+        // The dense file is only needed until the bricks are built
+        BrickedVolumeGrid *volume = new BrickedVolumeGrid(sigma_a, sigma_s,
+            g, Le, BBox(p0, p1), volume2world, nx, ny, nz, NULL,
+            voxels->Data());
+        delete voxels;
+        return volume;
+    }
+    int nitems;
+    const float *data = params.FindFloat("density", &nitems);
+    if (!data) {
+        Error("No \"density\" values provided for bricked volume grid?");
+        return NULL;
+    }
+    uint64 nx = params.FindOneInt("nx", 1);
+    uint64 ny = params.FindOneInt("ny", 1);
+    uint64 nz = params.FindOneInt("nz", 1);
+    if (nitems != nx*ny*nz) {
+        Error("BrickedVolumeGrid has %d density values but nx*ny*nz = %d",
+              nitems, int(nx*ny*nz));
+        return NULL;
+    }
+    return new BrickedVolumeGrid(sigma_a, sigma_s, g, Le, BBox(p0, p1),
+                                 volume2world, nx, ny, nz, data, NULL);
+}
+
+
@@ -0,0 +1,109 @@
+
+/*
+    pbrt source code Copyright(c) Marwan Abdellah <marwan.abdellah>@epfl.ch>.
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#ifndef PBRT_VOLUMES_BRICKEDGRID_H
+#define PBRT_VOLUMES_BRICKEDGRID_H
+
+// volumes/brickedgrid.h*
+#include "volume.h"
+#include "bitarray.h"
+#include "majorantgrid.h"
+
+// Bricks are brickSize^3 voxels stored contiguously
+static const int brickShift = 3;
+static const int brickSize = 1 << brickShift;
+static const int brickVoxels = brickSize * brickSize * brickSize;
+
+// BrickedVolumeGrid Declarations
+class BrickedVolumeGrid : public DensityRegion {
+public:
+    // BrickedVolumeGrid Public Methods
+    BrickedVolumeGrid(const Spectrum &sa, const Spectrum &ss, float gg,
+            const Spectrum &em, const BBox &e, const Transform &v2w,
+            uint64 x, uint64 y, uint64 z, const float *d, const uint8 *v);
+    ~BrickedVolumeGrid();
+    BBox WorldBound() const { return Inverse(WorldToVolume)(extent); }
+    bool IntersectP(const Ray &r, float *t0, float *t1) const {
+        Ray ray = WorldToVolume(r);
+        return extent.IntersectP(ray, t0, t1);
+    }
+    bool SkipEmptySpace(const Ray &ray, float *tSkip) const;
+    float Density(const Point &Pobj) const;
+    float D(int x, int y, int z) const {
+        x = Clamp(x, 0, int(nx)-1);
+        y = Clamp(y, 0, int(ny)-1);
+        z = Clamp(z, 0, int(nz)-1);
+        const int32_t slot = brickSlot[bricks->CellIndex(x >> brickShift,
+            y >> brickShift, z >> brickShift)];
+        if (slot < 0) return 0.f;
+        const uint64 voxel = uint64(slot) * brickVoxels +
+            (((z & (brickSize-1)) << brickShift | (y & (brickSize-1)))
+                << brickShift | (x & (brickSize-1)));
+        return bytePool ? float(bytePool[voxel]) : floatPool[voxel];
+    }
+    Spectrum MaxSigma_t() const { return (sigma_a + sigma_s) * maxDensity; }
+    float MaxSigma_t(const int &wl) const {
+        return (sigma_a.Power(wl) + sigma_s.Power(wl)) * maxDensity;
+    }
+    Spectrum tau(const Ray &r, float stepSize, float offset) const;
+    float tauLambda(const Ray &r, float stepSize, float offset,
+        const int &wl) const;
+    bool SampleDistance(const Ray& ray, float* tDis, Point &Psample,
+        float* pdf, RNG &rng) const;
+    bool SampleDirection(const Point &p, const Vector& wi, Vector& wo,
+        float* pdf, RNG &rng) const;
+    bool SampleDistance(const Ray& ray, float* tDis, Point &Psample,
+        float* pdf, RNG &rng, const int &wl) const;
+private:
+    // BrickedVolumeGrid Private Methods
+    bool Track(const Ray &ray, float sigmaScale, float *tDis,
+        Point &Psample, float *pdf, RNG &rng) const;
+
+    // BrickedVolumeGrid Private Data
+    const uint64 nx, ny, nz;
+    const BBox extent;
+    MajorantGrid *bricks;
+    BitArray *occupied;
+    int32_t *brickSlot;
+    uint8 *bytePool;
+    float *floatPool;
+    float maxDensity, minDensity;
+};
+
+
+BrickedVolumeGrid *CreateBrickedGridVolumeRegion(const Transform &volume2world,
+        const ParamSet &params);
+
+#endif // PBRT_VOLUMES_BRICKEDGRID_H
@@ -116,7 +116,9 @@ FluorescentAnnotatedVolumeGrid *CreateFluorescentAnnotatedVolumeGrid(const Trans
     }
 
     uint64 nx, ny, nz;
-    uint8 *indices = ReadIndices(prefix, nx, ny, nz);
+    MappedFile *indices = MapVolume(prefix, nx, ny, nz);
+    if (!indices)
+        return NULL;
     return new FluorescentAnnotatedVolumeGrid(BBox(p0, p1), volume2world,
             fex, fem, epsilon, c, yield, gf, nx, ny, nz, indices, numberTags);
 }
@@ -38,6 +38,7 @@
 
 // volumes/annotatedgrid.h*
 #include "volume.h"
+#include "volumeutil.h"
 
 // FluorescentAnnotatedGrid Declarations
 class FluorescentAnnotatedVolumeGrid : public DensityRegion {
@@ -46,10 +47,10 @@ public:
     FluorescentAnnotatedVolumeGrid(const BBox &e, const Transform &v2w,
             Spectrum *fex, Spectrum *fem, const float *eps,
             const float *conc, const float *phi, const float *ggf,
-            uint64 x, uint64 y, uint64 z, uint8 *ind, const int &ntags)
+            uint64 x, uint64 y, uint64 z, MappedFile *ind, const int &ntags)
         : DensityRegion(0.f, 0.f, 0.f, 0.f, v2w), epsilon(eps), c(conc),
             yield(phi), nx(x), ny(y), nz(z), extent(e), nTags(ntags) {
-        indices = ind;
+        indices = ind->Data(); mapping = ind;
         yield = phi; gf = ggf;
         epsilon = eps; c = conc;
         f_ex = fex; f_em = fem;
@@ -63,12 +64,13 @@ public:
         for (uint64 i = 0; i < nTags; ++i) {
             mu[i] = LN10 * c[i] * epsilon[i];
         }
+        worldBound = Inverse(WorldToVolume)(extent);
         ValidateData();
         PreProcess();
     }
-     ~FluorescentAnnotatedVolumeGrid() { delete[] indices; }
+     ~FluorescentAnnotatedVolumeGrid() { delete mapping; }
     void ValidateData() const;
-    BBox WorldBound() const { return Inverse(WorldToVolume)(extent); }
+    BBox WorldBound() const { return worldBound; }
     bool IntersectP(const Ray &r, float *t0, float *t1) const {
         Ray ray = WorldToVolume(r);
         return extent.IntersectP(ray, t0, t1);
@@ -76,6 +78,21 @@ public:
     bool HasNonClearedFluorescentVolumes() const {
         return false;
     }
+    bool Lookup(const Point &p, MediumProperties *mp) const {
+        if (!worldBound.Inside(p)) {
+            mp->Clear();
+            return false;
+        }
+        // The fluorophore of the voxel gives all the coefficients
+        const uint64 tagIndex = Index(WorldToVolume(p));
+        if (tagIndex > 0) {
+            const Spectrum &m = mu[tagIndex-1];
+            mp->Set(m, m, m, g, int(tagIndex));
+        }
+        else
+            mp->Clear();
+        return true;
+    }
     uint64 Index(const Point &Pobj) const;
     Spectrum Mu(const Point &p, const Vector &, float) const {
         Point Pobj = WorldToVolume(p);
@@ -170,8 +187,10 @@ private:
     Spectrum *mu, *f_ex, *f_em;
     const float *epsilon, *c, *yield, *gf;
     const uint8 *indices;
+    MappedFile *mapping;
     uint64 nx, ny, nz;
     const BBox extent;
+    BBox worldBound;
     const int nTags;
 };
 
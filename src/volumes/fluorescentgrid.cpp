@@ -120,14 +120,17 @@ FluorescentGridDensity *CreateFluorescentGrid(const Transform &volume2world,
     Point p0 = params.FindOnePoint("p0", Point(-0.5, -0.5, -0.5));
     Point p1 = params.FindOnePoint("p1", Point(0.5, 0.5, 0.5));
     std::string format = params.FindOneString("format", "raw");
-    uchar* data;
     if (format == std::string("raw")) {
         std::string prefix = params.FindOneString("prefix", "");
         Info("Reading a RAW volume from %s \n", prefix.c_str());
         u_int64_t nx, ny, nz;
-        data = ReadIntVolume(prefix, nx, ny, nz);
+        MappedFile *voxels = MapVolume(prefix, nx, ny, nz);
+        if (!voxels)
+            return NULL;
+        voxels->AdviseRandom();
         return new FluorescentGridDensity(BBox(p0, p1), volume2world,
-                nx, ny, nz, data, fex, fem, epsilon, c, yield, gf);
+                nx, ny, nz, voxels->Data(), fex, fem, epsilon, c, yield, gf,
+                voxels);
     } else {
         int nitems;
         const uchar *data = params.FindUChar("density", &nitems);
@@ -39,6 +39,7 @@
 
 // volumes/fluorescentgrid.h*
 #include "volume.h"
+#include "volumeutil.h"
 
 // FluorescentGridDensity Declarations
 class FluorescentGridDensity : public DensityRegion {
@@ -47,16 +48,20 @@ public:
     FluorescentGridDensity(const BBox &e, const Transform &v2w,
             int x, int y, int z, const uchar *data,
             const Spectrum &fex, const Spectrum &fem,
-            float eps, float conc, float phi, float ggf)
+            float eps, float conc, float phi, float ggf,
+            MappedFile *m = NULL)
         : DensityRegion(0.f, 0.f, 0.f, 0.f, v2w), nx(x), ny(y), nz(z),
-            extent(e), yield(phi), gf(ggf), grid(data) {
+            extent(e), yield(phi), gf(ggf), grid(data), mapping(m) {
         f_ex = fex; f_em = fem;
         f_ex.Normalize(); f_em.Normalize(); f_em.NormalizeSPDArea();
         epsilon = eps; c = conc;
         mu = (LN10 * c * epsilon * Spectrum(1.f));
         ValidateData();
     }
-     ~FluorescentGridDensity() { delete[] grid; }
+     ~FluorescentGridDensity() {
+        if (mapping) delete mapping;
+        else delete[] grid;
+    }
     void ValidateData();
     BBox WorldBound() const { return Inverse(WorldToVolume)(extent); }
     bool IntersectP(const Ray &r, float *t0, float *t1) const {
@@ -71,6 +76,17 @@ public:
     }
     float Fluorescence(const Point &p) const;
     virtual float F(int x, int y, int z) const;
+    bool Lookup(const Point &p, MediumProperties *mp) const {
+        if (!WorldBound().Inside(p)) {
+            mp->Clear();
+            return false;
+        }
+        if (Fluorescence(WorldToVolume(p)))
+            mp->Set(mu, mu, mu, g, 1);
+        else
+            mp->Clear();
+        return true;
+    }
     Spectrum Mu(const Point &p, const Vector &, float) const {
         if(Fluorescence(WorldToVolume(p)))
             return mu;
@@ -161,6 +177,7 @@ protected:
 private:
     // FluorescentGridDensity Protected Data
     const uchar *grid;
+    MappedFile *mapping;
 };
 
 
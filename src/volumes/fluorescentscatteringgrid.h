@@ -91,6 +91,16 @@ public:
     }
 
     // Optical Properties
+    bool Lookup(const Point &p, MediumProperties *mp) const {
+        if (!WorldBound().Inside(p)) {
+            mp->Clear();
+            return false;
+        }
+        const float d = Density(WorldToVolume(p));
+        mp->Set(d * sigma_a, d * sigma_s, d * sigma_t, g, 0);
+        return true;
+    }
+
     // Spectral Optical Properties
     Spectrum Sigma_a(const Point &p, const Vector &, float) const {
         const Point Pobj = WorldToVolume(p);
@@ -65,24 +65,12 @@ float VolumeGrid::Density(const Point &Pobj) const {
 
 
 void VolumeGrid::PreProcess() {
-    // Compute the minimum and maximum optical properties
-    float maxVolumeDensity = std::numeric_limits<float>::min();
-    float minVolumeDensity = std::numeric_limits<float>::max();
-
-    size_t index = 0;
-    for(uint64 i = 0; i < nx; i++) {
-        for(uint64 j = 0; j < ny; j++) {
-            for(uint64 k = 0; k < nz; k++) {
-                if(density[index] > maxVolumeDensity)
-                    maxVolumeDensity = density[index];
-                if(density[index] < minVolumeDensity)
-                    minVolumeDensity = density[index];
-                index++;
-            }
-        }
-    }
-    maxDensity = maxVolumeDensity;
-    minDensity = minVolumeDensity;
+    // Compute the minimum and maximum optical properties, over the whole
+    // volume and over every cell of the majorant grid
+    majorants = new MajorantGrid(extent, nx, ny, nz, majorantShift);
+    majorants->Build([this](uint64 index) { return Voxel(index); });
+    maxDensity = majorants->Max();
+    minDensity = majorants->Min();
 }
 
 
@@ -96,15 +84,16 @@ VolumeGrid *CreateGridVolumeRegion(const Transform &volume2world,
     Point p0 = params.FindOnePoint("p0", Point(0,0,0));
     Point p1 = params.FindOnePoint("p1", Point(1,1,1));
     std::string format = params.FindOneString("format", "pbrt");
-    float* data;
-    VolumeGrid* volume;
+    VolumeGrid* volume = NULL;
     if (format == std::string("raw")) {
         std::string prefix = params.FindOneString("prefix", "");
         Info("Reading a RAW volume from %s \n", prefix.c_str());
         u_int64_t nx, ny, nz;
-        data = ReadFloatVolume(prefix, nx, ny, nz);
+        MappedFile *voxels = MapVolume(prefix, nx, ny, nz);
+        if (!voxels)
+            return NULL;
         volume = new VolumeGrid(sigma_a, sigma_s, g, Le, BBox(p0, p1),
-                        volume2world, nx, ny, nz, data);
+                        volume2world, nx, ny, nz, voxels);
 
     } else if (format == std::string("pbrt")) {
         Info("Reading a PBRT volume file with density \n");
@@ -129,64 +118,44 @@ VolumeGrid *CreateGridVolumeRegion(const Transform &volume2world,
 }
 
 
-bool VolumeGrid::SampleDistance(const Ray& ray, float* tDis,
-                                       Point& Psample, float* pdf,
-                                       RNG &rng) const {
-
-    // This function implements the unbiased distance sampling using woodcock
-    // tracking method.
-    // The idea about this algorithm is to take many steps as if the medium is
-    // denser than it is, and then randomly choose to return that distance or
-    // take another step.
-
-    // Find where the ray intersects with the bounding box to evaluate
-    // tMin and tMax correctly.
-    BBox volumeBoundary = WorldBound();
+bool VolumeGrid::Track(const Ray &ray, float sigmaScale, float *tDis,
+        Point &Psample, float *pdf, RNG &rng) const {
+    // Delta tracking through the majorant grid; tentative collisions are
+    // only drawn against the local maximum density
+    Ray rayObj = WorldToVolume(ray);
     float tHit0, tHit1;
-    if(!volumeBoundary.IntersectP(ray, &tHit0, &tHit1))
-        return false; // If the ray doesn't intersect the volume, ERROR
-    const float tMin = std::max(tHit0, ray.mint);
-    const float tMax = std::min(tHit1, ray.maxt);
-
-    //printf("%f %f %f %f %f %f \n", tHit0, tHit1, ray.mint, ray.maxt, tMin, tMax);
-    Point p0 = ray(tMin);
-    Point p1 = ray(tMax);
-
-   // printf("%f %f %f \n", p0.x, p0.y, p0.z);
-   // printf("%f %f %f \n", p1.x, p1.y, p1.z);
-
-
-
-    // Prepare for volumyoute integration stepping
-    // TODO: Change the step value
-    uint64 nSamples = Ceil2Int((tMax-tMin) / 0.5);
-    float step = (tMax - tMin) / nSamples;
-    float t = 0.f;
-    Point p = ray(tMin);
-    Spectrum mu_tCurrent(0.f);
-    Spectrum mu_tIntegrated(0.f);
-
-    while (true) {
-        if(t >= tMax)
-            break;
-        t -= log10(1 - rng.RandomFloat()) / MaxSigma_t().y();
-        if (rng.RandomFloat() < (Sigma_t(p, ray.d, 0).y() / MaxSigma_t().y()))
-            break;
-        p = ray(t);
-        mu_tCurrent = Sigma_t(p, -ray.d, 0);
-        mu_tIntegrated += mu_tCurrent;
-
-        Spectrum T = Exp(-mu_tIntegrated * step);
-        *pdf = mu_tCurrent.y() * T.y();
+    if (!extent.IntersectP(rayObj, &tHit0, &tHit1))
+        return false;
+    float t, density;
+    if (majorants->Track(rayObj, tHit0, tHit1, sigmaScale * ray.d.Length(),
+            [this](const Point &Pobj) { return Density(Pobj); }, rng, &t,
+            &density)) {
+        Psample = ray(t);
+        *tDis = t;
+        *pdf = density * sigmaScale;
+        return true;
     }
-    Psample = p;
-    *tDis = t;
+
+    // No collision, the photon leaves the volume
+    *tDis = INFINITY;
+    Psample = ray(INFINITY);
+    *pdf = 1.f;
     return true;
 }
 
+
+bool VolumeGrid::SampleDistance(const Ray& ray, float* tDis,
+                                       Point& Psample, float* pdf,
+                                       RNG &rng) const {
+    return Track(ray, Spectrum(sigma_a + sigma_s).y(), tDis, Psample, pdf,
+                 rng);
+}
+
+
 bool VolumeGrid::SampleDistance(const Ray& ray, float* tDis,
-        Point &Psample, float* pdf, RNG &rng, const uint64 &wl) const {
-    return false;
+        Point &Psample, float* pdf, RNG &rng, const int &wl) const {
+    return Track(ray, sigma_a.Power(wl) + sigma_s.Power(wl), tDis, Psample,
+                 pdf, rng);
 }
 
 
@@ -39,6 +39,11 @@
 
 // volumes/grid.h*
 #include "volume.h"
+#include "volumeutil.h"
+#include "majorantgrid.h"
+
+// Voxels per side of a majorant grid cell, as a power of two
+static const int majorantShift = 3;
 
 // VolumeGridDensity Declarations
 class VolumeGrid : public DensityRegion {
@@ -51,9 +56,23 @@ public:
           nx(x), ny(y), nz(z), extent(e) {
         density = new float[nx*ny*nz];
         memcpy(density, d, nx*ny*nz*sizeof(float));
+        voxels = NULL;
+        mapping = NULL;
         PreProcess();
     }
-     ~VolumeGrid() { delete[] density; }
+    VolumeGrid(const Spectrum &sa, const Spectrum &ss, float gg,
+            const Spectrum &em, const BBox &e, const Transform &v2w,
+            uint64 x, uint64 y, uint64 z, MappedFile *v)
+        : DensityRegion(sa, ss, gg, em, v2w),
+          nx(x), ny(y), nz(z), extent(e) {
+        // Sample the 8-bit voxels straight from the mapped file
+        density = NULL;
+        voxels = v->Data();
+        mapping = v;
+        PreProcess();
+        mapping->AdviseRandom();
+    }
+     ~VolumeGrid() { delete[] density; delete mapping; delete majorants; }
     void PreProcess();
     BBox WorldBound() const { return Inverse(WorldToVolume)(extent); }
     bool IntersectP(const Ray &r, float *t0, float *t1) const {
@@ -65,10 +84,13 @@ public:
         x = Clamp(x, 0, nx-1);
         y = Clamp(y, 0, ny-1);
         z = Clamp(z, 0, nz-1);
-        return density[z*nx*ny + y*nx + x];
+        return Voxel(z*nx*ny + y*nx + x);
+    }
+    float Voxel(uint64 index) const {
+        return density ? density[index] : float(voxels[index]);
     }
     Spectrum MaxSigma_t() const { return (sigma_a + sigma_s) * maxDensity; }
-    float MaxSigma_t(const uint64 &wl) const {
+    float MaxSigma_t(const int &wl) const {
         return (sigma_a.Power(wl) + sigma_s.Power(wl)) * maxDensity;
     }
     bool SampleDistance(const Ray& ray, float* tDis, Point &Psample,
@@ -76,10 +98,17 @@ public:
     bool SampleDirection(const Point &p, const Vector& wi, Vector& wo,
         float* pdf, RNG &rng) const;
     bool SampleDistance(const Ray& ray, float* tDis, Point &Psample,
-        float* pdf, RNG &rng, const uint64 &wl) const;
+        float* pdf, RNG &rng, const int &wl) const;
 private:
+    // VolumeGridDensity Private Methods
+    bool Track(const Ray &ray, float sigmaScale, float *tDis,
+        Point &Psample, float *pdf, RNG &rng) const;
+
     // VolumeGridDensity Private Data
     float *density;
+    const uint8 *voxels;
+    MappedFile *mapping;
+    MajorantGrid *majorants;
     float maxDensity, minDensity;
     const uint64 nx, ny, nz;
     const BBox extent;
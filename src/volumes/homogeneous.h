@@ -86,6 +86,15 @@ public:
     }
 
     // Spectral Optical Properties
+    bool Lookup(const Point &p, MediumProperties *mp) const {
+        if (!WorldBound().Inside(p)) {
+            mp->Clear();
+            return false;
+        }
+        const float d = Density(WorldToVolume(p));
+        mp->Set(d * sigma_a, d * sigma_s, d * (sigma_a + sigma_s), g, 0);
+        return true;
+    }
     Spectrum Sigma_a(const Point &p, const Vector &, float) const {
         const Point Pobj = WorldToVolume(p);
         return extent.Inside(Pobj) ? (sigma_a * Density(Pobj)) : 0.;
@@ -99,6 +99,26 @@ bool TissueLayer::SampleDistance(const Ray &ray, float *tDist,
 }
 
 
+bool TissueLayer::SampleDistance_f(const Ray &ray, float *tDist,
+        Point &Psample, float *pdf, RNG &rng, const int &wl) const {
+    // Compute the sampling step in the emission band
+    Vector w = -ray.d;
+    float t = -log(1 - rng.RandomFloat()) / Sigma_tf(ray.o, w, ray.time, wl);
+    *tDist = ray.mint + t;
+    Psample = ray(t);
+
+    if (!extent.Inside(Psample)) {
+        return false;
+    } else {
+        // Compute the PDF that is associated with this sample
+        float extenctionCoeff = Sigma_tf(Psample, w, ray.time, wl);
+        float samplePdf = extenctionCoeff * exp(-extenctionCoeff * t);
+        *pdf = samplePdf;
+        return true;
+    }
+}
+
+
 bool TissueLayer::SampleDirection(const Point &p, const Vector& wi,
         Vector& wo, float* pdf, RNG &rng) const {
     const Point Pobj = WorldToVolume(p);
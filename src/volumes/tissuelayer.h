@@ -183,6 +183,12 @@ public:
         return Distance(ray(t0), ray(t1)) *
                 ((sigma_a.Power(wl) + sigma_s.Power(wl)) * density);
     }
+    float tauLambda_f(const Ray &ray, float, float, const int &wl) const {
+        float t0, t1;
+        if (!IntersectP(ray, &t0, &t1)) return 0.;
+        // Optical thickness of the emission band
+        return Distance(ray(t0), ray(t1)) * MaxSigma_tf(wl);
+    }
 
     // Medium Sampling
     bool SampleDistance(const Ray& ray, float* tDist, Point &Psample,
@@ -198,6 +204,8 @@ public:
     // Medium Sampling at Specific Wavelength _wl_
     bool SampleDistance(const Ray& ray, float* tDist, Point &Psample,
         float* pdf, RNG &rng, const int &wl) const;
+    bool SampleDistance_f(const Ray& ray, float* tDist, Point &Psample,
+        float* pdf, RNG &rng, const int &wl) const;
 
 private:
     // TissueLayer Private Data
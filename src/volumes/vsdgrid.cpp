@@ -130,16 +130,22 @@ VSDVolumeGrid *CreateVSDGridVolumeRegion(const Transform &volume2world,
     Point p0 = params.FindOnePoint("p0", Point(0,0,0));
     Point p1 = params.FindOnePoint("p1", Point(1,1,1));
     std::string format = params.FindOneString("format", "pbrt");
-    float* data;
-    if (format == std::string("raw")) {
+    if (format == std::string("raw") || format == std::string("floatraw")) {
         std::string prefix = params.FindOneString("prefix", "");
         Info("Reading a RAW volume from %s \n", prefix.c_str());
         uint64 nx, ny, nz;
         float maxValue;
-        data = ReadVSDVolume(prefix, nx, ny, nz, p0.x, p0.y, p0.z,
-                             p1.x, p1.y, p1.z, maxValue);
+        const bool floatingPoint = (format == std::string("floatraw"));
+        MappedFile *voxels = floatingPoint ?
+            MapVSDFloatVolume(prefix, nx, ny, nz, p0.x, p0.y, p0.z,
+                              p1.x, p1.y, p1.z, maxValue) :
+            MapVSDVolume(prefix, nx, ny, nz, p0.x, p0.y, p0.z,
+                         p1.x, p1.y, p1.z, maxValue);
+        if (!voxels)
+            return NULL;
         return new VSDVolumeGrid(sigma_a, sigma_s, g, Le, BBox(p0, p1),
-                                     volume2world, nx, ny, nz, data);
+                                 volume2world, nx, ny, nz, voxels,
+                                 floatingPoint);
 
     } else if (format == std::string("pbrt")) {
         Info("Reading a PBRT volume file with density \n");
@@ -41,6 +41,7 @@
 // volumes/vsdgrid.h*
 #include "volume.h"
 #include <limits>
+#include "volumeutil.h"
 
 using namespace std;
 
@@ -55,7 +56,30 @@ public:
           nx(x), ny(y), nz(z), vsdSignalExtent(e) {
         density = new float[nx*ny*nz];
         memcpy(density, d, nx*ny*nz*sizeof(float));
-
+        voxels = NULL;
+        floatVoxels = NULL;
+        mapping = NULL;
+        SetSemiInfiniteExtent();
+        PreProcess();
+    }
+    VSDVolumeGrid(const Spectrum &sa, const Spectrum &ss, float gg,
+            const Spectrum &em, const BBox &e, const Transform &v2w,
+            uint64 x, uint64 y, uint64 z, MappedFile *v,
+            bool floatingPoint = false)
+        : DensityRegion(sa, ss, gg, em, v2w),
+          nx(x), ny(y), nz(z), vsdSignalExtent(e) {
+        // Scale the voxels on lookup rather than converting them; floating
+        // point volumes hold the 8-bit values before quantization
+        density = NULL;
+        voxels = floatingPoint ? NULL : v->Data();
+        floatVoxels = floatingPoint ? (const float *)v->Data() : NULL;
+        mapping = v;
+        SetSemiInfiniteExtent();
+        PreProcess();
+        mapping->AdviseRandom();
+    }
+     ~VSDVolumeGrid() { delete[] density; delete mapping; }
+    void SetSemiInfiniteExtent() {
         // Set the parameters of the semi infinite extent.
         semiInfiniteExtent.pMin.x = vsdSignalExtent.pMin.x * 1000;
         semiInfiniteExtent.pMin.y = vsdSignalExtent.pMin.y;
@@ -63,10 +87,7 @@ public:
         semiInfiniteExtent.pMax.x = vsdSignalExtent.pMax.x * 1000;
         semiInfiniteExtent.pMax.y = vsdSignalExtent.pMax.y;
         semiInfiniteExtent.pMax.z = vsdSignalExtent.pMax.z * 1000;
-
-        PreProcess();
     }
-     ~VSDVolumeGrid() { delete[] density; }
     void PreProcess();
     BBox WorldBound() const { return Inverse(WorldToVolume)(semiInfiniteExtent); }
     bool IntersectP(const Ray &r, float *t0, float *t1) const {
@@ -84,12 +105,17 @@ public:
         x = Clamp(x, 0, nx-1);
         y = Clamp(y, 0, ny-1);
         z = Clamp(z, 0, nz-1);
-        return density[z*nx*ny + y*nx + x];
+        const uint64 index = z*nx*ny + y*nx + x;
+        if (density) return density[index];
+        return vsdVoxelScale * (floatVoxels ? floatVoxels[index] : voxels[index]);
     }
 
 private:
     // VSDVolumeGrid Private Data
     float *density;
+    const uint8 *voxels;
+    const float *floatVoxels;
+    MappedFile *mapping;
     const uint64 nx, ny, nz;
     BBox semiInfiniteExtent, vsdSignalExtent;
 };
@@ -30,6 +30,7 @@
  */
 
 #include "vsdgrid.h"
+#include "memory.h"
 #include <fstream>
 #include <string>
 #include <limits>
@@ -41,10 +42,27 @@
 
 using namespace std;
 
+bool VSDReconstructionFromString(const string &name,
+                                 VSDReconstruction *reconstruction) {
+    if (name == "nearest")
+        *reconstruction = VSD_RECONSTRUCTION_NEAREST;
+    else if (name == "trilinear")
+        *reconstruction = VSD_RECONSTRUCTION_TRILINEAR;
+    else if (name == "gaussian")
+        *reconstruction = VSD_RECONSTRUCTION_GAUSSIAN;
+    else
+        return false;
+    return true;
+}
+
+
 VSDGrid::VSDGrid(const int &nxx, const int &nyy, const int &nzz,
-                 const BBox bb) :
-    nx(nxx), ny(nyy), nz(nzz), nxyz(nx * ny * nz), bbox(bb)
+                 const BBox bb, VSDReconstruction r, float gr) :
+    nx(nxx), ny(nyy), nz(nzz), nxyz(uint64_t(nx) * ny * nz), bbox(bb),
+    reconstruction(r), gaussianRadius(max(gr, sqrtf(3.f) / 2.f))
 {
+    // The minimum radius reaches the center of the voxel that contains the
+    // event wherever the event lies in it
     // Allocate the volume grid and initialize it
     density = new float[nxyz];
     for(uint64_t i = 0; i < nxyz; i++) density[i] = 0.f;
@@ -58,15 +76,77 @@ VSDGrid::VSDGrid(const int &nxx, const int &nyy, const int &nzz,
 
 void VSDGrid::AddEvent(const VSDEvent *event)
 {
-    // Sample the events along the grid
-    uint64_t vx = nx * (floor(event->p.x - bbox.pMin.x) /
-                   (bbox.pMax.x - bbox.pMin.x));
-    uint64_t vy = ny * (floor(event->p.y - bbox.pMin.y) /
-                   (bbox.pMax.y - bbox.pMin.y));
-    uint64_t vz = nz * (floor(event->p.z - bbox.pMin.z) /
-                   (bbox.pMax.z - bbox.pMin.z));
-    uint64_t voxelIndex(vx + nx * vy + nx * ny * vz);
-    density[voxelIndex] += event->power;
+    AddEvent(event->p, event->power);
+}
+
+
+void VSDGrid::AddEvent(const Point &p, float power)
+{
+    // Events outside the grid are not recorded
+    if (!bbox.Inside(p))
+        return;
+
+    // Continuous voxel coordinates of the event
+    const float vx = (p.x - bbox.pMin.x) / dx;
+    const float vy = (p.y - bbox.pMin.y) / dy;
+    const float vz = (p.z - bbox.pMin.z) / dz;
+
+    switch (reconstruction) {
+    case VSD_RECONSTRUCTION_NEAREST:
+        // The voxel that contains the event; the clamp in _Splat()_ keeps
+        // events on the upper faces of the grid inside it
+        Splat(Floor2Int(vx), Floor2Int(vy), Floor2Int(vz), power);
+        break;
+    case VSD_RECONSTRUCTION_TRILINEAR: {
+        // Split the power between the eight voxel centers around the event
+        const float ux = vx - 0.5f, uy = vy - 0.5f, uz = vz - 0.5f;
+        const int x0 = Floor2Int(ux), y0 = Floor2Int(uy), z0 = Floor2Int(uz);
+        const float fx = ux - x0, fy = uy - y0, fz = uz - z0;
+        for (int k = 0; k < 2; ++k)
+            for (int j = 0; j < 2; ++j)
+                for (int i = 0; i < 2; ++i)
+                    Splat(x0 + i, y0 + j, z0 + k, power *
+                          (i ? fx : 1.f - fx) * (j ? fy : 1.f - fy) *
+                          (k ? fz : 1.f - fz));
+        break;
+    }
+    case VSD_RECONSTRUCTION_GAUSSIAN: {
+        // Spread the power over the voxels within _gaussianRadius_ voxels,
+        // with a standard deviation of half the radius
+        const int r = Ceil2Int(gaussianRadius);
+        const int cx = Floor2Int(vx), cy = Floor2Int(vy), cz = Floor2Int(vz);
+        const int width = 2 * r + 1;
+        float *weights = ALLOCA(float, width * width * width);
+        const float invTwoSigma2 = 2.f / (gaussianRadius * gaussianRadius);
+        float weightSum = 0.f;
+        int w = 0;
+        for (int k = -r; k <= r; ++k)
+            for (int j = -r; j <= r; ++j)
+                for (int i = -r; i <= r; ++i, ++w) {
+                    const float ddx = cx + i + 0.5f - vx;
+                    const float ddy = cy + j + 0.5f - vy;
+                    const float ddz = cz + k + 0.5f - vz;
+                    const float d2 = ddx * ddx + ddy * ddy + ddz * ddz;
+                    weights[w] = d2 > gaussianRadius * gaussianRadius ?
+                        0.f : expf(-d2 * invTwoSigma2);
+                    weightSum += weights[w];
+                }
+        if (weightSum == 0.f) {
+            // Only an event on a voxel corner is as far as the minimum
+            // radius from all the centers around it
+            Splat(cx, cy, cz, power);
+            break;
+        }
+        const float scale = power / weightSum;
+        w = 0;
+        for (int k = -r; k <= r; ++k)
+            for (int j = -r; j <= r; ++j)
+                for (int i = -r; i <= r; ++i, ++w)
+                    if (weights[w] > 0.f)
+                        Splat(cx + i, cy + j, cz + k, scale * weights[w]);
+        break;
+    }
+    }
 }
 
 
@@ -230,32 +310,16 @@ void VSDGrid::WritePBRTVolumeFile(const string &outputDir, const string &prefix,
 }
 
 
-void VSDGrid::WriteRAWVolumeFile(const string &outputDir, const string &prefix,
-        const Vector &translation) {
-    string rawFileName = outputDir + "/" + prefix + "_volume.raw";
-    ofstream rawFileStream;
-    rawFileStream.open(rawFileName.c_str(), ios::binary);
-
-    // Get the maximum value
+float VSDGrid::MaxValue() const {
     float maxValue = 0.0;
-    uint64_t index = 0;
-    for (uint64_t i = 0; i < nx; i++)
-        for (uint64_t j = 0; j < ny; j++)
-            for (uint64_t k = 0; k < nz; k++) {
-                if (density[index] > maxValue) maxValue = density[index];
-                index++;
-            }
-    // Normalize
-    index = 0;
-    for (uint64_t i = 0; i < nx; i++)
-        for (uint64_t j = 0; j < ny; j++)
-            for (uint64_t k = 0; k < nz; k++) {
-                rawFileStream << uint8_t(int(255 * (density[index] / maxValue)));
-                index++;
-            }
-    rawFileStream.close();
+    for (uint64_t i = 0; i < nxyz; i++)
+        if (density[i] > maxValue) maxValue = density[i];
+    return maxValue;
+}
 
-    // Write the header file
+
+void VSDGrid::WriteHeaderFile(const string &outputDir, const string &prefix,
+        const Vector &translation, float maxValue) const {
     string hdrFileName = outputDir + "/" + prefix + "_volume.hdr";
     ofstream hdrFileStream;
     hdrFileStream.open(hdrFileName.c_str());
@@ -272,3 +336,48 @@ void VSDGrid::WriteRAWVolumeFile(const string &outputDir, const string &prefix,
                   << bbox.Depth()                   << " ";
     hdrFileStream.close();
 }
+
+
+void VSDGrid::WriteRAWVolumeFile(const string &outputDir, const string &prefix,
+        const Vector &translation) {
+    string rawFileName = outputDir + "/" + prefix + "_volume.raw";
+    ofstream rawFileStream;
+    rawFileStream.open(rawFileName.c_str(), ios::binary);
+
+    // Normalize to 8 bits and write the voxels in one go
+    const float maxValue = MaxValue();
+    const float scale = maxValue > 0.f ? 255.f / maxValue : 0.f;
+    uint8_t *voxels = new uint8_t[nxyz];
+    for (uint64_t i = 0; i < nxyz; i++)
+        voxels[i] = uint8_t(int(scale * density[i]));
+    rawFileStream.write((const char *)voxels, nxyz);
+    rawFileStream.close();
+    delete[] voxels;
+
+    // Write the header file
+    WriteHeaderFile(outputDir, prefix, translation, maxValue);
+}
+
+
+void VSDGrid::WriteFloatVolumeFile(const string &outputDir,
+        const string &prefix, const Vector &translation) {
+    // Same normalization as the 8-bit volume, without the quantization, so
+    // that _VSDVolumeGrid_ can map either file with the same header
+    string fileName = outputDir + "/" + prefix + "_volume.fraw";
+    ofstream fileStream;
+    fileStream.open(fileName.c_str(), ios::binary);
+    const float maxValue = MaxValue();
+    const float scale = maxValue > 0.f ? 255.f / maxValue : 0.f;
+    const uint64_t chunkSize = 1 << 20;
+    float *voxels = new float[min(chunkSize, nxyz)];
+    for (uint64_t first = 0; first < nxyz; first += chunkSize) {
+        const uint64_t count = min(chunkSize, nxyz - first);
+        for (uint64_t i = 0; i < count; i++)
+            voxels[i] = scale * density[first + i];
+        fileStream.write((const char *)voxels, count * sizeof(float));
+    }
+    fileStream.close();
+    delete[] voxels;
+
+    WriteHeaderFile(outputDir, prefix, translation, maxValue);
+}
@@ -40,15 +40,34 @@
 
 // vsd/volumegrid.h*
 #include "geometry.h"
+#include "parallel.h"
 #include "vsdevent.h"
 
+// VSDReconstruction Declarations
+// How the power of an event is spread over the voxels around it.  The
+// trilinear and Gaussian kernels are normalized, so they conserve power.
+enum VSDReconstruction {
+    VSD_RECONSTRUCTION_NEAREST,
+    VSD_RECONSTRUCTION_TRILINEAR,
+    VSD_RECONSTRUCTION_GAUSSIAN
+};
+
+bool VSDReconstructionFromString(const std::string &name,
+                                 VSDReconstruction *reconstruction);
+
+
 // VSDGrid Declarations
 class VSDGrid
 {
 public:
     // VSDGrid Public Methods
-    VSDGrid(const int &nxx, const int &nyy, const int &nzz, const BBox bb);
+    VSDGrid(const int &nxx, const int &nyy, const int &nzz, const BBox bb,
+            VSDReconstruction r = VSD_RECONSTRUCTION_NEAREST,
+            float gaussianRadius = 1.5f);
+    ~VSDGrid() { delete[] density; }
+    // Safe to call concurrently, the voxels are updated atomically
     void AddEvent(const VSDEvent *event);
+    void AddEvent(const Point &p, float power);
     void GeneratePBRTConfiguration(const string &outputDir, const string &prefix,
             const std::string &simulationMethod, const int &gridBaseResolution,
             const int &sensorBaseResolution, const Point &sensorPosition,
@@ -58,13 +77,29 @@ public:
             const Vector &translation);
     void WriteRAWVolumeFile(const string &outputDir, const string &prefix,
             const Vector &translation);
+    void WriteFloatVolumeFile(const string &outputDir, const string &prefix,
+            const Vector &translation);
     float* Data() { return density; }
 private:
+    // VSDGrid Private Methods
+    float MaxValue() const;
+    void WriteHeaderFile(const string &outputDir, const string &prefix,
+            const Vector &translation, float maxValue) const;
+    void Splat(int x, int y, int z, float value) {
+        x = Clamp(x, 0, nx - 1);
+        y = Clamp(y, 0, ny - 1);
+        z = Clamp(z, 0, nz - 1);
+        AtomicAdd(&density[x + uint64_t(nx) * (y + uint64_t(ny) * z)], value);
+    }
+
     // VSDGrid Private Data
     float *density;
-    int nx, ny, nz, nxyz;
+    int nx, ny, nz;
+    uint64_t nxyz;
     float dx, dy, dz;
     BBox bbox;
+    VSDReconstruction reconstruction;
+    float gaussianRadius;
 };
 
 #endif // PBRT_VSD_VSDGRID_H
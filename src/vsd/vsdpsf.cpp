@@ -0,0 +1,416 @@
+
+/*
+    pbrt source code Copyright(c) 2016 Marwan Abdellah.
+                                  Blue Brain Project (BBP) / EPFL
+
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+// vsd/vsdpsf.cpp*
+#include "vsdpsf.h"
+#include "scene.h"
+#include "sensor.h"
+#include "volume.h"
+#include "montecarlo.h"
+#include "parallel.h"
+#include "photontracer.h"
+#include "shard.h"
+
+using namespace std;
+
+// VSDPointSpreadFunction Local Declarations
+// Header of the cached kernels.  The kernels are only reused for the same
+// sensor, depth range and volume bounds, and for the same optical properties
+// of the medium at the emitters, which follow the header.
+struct VSDPSFFileHeader {
+    char magic[8];
+    uint32_t nDepths, radius;
+    uint64_t nPhotons;
+    uint64_t xPixels, yPixels;
+    float depthMin, depthMax;
+    float filmWidth, filmHeight;
+    float volumeMin[3], volumeMax[3];
+};
+
+
+class VSDPSFPhotonTracer : public PhotonTracer {
+public:
+    VSDPSFPhotonTracer(const VSDPointSpreadFunction *p) : psf(p) { }
+    void Trace(uint64_t photon, RNG &rng) { psf->TracePhoton(photon, rng); }
+private:
+    const VSDPointSpreadFunction *psf;
+};
+
+
+// Radix-2 transform of _n_ values in place; _twiddles_ holds the _n_ / 2
+// roots of unity of the forward transform.
+static void FFT(complex<float> *a, uint32_t n,
+                const complex<float> *twiddles, bool inverse) {
+    // Reorder the values by bit-reversed index
+    for (uint32_t i = 1, j = 0; i < n; ++i) {
+        uint32_t bit = n >> 1;
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+        if (i < j) swap(a[i], a[j]);
+    }
+
+    // Combine the transforms of increasing length
+    for (uint32_t length = 2; length <= n; length <<= 1) {
+        const uint32_t half = length / 2, step = n / length;
+        for (uint32_t i = 0; i < n; i += length) {
+            for (uint32_t j = 0; j < half; ++j) {
+                const complex<float> w = inverse ?
+                    conj(twiddles[j * step]) : twiddles[j * step];
+                const complex<float> u = a[i + j];
+                const complex<float> v = a[i + j + half] * w;
+                a[i + j] = u + v;
+                a[i + j + half] = u - v;
+            }
+        }
+    }
+}
+
+
+static vector<complex<float> > Twiddles(uint32_t n) {
+    vector<complex<float> > twiddles(max(n / 2, 1u));
+    for (uint32_t k = 0; k < n / 2; ++k)
+        twiddles[k] = complex<float>(cos(-2. * M_PI * k / n),
+                                     sin(-2. * M_PI * k / n));
+    return twiddles;
+}
+
+
+// Unnormalized 2D transform of an _nx_ x _ny_ image, x varying fastest
+static void FFT2D(complex<float> *data, uint32_t nx, uint32_t ny,
+                  bool inverse) {
+    const vector<complex<float> > xTwiddles = Twiddles(nx);
+    const vector<complex<float> > yTwiddles = Twiddles(ny);
+    ParallelFor(0, ny, 16, [&](int64_t y) {
+        FFT(&data[y * nx], nx, &xTwiddles[0], inverse);
+    });
+    ParallelFor(0, nx, 16, [&](int64_t x) {
+        vector<complex<float> > column(ny);
+        for (uint32_t y = 0; y < ny; ++y)
+            column[y] = data[y * nx + x];
+        FFT(&column[0], ny, &yTwiddles[0], inverse);
+        for (uint32_t y = 0; y < ny; ++y)
+            data[y * nx + x] = column[y];
+    });
+}
+
+
+// VSDPointSpreadFunction Method Definitions
+VSDPointSpreadFunction::VSDPointSpreadFunction(uint32_t ndepths,
+        uint32_t r, uint64_t nphotons)
+    : nDepths(max(ndepths, 1u)), radius(r), kernelWidth(2 * r + 1),
+      nPhotons(max(nphotons, uint64_t(1))), xPixels(0), yPixels(0),
+      depthMin(0.f), depthMax(0.f), kernels(NULL), scene(NULL),
+      sensor(NULL), xCenter(0), yCenter(0), fftWidth(0), fftHeight(0) {
+}
+
+
+VSDPointSpreadFunction::~VSDPointSpreadFunction() {
+    delete[] kernels;
+    for (size_t i = 0; i < spectra.size(); i++)
+        delete[] spectra[i];
+}
+
+
+void VSDPointSpreadFunction::Prepare(const string &filename,
+        const Scene *s, const Sensor *snsr) {
+    scene = s;
+    sensor = snsr;
+    VolumeRegion *vr = scene->volumeRegion;
+    if (!vr)
+        Severe("The point-spread function needs a volume region");
+    xPixels = sensor->NumberPixelsX();
+    yPixels = sensor->NumberPixelsY();
+    xCenter = xPixels / 2;
+    yCenter = yPixels / 2;
+
+    // Tabulate the depths of the volume in front of the sensor
+    const BBox bound = vr->WorldBound();
+    depthMin = INFINITY;
+    depthMax = -INFINITY;
+    for (int i = 0; i < 8; ++i) {
+        const Point corner(bound[i & 1].x, bound[(i >> 1) & 1].y,
+                           bound[(i >> 2) & 1].z);
+        float x, y, depth;
+        sensor->FilmPosition(corner, &x, &y, &depth);
+        depthMin = min(depthMin, depth);
+        depthMax = max(depthMax, depth);
+    }
+    depthMin = max(depthMin, 0.f);
+    if (!(depthMax > depthMin))
+        Severe("The volume region is not in front of the sensor \"%s\"",
+               sensor->ReferenceString().c_str());
+
+    // The linear convolution of the padded events with the kernels
+    fftWidth = RoundUpPow2(xPixels + 4 * radius);
+    fftHeight = RoundUpPow2(yPixels + 4 * radius);
+    for (size_t i = 0; i < spectra.size(); i++)
+        delete[] spectra[i];
+    spectra.assign(nDepths, NULL);
+
+    delete[] kernels;
+    kernels = new float[nDepths * kernelWidth * kernelWidth];
+    if (filename.empty() || !Read(filename)) {
+        Estimate();
+        if (!filename.empty())
+            Write(filename);
+    }
+}
+
+
+bool VSDPointSpreadFunction::Read(const string &filename) {
+    FILE *file = fopen(filename.c_str(), "rb");
+    if (!file)
+        return false;
+    VSDPSFFileHeader header, expected;
+    memset(&expected, 0, sizeof(expected));
+    memcpy(expected.magic, "PBRTPSF2", 8);
+    expected.nDepths = nDepths;
+    expected.radius = radius;
+    expected.nPhotons = nPhotons;
+    expected.xPixels = xPixels;
+    expected.yPixels = yPixels;
+    expected.depthMin = depthMin;
+    expected.depthMax = depthMax;
+    expected.filmWidth = sensor->FilmWidth_um();
+    expected.filmHeight = sensor->FilmHeight_um();
+    const BBox bound = scene->volumeRegion->WorldBound();
+    for (int i = 0; i < 3; ++i) {
+        expected.volumeMin[i] = bound.pMin[i];
+        expected.volumeMax[i] = bound.pMax[i];
+    }
+    const vector<float> properties = OpticalProperties();
+    vector<float> cachedProperties(properties.size());
+    const size_t nValues = nDepths * kernelWidth * kernelWidth;
+    bool read = fread(&header, sizeof(header), 1, file) == 1 &&
+        memcmp(&header, &expected, sizeof(header)) == 0 &&
+        fread(&cachedProperties[0], sizeof(float), properties.size(),
+              file) == properties.size() &&
+        cachedProperties == properties &&
+        fread(kernels, sizeof(float), nValues, file) == nValues;
+    fclose(file);
+    if (read)
+        Info("Reusing the point-spread function in \"%s\"", filename.c_str());
+    else
+        Info("\"%s\" was estimated for another configuration, estimating "
+             "the point-spread function again", filename.c_str());
+    return read;
+}
+
+
+bool VSDPointSpreadFunction::Write(const string &filename) const {
+    VSDPSFFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, "PBRTPSF2", 8);
+    header.nDepths = nDepths;
+    header.radius = radius;
+    header.nPhotons = nPhotons;
+    header.xPixels = xPixels;
+    header.yPixels = yPixels;
+    header.depthMin = depthMin;
+    header.depthMax = depthMax;
+    header.filmWidth = sensor->FilmWidth_um();
+    header.filmHeight = sensor->FilmHeight_um();
+    const BBox bound = scene->volumeRegion->WorldBound();
+    for (int i = 0; i < 3; ++i) {
+        header.volumeMin[i] = bound.pMin[i];
+        header.volumeMax[i] = bound.pMax[i];
+    }
+    FILE *file = fopen(filename.c_str(), "wb");
+    if (!file) {
+        Error("Cannot open \"%s\" for writing", filename.c_str());
+        return false;
+    }
+    const vector<float> properties = OpticalProperties();
+    const size_t nValues = nDepths * kernelWidth * kernelWidth;
+    const bool written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+        fwrite(&properties[0], sizeof(float), properties.size(), file) ==
+        properties.size() &&
+        fwrite(kernels, sizeof(float), nValues, file) == nValues;
+    fclose(file);
+    if (!written)
+        Error("Writing the point-spread function to \"%s\" failed",
+              filename.c_str());
+    return written;
+}
+
+
+vector<float> VSDPointSpreadFunction::OpticalProperties() const {
+    // The photons only see the luminance of the coefficients, which covers
+    // their spectral dependence
+    vector<float> properties;
+    properties.reserve(3 * nDepths);
+    for (uint32_t depth = 0; depth < nDepths; ++depth) {
+        const Point p = sensor->FilmPoint(xCenter + .5f, yCenter + .5f,
+                                          DepthBinCenter(depth));
+        MediumProperties mp;
+        scene->volumeRegion->Lookup(p, &mp);
+        properties.push_back(mp.sigma_a.y());
+        properties.push_back(mp.sigma_s.y());
+        properties.push_back(mp.g);
+    }
+    return properties;
+}
+
+
+void VSDPointSpreadFunction::Estimate() {
+    // The hits are counted first, exactly as long as no offset receives
+    // more than 2^24 photons, and then normalized per emitted photon
+    const uint64_t nValues = uint64_t(nDepths) * kernelWidth * kernelWidth;
+    for (uint64_t i = 0; i < nValues; i++)
+        kernels[i] = 0.f;
+    VSDPSFPhotonTracer tracer(this);
+    TracePhotons(&tracer, nDepths * nPhotons,
+                 "Estimating the point-spread function");
+    const float scale = 1.f / nPhotons;
+    for (uint64_t i = 0; i < nValues; i++)
+        kernels[i] *= scale;
+}
+
+
+void VSDPointSpreadFunction::TracePhoton(uint64_t photon, RNG &rng) const {
+    // Emit the photon below the center pixel of the sensor and let it
+    // scatter through the volume as in the photon random walk
+    const uint32_t depth = photon / nPhotons;
+    VolumeRegion *vr = scene->volumeRegion;
+    Point p = sensor->FilmPoint(xCenter + .5f, yCenter + .5f,
+                                DepthBinCenter(depth));
+    while (vr->WorldBound().Inside(p)) {
+        const Vector wo = UniformSampleSphere(rng.RandomFloat(),
+                                              rng.RandomFloat());
+        Ray ray(p, wo, 0, INFINITY);
+
+        // A photon whose next interaction is outside the volume escapes
+        // and flies freely
+        float tDist, distancePdf;
+        Point pNext;
+        if (!vr->SampleDistance(ray, &tDist, pNext, &distancePdf, rng))
+            tDist = INFINITY;
+
+        // Count the hit at its pixel offset from the emitter
+        float tHit;
+        if (sensor->Hit(ray, &tHit, tDist)) {
+            float x, y, hitDepth;
+            sensor->FilmPosition(ray(tHit), &x, &y, &hitDepth);
+            const int kx = Floor2Int(x) - int(xCenter) + int(radius);
+            const int ky = Floor2Int(y) - int(yCenter) + int(radius);
+            if (kx >= 0 && kx < int(kernelWidth) &&
+                ky >= 0 && ky < int(kernelWidth))
+                AtomicAdd(&kernels[(depth * kernelWidth + ky) * kernelWidth +
+                                   kx], 1.f);
+            return;
+        }
+        if (tDist == INFINITY)
+            return;
+        p = ray(tDist);
+
+        // Absorption or scattering at the new interaction point
+        const Spectrum sigma_a = vr->Sigma_a(p, Vector(0, 0, 0), 0);
+        const Spectrum sigma_t = vr->Sigma_t(p, Vector(0, 0, 0), 0);
+        if (sigma_a.y() / sigma_t.y() > rng.RandomFloat())
+            return;
+    }
+}
+
+
+const complex<float> *VSDPointSpreadFunction::KernelSpectrum(
+        uint32_t depth) {
+    if (!spectra[depth]) {
+        const uint64_t nValues = uint64_t(fftWidth) * fftHeight;
+        complex<float> *spectrum = new complex<float>[nValues];
+        for (uint64_t i = 0; i < nValues; i++)
+            spectrum[i] = 0.f;
+        const float *kernel = &kernels[depth * kernelWidth * kernelWidth];
+        for (uint32_t y = 0; y < kernelWidth; ++y)
+            for (uint32_t x = 0; x < kernelWidth; ++x)
+                spectrum[y * fftWidth + x] = kernel[y * kernelWidth + x];
+        FFT2D(spectrum, fftWidth, fftHeight, false);
+        spectra[depth] = spectrum;
+    }
+    return spectra[depth];
+}
+
+
+void VSDPointSpreadFunction::Render(const VSDSprite &sprite, Sensor *snsr) {
+    // Bin the events in depth over the sensor pixels, with a margin of
+    // the kernel radius for the events that still reach the sensor
+    const uint32_t gridWidth = xPixels + 2 * radius;
+    const uint32_t gridHeight = yPixels + 2 * radius;
+    vector<vector<float> > slabs(nDepths);
+    uint64_t firstEvent, endEvent;
+    ShardRange(sprite.GetNumberEvents(), &firstEvent, &endEvent);
+    for (uint64_t i = firstEvent; i < endEvent; i++) {
+        float x, y, depth;
+        snsr->FilmPosition(sprite.GetEventPosition(i), &x, &y, &depth);
+        if (depth < 0.f)
+            continue;
+        const int bin = Clamp(Floor2Int((depth - depthMin) /
+            (depthMax - depthMin) * nDepths), 0, int(nDepths) - 1);
+        const int gx = Floor2Int(x) + int(radius);
+        const int gy = Floor2Int(y) + int(radius);
+        if (gx < 0 || gx >= int(gridWidth) || gy < 0 || gy >= int(gridHeight))
+            continue;
+        if (slabs[bin].empty())
+            slabs[bin].resize(uint64_t(gridWidth) * gridHeight, 0.f);
+        slabs[bin][gy * gridWidth + gx] += 1.f;
+    }
+
+    // Sum the products of the spectra of the bins and of their kernels
+    const uint64_t nValues = uint64_t(fftWidth) * fftHeight;
+    vector<complex<float> > sum(nValues, 0.f), slab(nValues);
+    for (uint32_t d = 0; d < nDepths; ++d) {
+        if (slabs[d].empty())
+            continue;
+        for (uint64_t i = 0; i < nValues; i++)
+            slab[i] = 0.f;
+        for (uint32_t y = 0; y < gridHeight; ++y)
+            for (uint32_t x = 0; x < gridWidth; ++x)
+                slab[y * fftWidth + x] = slabs[d][y * gridWidth + x];
+        FFT2D(&slab[0], fftWidth, fftHeight, false);
+        const complex<float> *kernel = KernelSpectrum(d);
+        ParallelFor(0, fftHeight, 16, [&](int64_t y) {
+            for (uint64_t i = y * fftWidth; i < (y + 1) * fftWidth; i++)
+                sum[i] += slab[i] * kernel[i];
+        });
+    }
+    FFT2D(&sum[0], fftWidth, fftHeight, true);
+
+    // The sensor pixels start after the margin and the kernel radius
+    const float scale = 1.f / nValues;
+    vector<float> image(xPixels * yPixels);
+    for (uint64_t y = 0; y < yPixels; ++y)
+        for (uint64_t x = 0; x < xPixels; ++x)
+            image[y * xPixels + x] = max(0.f, scale *
+                sum[(y + 2 * radius) * fftWidth + x + 2 * radius].real());
+    snsr->AddFilm(&image[0]);
+}
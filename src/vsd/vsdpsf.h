@@ -0,0 +1,94 @@
+
+/*
+    pbrt source code Copyright(c) 2016 Marwan Abdellah.
+                                  Blue Brain Project (BBP) / EPFL
+
+
+    This file is part of pbrt.
+
+    Redistribution and use in source and binary forms, with or without
+    modification, are permitted provided that the following conditions are
+    met:
+
+    - Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+
+    - Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+    THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+    IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+    TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+    PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+    HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+    SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+    LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+    DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+    THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+    (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+    OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ */
+
+#if defined(_MSC_VER)
+#pragma once
+#endif
+
+#ifndef PBRT_VSD_VSDPSF_H
+#define PBRT_VSD_VSDPSF_H
+
+// vsd/vsdpsf.h*
+#include "pbrt.h"
+#include "geometry.h"
+#include "vsdsprite.h"
+#include <complex>
+
+class Scene;
+class Sensor;
+
+// VSDPointSpreadFunction Declarations
+// Response of a sensor to a unit point emitter, tabulated over the depth of
+// the emitter in front of the sensor and the pixel offset of the hits from
+// the emitter.  In a laterally homogeneous tissue the response does not
+// depend on the lateral position of the emitter, so a sprite is rendered by
+// binning its events in depth and convolving each bin with its kernel.
+// The kernels are estimated once, by tracing photons from an emitter below
+// the center of the sensor, and cached in a file.
+class VSDPointSpreadFunction {
+public:
+    // VSDPointSpreadFunction Public Methods
+    VSDPointSpreadFunction(uint32_t ndepths, uint32_t radius,
+                           uint64_t nphotons);
+    ~VSDPointSpreadFunction();
+    void Prepare(const string &filename, const Scene *scene,
+                 const Sensor *sensor);
+    void TracePhoton(uint64_t photon, RNG &rng) const;
+    void Render(const VSDSprite &sprite, Sensor *sensor);
+
+private:
+    // VSDPointSpreadFunction Private Methods
+    bool Read(const string &filename);
+    bool Write(const string &filename) const;
+    vector<float> OpticalProperties() const;
+    void Estimate();
+    float DepthBinCenter(uint32_t depth) const {
+        return depthMin + (depth + .5f) * (depthMax - depthMin) / nDepths;
+    }
+    const std::complex<float> *KernelSpectrum(uint32_t depth);
+
+    // VSDPointSpreadFunction Private Data
+    uint32_t nDepths, radius, kernelWidth;
+    uint64_t nPhotons;
+    uint64_t xPixels, yPixels;
+    float depthMin, depthMax;
+    float *kernels; // _nDepths_ kernels of _kernelWidth_^2 values
+    const Scene *scene;
+    const Sensor *sensor;
+    uint32_t xCenter, yCenter; // Pixel below which the emitter is placed
+    uint32_t fftWidth, fftHeight;
+    vector<std::complex<float> *> spectra; // Kernel spectra, on first use
+};
+
+
+#endif // PBRT_VSD_VSDPSF_H
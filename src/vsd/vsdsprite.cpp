@@ -34,12 +34,31 @@
 #include "vsdsprite.h"
 #include "stdafx.h"
 #include "pbrt.h"
+#include "volumeutil.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <algorithm>
+#ifdef PBRT_IS_WINDOWS
+#include <windows.h>
+#else
+#include <glob.h>
+#endif
 using namespace std;
 
+// VSDSprite Method Definitions
+VSDSprite::VSDSprite()
+    : positionMapping(NULL), intensityMapping(NULL), positions(NULL),
+      intensities(NULL), eventsCount(0) {
+}
+
+
+VSDSprite::~VSDSprite() {
+    Unmap();
+}
+
+
 void VSDSprite::ReadHeaderData(const string &filePath) {
     std::vector<std::string> data;
     std::ifstream file(filePath.c_str());
@@ -101,6 +120,36 @@ void VSDSprite::ReadHeaderData(const string &filePath) {
 }
 
 
+void VSDSprite::MapEvents(const string &datadirectory,
+                          const Vector &translation) {
+    Unmap();
+    offset = translation;
+
+    // Map the events instead of copying them one at a time
+    const std::string pspFilePath = datadirectory + "/" + positionFile;
+    const std::string psiFilePath = datadirectory + "/" + intensityFile;
+    printf("Sources: \n\t[%s]\n\t[%s] \n",
+           pspFilePath.c_str(), psiFilePath.c_str());
+    const uint64_t nEvents = uint64_t(max(eventsCount, 0));
+    positionMapping = MappedFile::Open(pspFilePath,
+                                       3 * nEvents * sizeof(float));
+    intensityMapping = MappedFile::Open(psiFilePath, nEvents * sizeof(float));
+    if (!positionMapping || !intensityMapping)
+        Severe("The sprite files do not hold %d events", eventsCount);
+    positions = (const float *)positionMapping->Data();
+    intensities = (const float *)intensityMapping->Data();
+    printf("The source data has %d fluorescent events \n", eventsCount);
+}
+
+
+void VSDSprite::Unmap() {
+    delete positionMapping;
+    delete intensityMapping;
+    positionMapping = intensityMapping = NULL;
+    positions = intensities = NULL;
+}
+
+
 void VSDSprite::Read(const string &datadirectory, const string &pshfile,
                      const bool computeBoundingBox,
                      const Vector &translation) {
@@ -109,37 +158,8 @@ void VSDSprite::Read(const string &datadirectory, const string &pshfile,
     printf("Header Path \n\t[%s] \n", pshFilePath.c_str());
     ReadHeaderData(pshFilePath);
 
-    // Open the data file and read the fluorescence events
-    std::ifstream positionFileStream, intensityFileStream;
-    const std::string pspFilePath = datadirectory + "/" + positionFile;
-    const std::string psiFilePath = datadirectory + "/" + intensityFile;
-    printf("Sources: \n\t[%s]\n\t[%s] \n",
-           pspFilePath.c_str(), psiFilePath.c_str());
-    positionFileStream.open(pspFilePath.c_str(), std::ios::binary);
-    intensityFileStream.open(psiFilePath.c_str(), std::ios::binary);
-    if(positionFileStream.is_open() && intensityFileStream.is_open()) {
-        for (int i = 0; i < eventsCount; i++) {
-            float x, y, z, intensity;
-            positionFileStream.read(reinterpret_cast<char*>(&x), sizeof(x));
-            positionFileStream.read(reinterpret_cast<char*>(&y), sizeof(y));
-            positionFileStream.read(reinterpret_cast<char*>(&z), sizeof(z));
-            intensityFileStream.read(reinterpret_cast<char*>(&intensity),
-                                     sizeof(intensity));
-            events.push_back(VSDEvent(Point(x , y, z) - translation, intensity));
-        }
-        positionFileStream.close();
-        intensityFileStream.close();
-    }
-
-    // Double check the number of events in the sprite
-    if(events.size() == eventsCount)
-        printf("The source data has %d fluorescent events \n",
-               int(events.size()));
-    else {
-        Severe("Wrong sprite count [Given: %d/ Current: %zu]\n",
-               eventsCount, events.size());
-        exit(EXIT_SUCCESS);
-    }
+    // Map the fluorescence events
+    MapEvents(datadirectory, translation);
 
     if(computeBoundingBox)
         ComputeBoundingBox();
@@ -156,48 +176,18 @@ void VSDSprite::Read(const string &datadirectory, const string &pshfile,
 #endif
     ReadHeaderData(pshFilePath);
 
-    // Open the data file and read the fluorescence events
-    std::ifstream positionFileStream, intensityFileStream;
-    const std::string pspFilePath = datadirectory + "/" + positionFile;
-    const std::string psiFilePath = datadirectory + "/" + intensityFile;
-
-    printf("Sources Paths: \n\t[%s]\n\t[%s] \n",
-           pspFilePath.c_str(), psiFilePath.c_str());
-    positionFileStream.open(pspFilePath.c_str(), std::ios::binary);
-    intensityFileStream.open(psiFilePath.c_str(), std::ios::binary);
-    if(positionFileStream.is_open() && intensityFileStream.is_open()) {
-        for (int i = 0; i < eventsCount; i++) {
-            float x, y, z, intensity;
-            positionFileStream.read(reinterpret_cast<char*>(&x), sizeof(x));
-            positionFileStream.read(reinterpret_cast<char*>(&y), sizeof(y));
-            positionFileStream.read(reinterpret_cast<char*>(&z), sizeof(z));
-            intensityFileStream.read(reinterpret_cast<char*>(&intensity),
-                                     sizeof(intensity));
-            events.push_back(VSDEvent(Point(x , y, z) - shift, intensity));
-        }
-        positionFileStream.close();
-        intensityFileStream.close();
-    }
+    // Map the fluorescence events
+    MapEvents(datadirectory, shift);
 
     // Update the bounding box from the loaded configuration to avoid computing
     // the bounding box of the sprite again
     bbox.pMin = pMin;
     bbox.pMax = pMax;
-
-    // Double check the number of events in the sprite
-    if(events.size() == eventsCount)
-        printf("The source data has %d fluorescent events \n",
-               int(events.size()));
-    else {
-        Severe("The number of the events in the sprite is not right \n");
-        exit(EXIT_SUCCESS);
-    }
 }
 
 
 void VSDSprite::WriteHeaderData(const string &filePath) {
     std::ofstream file(filePath.c_str());
-    file.open(filePath.c_str());
     file << "EventsCount=" << eventsCount << std::endl;
     file << "XCenter=" << center.x << std::endl;
     file << "YCenter=" << center.y << std::endl;
@@ -227,18 +217,37 @@ void VSDSprite::Write(const string &datadirectory, const string &pshfile) {
     const std::string pspFilePath = datadirectory + "/" + positionFile;
     const std::string psiFilePath = datadirectory + "/" + intensityFile;
 
-    positionFileStream.open(pspFilePath.c_str(), std::ios::binary);
-    intensityFileStream.open(psiFilePath.c_str(), std::ios::binary);
+    // The events may be mapped from the very files being written, so write
+    // next to them and swap the files in at the end
+    const std::string pspTempPath = pspFilePath + ".tmp";
+    const std::string psiTempPath = psiFilePath + ".tmp";
+    positionFileStream.open(pspTempPath.c_str(), std::ios::binary);
+    intensityFileStream.open(psiTempPath.c_str(), std::ios::binary);
 
     if(positionFileStream.is_open() && intensityFileStream.is_open()) {
-        for (int i = 0; i < eventsCount; i++) {
-            positionFileStream << events[i].p.x;
-            positionFileStream << events[i].p.y;
-            positionFileStream << events[i].p.z;
-            intensityFileStream << events[i].power;
+        // Write the positions in the layout the sprite is read back with,
+        // with the translation of the sprite applied
+        VSDEventChunk chunk;
+        uint64_t cursor = 0;
+        vector<float> shifted;
+        while (NextChunk(&cursor, 1 << 16, &chunk)) {
+            shifted.resize(3 * chunk.count);
+            for (uint64_t i = 0; i < chunk.count; i++) {
+                shifted[3 * i    ] = chunk.positions[3 * i    ] - offset.x;
+                shifted[3 * i + 1] = chunk.positions[3 * i + 1] - offset.y;
+                shifted[3 * i + 2] = chunk.positions[3 * i + 2] - offset.z;
+            }
+            positionFileStream.write((const char *)&shifted[0],
+                                     shifted.size() * sizeof(float));
+            intensityFileStream.write((const char *)chunk.intensities,
+                                      chunk.count * sizeof(float));
         }
         positionFileStream.close();
         intensityFileStream.close();
+        if (rename(pspTempPath.c_str(), pspFilePath.c_str()) != 0 ||
+            rename(psiTempPath.c_str(), psiFilePath.c_str()) != 0)
+            Error("Cannot write the sprite events to [%s]",
+                  datadirectory.c_str());
     }
 }
 
@@ -246,16 +255,23 @@ void VSDSprite::Write(const string &datadirectory, const string &pshfile) {
 void VSDSprite::ComputeBoundingBox() {
     Point pMin(INFINITY, INFINITY, INFINITY);
     Point pMax(-INFINITY, -INFINITY, -INFINITY);
-    for (int i = 0; i < eventsCount; i++) {
-        VSDEvent &event = events[i];
-
-        if (event.p.x < pMin.x) pMin.x = event.p.x;
-        if (event.p.y < pMin.y) pMin.y = event.p.y;
-        if (event.p.z < pMin.z) pMin.z = event.p.z;
-
-        if (event.p.x > pMax.x) pMax.x = event.p.x;
-        if (event.p.y > pMax.y) pMax.y = event.p.y;
-        if (event.p.z > pMax.z) pMax.z = event.p.z;
+    VSDEventChunk chunk;
+    uint64_t cursor = 0;
+    while (NextChunk(&cursor, 1 << 16, &chunk)) {
+        for (uint64_t i = 0; i < chunk.count; i++) {
+            const float *p = &chunk.positions[3 * i];
+            if (p[0] < pMin.x) pMin.x = p[0];
+            if (p[1] < pMin.y) pMin.y = p[1];
+            if (p[2] < pMin.z) pMin.z = p[2];
+
+            if (p[0] > pMax.x) pMax.x = p[0];
+            if (p[1] > pMax.y) pMax.y = p[1];
+            if (p[2] > pMax.z) pMax.z = p[2];
+        }
+    }
+    if (eventsCount > 0) {
+        pMin = pMin - offset;
+        pMax = pMax - offset;
     }
 
     // Update the bounding box
@@ -286,8 +302,7 @@ void VSDSprite::PrintBoundingBox(string outputDirectory,
 
 void VSDSprite::Shift(const Vector &shift) {
     // Update the sprite data
-    for (int i = 0; i < eventsCount; i++)
-        events[i].p -= shift;
+    offset += shift;
 
     // Update the bounding box
     bbox.pMin = bbox.pMin - shift;
@@ -297,8 +312,7 @@ void VSDSprite::Shift(const Vector &shift) {
 
 void VSDSprite::CenterAtOrigin() {
     // Update the sprite data
-    for (int i = 0; i < eventsCount; i++)
-        events[i].p -= center;
+    offset += center;
 
     // Update the bounding box
     bbox.pMin = bbox.pMin - center;
@@ -316,26 +330,41 @@ string VSDSprite::GetTimeStep() const {
 }
 
 
-float VSDSprite::GetEventIntensity(int i) const {
-    return events[i].power;
-}
-
-
-Point VSDSprite::GetEventPosition(int i) const {
-    return events[i].p;
+bool VSDSprite::NextChunk(uint64_t *cursor, uint64_t chunkSize,
+                          VSDEventChunk *chunk) const {
+    const uint64_t nEvents = uint64_t(max(eventsCount, 0));
+    if (*cursor >= nEvents)
+        return false;
+    chunk->first = *cursor;
+    chunk->count = min(chunkSize, nEvents - *cursor);
+    chunk->positions = positions + 3 * chunk->first;
+    chunk->intensities = intensities + chunk->first;
+    *cursor += chunk->count;
+
+    // Have the following chunk paged in while this one is consumed
+    if (*cursor < nEvents) {
+        const uint64_t next = min(chunkSize, nEvents - *cursor);
+        positionMapping->Prefetch(3 * *cursor * sizeof(float),
+                                  3 * next * sizeof(float));
+        intensityMapping->Prefetch(*cursor * sizeof(float),
+                                   next * sizeof(float));
+    }
+    return true;
 }
 
 
-VSDGrid* VSDSprite::Voxelize(const int resolution) const {
+VSDGrid* VSDSprite::Voxelize(const int resolution,
+                             VSDReconstruction reconstruction,
+                             float gaussianRadius) const {
     // Compute the resolution of the grid
     int xresolution, yresolution, zresolution;
     float largest = bbox.Width();
     if(bbox.Height() > largest) largest = bbox.Height();
     if(bbox.Depth() > largest) largest = bbox.Depth();
 
-    xresolution = (bbox.Width() / largest) * resolution;
-    yresolution = (bbox.Height() / largest) * resolution;
-    zresolution = (bbox.Depth() / largest) * resolution;
+    xresolution = max(1, int((bbox.Width() / largest) * resolution));
+    yresolution = max(1, int((bbox.Height() / largest) * resolution));
+    zresolution = max(1, int((bbox.Depth() / largest) * resolution));
 
 #ifndef DEBUG
     printf("VSDGrid resolution [%d %d %d] \n",
@@ -343,13 +372,20 @@ VSDGrid* VSDSprite::Voxelize(const int resolution) const {
 #endif
 
     // Create the VSD grid
-    VSDGrid* vsdGrid = new VSDGrid(xresolution, yresolution, zresolution, bbox);
-
-    // Sample the events in a Cartesian grid
-    for (int i = 0; i < eventsCount; i++)
-    {
-        vsdGrid->AddEvent(&events[i]);
-    }
+    VSDGrid* vsdGrid = new VSDGrid(xresolution, yresolution, zresolution, bbox,
+                                   reconstruction, gaussianRadius);
+
+    // Sample the events in a Cartesian grid, one chunk of events per task;
+    // the grid takes the events concurrently
+    const uint64_t nEvents = uint64_t(max(eventsCount, 0));
+    const uint64_t chunkSize = 1 << 16;
+    const int64_t nChunks = int64_t((nEvents + chunkSize - 1) / chunkSize);
+    ParallelFor(0, nChunks, 1, [&](int64_t c) {
+        const uint64_t first = uint64_t(c) * chunkSize;
+        const uint64_t last = min(first + chunkSize, nEvents);
+        for (uint64_t i = first; i < last; i++)
+            vsdGrid->AddEvent(GetEventPosition(i), intensities[i]);
+    });
 
     return vsdGrid;
 }
@@ -398,3 +434,88 @@ float ParseFloatParameter(const string line) {
     value = string(tokens[1]);
     return atof(value.c_str());
 }
+
+
+static inline bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+
+// Orders file names with the runs of digits compared by value, so that the
+// unpadded frame numbers of a time series sort as frame2 < frame10
+static bool NaturalLess(const string &a, const string &b) {
+    size_t i = 0, j = 0;
+    while (i < a.size() && j < b.size()) {
+        if (IsDigit(a[i]) && IsDigit(b[j])) {
+            // Compare the digit runs without their leading zeros
+            while (i < a.size() && a[i] == '0') i++;
+            while (j < b.size() && b[j] == '0') j++;
+            size_t ia = i, jb = j;
+            while (ia < a.size() && IsDigit(a[ia])) ia++;
+            while (jb < b.size() && IsDigit(b[jb])) jb++;
+            if (ia - i != jb - j)
+                return ia - i < jb - j;
+            const int order = a.compare(i, ia - i, b, j, jb - j);
+            if (order != 0)
+                return order < 0;
+            i = ia;
+            j = jb;
+            continue;
+        }
+        if (a[i] != b[j])
+            return a[i] < b[j];
+        i++;
+        j++;
+    }
+    if (a.size() - i != b.size() - j)
+        return a.size() - i < b.size() - j;
+    // Equal up to leading zeros, keep the order total
+    return a < b;
+}
+
+
+vector<string> ExpandSpriteSequence(const string &datadirectory,
+                                    const vector<string> &pshfiles) {
+    vector<string> sequence;
+    for (size_t i = 0; i < pshfiles.size(); i++) {
+        // Plain file names are kept as they are
+        if (pshfiles[i].find_first_of("*?[") == string::npos) {
+            sequence.push_back(pshfiles[i]);
+            continue;
+        }
+
+        // Expand the pattern relative to the data directory, in name order
+        // with the frame numbers compared by value
+        const string pattern = datadirectory + "/" + pshfiles[i];
+        vector<string> expanded;
+#ifdef PBRT_IS_WINDOWS
+        // FindFirstFile() only expands * and ? in the last component and
+        // returns the bare file names
+        const size_t slash = pshfiles[i].find_last_of("/\\");
+        const string directory = slash == string::npos ? "" :
+                                 pshfiles[i].substr(0, slash + 1);
+        WIN32_FIND_DATAA match;
+        HANDLE find = FindFirstFileA(pattern.c_str(), &match);
+        if (find == INVALID_HANDLE_VALUE) {
+            Warning("No sprite matches the pattern [%s]", pattern.c_str());
+            continue;
+        }
+        do {
+            if (!(match.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+                expanded.push_back(directory + match.cFileName);
+        } while (FindNextFileA(find, &match));
+        FindClose(find);
+#else
+        glob_t matches;
+        if (glob(pattern.c_str(), 0, NULL, &matches) != 0) {
+            Warning("No sprite matches the pattern [%s]", pattern.c_str());
+            continue;
+        }
+        for (size_t j = 0; j < matches.gl_pathc; j++)
+            expanded.push_back(string(matches.gl_pathv[j]).substr(
+                datadirectory.size() + 1));
+        globfree(&matches);
+#endif // PBRT_IS_WINDOWS
+        sort(expanded.begin(), expanded.end(), NaturalLess);
+        sequence.insert(sequence.end(), expanded.begin(), expanded.end());
+    }
+    return sequence;
+}
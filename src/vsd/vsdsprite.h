@@ -41,12 +41,28 @@
 #include "vsdgrid.h"
 #include "vsdevent.h"
 
+class MappedFile;
+
+// VSDEventChunk Declarations
+// A contiguous run of sprite events.  The positions are stored as x, y, z
+// triplets as they are in the .psp file, and still have to be offset by
+// the translation of the sprite, see _VSDSprite::GetEventOffset()_.
+struct VSDEventChunk {
+    uint64_t first, count;
+    const float *positions;
+    const float *intensities;
+};
+
+
 // VSDSprite Declarations
+// The events are not copied out of the .psp/.psi files: both are mapped
+// into memory and exposed as structure-of-arrays spans.
 class VSDSprite
 {
 public:
     // VSDSprite Public Methods
-    VSDSprite() { }
+    VSDSprite();
+    ~VSDSprite();
     // @NOTE: This constructor requires computing the bounding box of the
     // sprite on the fly
     void Read(const string &datadirectory, const string &pshfile,
@@ -64,17 +80,36 @@ public:
     void PrintBoundingBox() const;
     int GetNumberEvents() const;
     string GetTimeStep() const;
-    float GetEventIntensity(int i) const;
-    Point GetEventPosition(int i) const;
+    float GetEventIntensity(uint64_t i) const {
+        return intensities[i];
+    }
+    Point GetEventPosition(uint64_t i) const {
+        return Point(positions[3 * i], positions[3 * i + 1],
+                     positions[3 * i + 2]) - offset;
+    }
+    const float *GetEventPositions() const { return positions; }
+    const float *GetEventIntensities() const { return intensities; }
+    const Vector &GetEventOffset() const { return offset; }
+    bool NextChunk(uint64_t *cursor, uint64_t chunkSize,
+                   VSDEventChunk *chunk) const;
     void PrintBoundingBox( string outputDirectory, string pshFilePrefix ) const;
-    VSDGrid* Voxelize(const int resolution = 512) const;
+    VSDGrid* Voxelize(const int resolution = 512,
+        VSDReconstruction reconstruction = VSD_RECONSTRUCTION_NEAREST,
+        float gaussianRadius = 1.5f) const;
 private:
     // VSDSprite Private Methods
     void ReadHeaderData(const string &hdrfile);
     void WriteHeaderData(const string &hdrfile);
+    void MapEvents(const string &datadirectory, const Vector &translation);
+    void Unmap();
+    VSDSprite(const VSDSprite &);
+    VSDSprite &operator=(const VSDSprite &);
 private:
     // VSDSprite Private Data
-    vector <VSDEvent> events;
+    MappedFile *positionMapping, *intensityMapping;
+    const float *positions;
+    const float *intensities;
+    Vector offset; // Subtracted from the positions when they are read
     int eventsCount;
     Vector center;
     Vector dimensions;
@@ -88,4 +123,9 @@ int ParseIntParameter(const string line);
 float ParseFloatParameter(const std::string line);
 std::string ParseStringParameter(const std::string line);
 
+// Expands the sprite headers given to a time-series run into the ordered
+// list of frames; entries with wildcards are globbed in _datadirectory_
+std::vector<std::string> ExpandSpriteSequence(const std::string &datadirectory,
+    const std::vector<std::string> &pshfiles);
+
 #endif // PBRT_VSD_VSDSPRITE_H
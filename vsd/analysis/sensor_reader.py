@@ -0,0 +1,208 @@
+#!/usr/bin/python
+################################################################################
+# Copyright BBP/EPFL (c) 2015
+# Author : Marwan Abdellah (marwan.abdellah@epfl.ch)
+################################################################################
+
+import struct
+import sys
+import zlib
+import numpy
+
+
+# Layout of the 128-byte header written by core/sensorfile.cpp
+SENSOR_HEADER_FORMAT = '<8sII7Q5f6If8x'
+SENSOR_HEADER_SIZE = struct.calcsize(SENSOR_HEADER_FORMAT)
+SENSOR_HEADER_FIELDS = ['magic', 'version', 'flags',
+                        'x_pixels', 'y_pixels', 'hit_count', 'records_count',
+                        'planes_offset', 'cube_offset', 'records_offset',
+                        'width_um', 'height_um', 'fov',
+                        'lambda_start', 'lambda_end',
+                        'spectral_samples', 'planes_count',
+                        'record_block_size',
+                        'theta_bins', 'phi_bins', 'tile_size', 'theta_max']
+
+# Header flag set by the angular histograms (.angular)
+SENSOR_FILE_ANGULAR = 1
+
+# Planes stored in .sensor files, in order
+SENSOR_PLANES = ['energy', 'x', 'y', 'z']
+
+
+################################################################################
+# @read_sensor_header
+################################################################################
+def read_sensor_header(sensor_file_path):
+    """
+    Reads the header of a binary sensor file (.sensor, .photons or .angular).
+
+    :param sensor_file_path: the path of the sensor file
+    :return: a dictionary with the header fields
+    """
+
+    with open(sensor_file_path, 'rb') as sensor_file:
+        data = sensor_file.read(SENSOR_HEADER_SIZE)
+    if len(data) != SENSOR_HEADER_SIZE:
+        sys.exit("[%s] is too short to be a sensor file" % sensor_file_path)
+    header = dict(zip(SENSOR_HEADER_FIELDS,
+                      struct.unpack(SENSOR_HEADER_FORMAT, data)))
+    if header['magic'] != b'PBRTSENS':
+        sys.exit("[%s] is not a sensor file" % sensor_file_path)
+    return header
+
+
+################################################################################
+# @map_sensor_planes
+################################################################################
+def map_sensor_planes(sensor_file_path, header=None):
+    """
+    Maps the energy and XYZ planes of a sensor file without reading them.
+
+    :param sensor_file_path: the path of the sensor file
+    :param header: the header of the file, read if not given
+    :return: a dictionary of [y, x] arrays keyed by the plane names
+    """
+
+    if header is None:
+        header = read_sensor_header(sensor_file_path)
+    planes = dict()
+    if header['planes_count'] == 0 or header['flags'] & SENSOR_FILE_ANGULAR:
+        return planes
+    shape = (header['planes_count'], header['y_pixels'], header['x_pixels'])
+    data = numpy.memmap(sensor_file_path, dtype='<f4', mode='r',
+                        offset=header['planes_offset'], shape=shape)
+    for i in range(header['planes_count']):
+        planes[SENSOR_PLANES[i]] = data[i]
+    return planes
+
+
+################################################################################
+# @map_angular_histogram
+################################################################################
+def map_angular_histogram(sensor_file_path, header=None):
+    """
+    Maps the angular histogram of a .angular file without reading it.
+
+    :param sensor_file_path: the path of the .angular file
+    :param header: the header of the file, read if not given
+    :return: a [theta, phi, y-tile, x-tile] array of the recorded energy and
+    the lower edges of the theta bins in degrees, or None if the file is not a
+    histogram
+    """
+
+    if header is None:
+        header = read_sensor_header(sensor_file_path)
+    if not header['flags'] & SENSOR_FILE_ANGULAR:
+        return None, None
+    shape = (header['theta_bins'], header['phi_bins'],
+             header['y_pixels'], header['x_pixels'])
+    histogram = numpy.memmap(sensor_file_path, dtype='<f4', mode='r',
+                             offset=header['planes_offset'], shape=shape)
+    thetas = header['theta_max'] / header['theta_bins'] * \
+        numpy.arange(header['theta_bins'])
+    return histogram, thetas
+
+
+################################################################################
+# @map_sensor_cube
+################################################################################
+def map_sensor_cube(sensor_file_path, header=None):
+    """
+    Maps the per-wavelength cube of a sensor file without reading it.
+
+    :param sensor_file_path: the path of the sensor file
+    :param header: the header of the file, read if not given
+    :return: a [wavelength, y, x] array and the wavelengths in nm, or None if
+    the file has no cube
+    """
+
+    if header is None:
+        header = read_sensor_header(sensor_file_path)
+    if header['cube_offset'] == 0:
+        return None, None
+    samples = header['spectral_samples']
+    shape = (samples, header['y_pixels'], header['x_pixels'])
+    cube = numpy.memmap(sensor_file_path, dtype='<f4', mode='r',
+                        offset=header['cube_offset'], shape=shape)
+    step = (header['lambda_end'] - header['lambda_start']) / float(samples)
+    wavelengths = header['lambda_start'] + step * numpy.arange(samples)
+    return cube, wavelengths
+
+
+################################################################################
+# @iterate_sensor_records
+################################################################################
+def iterate_sensor_records(sensor_file_path, header=None):
+    """
+    Iterates over the compressed photon record blocks of a sensor file.
+
+    :param sensor_file_path: the path of the sensor file
+    :param header: the header of the file, read if not given
+    :return: a generator of (x, y, theta) column arrays, one per block
+    """
+
+    if header is None:
+        header = read_sensor_header(sensor_file_path)
+    if header['records_offset'] == 0:
+        return
+    data = numpy.memmap(sensor_file_path, dtype=numpy.uint8, mode='r')
+    offset = header['records_offset']
+    remaining = header['records_count']
+    while remaining > 0:
+        count, x_bytes, y_bytes, theta_bytes = \
+            struct.unpack('<4I', data[offset:offset + 16].tobytes())
+        offset += 16
+        columns = list()
+        for n_bytes, dtype in [(x_bytes, '<u2'), (y_bytes, '<u2'),
+                               (theta_bytes, '<f2')]:
+            column = zlib.decompress(data[offset:offset + n_bytes].tobytes())
+            columns.append(numpy.frombuffer(column, dtype=dtype))
+            offset += n_bytes
+        remaining -= count
+        yield columns[0], columns[1], columns[2]
+
+
+################################################################################
+# @read_sensor_records
+################################################################################
+def read_sensor_records(sensor_file_path, header=None):
+    """
+    Reads all the photon records of a sensor file.
+
+    :param sensor_file_path: the path of the sensor file
+    :param header: the header of the file, read if not given
+    :return: the x, y and theta columns of the records
+    """
+
+    x = list()
+    y = list()
+    theta = list()
+    for block in iterate_sensor_records(sensor_file_path, header):
+        x.append(block[0])
+        y.append(block[1])
+        theta.append(block[2])
+    if len(x) == 0:
+        return (numpy.zeros(0, numpy.uint16), numpy.zeros(0, numpy.uint16),
+                numpy.zeros(0, numpy.float16))
+    return numpy.concatenate(x), numpy.concatenate(y), numpy.concatenate(theta)
+
+
+################################################################################
+# @main
+################################################################################
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        sys.exit("Usage: sensor_reader.py <file.sensor | file.photons>")
+    header = read_sensor_header(sys.argv[1])
+    for field in SENSOR_HEADER_FIELDS[1:]:
+        print("%s: %s" % (field, header[field]))
+    histogram, thetas = map_angular_histogram(sys.argv[1], header)
+    if histogram is not None:
+        profile = histogram.sum(axis=(1, 2, 3))
+        for theta, energy in zip(thetas, profile):
+            print("theta %g: %g" % (theta, energy))
+    for name, plane in map_sensor_planes(sys.argv[1], header).items():
+        print("%s plane: total %g, max %g" % (name, plane.sum(), plane.max()))
+    if header['records_count'] > 0:
+        x, y, theta = read_sensor_records(sys.argv[1], header)
+        print("records: %d, mean theta %g" % (len(x), theta.mean()))
@@ -141,6 +141,33 @@ def create_batch_config(slurm_config):
     return b
 
 
+###############################################################################
+def create_shard_batch_scripts(slurm_config, pbrt_command, number_shards,
+                               scripts_directory):
+    """
+    * splits a single heavy pbrt run in shards, one batch job per shard.
+    The partial outputs of the shards are summed afterwards with
+    pbrtmerge <name>.shard*of<number_shards>.<extension>
+
+    keyword arguments
+    :param slurm_config : Slurm configuration parameters.
+    :param pbrt_command : the pbrt command line that renders the step.
+    :param number_shards : the number of jobs the step is split in.
+    :param scripts_directory : where the batch scripts are generated.
+    """
+
+    for shard in range(number_shards):
+
+        # each shard gets its own job and logs
+        slurm_config.job_number = shard
+        b = create_batch_config(slurm_config)
+        b += "%s --shard %d/%d%s" % (pbrt_command, shard, number_shards, sl)
+
+        # save the script
+        script_path = "%s/shard%d.sh" % (scripts_directory, shard)
+        fh.save_file_to_disk(script_path, b)
+
+
 ###############################################################################
 def submit_batch_scripts(scripts_directory):
     """